@@ -0,0 +1,55 @@
+module;
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+export module Benchmarks.Base64;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Base64;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Decoding throughput of every instruction set the CPU supports, in GB/s of base64 text.
+    void RunBase64Benchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr char k_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    void RunBase64Benchmark( Allocator* allocator ) {
+        // Big enough to stream from memory like a large embedded buffer. Any valid text decodes at the same speed.
+        const sizet textSize = cmega( 64 );
+        Array(char) text( textSize, *allocator );
+        std::mt19937 random( 1234 );
+        for ( char& character : text ) {
+            character = k_alphabet[ random() & 63 ];
+        }
+        Array(u8) output( Base64DecodedSize( text.data(), text.size() ), *allocator );
+
+        const char* isaNames[] = { "scalar", "SSSE3", "AVX2" };
+        const Base64Isa supported = Base64SupportedIsa();
+        constexpr u32 k_repetitions = 10;
+        for ( u32 isa = ( u32 )Base64Isa::Scalar; isa <= ( u32 )supported; ++isa ) {
+            // Warm up, the first pass also faults the output pages in.
+            bool valid = Base64Decode( text.data(), text.size(), output.data(), ( Base64Isa )isa );
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            for ( u32 i = 0; i < k_repetitions; ++i ) {
+                valid &= Base64Decode( text.data(), text.size(), output.data(), ( Base64Isa )isa );
+            }
+            const double seconds = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - start ).count();
+
+            if ( !valid ) {
+                error( "Base64 benchmark text failed to decode with {}", isaNames[ isa ] );
+                continue;
+            }
+            info( "Base64 decode {}: {:.2f} GB/s", isaNames[ isa ], ( double )textSize * k_repetitions / seconds / 1e9 );
+        }
+    }
+}
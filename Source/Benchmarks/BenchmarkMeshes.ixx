@@ -0,0 +1,87 @@
+module;
+
+#include <math.h>
+
+#include <vector>
+
+export module Benchmarks.Meshes;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Platform;
+
+export namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    // Tightly packed streams of an indexed triangle list.
+    struct BenchmarkMesh {
+        BenchmarkMesh( Allocator& allocator );
+
+        Array(f32)                  m_positions;
+        Array(f32)                  m_normals;
+        Array(f32)                  m_uvs;
+        Array(u32)                  m_indices;
+        u32                         m_vertexCount   = 0;
+    };
+
+    // Grid over [-1, 1] on xz displaced by waves, with resolution * resolution * 2 triangles.
+    // Curved like scanned terrain, so simplification and normal cones have something to work with.
+    void GenerateTerrainMesh( u32 resolution, BenchmarkMesh& mesh );
+}
+
+namespace Caustix {
+
+    BenchmarkMesh::BenchmarkMesh( Allocator& allocator )
+    : m_positions( allocator )
+    , m_normals( allocator )
+    , m_uvs( allocator )
+    , m_indices( allocator ) {
+    }
+
+    void GenerateTerrainMesh( u32 resolution, BenchmarkMesh& mesh ) {
+        const u32 side = resolution + 1;
+        mesh.m_vertexCount = side * side;
+        mesh.m_positions.resize( mesh.m_vertexCount * 3 );
+        mesh.m_normals.resize( mesh.m_vertexCount * 3 );
+        mesh.m_uvs.resize( mesh.m_vertexCount * 2 );
+
+        for ( u32 row = 0; row < side; ++row ) {
+            for ( u32 column = 0; column < side; ++column ) {
+                const u32 vertex = row * side + column;
+                const f32 u = ( f32 )column / resolution;
+                const f32 v = ( f32 )row / resolution;
+                const f32 x = u * 2.0f - 1.0f;
+                const f32 z = v * 2.0f - 1.0f;
+
+                // Height and its derivatives give the normal.
+                const f32 height = 0.1f * sinf( x * 7.0f ) * cosf( z * 5.0f ) + 0.02f * sinf( x * 31.0f + z * 23.0f );
+                const f32 dx = 0.7f * cosf( x * 7.0f ) * cosf( z * 5.0f ) + 0.62f * cosf( x * 31.0f + z * 23.0f );
+                const f32 dz = -0.5f * sinf( x * 7.0f ) * sinf( z * 5.0f ) + 0.46f * cosf( x * 31.0f + z * 23.0f );
+                const f32 length = sqrtf( dx * dx + 1.0f + dz * dz );
+
+                f32* position = &mesh.m_positions[ vertex * 3 ];
+                position[ 0 ] = x;
+                position[ 1 ] = height;
+                position[ 2 ] = z;
+
+                f32* normal = &mesh.m_normals[ vertex * 3 ];
+                normal[ 0 ] = -dx / length;
+                normal[ 1 ] = 1.0f / length;
+                normal[ 2 ] = -dz / length;
+
+                mesh.m_uvs[ vertex * 2 + 0 ] = u;
+                mesh.m_uvs[ vertex * 2 + 1 ] = v;
+            }
+        }
+
+        // Counter clockwise seen from above.
+        mesh.m_indices.clear();
+        mesh.m_indices.reserve( resolution * resolution * 6 );
+        for ( u32 row = 0; row < resolution; ++row ) {
+            for ( u32 column = 0; column < resolution; ++column ) {
+                const u32 corner = row * side + column;
+                const u32 quad[ 6 ] = { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 };
+                mesh.m_indices.insert( mesh.m_indices.end(), quad, quad + 6 );
+            }
+        }
+    }
+}
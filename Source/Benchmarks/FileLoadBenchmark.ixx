@@ -0,0 +1,130 @@
+module;
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+export module Benchmarks.FileLoad;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Memory.VirtualMemory;
+import Foundation.File;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Time and resident memory of loading a large buffer file with the mapped loader against reading it into a heap buffer.
+    // Both read every byte once, like the copy to the staging buffers. The file was just written, so it comes from the page cache.
+    void RunFileLoadBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    static constexpr sizet k_file_load_size         = cmega( 256 );
+    static constexpr sizet k_file_load_chunk_size   = cmega( 1 );
+    static constexpr u32   k_file_load_repetitions  = 3;
+
+    struct FileLoadMeasure {
+        f64         m_best          = 0.0;  // Milliseconds.
+        sizet       m_peakResident  = 0;    // Bytes above the resident size before the first load.
+        u64         m_checksum      = 0;
+    };
+
+    // Stands in for the copy to the staging buffers.
+    static u64 ReadFileBytes( const u8* data, sizet size ) {
+        u64 sum = 0;
+        sizet i = 0;
+        for ( ; i + sizeof( u64 ) <= size; i += sizeof( u64 ) ) {
+            u64 value;
+            memcpy( &value, data + i, sizeof( u64 ) );
+            sum += value;
+        }
+        for ( ; i < size; ++i ) {
+            sum += data[ i ];
+        }
+        return sum;
+    }
+
+    static bool WriteBenchmarkFile( cstring filename, Allocator* allocator ) {
+        FILE* file = fopen( filename, "wb" );
+        if ( file == nullptr ) {
+            return false;
+        }
+
+        u64* chunk = ( u64* )calloca( k_file_load_chunk_size, allocator );
+        bool written = true;
+        for ( sizet offset = 0; offset < k_file_load_size && written; offset += k_file_load_chunk_size ) {
+            for ( sizet i = 0; i < k_file_load_chunk_size / sizeof( u64 ); ++i ) {
+                chunk[ i ] = offset + i * 0x9E3779B97F4A7C15ull;
+            }
+            written = fwrite( chunk, k_file_load_chunk_size, 1, file ) == 1;
+        }
+        cfree( chunk, allocator );
+        fclose( file );
+        return written;
+    }
+
+    // Resident size is sampled with the whole file loaded and read, the highest point of each load.
+    template <typename Load>
+    static FileLoadMeasure MeasureLoad( Load&& load ) {
+        FileLoadMeasure measure;
+        const sizet baseResident = VirtualMemoryResidentSize();
+        for ( u32 repetition = 0; repetition < k_file_load_repetitions; ++repetition ) {
+            sizet resident = 0;
+            const auto start = std::chrono::high_resolution_clock::now();
+            measure.m_checksum += load( resident );
+            const f64 time = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+
+            measure.m_best = repetition == 0 ? time : std::min( measure.m_best, time );
+            measure.m_peakResident = std::max( measure.m_peakResident, resident > baseResident ? resident - baseResident : 0 );
+        }
+        return measure;
+    }
+
+    void RunFileLoadBenchmark( Allocator* allocator ) {
+        const std::string filename = ( std::filesystem::temp_directory_path() / "caustix_file_load_benchmark.bin" ).string();
+        if ( !WriteBenchmarkFile( filename.c_str(), allocator ) ) {
+            error( "File load benchmark: cannot write {}", filename );
+            return;
+        }
+
+        // Mapped first: the heap keeps the pool of the read buffer resident once freed, which would hide the mapped pages.
+        const FileLoadMeasure mapped = MeasureLoad( [ & ]( sizet& resident ) -> u64 {
+            MappedFile file;
+            if ( !file.Open( filename.c_str(), FileAccessHint::Sequential ) ) {
+                return 0;
+            }
+            const u64 checksum = ReadFileBytes( file.m_data, file.m_size );
+            resident = VirtualMemoryResidentSize();
+            return checksum;
+        } );
+
+        const FileLoadMeasure read = MeasureLoad( [ & ]( sizet& resident ) -> u64 {
+            FileReadResult file = FileReadBinary( filename.c_str(), allocator );
+            if ( file.data == nullptr ) {
+                return 0;
+            }
+            const u64 checksum = ReadFileBytes( ( const u8* )file.data, file.size );
+            resident = VirtualMemoryResidentSize();
+            cfree( file.data, allocator );
+            return checksum;
+        } );
+
+        std::filesystem::remove( filename );
+
+        if ( mapped.m_checksum != read.m_checksum ) {
+            error( "File load benchmark: mapped and read loaders saw different bytes" );
+            return;
+        }
+
+        // Mapped pages are clean page cache pages shared with the OS, the read buffer is private memory on top of the page cache.
+        const f64 mega = 1024.0 * 1024.0;
+        info( "File load {:.0f} MB read: {:.2f} ms best, {:.1f} MB peak resident", k_file_load_size / mega, read.m_best, read.m_peakResident / mega );
+        info( "File load {:.0f} MB mapped: {:.2f} ms best, {:.1f} MB peak resident, {:.2f}x faster", k_file_load_size / mega, mapped.m_best,
+              mapped.m_peakResident / mega, read.m_best / mapped.m_best );
+    }
+}
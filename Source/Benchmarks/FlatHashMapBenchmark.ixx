@@ -0,0 +1,106 @@
+module;
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+export module Benchmarks.FlatHashMap;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.FlatHashMap;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Insert, lookup and erase times of FlatHashMap and std::unordered_map with u64 keys, from 1K to 10M entries.
+    void RunFlatHashMapBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    using StdHashMap = std::unordered_map<u64, u64, FlatHash<u64>, std::equal_to<u64>, STLAdaptor<std::pair<const u64, u64>>>;
+
+    struct HashMapTimings {
+        f64                 m_insert    = 0.0;
+        f64                 m_hit       = 0.0;
+        f64                 m_miss      = 0.0;
+        f64                 m_erase     = 0.0;
+    };
+
+    // Nanoseconds per key.
+    template <typename Func>
+    static f64 MeasurePerKey( sizet count, Func&& func ) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        func();
+        return std::chrono::duration<f64, std::nano>( std::chrono::high_resolution_clock::now() - start ).count() / count;
+    }
+
+    // Both maps grow from empty, like the resource caches.
+    template <typename Map>
+    static HashMapTimings BenchmarkMap( Map& map, const Array(u64)& keys, const Array(u64)& missingKeys ) {
+        HashMapTimings timings;
+        timings.m_insert = MeasurePerKey( keys.size(), [ & ]() {
+            for ( const u64 key : keys ) {
+                map.emplace( key, key );
+            }
+        } );
+
+        // Lookups in a different order than the inserts.
+        u64 found = 0;
+        timings.m_hit = MeasurePerKey( keys.size(), [ & ]() {
+            for ( sizet i = keys.size(); i-- > 0; ) {
+                found += map.find( keys[ i ] ) != map.end();
+            }
+        } );
+        timings.m_miss = MeasurePerKey( missingKeys.size(), [ & ]() {
+            for ( const u64 key : missingKeys ) {
+                found += map.find( key ) != map.end();
+            }
+        } );
+
+        timings.m_erase = MeasurePerKey( keys.size(), [ & ]() {
+            for ( const u64 key : keys ) {
+                map.erase( key );
+            }
+        } );
+
+        if ( found != keys.size() || !map.empty() ) {
+            error( "Hash map benchmark found {} keys out of {}", found, keys.size() );
+        }
+        return timings;
+    }
+
+    static void ReportTimings( cstring name, sizet count, const HashMapTimings& timings ) {
+        info( "{} {} keys: insert {:.1f} ns, hit {:.1f} ns, miss {:.1f} ns, erase {:.1f} ns",
+              name, count, timings.m_insert, timings.m_hit, timings.m_miss, timings.m_erase );
+    }
+
+    void RunFlatHashMapBenchmark( Allocator* allocator ) {
+        std::mt19937_64 random( 1234 );
+
+        Array(u64) keys( *allocator );
+        Array(u64) missingKeys( *allocator );
+        for ( sizet count = 1000; count <= 10000000; count *= 10 ) {
+            keys.resize( count );
+            missingKeys.resize( count );
+            for ( u64& key : keys ) {
+                key = random();
+            }
+            for ( u64& key : missingKeys ) {
+                key = random();
+            }
+
+            {
+                FlatHashMap<u64, u64> map( *allocator );
+                ReportTimings( "FlatHashMap", count, BenchmarkMap( map, keys, missingKeys ) );
+            }
+            {
+                StdHashMap map( *allocator );
+                ReportTimings( "std::unordered_map", count, BenchmarkMap( map, keys, missingKeys ) );
+            }
+        }
+    }
+}
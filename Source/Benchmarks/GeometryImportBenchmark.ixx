@@ -0,0 +1,221 @@
+module;
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+export module Benchmarks.GeometryImport;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.GeometryImport;
+import Foundation.glTF;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // DecodeAccessor throughput for every component type, normalized and not, and DecodeIndices for every index type,
+    // against a per component loop like the one the loader had before, on one thread and on the job system.
+    void RunGeometryImportBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_geometry_bench_count         = 1 << 22;  // Vec4 elements, or indices.
+    static constexpr u32 k_geometry_bench_repetitions   = 5;
+
+    // Per component, with the glTF normalization rules, what every accessor went through before the packed paths.
+    static f32 ReferenceComponent( const u8* source, i32 componentType, bool normalized ) {
+        switch ( componentType ) {
+            case glTF::Accessor::BYTE:
+                return normalized ? std::max( ( i8 )*source / 127.0f, -1.0f ) : ( f32 )( i8 )*source;
+            case glTF::Accessor::UNSIGNED_BYTE:
+                return normalized ? *source / 255.0f : ( f32 )*source;
+            case glTF::Accessor::SHORT: {
+                i16 value;
+                memcpy( &value, source, sizeof( i16 ) );
+                return normalized ? std::max( value / 32767.0f, -1.0f ) : ( f32 )value;
+            }
+            case glTF::Accessor::UNSIGNED_SHORT: {
+                u16 value;
+                memcpy( &value, source, sizeof( u16 ) );
+                return normalized ? value / 65535.0f : ( f32 )value;
+            }
+            case glTF::Accessor::UNSIGNED_INT: {
+                u32 value;
+                memcpy( &value, source, sizeof( u32 ) );
+                return ( f32 )value;
+            }
+            default: {
+                f32 value;
+                memcpy( &value, source, sizeof( f32 ) );
+                return value;
+            }
+        }
+    }
+
+    static u32 ReferenceIndex( const u8* source, i32 componentType ) {
+        switch ( componentType ) {
+            case glTF::Accessor::UNSIGNED_BYTE:
+                return *source;
+            case glTF::Accessor::UNSIGNED_SHORT: {
+                u16 value;
+                memcpy( &value, source, sizeof( u16 ) );
+                return value;
+            }
+            default: {
+                u32 value;
+                memcpy( &value, source, sizeof( u32 ) );
+                return value;
+            }
+        }
+    }
+
+    // A scene of one buffer and one accessor over all of it, enough for the decoders.
+    struct GeometryBenchScene {
+        GeometryBenchScene( Allocator* allocator, const u8* data, u32 size )
+            : m_scene( allocator )
+            , m_buffer{ ( i32 )size, StringBuffer( *allocator ), StringBuffer( *allocator ), data }
+            , m_bufferView{ 0, ( i32 )size, 0, glTF::INVALID_INT_VALUE, glTF::BufferView::ARRAY_BUFFER, StringBuffer( *allocator ) } {
+            m_scene.buffers_count = 1;
+            m_scene.buffers = &m_buffer;
+            m_scene.buffer_views_count = 1;
+            m_scene.buffer_views = &m_bufferView;
+            m_scene.accessors_count = 1;
+            m_scene.accessors = &m_accessor;
+        }
+
+        glTF::glTF          m_scene;
+        glTF::Buffer        m_buffer;
+        glTF::BufferView    m_bufferView;
+        glTF::Accessor      m_accessor{ 0, 0, glTF::Accessor::FLOAT, 0, 0, nullptr, 0, nullptr, false, nullptr, glTF::Accessor::Vec4 };
+    };
+
+    // Best of the repetitions, in GB/s of source data.
+    template <typename Decode>
+    static f64 MeasureDecode( u64 sourceBytes, Decode&& decode ) {
+        f64 best = 0.0;
+        for ( u32 repetition = 0; repetition < k_geometry_bench_repetitions; ++repetition ) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            decode();
+            const f64 seconds = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - start ).count();
+            best = std::max( best, sourceBytes / seconds * 1e-9 );
+        }
+        return best;
+    }
+
+    static void BenchmarkAccessor( GeometryBenchScene& bench, i32 componentType, bool normalized, f32* output, JobSystem& jobSystem ) {
+        glTF::Accessor& accessor = bench.m_accessor;
+        accessor.component_type = componentType;
+        accessor.normalized = normalized;
+        accessor.type = glTF::Accessor::Vec4;
+        accessor.count = k_geometry_bench_count;
+
+        const u32 componentSize = GetAccessorComponentSize( componentType );
+        const u64 sourceBytes = ( u64 )k_geometry_bench_count * 4 * componentSize;
+        const u8* buffers[] = { bench.m_buffer.data };
+
+        const f64 reference = MeasureDecode( sourceBytes, [ & ]() {
+            const u8* source = bench.m_buffer.data;
+            for ( u32 i = 0; i < k_geometry_bench_count * 4; ++i ) {
+                output[ i ] = ReferenceComponent( source + i * componentSize, componentType, normalized );
+            }
+        } );
+        bool decoded = true;
+        const f64 single = MeasureDecode( sourceBytes, [ & ]() {
+            decoded &= DecodeAccessor( bench.m_scene, buffers, 0, output, 4, 4 * sizeof( f32 ) );
+        } );
+        const f64 parallel = MeasureDecode( sourceBytes, [ & ]() {
+            decoded &= DecodeAccessor( bench.m_scene, buffers, 0, output, 4, 4 * sizeof( f32 ), &jobSystem );
+        } );
+
+        static constexpr cstring k_names[] = { "i8", "u8", "i16", "u16", "", "u32", "f32" };
+        if ( !decoded ) {
+            error( "Geometry import benchmark: {} accessor failed to decode", k_names[ componentType - glTF::Accessor::BYTE ] );
+            return;
+        }
+        info( "Geometry import vec4 {}{}: per component {:.2f} GB/s, DecodeAccessor {:.2f} GB/s ({:.1f}x), {} workers {:.2f} GB/s ({:.1f}x)",
+              k_names[ componentType - glTF::Accessor::BYTE ], normalized ? " normalized" : "", reference, single, single / reference,
+              jobSystem.GetWorkerCount(), parallel, parallel / reference );
+    }
+
+    template <typename Index>
+    static void BenchmarkIndices( GeometryBenchScene& bench, i32 componentType, Index* output, JobSystem& jobSystem ) {
+        glTF::Accessor& accessor = bench.m_accessor;
+        accessor.component_type = componentType;
+        accessor.normalized = false;
+        accessor.type = glTF::Accessor::Scalar;
+        accessor.count = k_geometry_bench_count;
+
+        const u32 componentSize = GetAccessorComponentSize( componentType );
+        const u64 sourceBytes = ( u64 )k_geometry_bench_count * componentSize;
+        const u8* buffers[] = { bench.m_buffer.data };
+
+        const f64 reference = MeasureDecode( sourceBytes, [ & ]() {
+            const u8* source = bench.m_buffer.data;
+            for ( u32 i = 0; i < k_geometry_bench_count; ++i ) {
+                output[ i ] = ( Index )ReferenceIndex( source + i * componentSize, componentType );
+            }
+        } );
+        bool decoded = true;
+        const f64 single = MeasureDecode( sourceBytes, [ & ]() {
+            decoded &= DecodeIndices( bench.m_scene, buffers, 0, output );
+        } );
+        const f64 parallel = MeasureDecode( sourceBytes, [ & ]() {
+            decoded &= DecodeIndices( bench.m_scene, buffers, 0, output, &jobSystem );
+        } );
+
+        static constexpr cstring k_names[] = { "", "u8", "", "u16", "", "u32" };
+        if ( !decoded ) {
+            error( "Geometry import benchmark: {} indices failed to decode", k_names[ componentType - glTF::Accessor::BYTE ] );
+            return;
+        }
+        info( "Geometry import indices {} to u{}: per index {:.2f} GB/s, DecodeIndices {:.2f} GB/s ({:.1f}x), {} workers {:.2f} GB/s ({:.1f}x)",
+              k_names[ componentType - glTF::Accessor::BYTE ], sizeof( Index ) * 8, reference, single, single / reference,
+              jobSystem.GetWorkerCount(), parallel, parallel / reference );
+    }
+
+    void RunGeometryImportBenchmark( Allocator* allocator ) {
+        // Large enough for the biggest accessor, vec4 of f32. Real floats, random bytes could hold NaNs and denormals,
+        // the integer types read their bytes as they are.
+        const u32 bufferSize = k_geometry_bench_count * 4 * sizeof( f32 );
+        Array(u8) buffer( bufferSize, *allocator );
+        for ( u32 i = 0; i < bufferSize / sizeof( f32 ); ++i ) {
+            const f32 value = ( f32 )( i % 2048 ) * 0.25f - 256.0f;
+            memcpy( buffer.data() + i * sizeof( f32 ), &value, sizeof( f32 ) );
+        }
+
+        Array(f32) output( k_geometry_bench_count * 4, *allocator );
+        GeometryBenchScene bench( allocator, buffer.data(), bufferSize );
+
+        JobSystemConfiguration jobConfiguration;
+        jobConfiguration.m_allocator = allocator;
+        JobSystem jobSystem( jobConfiguration );
+
+        const i32 componentTypes[] = { glTF::Accessor::BYTE, glTF::Accessor::UNSIGNED_BYTE, glTF::Accessor::SHORT, glTF::Accessor::UNSIGNED_SHORT,
+                                       glTF::Accessor::UNSIGNED_INT, glTF::Accessor::FLOAT };
+        for ( i32 componentType : componentTypes ) {
+            BenchmarkAccessor( bench, componentType, false, output.data(), jobSystem );
+            // Only 8 and 16 bit integers can be normalized.
+            if ( componentType != glTF::Accessor::UNSIGNED_INT && componentType != glTF::Accessor::FLOAT ) {
+                BenchmarkAccessor( bench, componentType, true, output.data(), jobSystem );
+            }
+        }
+
+        // The f32 output is large enough for either index width. Indices stay below 2^16 so the u16 output holds them too.
+        const i32 indexTypes[] = { glTF::Accessor::UNSIGNED_BYTE, glTF::Accessor::UNSIGNED_SHORT, glTF::Accessor::UNSIGNED_INT };
+        for ( i32 indexType : indexTypes ) {
+            const u32 indexSize = GetAccessorComponentSize( indexType );
+            for ( u32 i = 0; i < k_geometry_bench_count; ++i ) {
+                const u32 index = ( i * 7 ) % ( indexSize == 1 ? 256 : 65536 );
+                memcpy( buffer.data() + i * indexSize, &index, indexSize );
+            }
+            BenchmarkIndices( bench, indexType, ( u32* )output.data(), jobSystem );
+            BenchmarkIndices( bench, indexType, ( u16* )output.data(), jobSystem );
+        }
+    }
+}
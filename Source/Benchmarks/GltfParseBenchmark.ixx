@@ -0,0 +1,188 @@
+module;
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+export module Benchmarks.GltfParse;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.LinearAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.File;
+import Foundation.Json;
+import Foundation.glTF;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // glTF JSON parsing throughput over synthetic scenes of 1k to 100k meshes, shaped like exporter output.
+    // A walk reading every value with the JsonReader gives the tokenizer alone, gltfLoadFile the whole document load.
+    void RunGltfParseBenchmark( Allocator* allocator, LinearAllocator* scratchAllocator );
+}
+
+namespace Caustix {
+    using JsonText = std::basic_string<char, std::char_traits<char>, STLAdaptor<char>>;
+
+    static constexpr u32 k_gltf_parse_mesh_counts[]    = { 1000, 10000, 100000 };
+    static constexpr u32 k_gltf_parse_materials        = 64;
+    static constexpr u32 k_gltf_parse_repetitions      = 5;
+
+    // Every mesh has one primitive with positions, normals, texcoords and indices, each in its own buffer view,
+    // and a node placing it under the root. Numbers are printed the way exporters print them.
+    // Meshes stay small so the buffer of the largest scene still fits the i32 byte lengths of the loader.
+    // Returns the byte length of the buffer.
+    static u64 WriteSyntheticScene( JsonText& json, u32 meshCount ) {
+        json.clear();
+        json += R"({"asset":{"generator":"Caustix benchmark","version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],"nodes":[{"name":"root","children":[)";
+        for ( u32 i = 0; i < meshCount; ++i ) {
+            std::format_to( std::back_inserter( json ), "{}{}", i ? "," : "", i + 1 );
+        }
+        json += "]}";
+        for ( u32 i = 0; i < meshCount; ++i ) {
+            const f32 angle = i * 0.001f;
+            std::format_to( std::back_inserter( json ),
+                            R"(,{{"name":"node_{}","mesh":{},"translation":[{},{},{}],"rotation":[0,{},0,{}],"scale":[1,1,1]}})",
+                            i, i, i * 1.25f, -i * 0.5f, i * 0.125f, angle, 1.0f - angle * angle * 0.5f );
+        }
+
+        json += R"(],"meshes":[)";
+        for ( u32 i = 0; i < meshCount; ++i ) {
+            std::format_to( std::back_inserter( json ),
+                            R"({}{{"name":"mesh_{}","primitives":[{{"attributes":{{"POSITION":{},"NORMAL":{},"TEXCOORD_0":{}}},"indices":{},"material":{},"mode":4}}]}})",
+                            i ? "," : "", i, i * 4, i * 4 + 1, i * 4 + 2, i * 4 + 3, i % k_gltf_parse_materials );
+        }
+
+        json += R"(],"accessors":[)";
+        for ( u32 i = 0; i < meshCount; ++i ) {
+            const u32 vertexCount = 16 + i % 64;
+            std::format_to( std::back_inserter( json ),
+                            R"({}{{"bufferView":{},"componentType":5126,"count":{},"type":"VEC3","min":[{},{},{}],"max":[{},{},{}]}})"
+                            R"(,{{"bufferView":{},"componentType":5126,"count":{},"type":"VEC3"}})"
+                            R"(,{{"bufferView":{},"componentType":5126,"count":{},"type":"VEC2"}})"
+                            R"(,{{"bufferView":{},"componentType":5125,"count":{},"type":"SCALAR"}})",
+                            i ? "," : "", i * 4, vertexCount, -0.5f - i * 0.001f, -1.0f, -0.25f, 0.5f + i * 0.001f, 1.0f, 0.25f,
+                            i * 4 + 1, vertexCount, i * 4 + 2, vertexCount, i * 4 + 3, vertexCount * 3 );
+        }
+
+        json += R"(],"bufferViews":[)";
+        u64 offset = 0;
+        for ( u32 i = 0; i < meshCount; ++i ) {
+            const u32 vertexCount = 16 + i % 64;
+            const u32 sizes[] = { vertexCount * 12, vertexCount * 12, vertexCount * 8, vertexCount * 12 };
+            for ( u32 view = 0; view < 4; ++view ) {
+                std::format_to( std::back_inserter( json ), R"({}{{"buffer":0,"byteOffset":{},"byteLength":{},"target":{}}})",
+                                i || view ? "," : "", offset, sizes[ view ], view == 3 ? 34963 : 34962 );
+                offset += sizes[ view ];
+            }
+        }
+
+        // Names with escapes take the slow string path.
+        json += R"(],"materials":[)";
+        for ( u32 i = 0; i < k_gltf_parse_materials; ++i ) {
+            std::format_to( std::back_inserter( json ),
+                            R"({}{{"name":"mat\u00e9rial \"{}\"","pbrMetallicRoughness":{{"baseColorFactor":[0.8,0.8,0.8,1],"metallicFactor":0,"roughnessFactor":0.5}},"doubleSided":false}})",
+                            i ? "," : "", i );
+        }
+
+        std::format_to( std::back_inserter( json ), R"(],"buffers":[{{"uri":"scene.bin","byteLength":{}}}]}})", offset );
+        return offset;
+    }
+
+    // Reads every value, what any loader pays before building its own data.
+    static u64 WalkJson( JsonReader& reader ) {
+        u64 values = 1;
+        switch ( reader.Peek() ) {
+            case JsonType::Object: {
+                reader.BeginObject();
+                std::string_view key;
+                while ( reader.NextKey( key ) ) {
+                    values += WalkJson( reader );
+                }
+                break;
+            }
+            case JsonType::Array:
+                reader.BeginArray();
+                while ( reader.NextElement() ) {
+                    values += WalkJson( reader );
+                }
+                break;
+            case JsonType::String:
+                values += reader.ReadString().size();
+                break;
+            case JsonType::Number:
+                values += ( u64 )reader.ReadDouble();
+                break;
+            case JsonType::Bool:
+                values += reader.ReadBool();
+                break;
+            default:
+                reader.Skip();
+                break;
+        }
+        return values;
+    }
+
+    // Best of the repetitions in milliseconds.
+    template <typename Parse>
+    static f64 MeasureParse( Parse&& parse ) {
+        f64 best = 0.0;
+        for ( u32 repetition = 0; repetition < k_gltf_parse_repetitions; ++repetition ) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            parse();
+            const f64 time = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+            best = repetition == 0 ? time : std::min( best, time );
+        }
+        return best;
+    }
+
+    void RunGltfParseBenchmark( Allocator* allocator, LinearAllocator* scratchAllocator ) {
+        const std::string path = ( std::filesystem::temp_directory_path() / "caustix_parse_benchmark.gltf" ).string();
+        JsonText json( *allocator );
+
+        for ( u32 meshCount : k_gltf_parse_mesh_counts ) {
+            const u64 bufferSize = WriteSyntheticScene( json, meshCount );
+            if ( !FileWriteBinary( path.c_str(), json.data(), json.size() ) ) {
+                error( "glTF parse benchmark: cannot write {}", path );
+                return;
+            }
+
+            // Keeps the walk from being optimized away.
+            static volatile u64 s_values;
+            bool walked = true;
+            const f64 walkTime = MeasureParse( [ & ]() {
+                JsonReader reader( json.data(), json.size() );
+                s_values = WalkJson( reader );
+                walked &= !reader.HasError();
+            } );
+
+            // Loaded from the file like the demo, the mapping is in the page cache after the first repetition.
+            bool loaded = true;
+            const f64 loadTime = MeasureParse( [ & ]() {
+                {
+                    glTF::glTF scene = gltfLoadFile( path.c_str(), scratchAllocator );
+                    // The buffer is the last member, a parse error anywhere leaves it out.
+                    loaded &= scene.meshes_count == meshCount && scene.buffers_count == 1 && scene.buffers[ 0 ].byte_length == ( i32 )bufferSize;
+                }
+                scratchAllocator->Clear();
+            } );
+
+            if ( !walked || !loaded ) {
+                error( "glTF parse benchmark: the scene of {} meshes did not parse", meshCount );
+                continue;
+            }
+
+            const f64 megabytes = json.size() / ( 1024.0 * 1024.0 );
+            info( "glTF parse {} meshes, {:.1f} MB: walk {:.2f} ms ({:.0f} MB/s), gltfLoadFile {:.2f} ms ({:.0f} MB/s)", meshCount, megabytes,
+                  walkTime, megabytes / walkTime * 1000.0, loadTime, megabytes / loadTime * 1000.0 );
+        }
+
+        std::filesystem::remove( path );
+    }
+}
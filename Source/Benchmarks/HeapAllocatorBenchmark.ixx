@@ -0,0 +1,139 @@
+module;
+
+#include <cstdlib>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+export module Benchmarks.HeapAllocator;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.HeapAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Allocation throughput of malloc, a single mutex guarded TLSF heap and the heap with thread arenas, from 1 to 32 threads.
+    void RunHeapAllocatorBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_heap_max_threads     = 32;
+    static constexpr u32 k_heap_live_blocks     = 1024;     // Blocks each thread keeps allocated.
+    static constexpr u32 k_heap_operations      = 1 << 18;  // Free and allocate pairs per thread.
+    static constexpr u32 k_heap_min_block_size  = 16;
+    static constexpr u32 k_heap_max_block_size  = 1024;
+    static constexpr u32 k_heap_alignment       = 8;
+
+    struct MallocContender {
+        void*   Allocate( sizet size )  { return malloc( size ); }
+        void    Free( void* pointer )   { free( pointer ); }
+    };
+
+    // What every thread allocating from the shared heap did before the thread arenas.
+    struct LockedHeapContender {
+        LockedHeapContender() : m_heap( cmega( 256 ) ) {}
+
+        void* Allocate( sizet size ) {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            return m_heap.allocate( size, k_heap_alignment );
+        }
+        void Free( void* pointer ) {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_heap.deallocate( pointer );
+        }
+
+        HeapAllocator       m_heap;
+        std::mutex          m_mutex;
+    };
+
+    struct ArenaHeapContender {
+        ArenaHeapContender() : m_heap( HeapAllocatorConfiguration{ cmega( 256 ), k_max_heap_arenas - 1 } ) {}
+
+        void*   Allocate( sizet size )  { return m_heap.allocate( size, k_heap_alignment ); }
+        void    Free( void* pointer )   { m_heap.deallocate( pointer ); }
+
+        HeapAllocator       m_heap;
+    };
+
+    // Random sizes and slots, the same sequence for every contender.
+    static u32 NextRandom( u32& state ) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Millions of operations per second, an operation being one allocation or one free.
+    template <typename Contender>
+    static f64 MeasureContender( Contender& contender, u32 threadCount, Allocator* allocator ) {
+        std::atomic<u32> ready{ 0 };
+        std::atomic<bool> start{ false };
+
+        auto worker = [ & ]( u32 threadIndex ) {
+            void* blocks[ k_heap_live_blocks ];
+            u32 state = 0x9E3779B9u * ( threadIndex + 1 );
+            for ( void*& block : blocks ) {
+                block = contender.Allocate( k_heap_min_block_size + NextRandom( state ) % ( k_heap_max_block_size - k_heap_min_block_size ) );
+            }
+
+            ready.fetch_add( 1, std::memory_order_acq_rel );
+            while ( !start.load( std::memory_order_acquire ) ) {
+                std::this_thread::yield();
+            }
+
+            for ( u32 i = 0; i < k_heap_operations; ++i ) {
+                const u32 random = NextRandom( state );
+                void*& block = blocks[ random % k_heap_live_blocks ];
+                contender.Free( block );
+                block = contender.Allocate( k_heap_min_block_size + ( random >> 10 ) % ( k_heap_max_block_size - k_heap_min_block_size ) );
+                // Touch the block, like a real user would.
+                *( u8* )block = ( u8 )i;
+            }
+
+            for ( void* block : blocks ) {
+                contender.Free( block );
+            }
+        };
+
+        Array(std::thread) threads( *allocator );
+        threads.reserve( threadCount );
+        for ( u32 i = 0; i < threadCount; ++i ) {
+            threads.emplace_back( worker, i );
+        }
+        while ( ready.load( std::memory_order_acquire ) != threadCount ) {
+            std::this_thread::yield();
+        }
+
+        const auto begin = std::chrono::high_resolution_clock::now();
+        start.store( true, std::memory_order_release );
+        for ( std::thread& thread : threads ) {
+            thread.join();
+        }
+        const f64 seconds = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - begin ).count();
+
+        return 2.0 * k_heap_operations * threadCount / seconds / 1e6;
+    }
+
+    void RunHeapAllocatorBenchmark( Allocator* allocator ) {
+        MallocContender mallocContender;
+        LockedHeapContender lockedContender;
+        ArenaHeapContender arenaContender;
+
+        // Threads exit after every run, the next run claims the released arenas again.
+        for ( u32 threadCount = 1; threadCount <= k_heap_max_threads; threadCount *= 2 ) {
+            const f64 mallocRate = MeasureContender( mallocContender, threadCount, allocator );
+            const f64 lockedRate = MeasureContender( lockedContender, threadCount, allocator );
+            const f64 arenaRate = MeasureContender( arenaContender, threadCount, allocator );
+
+            info( "Heap {} threads: malloc {:.1f} Mops/s, locked tlsf {:.1f} Mops/s, thread arenas {:.1f} Mops/s ({:.2f}x locked, {:.2f}x malloc)",
+                  threadCount, mallocRate, lockedRate, arenaRate, arenaRate / lockedRate, arenaRate / mallocRate );
+        }
+    }
+}
@@ -0,0 +1,176 @@
+module;
+
+#include <stdio.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+export module Benchmarks.IoService;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Services.IoService;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Read throughput of a batch of files, blocking reads one after the other against the IoService with 1 and 4 threads
+    // (and io_uring when built with it), with the files in the page cache and, where the OS lets us drop them, out of it.
+    void RunIoServiceBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32   k_io_bench_file_count    = 64;
+    static constexpr sizet k_io_bench_file_size     = cmega( 4 );
+
+    static bool WriteIoBenchmarkFile( cstring path, u8* data ) {
+        for ( sizet i = 0; i < k_io_bench_file_size; ++i ) {
+            data[ i ] = ( u8 )( i * 31 );
+        }
+        FILE* file = fopen( path, "wb" );
+        if ( file == nullptr ) {
+            return false;
+        }
+        const bool written = fwrite( data, k_io_bench_file_size, 1, file ) == 1;
+        fclose( file );
+        return written;
+    }
+
+    // Drops the cached pages of the file, the next read goes to the disk. Only Linux can do it without privileges.
+    static bool EvictFromPageCache( cstring path ) {
+#if defined(_MSC_VER)
+        return false;
+#else
+        const int file = open( path, O_RDONLY );
+        if ( file < 0 ) {
+            return false;
+        }
+        const bool evicted = fdatasync( file ) == 0 && posix_fadvise( file, 0, 0, POSIX_FADV_DONTNEED ) == 0;
+        close( file );
+        return evicted;
+#endif // _MSC_VER
+    }
+
+    static bool EvictAll( const Array(std::string)& paths ) {
+        bool evicted = true;
+        for ( const std::string& path : paths ) {
+            evicted &= EvictFromPageCache( path.c_str() );
+        }
+        return evicted;
+    }
+
+    // What the loader did before the IoService.
+    static bool ReadBlocking( const Array(std::string)& paths, u8* const* destinations ) {
+        bool read = true;
+        for ( u32 i = 0; i < paths.size(); ++i ) {
+            FILE* file = fopen( paths[ i ].c_str(), "rb" );
+            if ( file == nullptr ) {
+                read = false;
+                continue;
+            }
+            read &= fread( destinations[ i ], k_io_bench_file_size, 1, file ) == 1;
+            fclose( file );
+        }
+        return read;
+    }
+
+    // One batch, like the image reads of the scene loader.
+    static bool ReadIoService( IoService& ioService, const Array(std::string)& paths, u8* const* destinations, IoRequest* requests ) {
+        for ( u32 i = 0; i < paths.size(); ++i ) {
+            requests[ i ].m_path = paths[ i ].c_str();
+            requests[ i ].m_offset = 0;
+            requests[ i ].m_size = k_io_bench_file_size;
+            requests[ i ].m_destination = destinations[ i ];
+        }
+        ioService.Submit( requests, ( u32 )paths.size() );
+        ioService.Wait( requests, ( u32 )paths.size() );
+
+        bool read = true;
+        for ( u32 i = 0; i < paths.size(); ++i ) {
+            read &= requests[ i ].m_status.load() == IoStatus::Completed;
+        }
+        return read;
+    }
+
+    // Megabytes per second, or 0 when a read failed.
+    template <typename Read>
+    static f64 MeasureRead( bool cold, const Array(std::string)& paths, Read&& read ) {
+        if ( cold ) {
+            EvictAll( paths );
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        const bool succeeded = read();
+        const f64 seconds = std::chrono::duration<f64>( std::chrono::high_resolution_clock::now() - start ).count();
+        return succeeded ? k_io_bench_file_count * k_io_bench_file_size / seconds / ( 1024.0 * 1024.0 ) : 0.0;
+    }
+
+    static void BenchmarkCache( bool cold, const Array(std::string)& paths, u8* const* destinations, IoRequest* requests, IoService* const* services, u32 serviceCount ) {
+        cstring cache = cold ? "cold" : "warm";
+        // Warm runs read everything once first, the files were just written but could have been evicted since.
+        if ( !cold ) {
+            ReadBlocking( paths, destinations );
+        }
+
+        info( "IoService {} cache, blocking reads: {:.0f} MB/s", cache, MeasureRead( cold, paths, [ & ]() { return ReadBlocking( paths, destinations ); } ) );
+        for ( u32 i = 0; i < serviceCount; ++i ) {
+            IoService& ioService = *services[ i ];
+            const f64 rate = MeasureRead( cold, paths, [ & ]() { return ReadIoService( ioService, paths, destinations, requests ); } );
+            info( "IoService {} cache, {} {} threads: {:.0f} MB/s", cache, ioService.m_ringEnabled ? "io_uring and" : "blocking", ioService.m_threadCount, rate );
+        }
+    }
+
+    void RunIoServiceBenchmark( Allocator* allocator ) {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "caustix_io_benchmark";
+        std::filesystem::create_directories( directory );
+
+        Array(std::string) paths( *allocator );
+        Array(u8*) destinations( *allocator );
+        bool written = true;
+        for ( u32 i = 0; i < k_io_bench_file_count; ++i ) {
+            paths.push_back( ( directory / ( "file_" + std::to_string( i ) + ".bin" ) ).string() );
+            destinations.push_back( callocaa<u8>( k_io_bench_file_size, allocator ) );
+            written &= WriteIoBenchmarkFile( paths.back().c_str(), destinations.back() );
+        }
+
+        IoRequest* requests = callocaa<IoRequest>( k_io_bench_file_count, allocator, alignof( IoRequest ) );
+        for ( u32 i = 0; i < k_io_bench_file_count; ++i ) {
+            new ( &requests[ i ] ) IoRequest();
+        }
+
+        // The ring is tried by both when built with it, the threads only take what it refuses.
+        IoServiceConfiguration configuration;
+        configuration.m_threadCount = 1;
+        IoService singleThread( configuration );
+        configuration.m_threadCount = 4;
+        IoService fourThreads( configuration );
+        IoService* const services[] = { &singleThread, &fourThreads };
+
+        if ( written ) {
+            BenchmarkCache( false, paths, destinations.data(), requests, services, ( u32 )std::size( services ) );
+            if ( EvictAll( paths ) ) {
+                BenchmarkCache( true, paths, destinations.data(), requests, services, ( u32 )std::size( services ) );
+            } else {
+                info( "IoService cold cache runs skipped, the page cache cannot be dropped on this platform" );
+            }
+        } else {
+            error( "IoService benchmark: cannot write the files in {}", directory.string() );
+        }
+
+        cfree( requests, allocator );
+        for ( u8* destination : destinations ) {
+            cfree( destination, allocator );
+        }
+        std::filesystem::remove_all( directory );
+    }
+}
@@ -0,0 +1,102 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+export module Benchmarks.Jobs;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // ParallelFor time and speedup over a single worker for 1, 2, 4... workers, up to every hardware thread.
+    void RunJobsBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_jobs_item_count      = 1 << 20;
+    static constexpr u32 k_jobs_repetitions     = 5;
+
+    // Integer mixing, so the work scales with the cores and not with the memory bandwidth.
+    static u32 MixItem( u32 value, u32 rounds ) {
+        for ( u32 i = 0; i < rounds; ++i ) {
+            value ^= value << 13;
+            value ^= value >> 17;
+            value ^= value << 5;
+        }
+        return value;
+    }
+
+    struct JobsWorkload {
+        cstring             m_name;
+        u32                 m_rounds;       // Cost of one item.
+        u32                 m_grainSize;    // 0 for the default one.
+    };
+
+    // Best of a few runs, in milliseconds.
+    static f64 MeasureWorkload( JobSystem& jobSystem, const JobsWorkload& workload, Array(u32)& results ) {
+        f64 best = 0.0;
+        for ( u32 repetition = 0; repetition < k_jobs_repetitions; ++repetition ) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            jobSystem.ParallelFor( k_jobs_item_count, [ & ]( u32 begin, u32 end ) {
+                for ( u32 i = begin; i < end; ++i ) {
+                    results[ i ] = MixItem( i + 1, workload.m_rounds );
+                }
+            }, workload.m_grainSize );
+            const f64 milliseconds = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+            best = repetition == 0 ? milliseconds : std::min( best, milliseconds );
+        }
+        return best;
+    }
+
+    void RunJobsBenchmark( Allocator* allocator ) {
+        const JobsWorkload workloads[] = {
+            { "coarse", 256, 0 },
+            // Ranges of a few microseconds, mostly scheduling and stealing overhead.
+            { "fine", 16, 64 },
+        };
+
+        const u32 hardwareThreads = std::max( std::thread::hardware_concurrency(), 1u );
+        const u32 maxWorkers = std::min( hardwareThreads, k_max_job_workers );
+
+        Array(u32) results( k_jobs_item_count, *allocator );
+        for ( const JobsWorkload& workload : workloads ) {
+            f64 singleWorker = 0.0;
+            for ( u32 workers = 1; ; workers = std::min( workers * 2, maxWorkers ) ) {
+                JobSystemConfiguration configuration;
+                configuration.m_allocator = allocator;
+                configuration.m_workerCount = workers;
+                JobSystem jobSystem( configuration );
+
+                // Let the workers start before measuring.
+                MeasureWorkload( jobSystem, workload, results );
+                jobSystem.ResetStatistics();
+                const f64 milliseconds = MeasureWorkload( jobSystem, workload, results );
+
+                u64 executed = 0;
+                u64 stolen = 0;
+                for ( u32 i = 0; i < jobSystem.GetWorkerCount(); ++i ) {
+                    executed += jobSystem.m_workers[ i ].m_statistics.m_jobsExecuted.load( std::memory_order_relaxed );
+                    stolen += jobSystem.m_workers[ i ].m_statistics.m_jobsStolen.load( std::memory_order_relaxed );
+                }
+
+                if ( workers == 1 ) {
+                    singleWorker = milliseconds;
+                }
+                info( "Jobs {} {} workers: {:.2f} ms, speedup {:.2f}, {} jobs, {:.1f}% stolen", workload.m_name, workers, milliseconds,
+                      singleWorker / milliseconds, executed, executed ? 100.0 * stolen / executed : 0.0 );
+
+                if ( workers == maxWorkers ) {
+                    break;
+                }
+            }
+        }
+    }
+}
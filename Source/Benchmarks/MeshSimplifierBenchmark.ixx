@@ -0,0 +1,62 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+export module Benchmarks.MeshSimplifier;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.MeshSimplifier;
+import Foundation.Platform;
+import Foundation.Log;
+import Benchmarks.Meshes;
+
+export namespace Caustix {
+    // LOD chain generation time and the triangles and error of every level, for terrains of 32K to 512K triangles
+    // simplified with normal and uv aware error.
+    void RunMeshSimplifierBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    void RunMeshSimplifierBenchmark( Allocator* allocator ) {
+        BenchmarkMesh mesh( *allocator );
+        Array(u32) lodIndices( *allocator );
+
+        for ( u32 resolution = 128; resolution <= 512; resolution *= 2 ) {
+            GenerateTerrainMesh( resolution, mesh );
+            const u32 indexCount = ( u32 )mesh.m_indices.size();
+            const u32 triangleCount = indexCount / 3;
+
+            // Same weights and configuration as the demo.
+            const SimplifierAttribute attributes[] = {
+                { mesh.m_normals.data(), 3 * sizeof( f32 ), 3, 0.5f },
+                { mesh.m_uvs.data(), 2 * sizeof( f32 ), 2, 0.5f },
+            };
+
+            lodIndices.clear();
+            MeshLod lods[ k_max_mesh_lods ];
+            const auto start = std::chrono::high_resolution_clock::now();
+            const u32 lodCount = GenerateMeshLods( mesh.m_indices.data(), indexCount, mesh.m_positions.data(), mesh.m_vertexCount,
+                                                   attributes, ( u32 )std::size( attributes ), lodIndices, lods, allocator );
+            const f64 milliseconds = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+
+            // Every level but the first is simplified from the previous one.
+            u32 simplifiedTriangles = 0;
+            for ( u32 level = 0; level + 1 < lodCount; ++level ) {
+                simplifiedTriangles += lods[ level ].m_indexCount / 3;
+            }
+            info( "Simplifier {} triangles: {} levels in {:.2f} ms, {:.2f} M input triangles per second",
+                  triangleCount, lodCount, milliseconds, simplifiedTriangles / milliseconds / 1e3 );
+
+            for ( u32 level = 0; level < lodCount; ++level ) {
+                const u32 levelTriangles = lods[ level ].m_indexCount / 3;
+                info( "    level {}: {} triangles, {:.1f}% of level 0, error {:.5f}",
+                      level, levelTriangles, 100.0 * levelTriangles / triangleCount, lods[ level ].m_error );
+            }
+        }
+    }
+}
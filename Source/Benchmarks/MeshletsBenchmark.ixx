@@ -0,0 +1,101 @@
+module;
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "cglm/struct/cam.h"
+#include "cglm/struct/mat4.h"
+
+export module Benchmarks.Meshlets;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Meshlets;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+import Benchmarks.Meshes;
+
+export namespace Caustix {
+    // Meshlet build time on one thread and on the job system, with a check that both give the same clusters,
+    // and the time of the reference culler, for terrains of 128K to 2M triangles.
+    void RunMeshletsBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_meshlets_repetitions = 3;
+    static constexpr u32 k_cull_repetitions     = 10;
+
+    template <typename Func>
+    static f64 MeasureBestMilliseconds( u32 repetitions, Func&& func ) {
+        f64 best = 0.0;
+        for ( u32 repetition = 0; repetition < repetitions; ++repetition ) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            func();
+            const f64 milliseconds = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+            best = repetition == 0 ? milliseconds : std::min( best, milliseconds );
+        }
+        return best;
+    }
+
+    template <typename T>
+    static bool SameArrays( const Array(T)& a, const Array(T)& b ) {
+        return a.size() == b.size() && ( a.empty() || memcmp( a.data(), b.data(), a.size() * sizeof( T ) ) == 0 );
+    }
+
+    void RunMeshletsBenchmark( Allocator* allocator ) {
+        JobSystemConfiguration jobConfiguration;
+        jobConfiguration.m_allocator = allocator;
+        JobSystem jobSystem( jobConfiguration );
+
+        BenchmarkMesh mesh( *allocator );
+        MeshletMesh single( *allocator );
+        MeshletMesh parallel( *allocator );
+        Array(u32) visible( *allocator );
+
+        for ( u32 resolution = 256; resolution <= 1024; resolution *= 2 ) {
+            GenerateTerrainMesh( resolution, mesh );
+            const u32 indexCount = ( u32 )mesh.m_indices.size();
+            const u32 triangleCount = indexCount / 3;
+
+            const f64 singleTime = MeasureBestMilliseconds( k_meshlets_repetitions, [ & ]() {
+                single.Clear();
+                BuildMeshlets( mesh.m_indices.data(), indexCount, mesh.m_positions.data(), mesh.m_vertexCount, single );
+            } );
+            const f64 parallelTime = MeasureBestMilliseconds( k_meshlets_repetitions, [ & ]() {
+                parallel.Clear();
+                BuildMeshlets( mesh.m_indices.data(), indexCount, mesh.m_positions.data(), mesh.m_vertexCount, parallel, &jobSystem );
+            } );
+
+            if ( !SameArrays( single.m_meshlets, parallel.m_meshlets ) || !SameArrays( single.m_vertices, parallel.m_vertices ) ||
+                 !SameArrays( single.m_triangles, parallel.m_triangles ) ) {
+                error( "Meshlets of {} triangles differ between one thread and the job system", triangleCount );
+            }
+
+            const u32 meshletCount = ( u32 )single.m_meshlets.size();
+            info( "Meshlets {} triangles: build {:.2f} ms on one thread, {:.2f} ms on {} workers, {} meshlets of {:.1f} vertices and {:.1f} triangles",
+                  triangleCount, singleTime, parallelTime, jobSystem.GetWorkerCount(), meshletCount,
+                  ( f64 )single.m_vertices.size() / meshletCount, ( f64 )triangleCount / meshletCount );
+
+            // Camera low over the terrain looking across it: the clusters behind and to the sides are outside the frustum
+            // and the slopes facing away are cone culled.
+            const vec3s eye = { 0.0f, 0.25f, 0.5f };
+            const mat4s view = glms_lookat( eye, vec3s{ 0.0f, 0.0f, -0.5f }, vec3s{ 0.0f, 1.0f, 0.0f } );
+            const mat4s viewProjection = glms_mat4_mul( glms_perspective( glm_rad( 60.0f ), 16.0f / 9.0f, 0.01f, 100.0f ), view );
+            FrustumPlanes planes;
+            ExtractFrustumPlanes( ( const f32* )viewProjection.raw, planes );
+
+            visible.resize( meshletCount );
+            u32 visibleCount = 0;
+            const f64 cullTime = MeasureBestMilliseconds( k_cull_repetitions, [ & ]() {
+                visibleCount = CullMeshlets( single, 0, meshletCount, planes, eye.raw, visible.data() );
+            } );
+            info( "Meshlets {} triangles: cull {:.3f} ms, {:.1f} ns per meshlet, {} of {} visible",
+                  triangleCount, cullTime, cullTime * 1e6 / meshletCount, visibleCount, meshletCount );
+        }
+    }
+}
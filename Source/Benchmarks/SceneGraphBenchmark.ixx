@@ -0,0 +1,184 @@
+module;
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+export module Benchmarks.SceneGraph;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.SceneGraph;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // SceneGraph on a 1M node hierarchy: building it, then updating it after changing one leaf, a growing share of
+    // random nodes and every root, against walking up the parents of every node like the scene setup did before.
+    void RunSceneGraphBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_scene_graph_bench_nodes          = 1 << 20;
+    static constexpr u32 k_scene_graph_bench_roots          = 16;
+    static constexpr u32 k_scene_graph_bench_repetitions    = 5;
+
+    // Same numbers on every run.
+    static u32 NextSceneGraphRandom( u32& state ) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // Rotation around z and a translation, column major.
+    static void MakeNodeMatrix( f32 angle, f32 x, f32 y, f32 z, f32* matrix ) {
+        const f32 c = cosf( angle );
+        const f32 s = sinf( angle );
+        const f32 values[ 16 ] = { c, s, 0.0f, 0.0f,
+                                   -s, c, 0.0f, 0.0f,
+                                   0.0f, 0.0f, 1.0f, 0.0f,
+                                   x, y, z, 1.0f };
+        std::copy( values, values + 16, matrix );
+    }
+
+    static void MultiplyReference( const f32* a, const f32* b, f32* result ) {
+        for ( u32 column = 0; column < 4; ++column ) {
+            for ( u32 row = 0; row < 4; ++row ) {
+                result[ column * 4 + row ] = a[ row ] * b[ column * 4 + 0 ] + a[ 4 + row ] * b[ column * 4 + 1 ]
+                                           + a[ 8 + row ] * b[ column * 4 + 2 ] + a[ 12 + row ] * b[ column * 4 + 3 ];
+            }
+        }
+    }
+
+    // What the scene setup did before the scene graph: every node walks up its parents, O(depth) multiplies each.
+    static void ComputeWorldByParentWalk( const u32* parents, const f32* localMatrices, u32 nodeCount, f32* worldMatrices ) {
+        for ( u32 node = 0; node < nodeCount; ++node ) {
+            f32 world[ 16 ];
+            f32 product[ 16 ];
+            std::copy( localMatrices + ( sizet )node * 16, localMatrices + ( sizet )node * 16 + 16, world );
+            for ( u32 parent = parents[ node ]; parent != k_scene_graph_root; parent = parents[ parent ] ) {
+                MultiplyReference( localMatrices + ( sizet )parent * 16, world, product );
+                std::copy( product, product + 16, world );
+            }
+            std::copy( world, world + 16, worldMatrices + ( sizet )node * 16 );
+        }
+    }
+
+    template <typename Func>
+    static f64 MeasureSceneGraph( Func&& func ) {
+        f64 best = 0.0;
+        for ( u32 repetition = 0; repetition < k_scene_graph_bench_repetitions; ++repetition ) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            func( repetition );
+            const f64 milliseconds = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+            best = repetition == 0 ? milliseconds : std::min( best, milliseconds );
+        }
+        return best;
+    }
+
+    // The products are not grouped the same way, only close values are expected.
+    static bool SameWorldMatrices( const SceneGraph& sceneGraph, const Array(f32)& worldMatrices ) {
+        for ( u32 node = 0; node < sceneGraph.m_nodeCount; ++node ) {
+            const f32* world = sceneGraph.GetWorldMatrix( node );
+            for ( u32 i = 0; i < 16; ++i ) {
+                const f32 expected = worldMatrices[ ( sizet )node * 16 + i ];
+                if ( fabsf( world[ i ] - expected ) > 1e-3f * std::max( 1.0f, fabsf( expected ) ) ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Changes the local matrix of every node given then updates, the work of a frame with these nodes animated.
+    static void BenchmarkUpdate( cstring name, SceneGraph& sceneGraph, const Array(u32)& nodes, const f32* localMatrices ) {
+        u32 updated = 0;
+        const f64 time = MeasureSceneGraph( [ & ]( u32 repetition ) {
+            // A different matrix every repetition, the node really changes.
+            const f32 angle = 0.01f * ( repetition + 1 );
+            f32 matrix[ 16 ];
+            for ( const u32 node : nodes ) {
+                const f32* local = localMatrices + ( sizet )node * 16;
+                MakeNodeMatrix( angle, local[ 12 ], local[ 13 ], local[ 14 ], matrix );
+                sceneGraph.SetLocalMatrix( node, matrix );
+            }
+            updated = sceneGraph.Update();
+        } );
+        info( "Scene graph {} nodes, {}: {} changed, {} world matrices computed, {:.3f} ms", sceneGraph.m_nodeCount, name, nodes.size(), updated, time );
+    }
+
+    void RunSceneGraphBenchmark( Allocator* allocator ) {
+        // A random tree, every node hangs under an earlier one, a few dozen levels at most like large levels.
+        Array(u32) parents( k_scene_graph_bench_nodes, *allocator );
+        Array(f32) localMatrices( ( sizet )k_scene_graph_bench_nodes * 16, *allocator );
+        u32 state = 1;
+        for ( u32 node = 0; node < k_scene_graph_bench_nodes; ++node ) {
+            parents[ node ] = node < k_scene_graph_bench_roots ? k_scene_graph_root : NextSceneGraphRandom( state ) % node;
+            const f32 x = ( NextSceneGraphRandom( state ) % 1024 ) / 256.0f - 2.0f;
+            const f32 y = ( NextSceneGraphRandom( state ) % 1024 ) / 256.0f - 2.0f;
+            const f32 z = ( NextSceneGraphRandom( state ) % 1024 ) / 256.0f - 2.0f;
+            MakeNodeMatrix( ( NextSceneGraphRandom( state ) % 628 ) / 100.0f, x, y, z, &localMatrices[ ( sizet )node * 16 ] );
+        }
+
+        Array(f32) referenceWorld( ( sizet )k_scene_graph_bench_nodes * 16, *allocator );
+        const f64 walkTime = MeasureSceneGraph( [ & ]( u32 ) {
+            ComputeWorldByParentWalk( parents.data(), localMatrices.data(), k_scene_graph_bench_nodes, referenceWorld.data() );
+        } );
+
+        SceneGraph sceneGraph( *allocator );
+        const f64 buildTime = MeasureSceneGraph( [ & ]( u32 ) {
+            sceneGraph.Build( parents.data(), localMatrices.data(), k_scene_graph_bench_nodes );
+        } );
+        if ( !SameWorldMatrices( sceneGraph, referenceWorld ) ) {
+            error( "Scene graph benchmark: world matrices differ from the parent walk" );
+            return;
+        }
+
+        u32 maxDepth = 0;
+        for ( u32 node = 0; node < k_scene_graph_bench_nodes; ++node ) {
+            u32 depth = 0;
+            for ( u32 parent = parents[ node ]; parent != k_scene_graph_root; parent = parents[ parent ] ) {
+                ++depth;
+            }
+            maxDepth = std::max( maxDepth, depth );
+        }
+        info( "Scene graph {} nodes, {} levels: parent walk {:.1f} ms, Build {:.1f} ms", k_scene_graph_bench_nodes, maxDepth + 1, walkTime, buildTime );
+
+        Array(u32) nodes( *allocator );
+        BenchmarkUpdate( "nothing changed", sceneGraph, nodes, localMatrices.data() );
+
+        nodes.push_back( k_scene_graph_bench_nodes - 1 );
+        BenchmarkUpdate( "one leaf", sceneGraph, nodes, localMatrices.data() );
+
+        // Random nodes, the ones under a changed ancestor are covered by its subtree.
+        const u32 changedCounts[] = { k_scene_graph_bench_nodes / 1000, k_scene_graph_bench_nodes / 100, k_scene_graph_bench_nodes / 10 };
+        for ( const u32 changedCount : changedCounts ) {
+            nodes.clear();
+            for ( u32 i = 0; i < changedCount; ++i ) {
+                nodes.push_back( NextSceneGraphRandom( state ) % k_scene_graph_bench_nodes );
+            }
+            std::sort( nodes.begin(), nodes.end() );
+            nodes.erase( std::unique( nodes.begin(), nodes.end() ), nodes.end() );
+            BenchmarkUpdate( "random nodes", sceneGraph, nodes, localMatrices.data() );
+        }
+
+        nodes.clear();
+        for ( u32 root = 0; root < k_scene_graph_bench_roots; ++root ) {
+            nodes.push_back( root );
+        }
+        BenchmarkUpdate( "every root", sceneGraph, nodes, localMatrices.data() );
+
+        // The roots were changed last, the walk over the new local matrices must give the same world matrices.
+        Array(f32) currentLocal( ( sizet )k_scene_graph_bench_nodes * 16, *allocator );
+        for ( u32 node = 0; node < k_scene_graph_bench_nodes; ++node ) {
+            const f32* local = sceneGraph.GetLocalMatrix( node );
+            std::copy( local, local + 16, &currentLocal[ ( sizet )node * 16 ] );
+        }
+        ComputeWorldByParentWalk( parents.data(), currentLocal.data(), k_scene_graph_bench_nodes, referenceWorld.data() );
+        if ( !SameWorldMatrices( sceneGraph, referenceWorld ) ) {
+            error( "Scene graph benchmark: world matrices differ from the parent walk after the updates" );
+        }
+    }
+}
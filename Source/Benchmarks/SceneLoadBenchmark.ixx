@@ -0,0 +1,238 @@
+module;
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+export module Benchmarks.SceneLoad;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.LinearAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.CookedScene;
+import Foundation.Blob;
+import Foundation.File;
+import Foundation.glTF;
+import Foundation.GeometryImport;
+import Foundation.TangentSpace;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Time to get a scene ready for the GPU upload from its glTF file and from the file cooked by the Cooker.
+    // The glTF path parses the JSON, decodes every primitive and image and generates the missing normals, the cooked path
+    // maps the blob. Both then read every byte the upload would copy. The upload itself is the same for both and left out.
+    void RunSceneLoadBenchmark( cstring gltfPath, cstring cookedPath, Allocator* allocator, LinearAllocator* scratchAllocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_scene_load_repetitions = 3;
+
+    // Stands in for the copy to the staging buffers.
+    static u64 ReadBytes( const u8* data, sizet size ) {
+        u64 sum = 0;
+        sizet i = 0;
+        for ( ; i + sizeof( u64 ) <= size; i += sizeof( u64 ) ) {
+            u64 value;
+            memcpy( &value, data + i, sizeof( u64 ) );
+            sum += value;
+        }
+        for ( ; i < size; ++i ) {
+            sum += data[ i ];
+        }
+        return sum;
+    }
+
+    static bool LoadGltfPrimitive( const glTF::glTF& scene, const u8* const* buffers, const glTF::MeshPrimitive& meshPrimitive,
+                                   Allocator* allocator, JobSystem* jobSystem, u64& checksum ) {
+        const i32 positionIndex = gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "POSITION" );
+        const i32 tangentIndex = gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "TANGENT" );
+        const i32 normalIndex = gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "NORMAL" );
+        const i32 texcoordIndex = gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "TEXCOORD_0" );
+        if ( positionIndex == -1 || meshPrimitive.indices == glTF::INVALID_INT_VALUE ) {
+            return false;
+        }
+
+        // Same float streams as the demo.
+        const u32 vertexCount = scene.accessors[ positionIndex ].count;
+        const u32 indexCount = scene.accessors[ meshPrimitive.indices ].count;
+        const sizet positionSize = vertexCount * 3 * sizeof( f32 );
+        const sizet tangentSize = tangentIndex != -1 ? vertexCount * 4 * sizeof( f32 ) : 0;
+        const sizet normalSize = vertexCount * 3 * sizeof( f32 );
+        const sizet texcoordSize = texcoordIndex != -1 ? vertexCount * 2 * sizeof( f32 ) : 0;
+        const sizet vertexSize = positionSize + tangentSize + normalSize + texcoordSize;
+
+        u8* vertexData = callocaa<u8>( vertexSize, allocator );
+        u32* indexData = callocaa<u32>( indexCount, allocator );
+        f32* positions = ( f32* )vertexData;
+        f32* tangents = ( f32* )( vertexData + positionSize );
+        f32* normals = ( f32* )( vertexData + positionSize + tangentSize );
+        f32* texcoords = ( f32* )( vertexData + positionSize + tangentSize + normalSize );
+
+        bool decoded = DecodeAccessor( scene, buffers, positionIndex, positions, 3, 3 * sizeof( f32 ), jobSystem );
+        if ( tangentIndex != -1 ) {
+            decoded &= DecodeAccessor( scene, buffers, tangentIndex, tangents, 4, 4 * sizeof( f32 ), jobSystem );
+        }
+        if ( normalIndex != -1 ) {
+            decoded &= DecodeAccessor( scene, buffers, normalIndex, normals, 3, 3 * sizeof( f32 ), jobSystem );
+        }
+        if ( texcoordIndex != -1 ) {
+            decoded &= DecodeAccessor( scene, buffers, texcoordIndex, texcoords, 2, 2 * sizeof( f32 ), jobSystem );
+        }
+        decoded &= DecodeIndices( scene, buffers, meshPrimitive.indices, indexData, jobSystem );
+        if ( decoded && normalIndex == -1 ) {
+            decoded = GenerateNormals( positions, vertexCount, indexData, indexCount, normals, allocator, jobSystem );
+        }
+
+        if ( decoded ) {
+            checksum += ReadBytes( vertexData, vertexSize ) + ReadBytes( ( const u8* )indexData, indexCount * sizeof( u32 ) );
+        }
+        cfree( vertexData, allocator );
+        cfree( indexData, allocator );
+        return decoded;
+    }
+
+    // Relative uris are resolved from the working directory, already the folder of the glTF file.
+    static bool DecodeGltfScene( cstring gltfFile, Allocator* allocator, LinearAllocator* scratchAllocator, JobSystem* jobSystem, u64& checksum ) {
+        glTF::glTF scene = gltfLoadFile( gltfFile, scratchAllocator );
+        if ( scene.meshes_count == 0 ) {
+            return false;
+        }
+
+        Array(MappedFile) bufferFiles( *allocator );
+        bufferFiles.reserve( scene.buffers_count );
+        Array(const u8*) buffers( *allocator );
+        for ( u32 bufferIndex = 0; bufferIndex < scene.buffers_count; ++bufferIndex ) {
+            glTF::Buffer& buffer = scene.buffers[ bufferIndex ];
+            if ( buffer.data ) {
+                buffers.push_back( buffer.data );
+                continue;
+            }
+
+            MappedFile& bufferFile = bufferFiles.emplace_back();
+            if ( !bufferFile.Open( buffer.uri.data(), FileAccessHint::WillNeed ) || buffer.byte_length == glTF::INVALID_INT_VALUE ||
+                 bufferFile.m_size < ( sizet )buffer.byte_length ) {
+                error( "Scene load benchmark: cannot open buffer {}", buffer.uri.data() );
+                return false;
+            }
+            buffers.push_back( bufferFile.m_data );
+        }
+
+        // Once per mesh, the demo decodes them again for every node using them.
+        bool loaded = true;
+        for ( u32 meshIndex = 0; meshIndex < scene.meshes_count; ++meshIndex ) {
+            const glTF::Mesh& mesh = scene.meshes[ meshIndex ];
+            for ( u32 primitiveIndex = 0; primitiveIndex < mesh.primitives_count; ++primitiveIndex ) {
+                loaded &= LoadGltfPrimitive( scene, buffers.data(), mesh.primitives[ primitiveIndex ], allocator, jobSystem, checksum );
+            }
+        }
+
+        for ( u32 imageIndex = 0; imageIndex < scene.images_count; ++imageIndex ) {
+            const glTF::Image& image = scene.images[ imageIndex ];
+
+            i32 width = 0, height = 0, components = 0;
+            u8* pixels = nullptr;
+            if ( image.data ) {
+                pixels = stbi_load_from_memory( image.data, ( i32 )image.data_size, &width, &height, &components, 4 );
+            } else if ( image.buffer_view != glTF::INVALID_INT_VALUE && image.uri.empty() ) {
+                const glTF::BufferView& bufferView = scene.buffer_views[ image.buffer_view ];
+                const u8* data = buffers[ bufferView.buffer ] + glTF::GetDataOffset( 0, bufferView.byte_offset );
+                pixels = stbi_load_from_memory( data, bufferView.byte_length, &width, &height, &components, 4 );
+            } else {
+                pixels = stbi_load( image.uri.data(), &width, &height, &components, 4 );
+            }
+
+            if ( pixels == nullptr ) {
+                loaded = false;
+                continue;
+            }
+            checksum += ReadBytes( pixels, ( sizet )width * height * 4 );
+            stbi_image_free( pixels );
+        }
+        return loaded;
+    }
+
+    static bool LoadGltfScene( cstring gltfFile, Allocator* allocator, LinearAllocator* scratchAllocator, JobSystem* jobSystem, u64& checksum ) {
+        const bool loaded = DecodeGltfScene( gltfFile, allocator, scratchAllocator, jobSystem, checksum );
+        // Everything of the scene lives in the scratch allocator.
+        scratchAllocator->Clear();
+        return loaded;
+    }
+
+    static bool LoadCookedScene( cstring cookedPath, Allocator* allocator, u64& checksum ) {
+        MappedFile file;
+        if ( !file.Open( cookedPath, FileAccessHint::WillNeed ) ) {
+            return false;
+        }
+
+        BlobSerializer serializer;
+        const CookedScene* scene = serializer.Map<CookedScene>( file, k_cooked_scene_version, allocator, file.m_size * 2 );
+        if ( scene == nullptr ) {
+            return false;
+        }
+
+        checksum += ReadBytes( scene->m_vertexData.Get(), scene->m_vertexData.m_size );
+        checksum += ReadBytes( scene->m_indexData.Get(), scene->m_indexData.m_size );
+        for ( const CookedTexture& texture : scene->m_textures ) {
+            checksum += ReadBytes( texture.m_pixels.Get(), texture.m_pixels.m_size );
+        }
+
+        serializer.Shutdown();
+        return true;
+    }
+
+    void RunSceneLoadBenchmark( cstring gltfPath, cstring cookedPath, Allocator* allocator, LinearAllocator* scratchAllocator ) {
+        const std::filesystem::path absoluteGltf = std::filesystem::absolute( gltfPath );
+        const std::string absoluteCooked = std::filesystem::absolute( cookedPath ).string();
+        const std::string gltfFile = absoluteGltf.filename().string();
+
+        const auto cwd = std::filesystem::current_path();
+        std::filesystem::current_path( absoluteGltf.parent_path() );
+
+        JobSystemConfiguration jobConfiguration;
+        jobConfiguration.m_allocator = allocator;
+        JobSystem jobSystem( jobConfiguration );
+
+        // The first run of each path reads the files from disk unless they are in the OS cache already.
+        f64 gltfFirst = 0.0, gltfBest = 0.0, cookedFirst = 0.0, cookedBest = 0.0;
+        u64 gltfChecksum = 0, cookedChecksum = 0;
+        bool loaded = true;
+        for ( u32 repetition = 0; repetition < k_scene_load_repetitions && loaded; ++repetition ) {
+            auto start = std::chrono::high_resolution_clock::now();
+            loaded &= LoadGltfScene( gltfFile.c_str(), allocator, scratchAllocator, &jobSystem, gltfChecksum );
+            const f64 gltfTime = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+
+            start = std::chrono::high_resolution_clock::now();
+            loaded &= LoadCookedScene( absoluteCooked.c_str(), allocator, cookedChecksum );
+            const f64 cookedTime = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+
+            gltfFirst = repetition == 0 ? gltfTime : gltfFirst;
+            cookedFirst = repetition == 0 ? cookedTime : cookedFirst;
+            gltfBest = repetition == 0 ? gltfTime : std::min( gltfBest, gltfTime );
+            cookedBest = repetition == 0 ? cookedTime : std::min( cookedBest, cookedTime );
+        }
+
+        std::filesystem::current_path( cwd );
+
+        // Keeps the reads from being optimized away.
+        static volatile u64 s_checksum;
+        s_checksum = gltfChecksum + cookedChecksum;
+
+        if ( !loaded ) {
+            error( "Scene load benchmark: cannot load {} or {}, cook it first with the Cooker", gltfPath, cookedPath );
+            return;
+        }
+        info( "Scene load glTF: {:.2f} ms first, {:.2f} ms best", gltfFirst, gltfBest );
+        info( "Scene load cooked: {:.2f} ms first, {:.2f} ms best, {:.1f}x faster", cookedFirst, cookedBest, gltfBest / cookedBest );
+    }
+}
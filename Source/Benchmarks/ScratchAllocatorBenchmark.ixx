@@ -0,0 +1,105 @@
+module;
+
+#include <string.h>
+
+#include <chrono>
+
+export module Benchmarks.ScratchAllocator;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.LinearAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Memory.VirtualMemory;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Committed and resident memory of the fixed size scratch allocator against the reserve/commit one,
+    // over light frames, a spike frame and light frames again.
+    void RunScratchAllocatorBenchmark();
+}
+
+namespace Caustix {
+    static constexpr sizet k_scratch_size          = cmega( 512 );
+    static constexpr sizet k_scratch_light_frame   = cmega( 2 );
+    static constexpr sizet k_scratch_spike_frame   = cmega( 384 );
+    static constexpr sizet k_scratch_chunk_size    = ckilo( 64 );
+    static constexpr u32   k_scratch_light_frames  = 60;
+
+    struct ScratchMeasure {
+        sizet       m_committed     = 0;
+        sizet       m_resident      = 0;
+    };
+
+    // Allocates and writes a frame worth of scratch memory, the caller rewinds. Returns the time in milliseconds.
+    static f64 RunFrame( LinearAllocator& scratch, sizet frameSize ) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for ( sizet allocated = 0; allocated < frameSize; allocated += k_scratch_chunk_size ) {
+            void* chunk = scratch.allocate( k_scratch_chunk_size, 16 );
+            if ( chunk == nullptr ) {
+                error( "Scratch benchmark ran out of memory at {} bytes", allocated );
+                break;
+            }
+            memset( chunk, 1, k_scratch_chunk_size );
+        }
+        return std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+    }
+
+    static ScratchMeasure Measure( const LinearAllocator& scratch, sizet baseResident ) {
+        ScratchMeasure measure;
+        // A malloc'ed block is committed as a whole, only the virtual mode commits on demand.
+        measure.m_committed = scratch.m_virtual ? scratch.m_committedSize : scratch.m_totalSize;
+        const sizet resident = VirtualMemoryResidentSize();
+        measure.m_resident = resident > baseResident ? resident - baseResident : 0;
+        return measure;
+    }
+
+    static void BenchmarkScratch( cstring name, LinearAllocator& scratch, sizet baseResident ) {
+        // Measured at the end of the last frame of each phase, before the rewind.
+        ScratchMeasure light;
+        f64 lightTime = 0.0;
+        for ( u32 i = 0; i < k_scratch_light_frames; ++i ) {
+            lightTime += RunFrame( scratch, k_scratch_light_frame );
+            light = Measure( scratch, baseResident );
+            scratch.Clear();
+        }
+
+        const f64 spikeTime = RunFrame( scratch, k_scratch_spike_frame );
+        const ScratchMeasure spike = Measure( scratch, baseResident );
+        scratch.Clear();
+
+        // Pages stay committed after the spike unless the allocator decommits on Clear.
+        ScratchMeasure after;
+        f64 afterTime = 0.0;
+        for ( u32 i = 0; i < k_scratch_light_frames; ++i ) {
+            afterTime += RunFrame( scratch, k_scratch_light_frame );
+            after = Measure( scratch, baseResident );
+            scratch.Clear();
+        }
+
+        const f64 mega = 1024.0 * 1024.0;
+        info( "Scratch {}: light frames {:.3f} ms committed {:.1f} MB resident {:.1f} MB, spike {:.2f} ms committed {:.1f} MB resident {:.1f} MB, after {:.3f} ms committed {:.1f} MB resident {:.1f} MB",
+              name, lightTime / k_scratch_light_frames, light.m_committed / mega, light.m_resident / mega,
+              spikeTime, spike.m_committed / mega, spike.m_resident / mega,
+              afterTime / k_scratch_light_frames, after.m_committed / mega, after.m_resident / mega );
+    }
+
+    void RunScratchAllocatorBenchmark() {
+        // Each allocator is released before the next one, resident sizes are relative to the process before its creation.
+        {
+            const sizet baseResident = VirtualMemoryResidentSize();
+            LinearAllocator scratch( k_scratch_size );
+            BenchmarkScratch( "fixed", scratch, baseResident );
+        }
+        {
+            const sizet baseResident = VirtualMemoryResidentSize();
+            LinearAllocator scratch( VirtualAllocatorConfiguration{ k_scratch_size, k_scratch_chunk_size, false } );
+            BenchmarkScratch( "virtual", scratch, baseResident );
+        }
+        {
+            const sizet baseResident = VirtualMemoryResidentSize();
+            LinearAllocator scratch( VirtualAllocatorConfiguration{ k_scratch_size, k_scratch_chunk_size, true } );
+            BenchmarkScratch( "virtual decommit", scratch, baseResident );
+        }
+    }
+}
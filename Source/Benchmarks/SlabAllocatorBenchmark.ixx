@@ -0,0 +1,117 @@
+module;
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+export module Benchmarks.SlabAllocator;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.HeapAllocator;
+import Foundation.Memory.Allocators.SlabAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Slab allocator against the heap on a mixed trace of small object allocations and frees, from 1 to 8 threads.
+    void RunSlabAllocatorBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_slab_bench_max_threads   = 8;
+    static constexpr u32 k_slab_bench_live_blocks   = 4096;     // Slots of each thread, about half of them allocated.
+    static constexpr u32 k_slab_bench_operations    = 1 << 20;
+
+    static u32 NextSlabRandom( u32& state ) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Mostly map nodes and queue entries, a few larger objects up to the biggest class.
+    static sizet GetTraceSize( u32 random ) {
+        const u32 bucket = random % 100;
+        const u32 bits = random >> 8;
+        if ( bucket < 70 ) {
+            return 16 + bits % 49;
+        }
+        if ( bucket < 95 ) {
+            return 64 + bits % 193;
+        }
+        return 256 + bits % 769;
+    }
+
+    // Nanoseconds per operation of a thread, each operation allocating an empty slot or freeing a full one.
+    static f64 MeasureTrace( Allocator& allocator, u32 threadCount, Allocator* arrayAllocator ) {
+        std::atomic<u32> ready{ 0 };
+        std::atomic<bool> start{ false };
+
+        auto worker = [ & ]( u32 threadIndex ) {
+            void* blocks[ k_slab_bench_live_blocks ] = {};
+            u32 state = 0x2545F491u * ( threadIndex + 1 );
+
+            ready.fetch_add( 1, std::memory_order_acq_rel );
+            while ( !start.load( std::memory_order_acquire ) ) {
+                std::this_thread::yield();
+            }
+
+            for ( u32 i = 0; i < k_slab_bench_operations; ++i ) {
+                const u32 random = NextSlabRandom( state );
+                void*& block = blocks[ random % k_slab_bench_live_blocks ];
+                if ( block ) {
+                    allocator.deallocate( block );
+                    block = nullptr;
+                } else {
+                    block = allocator.allocate( GetTraceSize( NextSlabRandom( state ) ), 8 );
+                    *( u8* )block = ( u8 )i;
+                }
+            }
+
+            for ( void* block : blocks ) {
+                allocator.deallocate( block );
+            }
+        };
+
+        Array(std::thread) threads( *arrayAllocator );
+        threads.reserve( threadCount );
+        for ( u32 i = 0; i < threadCount; ++i ) {
+            threads.emplace_back( worker, i );
+        }
+        while ( ready.load( std::memory_order_acquire ) != threadCount ) {
+            std::this_thread::yield();
+        }
+
+        const auto begin = std::chrono::high_resolution_clock::now();
+        start.store( true, std::memory_order_release );
+        for ( std::thread& thread : threads ) {
+            thread.join();
+        }
+        const f64 nanoseconds = std::chrono::duration<f64, std::nano>( std::chrono::high_resolution_clock::now() - begin ).count();
+
+        // Threads run the trace side by side, so the wall time is what a single thread paid per operation.
+        return nanoseconds / k_slab_bench_operations;
+    }
+
+    void RunSlabAllocatorBenchmark( Allocator* allocator ) {
+        // Configured like the memory service ones: slab magazines and heap arenas for every thread.
+        HeapAllocator heap( HeapAllocatorConfiguration{ cmega( 64 ), k_slab_bench_max_threads, cmega( 64 ) } );
+        SlabAllocator slab( SlabAllocatorConfiguration{ cgiga( 1 ), k_slab_bench_max_threads, &heap } );
+
+        for ( u32 threadCount = 1; threadCount <= k_slab_bench_max_threads; threadCount *= 2 ) {
+            const f64 heapTime = MeasureTrace( heap, threadCount, allocator );
+            const f64 slabTime = MeasureTrace( slab, threadCount, allocator );
+
+            u32 slabCount = 0;
+            for ( const SlabClass& slabClass : slab.m_classes ) {
+                slabCount += slabClass.m_slabCount;
+            }
+            info( "Slab {} threads: heap {:.1f} ns, slab {:.1f} ns per operation ({:.2f}x), {} slabs committed", threadCount, heapTime, slabTime,
+                  heapTime / slabTime, slabCount );
+        }
+    }
+}
@@ -0,0 +1,101 @@
+module;
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+export module Benchmarks.TangentSpace;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.TangentSpace;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+import Benchmarks.Meshes;
+
+export namespace Caustix {
+    // Normal and tangent generation on a terrain of 10M triangles, on the calling thread and on 1, 2, 4... workers,
+    // checking that every run gives the same bits as the calling thread alone.
+    void RunTangentSpaceBenchmark( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_tangent_bench_resolution     = 2237;     // 2 * 2237^2, just over 10M triangles.
+    static constexpr u32 k_tangent_bench_repetitions    = 3;
+
+    template <typename Func>
+    static f64 MeasureTangentSpace( Func&& func ) {
+        f64 best = 0.0;
+        for ( u32 repetition = 0; repetition < k_tangent_bench_repetitions; ++repetition ) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            func();
+            const f64 milliseconds = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+            best = repetition == 0 ? milliseconds : std::min( best, milliseconds );
+        }
+        return best;
+    }
+
+    static bool SameBits( const Array(f32)& a, const Array(f32)& b ) {
+        return a.size() == b.size() && memcmp( a.data(), b.data(), a.size() * sizeof( f32 ) ) == 0;
+    }
+
+    void RunTangentSpaceBenchmark( Allocator* allocator ) {
+        BenchmarkMesh mesh( *allocator );
+        GenerateTerrainMesh( k_tangent_bench_resolution, mesh );
+        const u32 indexCount = ( u32 )mesh.m_indices.size();
+        const u32 triangleCount = indexCount / 3;
+
+        // The calling thread alone is the reference every job system run is compared with.
+        Array(f32) referenceNormals( mesh.m_vertexCount * 3, *allocator );
+        Array(f32) referenceTangents( mesh.m_vertexCount * 4, *allocator );
+        Array(f32) normals( mesh.m_vertexCount * 3, *allocator );
+        Array(f32) tangents( mesh.m_vertexCount * 4, *allocator );
+
+        bool generated = true;
+        const f64 normalsSingle = MeasureTangentSpace( [ & ]() {
+            generated &= GenerateNormals( mesh.m_positions.data(), mesh.m_vertexCount, mesh.m_indices.data(), indexCount, referenceNormals.data(), allocator );
+        } );
+        const f64 tangentsSingle = MeasureTangentSpace( [ & ]() {
+            generated &= GenerateTangents( mesh.m_positions.data(), referenceNormals.data(), mesh.m_uvs.data(), mesh.m_vertexCount, mesh.m_indices.data(),
+                                           indexCount, referenceTangents.data(), allocator );
+        } );
+        if ( !generated ) {
+            error( "Tangent space benchmark: generation failed on {} triangles", triangleCount );
+            return;
+        }
+        info( "Tangent space {} triangles, calling thread: normals {:.1f} ms, tangents {:.1f} ms", triangleCount, normalsSingle, tangentsSingle );
+
+        const u32 hardwareThreads = std::max( std::thread::hardware_concurrency(), 1u );
+        const u32 maxWorkers = std::min( hardwareThreads, k_max_job_workers );
+        for ( u32 workers = 1; ; workers = std::min( workers * 2, maxWorkers ) ) {
+            JobSystemConfiguration configuration;
+            configuration.m_allocator = allocator;
+            configuration.m_workerCount = workers;
+            JobSystem jobSystem( configuration );
+
+            const f64 normalsTime = MeasureTangentSpace( [ & ]() {
+                generated &= GenerateNormals( mesh.m_positions.data(), mesh.m_vertexCount, mesh.m_indices.data(), indexCount, normals.data(), allocator, &jobSystem );
+            } );
+            const f64 tangentsTime = MeasureTangentSpace( [ & ]() {
+                generated &= GenerateTangents( mesh.m_positions.data(), referenceNormals.data(), mesh.m_uvs.data(), mesh.m_vertexCount, mesh.m_indices.data(),
+                                               indexCount, tangents.data(), allocator, &jobSystem );
+            } );
+
+            if ( !generated || !SameBits( normals, referenceNormals ) || !SameBits( tangents, referenceTangents ) ) {
+                error( "Tangent space benchmark: {} workers differ from the calling thread", workers );
+            }
+            info( "Tangent space {} triangles, {} workers: normals {:.1f} ms ({:.2f}x), tangents {:.1f} ms ({:.2f}x), {:.1f} Mtriangles/s",
+                  triangleCount, workers, normalsTime, normalsSingle / normalsTime, tangentsTime, tangentsSingle / tangentsTime,
+                  triangleCount / ( normalsTime + tangentsTime ) * 1e-3 );
+
+            if ( workers == maxWorkers ) {
+                break;
+            }
+        }
+    }
+}
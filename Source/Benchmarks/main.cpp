@@ -0,0 +1,99 @@
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+import Benchmarks.Base64;
+import Benchmarks.FileLoad;
+import Benchmarks.FlatHashMap;
+import Benchmarks.GeometryImport;
+import Benchmarks.GltfParse;
+import Benchmarks.HeapAllocator;
+import Benchmarks.IoService;
+import Benchmarks.Jobs;
+import Benchmarks.Meshlets;
+import Benchmarks.MeshSimplifier;
+import Benchmarks.SceneGraph;
+import Benchmarks.ScratchAllocator;
+import Benchmarks.SlabAllocator;
+import Benchmarks.TangentSpace;
+import Benchmarks.SceneLoad;
+
+import Foundation.Services.MemoryService;
+import Foundation.Services.ServiceManager;
+import Foundation.Memory.MemoryDefines;
+import Foundation.CookedScene;
+import Foundation.Platform;
+import Foundation.Log;
+
+// Without arguments every benchmark runs, otherwise only the one named by the first argument.
+// The scene benchmark needs a glTF file and only runs when named.
+static bool IsSelected(int argc, char **argv, const char* name) {
+    return argc < 2 || strcmp(argv[1], name) == 0;
+}
+
+int main(int argc, char **argv) {
+    using namespace Caustix;
+
+    // Jobs can allocate from any worker, so the shared allocators get an arena per worker.
+    const u32 workerCount = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+    MemoryServiceConfiguration memoryConfiguration;
+    memoryConfiguration.m_systemThreadArenas = workerCount;
+    memoryConfiguration.m_smallObjectsThreadMagazines = workerCount;
+    ServiceManager::GetInstance()->AddService(MemoryService::Create(memoryConfiguration), MemoryService::m_name);
+    MemoryService* memoryService = ServiceManager::GetInstance()->Get<MemoryService>();
+
+    if (IsSelected(argc, argv, "base64")) {
+        RunBase64Benchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "file")) {
+        RunFileLoadBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "hashmap")) {
+        RunFlatHashMapBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "geometry")) {
+        RunGeometryImportBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "gltf")) {
+        RunGltfParseBenchmark(&memoryService->m_systemAllocator, &memoryService->m_scratchAllocator);
+    }
+    if (IsSelected(argc, argv, "heap")) {
+        RunHeapAllocatorBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "io")) {
+        RunIoServiceBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "jobs")) {
+        RunJobsBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "meshlets")) {
+        RunMeshletsBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "simplifier")) {
+        RunMeshSimplifierBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "scenegraph")) {
+        RunSceneGraphBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "scratch")) {
+        RunScratchAllocatorBenchmark();
+    }
+    if (IsSelected(argc, argv, "slab")) {
+        RunSlabAllocatorBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (IsSelected(argc, argv, "tangents")) {
+        RunTangentSpaceBenchmark(&memoryService->m_systemAllocator);
+    }
+    if (argc > 1 && strcmp(argv[1], "scene") == 0) {
+        if (argc < 3) {
+            info("Usage: Benchmarks scene [path to glTF model] [cooked scene path, defaults to the model path with the {} extension]", k_cooked_scene_extension);
+            return -1;
+        }
+        const std::string cookedPath = argc > 3 ? std::string(argv[3]) : std::filesystem::path(argv[2]).replace_extension(k_cooked_scene_extension).string();
+        RunSceneLoadBenchmark(argv[2], cookedPath.c_str(), &memoryService->m_systemAllocator, &memoryService->m_scratchAllocator);
+    }
+
+    return 0;
+}
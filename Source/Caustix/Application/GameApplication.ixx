@@ -3,6 +3,8 @@ module;
 #include <imgui.h>
 #include <cglm/util.h>
 
+#include <thread>
+
 export module Application.GameApplication;
 
 export import Application.Application;
@@ -12,11 +14,14 @@ import Application.Graphics.Renderer;
 import Application.Graphics.GPUDevice;
 import Application.Graphics.ImGuiService;
 import Foundation.Services.MemoryService;
+import Foundation.Services.IoService;
 import Foundation.Services.ServiceManager;
 import Foundation.Memory.MemoryDefines;
+import Foundation.Memory.VirtualMemory;
 import Foundation.Memory.Allocators.Allocator;
 import Foundation.Memory.Allocators.StackAllocator;
 import Foundation.ResourceManager;
+import Foundation.Jobs;
 import Foundation.Log;
 import Application.Graphics.CommandBuffer;
 
@@ -47,6 +52,8 @@ export namespace Caustix {
         ImGuiService*   m_imgui           = nullptr;
         MemoryService*  m_memoryService   = nullptr;
         GpuDevice*      m_gpu             = nullptr;
+        JobSystem*      m_jobSystem       = nullptr;
+        IoService*      m_ioService       = nullptr;
         StackAllocator  m_scratchAllocator;
     };
 }
@@ -59,13 +66,26 @@ namespace Caustix {
 
     GameApplication::GameApplication(const ApplicationConfiguration& configuration)
     : Application(configuration)
-    , m_scratchAllocator(cmega(8)){
+    , m_scratchAllocator(VirtualAllocatorConfiguration{ cmega(512) }){
+
+        // Jobs can allocate from any worker, so the shared allocators get an arena per worker.
+        const u32 workerCount = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
 
         MemoryServiceConfiguration memoryConfiguration;
+        memoryConfiguration.m_systemThreadArenas = workerCount;
+        memoryConfiguration.m_smallObjectsThreadMagazines = workerCount;
         ServiceManager::GetInstance()->AddService(MemoryService::Create(memoryConfiguration), MemoryService::m_name);
         m_memoryService = ServiceManager::GetInstance()->Get<MemoryService>();
         Allocator *allocator = &m_memoryService->m_systemAllocator;
 
+        JobSystemConfiguration jobConfiguration{ allocator, workerCount };
+        ServiceManager::GetInstance()->AddService(JobSystem::Create(jobConfiguration), JobSystem::m_name);
+        m_jobSystem = ServiceManager::GetInstance()->Get<JobSystem>();
+
+        IoServiceConfiguration ioConfiguration;
+        ServiceManager::GetInstance()->AddService(IoService::Create(ioConfiguration), IoService::m_name);
+        m_ioService = ServiceManager::GetInstance()->Get<IoService>();
+
         WindowConfiguration wconf{1280, 800, "Caustix Test", allocator};
         ServiceManager::GetInstance()->AddService(Window::Create(wconf), Window::m_name);
         m_window = ServiceManager::GetInstance()->Get<Window>();
@@ -78,12 +98,13 @@ namespace Caustix {
 
         // Graphics
         DeviceCreation deviceCreation;
-        deviceCreation.SetWindow(m_window->m_width, m_window->m_height, m_window->m_platformHandle).SetAllocator(allocator).SetLinearAllocator(&m_scratchAllocator);
+        deviceCreation.SetWindow(m_window->m_width, m_window->m_height, m_window->m_platformHandle).SetAllocator(allocator).SetLinearAllocator(&m_scratchAllocator).SetFrameAllocator(&m_memoryService->m_frameAllocator).SetSmallObjectsAllocator(&m_memoryService->m_smallObjectsAllocator);
 
         ServiceManager::GetInstance()->AddService(GpuDevice::Create(deviceCreation), GpuDevice::m_name);
         m_gpu = ServiceManager::GetInstance()->Get<GpuDevice>();
 
-        ResourceManager resourceManager(allocator, nullptr);
+        // Loader and compiler maps hold a handful of entries, their flat tables fit the small object size classes
+        ResourceManager resourceManager(&m_memoryService->m_smallObjectsAllocator, nullptr);
 
         ServiceManager::GetInstance()->AddService(Renderer::Create({m_gpu, allocator}), Renderer::m_name);
         m_renderer = ServiceManager::GetInstance()->Get<Renderer>();
@@ -101,6 +122,8 @@ namespace Caustix {
 
         m_imgui->Shutdown();
         m_renderer->Shutdown();
+        m_jobSystem->Shutdown();
+        m_ioService->Shutdown();
 
         m_window->UnregisterOsMessagesCallback(InputOsMessagesCallback);
     }
@@ -137,6 +160,7 @@ namespace Caustix {
 
             // Various updates
             m_input->Update( delta_time );
+            m_ioService->Update();
 
             while ( m_accumulator >= m_step ) {
                 FixedUpdate( m_step );
@@ -149,6 +173,7 @@ namespace Caustix {
             if ( !m_window->m_minimized ) {
                 // Draw debug UIs
                 ServiceManager::GetInstance()->Get<MemoryService>()->ImguiDraw();
+                m_jobSystem->debug_ui();
 
                 CommandBuffer* gpuCommands = m_renderer->GetCommandBuffer( QueueType::Graphics, true );
                 gpuCommands->PushMarker( "Frame" );
@@ -185,13 +185,22 @@ export namespace Caustix {
 
     namespace VertexComponentFormat {
         enum Enum {
-            Float, Float2, Float3, Float4, Mat4, Byte, Byte4N, UByte, UByte4N, Short2, Short2N, Short4, Short4N, Uint, Uint2, Uint4, Count
+            Float, Float2, Float3, Float4, Mat4, Byte, Byte4N, UByte, UByte4N, Short2, Short2N, Short4, Short4N, Uint, Uint2, Uint4, UShort4N, Half2, Count
         };
 
         constexpr const char* s_value_names[] = {
-                "Float", "Float2", "Float3", "Float4", "Mat4", "Byte", "Byte4N", "UByte", "UByte4N", "Short2", "Short2N", "Short4", "Short4N", "Uint", "Uint2", "Uint4", "Count"
+                "Float", "Float2", "Float3", "Float4", "Mat4", "Byte", "Byte4N", "UByte", "UByte4N", "Short2", "Short2N", "Short4", "Short4N", "Uint", "Uint2", "Uint4", "UShort4N", "Half2", "Count"
         };
 
+        // Bytes per vertex, the stride of a stream holding only this attribute.
+        constexpr u32 s_value_sizes[] = {
+                4, 8, 12, 16, 64, 1, 4, 1, 4, 4, 4, 8, 8, 4, 8, 16, 8, 4, 0
+        };
+
+        constexpr u32 GetSize( Enum e ) {
+            return ((u32)e < Enum::Count ? s_value_sizes[(int)e] : 0 );
+        }
+
         consteval const char* ToString( Enum e ) {
             return ((u32)e < Enum::Count ? s_value_names[(int)e] : "unsupported" );
         }
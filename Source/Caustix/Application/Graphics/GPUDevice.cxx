@@ -154,8 +154,9 @@ namespace Caustix {
     #define     check( result ) CASSERT( result == VK_SUCCESS )
 
     GpuDevice::GpuDevice(const DeviceCreation &creation)
-            : allocator(creation.m_allocator), string_buffer(*creation.m_allocator), resource_deletion_queue(*creation.m_allocator),
-              descriptor_set_updates(*creation.m_allocator), buffers(creation.m_allocator, 4096, sizeof(Buffer)),
+            : allocator(creation.m_allocator), string_buffer(*creation.m_allocator),
+              resource_deletion_queue(creation.m_smallObjectsAllocator ? *creation.m_smallObjectsAllocator : *creation.m_allocator),
+              descriptor_set_updates(creation.m_smallObjectsAllocator ? *creation.m_smallObjectsAllocator : *creation.m_allocator), buffers(creation.m_allocator, 4096, sizeof(Buffer)),
               textures(creation.m_allocator, 512, sizeof(Texture)), pipelines(creation.m_allocator, 128, sizeof(Pipeline)),
               samplers(creation.m_allocator, 32, sizeof(Sampler)),
               descriptor_set_layouts(creation.m_allocator, 128, sizeof(DesciptorSetLayout)),
@@ -165,6 +166,8 @@ namespace Caustix {
         info("Gpu Device init");
         // 1. Perform common code
         temporary_allocator = creation.m_temporaryAllocator;
+        frame_allocator = creation.m_frameAllocator;
+        CASSERT( frame_allocator == nullptr || frame_allocator->m_frameCount == k_max_frames );
         string_buffer.reserve( 1024 * 1024 );
 
         //////// Init Vulkan instance.
@@ -467,6 +470,7 @@ namespace Caustix {
         absolute_frame = 0;
         timestamps_enabled = false;
 
+        // 16 entries fit the slab size classes when the queues use the small objects allocator, bursts above 1KB spill to its fallback.
         resource_deletion_queue.reserve( 16 );
         descriptor_set_updates.reserve( 16 );
 
@@ -1994,7 +1998,7 @@ namespace Caustix {
 // Resource Destruction /////////////////////////////////////////////////////////
 
     void GpuDevice::destroy_buffer( BufferHandle buffer ) {
-        if ( buffer.m_index < buffers.m_poolSize ) {
+        if ( buffers.IsAlive( buffer.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::Buffer, buffer.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid Buffer {}", buffer.m_index );
@@ -2002,7 +2006,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_texture( TextureHandle texture ) {
-        if ( texture.m_index < textures.m_poolSize ) {
+        if ( textures.IsAlive( texture.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::Texture, texture.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid Texture {}", texture.m_index );
@@ -2010,7 +2014,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_pipeline( PipelineHandle pipeline ) {
-        if ( pipeline.m_index < pipelines.m_poolSize ) {
+        if ( pipelines.IsAlive( pipeline.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::Pipeline, pipeline.m_index, current_frame } );
             // Shader state creation is handled internally when creating a pipeline, thus add this to track correctly.
             Pipeline* v_pipeline = access_pipeline( pipeline );
@@ -2021,7 +2025,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_sampler( SamplerHandle sampler ) {
-        if ( sampler.m_index < samplers.m_poolSize ) {
+        if ( samplers.IsAlive( sampler.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::Sampler, sampler.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid Sampler {}", sampler.m_index );
@@ -2029,7 +2033,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_descriptor_set_layout( DescriptorSetLayoutHandle descriptor_set_layout ) {
-        if ( descriptor_set_layout.m_index < descriptor_set_layouts.m_poolSize ) {
+        if ( descriptor_set_layouts.IsAlive( descriptor_set_layout.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::DescriptorSetLayout, descriptor_set_layout.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid DescriptorSetLayout {}", descriptor_set_layout.m_index );
@@ -2037,7 +2041,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_descriptor_set( DescriptorSetHandle descriptor_set ) {
-        if ( descriptor_set.m_index < descriptor_sets.m_poolSize ) {
+        if ( descriptor_sets.IsAlive( descriptor_set.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::DescriptorSet, descriptor_set.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid DescriptorSet {}", descriptor_set.m_index );
@@ -2045,7 +2049,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_render_pass( RenderPassHandle render_pass ) {
-        if ( render_pass.m_index < render_passes.m_poolSize ) {
+        if ( render_passes.IsAlive( render_pass.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::RenderPass, render_pass.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid RenderPass {}", render_pass.m_index );
@@ -2053,7 +2057,7 @@ namespace Caustix {
     }
 
     void GpuDevice::destroy_shader_state( ShaderStateHandle shader ) {
-        if ( shader.m_index < shaders.m_poolSize ) {
+        if ( shaders.IsAlive( shader.m_index ) ) {
             resource_deletion_queue.push_back( { ResourceDeletionType::ShaderState, shader.m_index, current_frame } );
         } else {
             error( "Graphics error: trying to free invalid Shader {}", shader.m_index );
@@ -2341,7 +2345,7 @@ namespace Caustix {
 
     void GpuDevice::update_descriptor_set( DescriptorSetHandle descriptor_set ) {
 
-        if ( descriptor_set.m_index < descriptor_sets.m_poolSize ) {
+        if ( descriptor_sets.IsAlive( descriptor_set.m_index ) ) {
 
             DescriptorSetUpdate new_update = { descriptor_set, current_frame };
             descriptor_set_updates.push_back( new_update );
@@ -2370,9 +2374,13 @@ namespace Caustix {
         destroy_descriptor_set( dummy_delete_descriptor_set_handle );
 
         // Allocate the new descriptor set and update its content.
-        VkWriteDescriptorSet descriptor_write[ 8 ];
-        VkDescriptorBufferInfo buffer_info[ 8 ];
-        VkDescriptorImageInfo image_info[ 8 ];
+        // Updates run every frame, so the write arrays are frame temporaries sized by the layout.
+        const sizet temporary_marker = temporary_allocator->GetMarker();
+        Allocator* frame_temporaries = frame_allocator ? ( Allocator* )frame_allocator : ( Allocator* )temporary_allocator;
+        const u32 num_bindings = caustix_max( descriptor_set_layout->m_numBindings, 1u );
+        VkWriteDescriptorSet* descriptor_write = callocaa<VkWriteDescriptorSet>( num_bindings, frame_temporaries, alignof( VkWriteDescriptorSet ) );
+        VkDescriptorBufferInfo* buffer_info = callocaa<VkDescriptorBufferInfo>( num_bindings, frame_temporaries, alignof( VkDescriptorBufferInfo ) );
+        VkDescriptorImageInfo* image_info = callocaa<VkDescriptorImageInfo>( num_bindings, frame_temporaries, alignof( VkDescriptorImageInfo ) );
 
         Sampler* vk_default_sampler = access_sampler( default_sampler );
 
@@ -2387,6 +2395,8 @@ namespace Caustix {
                                            num_resources, descriptor_set->m_resources, descriptor_set->m_samplers, descriptor_set->m_bindings );
 
         vkUpdateDescriptorSets( vulkan_device, num_resources, descriptor_write, 0, nullptr );
+
+        temporary_allocator->FreeMarker( temporary_marker );
     }
 
 //
@@ -2498,6 +2508,11 @@ namespace Caustix {
 
         vkResetFences( vulkan_device, 1, render_complete_fence );
 
+        // The GPU is done with this frame, its temporaries can be reused
+        if ( frame_allocator ) {
+            frame_allocator->BeginFrame( current_frame );
+        }
+
         VkResult result = vkAcquireNextImageKHR( vulkan_device, vulkan_swapchain, UINT64_MAX, vulkan_image_acquired_semaphore[ current_frame ], VK_NULL_HANDLE, &vulkan_image_index );
         if ( result == VK_ERROR_OUT_OF_DATE_KHR ) {
             resize_swapchain();
@@ -2532,8 +2547,10 @@ namespace Caustix {
         VkSemaphore* render_complete_semaphore = &vulkan_render_complete_semaphore[ current_frame ];
         VkSemaphore* wait_semaphore = &vulkan_image_acquired_semaphore[ current_frame ];
 
-        // Copy all commands
-        VkCommandBuffer enqueued_command_buffers[ 4 ];
+        // Copy all commands, the list is a frame temporary rewound once this frame fence is waited on.
+        const sizet temporary_marker = temporary_allocator->GetMarker();
+        Allocator* frame_temporaries = frame_allocator ? ( Allocator* )frame_allocator : ( Allocator* )temporary_allocator;
+        VkCommandBuffer* enqueued_command_buffers = callocaa<VkCommandBuffer>( caustix_max( num_queued_command_buffers, 1u ), frame_temporaries, alignof( VkCommandBuffer ) );
         for ( u32 c = 0; c < num_queued_command_buffers; c++ ) {
 
             CommandBuffer* command_buffer = queued_command_buffers[ c ];
@@ -2560,6 +2577,8 @@ namespace Caustix {
 
         vkQueueSubmit( vulkan_queue, 1, &submit_info, *render_complete_fence );
 
+        temporary_allocator->FreeMarker( temporary_marker );
+
         VkPresentInfoKHR present_info{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
         present_info.waitSemaphoreCount = 1;
         present_info.pWaitSemaphores = render_complete_semaphore;
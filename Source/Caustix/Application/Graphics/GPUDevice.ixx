@@ -12,6 +12,7 @@ export import Application.Graphics.GPUResources;
 
 import Foundation.Memory.Allocators.Allocator;
 import Foundation.Memory.Allocators.StackAllocator;
+import Foundation.Memory.Allocators.FrameAllocator;
 import Foundation.Memory.MemoryDefines;
 import Foundation.Services.Service;
 import Foundation.DataStructures;
@@ -65,6 +66,8 @@ export namespace Caustix {
 
         Allocator*                      m_allocator       = nullptr;
         StackAllocator*                 m_temporaryAllocator = nullptr;
+        FrameAllocator*                 m_frameAllocator  = nullptr;
+        Allocator*                      m_smallObjectsAllocator = nullptr;  // Deferred update queues, m_allocator when not set.
         void*                           m_window          = nullptr; // Pointer to API-specific window: SDL_Window, GLFWWindow
         u16                             m_width           = 1;
         u16                             m_height          = 1;
@@ -76,6 +79,8 @@ export namespace Caustix {
         DeviceCreation&                 SetWindow( u32 width, u32 height, void* handle );
         DeviceCreation&                 SetAllocator( Allocator* allocator );
         DeviceCreation&                 SetLinearAllocator( StackAllocator* allocator );
+        DeviceCreation&                 SetFrameAllocator( FrameAllocator* allocator );
+        DeviceCreation&                 SetSmallObjectsAllocator( Allocator* allocator );
 
     };
 
@@ -222,6 +227,7 @@ export namespace Caustix {
 
         Allocator*                      allocator;
         StackAllocator*                 temporary_allocator;
+        FrameAllocator*                 frame_allocator;
 
         u32                             dynamic_max_per_frame_size;
         BufferHandle                    dynamic_buffer;
@@ -413,4 +419,14 @@ namespace Caustix {
         m_temporaryAllocator = allocator;
         return *this;
     }
+
+    DeviceCreation& DeviceCreation::SetFrameAllocator( FrameAllocator* allocator ) {
+        m_frameAllocator = allocator;
+        return *this;
+    }
+
+    DeviceCreation& DeviceCreation::SetSmallObjectsAllocator( Allocator* allocator ) {
+        m_smallObjectsAllocator = allocator;
+        return *this;
+    }
 }
\ No newline at end of file
@@ -1,7 +1,5 @@
 module;
 
-#include <unordered_map>
-
 #include <imgui.h>
 
 export module Application.Graphics.GPUProfiler;
@@ -9,13 +7,13 @@ export module Application.Graphics.GPUProfiler;
 import Application.Graphics.GPUDevice;
 
 import Foundation.Platform;
+import Foundation.FlatHashMap;
 import Foundation.Memory.Allocators.Allocator;
 import Foundation.Memory.MemoryDefines;
 import Foundation.Color;
 import Foundation.Numerics;
 
 export namespace Caustix {
-    #define FlatHashMap(key, value) std::unordered_map<key, value, std::hash<key>, std::equal_to<key>, STLAdaptor<std::pair<const key, value>>>
     struct GPUProfiler {
         GPUProfiler( Allocator* allocator, u32 maxFrames );
         ~GPUProfiler();
@@ -40,7 +38,7 @@ export namespace Caustix {
 
     private:
         // GPU task names to colors
-        FlatHashMap(u64, u32)   m_nameToColor;
+        FlatHashMap<u64, u32>   m_nameToColor;
     };
 }
 
@@ -75,8 +73,8 @@ namespace Caustix {
         cfree( m_perFrameActive, m_allocator );
     }
 
-    u32 GetWithDef(const  FlatHashMap(u64, u32)& m, const u64& key, const u32& defval ) {
-        typename FlatHashMap(u64, u32)::const_iterator it = m.find( key );
+    u32 GetWithDef(const  FlatHashMap<u64, u32>& m, const u64& key, const u32& defval ) {
+        typename FlatHashMap<u64, u32>::const_iterator it = m.find( key );
         if ( it == m.end() ) {
             return defval;
         }
@@ -1,7 +1,6 @@
 module;
 
 #include <memory>
-#include <unordered_map>
 
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
@@ -18,6 +17,7 @@ import Foundation.Services.Service;
 import Foundation.Services.MemoryService;
 import Foundation.Services.ServiceManager;
 import Foundation.Platform;
+import Foundation.FlatHashMap;
 import Foundation.Log;
 
 export namespace Caustix {
@@ -34,8 +34,6 @@ export namespace Caustix {
         void*                           m_windowHandle;
     };
 
-    #define FlatHashMap(key, value) std::unordered_map<key, value, std::hash<key>, std::equal_to<key>, STLAdaptor<std::pair<const key, value>>>
-
     struct ImGuiService : public Service {
 
         ImGuiService( const ImGuiServiceConfiguration& configuration );
@@ -59,7 +57,7 @@ export namespace Caustix {
         static constexpr cstring        m_name = "caustix_imgui_service";
 
     private:
-        FlatHashMap(ResourceHandle, ResourceHandle) m_textureToDescriptorSet;
+        FlatHashMap<ResourceHandle, ResourceHandle> m_textureToDescriptorSet;
     };
 }
 
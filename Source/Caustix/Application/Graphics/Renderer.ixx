@@ -1,6 +1,5 @@
 module;
 
-#include <unordered_map>
 #include <memory>
 
 #include <vulkan/vulkan.h>
@@ -14,6 +13,7 @@ import Foundation.Memory.Allocators.Allocator;
 import Foundation.Services.Service;
 import Foundation.ResourceManager;
 import Foundation.Platform;
+import Foundation.FlatHashMap;
 import Foundation.DataStructures;
 import Foundation.Log;
 
@@ -51,15 +51,13 @@ export namespace Caustix {
         static u64                      k_type_hash;
     };
 
-    #define FlatHashMap(key, value) std::unordered_map<key, value, std::hash<key>, std::equal_to<key>, STLAdaptor<std::pair<const key, value>>>
-
     struct ResourceCache {
         ResourceCache( Allocator* allocator );
         void    Shutdown( Renderer* renderer );
 
-        FlatHashMap(u64, TextureResource*) m_textures;
-        FlatHashMap(u64, BufferResource*)  m_buffers;
-        FlatHashMap(u64, SamplerResource*) m_samplers;
+        FlatHashMap<u64, TextureResource*> m_textures;
+        FlatHashMap<u64, BufferResource*>  m_buffers;
+        FlatHashMap<u64, SamplerResource*> m_samplers;
     };
 
     struct RendererCreation {
@@ -86,6 +84,8 @@ export namespace Caustix {
 
         TextureResource*            CreateTexture( const TextureCreation& creation );
         TextureResource*            CreateTexture( cstring name, cstring filename );
+        // From an encoded image already in memory, as read by the IoService.
+        TextureResource*            CreateTexture( cstring name, const u8* fileData, sizet fileSize );
 
         SamplerResource*            CreateSampler( const SamplerCreation& creation );
 
@@ -176,6 +176,29 @@ namespace Caustix {
         return k_invalid_texture;
     }
 
+    static TextureHandle CreateTextureFromMemory( GpuDevice& gpu, const u8* fileData, sizet fileSize, cstring name ) {
+
+        if ( fileData ) {
+            int comp, width, height;
+            uint8_t* image_data = stbi_load_from_memory( fileData, ( int )fileSize, &width, &height, &comp, 4 );
+            if ( !image_data ) {
+                error( "Error decoding texture {}", name );
+                return k_invalid_texture;
+            }
+
+            TextureCreation creation;
+            creation.SetData( image_data ).SetFormatType( VK_FORMAT_R8G8B8A8_UNORM, TextureType::Texture2D ).SetFlags( 1, 0 ).SetSize( ( u16 )width, ( u16 )height, 1 ).SetName( name );
+
+            TextureHandle new_texture = gpu.create_texture( creation );
+
+            free( image_data );
+
+            return new_texture;
+        }
+
+        return k_invalid_texture;
+    }
+
     u64 TextureResource::k_type_hash = 0;
     u64 BufferResource::k_type_hash = 0;
     u64 SamplerResource::k_type_hash = 0;
@@ -304,6 +327,23 @@ namespace Caustix {
         return nullptr;
     }
 
+    TextureResource* Renderer::CreateTexture( cstring name, const u8* fileData, sizet fileSize ) {
+        TextureResource* texture = m_textures.Obtain();
+
+        if ( texture ) {
+            TextureHandle handle = CreateTextureFromMemory( *m_gpu, fileData, fileSize, name );
+            texture->m_handle = handle;
+            m_gpu->query_texture( handle, texture->m_desc );
+            texture->m_references = 1;
+            texture->m_name = name;
+
+            m_resourceCache.m_textures.emplace( HashCalculate( name ), texture );
+
+            return texture;
+        }
+        return nullptr;
+    }
+
     SamplerResource* Renderer::CreateSampler( const SamplerCreation& creation ) {
         SamplerResource* sampler = m_samplers.Obtain();
         if ( sampler ) {
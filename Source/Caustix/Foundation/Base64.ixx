@@ -0,0 +1,276 @@
+module;
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CAUSTIX_BASE64_TARGET(features)
+#else
+#define CAUSTIX_BASE64_TARGET(features) __attribute__((target(features)))
+#endif
+#define CAUSTIX_BASE64_X86
+#endif
+
+export module Foundation.Base64;
+
+import Foundation.Platform;
+
+export namespace Caustix {
+
+    enum class Base64Isa : u8 {
+        Scalar, Ssse3, Avx2
+    };
+
+    // Size of the data encoded by the text, with or without trailing padding.
+    sizet   Base64DecodedSize( const char* input, sizet length );
+
+    // Decodes standard base64 into output, which must hold Base64DecodedSize bytes.
+    // Returns false on characters outside the alphabet or a truncated input.
+    // Blocks of 32 or 16 characters are decoded with AVX2 or SSSE3 when the CPU supports them.
+    bool    Base64Decode( const char* input, sizet length, u8* output );
+
+    // Best instruction set the decoder uses on this CPU.
+    Base64Isa   Base64SupportedIsa();
+    // Decodes with at most maxIsa, so tests and benchmarks can compare the paths.
+    bool        Base64Decode( const char* input, sizet length, u8* output, Base64Isa maxIsa );
+}
+
+namespace Caustix {
+
+    static constexpr u8 k_base64_invalid = 0xFF;
+
+    struct Base64Table {
+        u8                      m_values[ 256 ];
+
+        constexpr Base64Table() : m_values() {
+            for ( u32 i = 0; i < 256; ++i ) {
+                m_values[ i ] = k_base64_invalid;
+            }
+            for ( u32 i = 0; i < 26; ++i ) {
+                m_values[ 'A' + i ] = ( u8 )i;
+                m_values[ 'a' + i ] = ( u8 )( 26 + i );
+            }
+            for ( u32 i = 0; i < 10; ++i ) {
+                m_values[ '0' + i ] = ( u8 )( 52 + i );
+            }
+            m_values[ '+' ] = 62;
+            m_values[ '/' ] = 63;
+        }
+    };
+
+    static constexpr Base64Table k_base64_table;
+
+    static sizet Base64PaddingCount( const char* input, sizet length ) {
+        sizet padding = 0;
+        while ( padding < 2 && length > padding && input[ length - padding - 1 ] == '=' ) {
+            ++padding;
+        }
+        return padding;
+    }
+
+    sizet Base64DecodedSize( const char* input, sizet length ) {
+        const sizet characters = length - Base64PaddingCount( input, length );
+        const sizet remainder = characters % 4;
+        return characters / 4 * 3 + ( remainder > 1 ? remainder - 1 : 0 );
+    }
+
+    // Input without padding.
+    static bool Base64DecodeScalar( const u8* input, sizet length, u8* output ) {
+        const u8* values = k_base64_table.m_values;
+
+        sizet i = 0;
+        for ( ; i + 4 <= length; i += 4 ) {
+            const u32 a = values[ input[ i ] ];
+            const u32 b = values[ input[ i + 1 ] ];
+            const u32 c = values[ input[ i + 2 ] ];
+            const u32 d = values[ input[ i + 3 ] ];
+            if ( ( a | b | c | d ) & 0x80 ) {
+                return false;
+            }
+
+            const u32 triple = ( a << 18 ) | ( b << 12 ) | ( c << 6 ) | d;
+            *output++ = ( u8 )( triple >> 16 );
+            *output++ = ( u8 )( triple >> 8 );
+            *output++ = ( u8 )triple;
+        }
+
+        const sizet remainder = length - i;
+        if ( remainder == 0 ) {
+            return true;
+        }
+        if ( remainder == 1 ) {
+            return false;
+        }
+
+        const u32 a = values[ input[ i ] ];
+        const u32 b = values[ input[ i + 1 ] ];
+        const u32 c = remainder == 3 ? values[ input[ i + 2 ] ] : 0;
+        if ( ( a | b | c ) & 0x80 ) {
+            return false;
+        }
+
+        const u32 triple = ( a << 18 ) | ( b << 12 ) | ( c << 6 );
+        *output++ = ( u8 )( triple >> 16 );
+        if ( remainder == 3 ) {
+            *output++ = ( u8 )( triple >> 8 );
+        }
+        return true;
+    }
+
+#if defined(CAUSTIX_BASE64_X86)
+    struct Base64CpuFeatures {
+        bool                    m_ssse3 = false;
+        bool                    m_avx2  = false;
+    };
+
+    static Base64CpuFeatures DetectBase64CpuFeatures() {
+        Base64CpuFeatures features;
+#if defined(_MSC_VER)
+        int info[ 4 ];
+        __cpuid( info, 0 );
+        const int maxLeaf = info[ 0 ];
+
+        __cpuid( info, 1 );
+        features.m_ssse3 = ( info[ 2 ] & ( 1 << 9 ) ) != 0;
+        const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+        const bool avx = ( info[ 2 ] & ( 1 << 28 ) ) != 0;
+
+        if ( maxLeaf >= 7 && osxsave && avx && ( _xgetbv( 0 ) & 6 ) == 6 ) {
+            __cpuidex( info, 7, 0 );
+            features.m_avx2 = ( info[ 1 ] & ( 1 << 5 ) ) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        features.m_ssse3 = __builtin_cpu_supports( "ssse3" );
+        features.m_avx2 = __builtin_cpu_supports( "avx2" );
+#endif
+        return features;
+    }
+
+    // Lookup tables of the vectorized decoder: a character is valid when the bit of its high nibble is set
+    // in the mask selected by its low nibble, and its value is the character plus the shift selected by the high nibble.
+    // '+' and '/' share the high nibble and only '/' needs a correction.
+    static constexpr i8 k_base64_shift_lut[ 16 ] = { 0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 };
+    static constexpr u8 k_base64_mask_lut[ 16 ] = { 0xA8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF0, 0x54, 0x50, 0x50, 0x50, 0x54 };
+    static constexpr u8 k_base64_bit_lut[ 16 ] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0, 0, 0, 0, 0, 0, 0, 0 };
+    // 12 decoded bytes from the 4 dwords holding 3 big endian bytes each.
+    static constexpr i8 k_base64_pack_lut[ 16 ] = { 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 };
+
+    // Returns the characters decoded, a multiple of 16. Stops before an invalid block and leaves it to the scalar path.
+    // 16 bytes are stored for every 12 decoded, so it stops 8 characters before the end to stay in the output.
+    CAUSTIX_BASE64_TARGET( "ssse3" )
+    static sizet Base64DecodeSsse3( const u8* input, sizet length, u8* output ) {
+        const __m128i shiftLut = _mm_loadu_si128( ( const __m128i* )k_base64_shift_lut );
+        const __m128i maskLut = _mm_loadu_si128( ( const __m128i* )k_base64_mask_lut );
+        const __m128i bitLut = _mm_loadu_si128( ( const __m128i* )k_base64_bit_lut );
+        const __m128i packLut = _mm_loadu_si128( ( const __m128i* )k_base64_pack_lut );
+        const __m128i nibbleMask = _mm_set1_epi8( 0x0F );
+        const __m128i slash = _mm_set1_epi8( '/' );
+        const __m128i slashShift = _mm_set1_epi8( -3 );
+        const __m128i mergePairs = _mm_set1_epi32( 0x01400140 );
+        const __m128i mergeQuads = _mm_set1_epi32( 0x00011000 );
+
+        sizet i = 0;
+        for ( ; i + 24 <= length; i += 16 ) {
+            const __m128i chunk = _mm_loadu_si128( ( const __m128i* )( input + i ) );
+            const __m128i high = _mm_and_si128( _mm_srli_epi32( chunk, 4 ), nibbleMask );
+            const __m128i low = _mm_and_si128( chunk, nibbleMask );
+
+            const __m128i valid = _mm_and_si128( _mm_shuffle_epi8( maskLut, low ), _mm_shuffle_epi8( bitLut, high ) );
+            if ( _mm_movemask_epi8( _mm_cmpeq_epi8( valid, _mm_setzero_si128() ) ) ) {
+                break;
+            }
+
+            __m128i shift = _mm_shuffle_epi8( shiftLut, high );
+            shift = _mm_add_epi8( shift, _mm_and_si128( _mm_cmpeq_epi8( chunk, slash ), slashShift ) );
+            const __m128i values = _mm_add_epi8( chunk, shift );
+
+            // 6 bit values to 12 bit pairs, then to 24 bit groups.
+            const __m128i pairs = _mm_maddubs_epi16( values, mergePairs );
+            const __m128i groups = _mm_madd_epi16( pairs, mergeQuads );
+            _mm_storeu_si128( ( __m128i* )( output + i / 4 * 3 ), _mm_shuffle_epi8( groups, packLut ) );
+        }
+        return i;
+    }
+
+    // Same as the SSSE3 version on 32 characters, the two 12 bytes lanes are joined with a cross lane permute.
+    CAUSTIX_BASE64_TARGET( "avx2" )
+    static sizet Base64DecodeAvx2( const u8* input, sizet length, u8* output ) {
+        const __m256i shiftLut = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )k_base64_shift_lut ) );
+        const __m256i maskLut = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )k_base64_mask_lut ) );
+        const __m256i bitLut = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )k_base64_bit_lut ) );
+        const __m256i packLut = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )k_base64_pack_lut ) );
+        const __m256i laneJoin = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 7, 7 );
+        const __m256i nibbleMask = _mm256_set1_epi8( 0x0F );
+        const __m256i slash = _mm256_set1_epi8( '/' );
+        const __m256i slashShift = _mm256_set1_epi8( -3 );
+        const __m256i mergePairs = _mm256_set1_epi32( 0x01400140 );
+        const __m256i mergeQuads = _mm256_set1_epi32( 0x00011000 );
+
+        sizet i = 0;
+        for ( ; i + 48 <= length; i += 32 ) {
+            const __m256i chunk = _mm256_loadu_si256( ( const __m256i* )( input + i ) );
+            const __m256i high = _mm256_and_si256( _mm256_srli_epi32( chunk, 4 ), nibbleMask );
+            const __m256i low = _mm256_and_si256( chunk, nibbleMask );
+
+            const __m256i valid = _mm256_and_si256( _mm256_shuffle_epi8( maskLut, low ), _mm256_shuffle_epi8( bitLut, high ) );
+            if ( _mm256_movemask_epi8( _mm256_cmpeq_epi8( valid, _mm256_setzero_si256() ) ) ) {
+                break;
+            }
+
+            __m256i shift = _mm256_shuffle_epi8( shiftLut, high );
+            shift = _mm256_add_epi8( shift, _mm256_and_si256( _mm256_cmpeq_epi8( chunk, slash ), slashShift ) );
+            const __m256i values = _mm256_add_epi8( chunk, shift );
+
+            const __m256i pairs = _mm256_maddubs_epi16( values, mergePairs );
+            const __m256i groups = _mm256_madd_epi16( pairs, mergeQuads );
+            const __m256i packed = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( groups, packLut ), laneJoin );
+            _mm256_storeu_si256( ( __m256i* )( output + i / 4 * 3 ), packed );
+        }
+        return i;
+    }
+#endif
+
+#if defined(CAUSTIX_BASE64_X86)
+    static const Base64CpuFeatures& GetBase64CpuFeatures() {
+        static const Base64CpuFeatures s_features = DetectBase64CpuFeatures();
+        return s_features;
+    }
+#endif
+
+    Base64Isa Base64SupportedIsa() {
+#if defined(CAUSTIX_BASE64_X86)
+        const Base64CpuFeatures& features = GetBase64CpuFeatures();
+        if ( features.m_avx2 ) {
+            return Base64Isa::Avx2;
+        }
+        if ( features.m_ssse3 ) {
+            return Base64Isa::Ssse3;
+        }
+#endif
+        return Base64Isa::Scalar;
+    }
+
+    bool Base64Decode( const char* input, sizet length, u8* output ) {
+        return Base64Decode( input, length, output, Base64Isa::Avx2 );
+    }
+
+    bool Base64Decode( const char* input, sizet length, u8* output, Base64Isa maxIsa ) {
+        const u8* text = ( const u8* )input;
+        length -= Base64PaddingCount( input, length );
+
+        sizet decoded = 0;
+#if defined(CAUSTIX_BASE64_X86)
+        const Base64CpuFeatures& features = GetBase64CpuFeatures();
+        if ( features.m_avx2 && maxIsa >= Base64Isa::Avx2 ) {
+            decoded = Base64DecodeAvx2( text, length, output );
+        }
+        if ( features.m_ssse3 && maxIsa >= Base64Isa::Ssse3 ) {
+            decoded += Base64DecodeSsse3( text + decoded, length - decoded, output + decoded / 4 * 3 );
+        }
+#endif
+        return Base64DecodeScalar( text + decoded, length - decoded, output + decoded / 4 * 3 );
+    }
+}
@@ -1,6 +1,18 @@
+module;
+
+#include <cstdlib>
+#include <concepts>
+#include <cstring>
+#include <type_traits>
+
 export module Foundation.Blob;
 
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.File;
 import Foundation.Platform;
+import Foundation.Assert;
+import Foundation.Log;
 
 export namespace Caustix {
 
@@ -9,16 +21,540 @@ export namespace Caustix {
 // offset to track where to allocate memory from when writing, so that Relative structures
 // like pointers and arrays can be serialized.
 //
-// TODO: when finalized and when reading, if data version matches between the one written in
-// the file and the root structure is marked as 'relative only', memory mappable is doable and
-// thus serialization is automatic.
+// Data is laid out exactly as in memory: every value is aligned to its natural alignment and
+// structures are walked field by field in declaration order. When the version written in the
+// file matches the one of the reader and the blob is marked mappable, the file can be used in
+// place without any parsing, otherwise it is serialized into newly allocated memory and the
+// BlobSerialize functions can migrate old versions looking at m_dataVersion.
+//
+// Types other than arithmetic, enums, fixed arrays and Relative structures need a
+// void BlobSerialize( BlobSerializer* serializer, T* data ) function, found by argument dependent lookup.
 //
+
+    // Offset from the address of the pointer itself, so the data stays valid wherever the memory is placed.
+    template <typename T>
+    struct RelativePointer {
+        T*                  Get()                       { return m_offset ? ( T* )( ( char* )this + m_offset ) : nullptr; }
+        const T*            Get() const                 { return m_offset ? ( const T* )( ( const char* )this + m_offset ) : nullptr; }
+
+        T*                  operator->()                { return Get(); }
+        const T*            operator->() const          { return Get(); }
+        T&                  operator*()                 { return *Get(); }
+        const T&            operator*() const           { return *Get(); }
+
+        bool                IsNull() const              { return m_offset == 0; }
+        bool                IsNotNull() const           { return m_offset != 0; }
+
+        void                Set( const void* target )   { m_offset = target ? ( i32 )( ( const char* )target - ( const char* )this ) : 0; }
+        void                SetNull()                   { m_offset = 0; }
+
+        i32                 m_offset;
+    };
+
+    template <typename T>
+    struct RelativeArray {
+        T&                  operator[]( u32 index )         { CASSERT( index < m_size ); return m_data.Get()[ index ]; }
+        const T&            operator[]( u32 index ) const   { CASSERT( index < m_size ); return m_data.Get()[ index ]; }
+
+        T*                  Get()                       { return m_data.Get(); }
+        const T*            Get() const                 { return m_data.Get(); }
+
+        T*                  begin()                     { return m_data.Get(); }
+        T*                  end()                       { return m_data.Get() + m_size; }
+        const T*            begin() const               { return m_data.Get(); }
+        const T*            end() const                 { return m_data.Get() + m_size; }
+
+        void                Set( const void* data, u32 size ) { m_data.Set( data ); m_size = size; }
+        void                SetEmpty()                  { m_data.SetNull(); m_size = 0; }
+
+        u32                 m_size;
+        RelativePointer<T>  m_data;
+    };
+
+    // Characters are followed by a null terminator not counted in m_size.
+    struct RelativeString : public RelativeArray<char> {
+        cstring             CStr() const                { return m_size ? m_data.Get() : ""; }
+    };
+
     struct BlobHeader {
         u32                 version;
         u32                 mappable;
+        u32                 size;       // Bytes of the whole blob, header included.
     };
 
-    struct Blob {
-        BlobHeader          header;
+    // Root structure starts after the header, at an offset that keeps SIMD types aligned.
+    static constexpr u32    k_blob_root_offset = 16;
+
+    struct BlobSerializer {
+
+        // Writing
+        // Allocates a blob of size bytes and returns the root structure inside it, to be filled in place
+        // with AllocateAndSet for the relative members.
+        template <typename T>
+        T*                  WriteAndPrepare( Allocator* allocator, u32 version, sizet size );
+        // Allocates a blob of size bytes and serializes root into it.
+        template <typename T>
+        void                WriteFull( Allocator* allocator, u32 version, sizet size, T* root );
+
+        u32                 Allocate( sizet size, sizet alignment );
+        void*               AllocateStatic( sizet size, sizet alignment );
+
+        template <typename T>
+        void                AllocateAndSet( RelativePointer<T>& data, const T* source = nullptr );
+        template <typename T>
+        void                AllocateAndSet( RelativeArray<T>& data, u32 count, const T* source = nullptr );
+        void                AllocateAndSet( RelativeString& string, cstring source );
+
+        sizet               GetBlobSize() const         { return m_allocatedOffset; }
+        bool                Save( cstring filename ) const;
+
+        // Reading
+        // Returns the root inside blobMemory when versions match and the blob is mappable, otherwise
+        // serializes it into size bytes allocated from allocator. blobSize is the number of readable bytes at blobMemory,
+        // the size in the header has to fit in it and every relative offset has to stay inside that size.
+        // A mapped root is checked with a bool BlobValidate( const BlobSerializer* serializer, const T* root ) function
+        // when there is one, found by argument dependent lookup.
+        template <typename T>
+        T*                  Read( Allocator* allocator, u32 version, sizet size, char* blobMemory, sizet blobSize, bool forceSerialization = false );
+        // Zero parse loading: the root points inside the mapping, which must stay open while it is used.
+        template <typename T>
+        const T*            Map( const MappedFile& file, u32 version, Allocator* allocator, sizet migrationSize );
+
+        // Frees the blob when writing or the migrated data when reading.
+        void                Shutdown();
+
+        // True when the elements of an array read in place lie inside the blob. Strings also need their terminator.
+        template <typename T>
+        bool                IsInBlob( const RelativeArray<T>& array ) const;
+        bool                IsInBlob( const RelativeString& string ) const;
+
+        // Walk, reads from the blob into data or writes data into the blob.
+        template <typename T>
+        void                Serialize( T* data );
+        template <typename T>
+        void                Serialize( RelativePointer<T>* data );
+        template <typename T>
+        void                Serialize( RelativeArray<T>* data );
+        void                Serialize( RelativeString* data );
+
+        void                SerializeMemory( void* data, sizet size, sizet alignment );
+
+        template <typename T>
+        void                SerializeRelativeArray( RelativeArray<T>* data, u32 terminatorCount );
+        void                SerializeRelativeOffset( u32 pointerOffset, i32* relativeOffset );
+        bool                CheckSourceRange( i64 offset, u64 size );
+
+        void                Begin( Allocator* allocator, u32 version, sizet size, sizet rootSize );
+
+        Allocator*          m_allocator         = nullptr;
+        char*               m_blobMemory        = nullptr;
+        char*               m_dataMemory        = nullptr;
+
+        sizet               m_totalSize         = 0;
+        sizet               m_blobSize          = 0;    // Size from the header of the blob being read.
+        u32                 m_serializedOffset  = 0;
+        u32                 m_allocatedOffset   = 0;
+
+        u32                 m_serializerVersion = 0;    // Version of the code.
+        u32                 m_dataVersion       = 0;    // Version of the blob, BlobSerialize functions branch on it.
+
+        bool                m_isReading         = false;
+        bool                m_isMappable        = false;
+        bool                m_hasAllocatedMemory = false;
+        bool                m_hasError          = false;    // Reading went outside of the blob, the result is discarded.
     };
+
+    template <typename T>
+    T* BlobSerializer::WriteAndPrepare( Allocator* allocator, u32 version, sizet size ) {
+        static_assert( alignof( T ) <= k_blob_root_offset );
+        Begin( allocator, version, size, sizeof( T ) );
+        return ( T* )( m_blobMemory + k_blob_root_offset );
+    }
+
+    template <typename T>
+    void BlobSerializer::WriteFull( Allocator* allocator, u32 version, sizet size, T* root ) {
+        static_assert( alignof( T ) <= k_blob_root_offset );
+        Begin( allocator, version, size, sizeof( T ) );
+        Serialize( root );
+    }
+
+    template <typename T>
+    void BlobSerializer::AllocateAndSet( RelativePointer<T>& data, const T* source ) {
+        CASSERT( !m_isReading );
+        char* memory = m_blobMemory + Allocate( sizeof( T ), alignof( T ) );
+        if ( source ) {
+            memcpy( memory, source, sizeof( T ) );
+        }
+        data.Set( memory );
+    }
+
+    template <typename T>
+    void BlobSerializer::AllocateAndSet( RelativeArray<T>& data, u32 count, const T* source ) {
+        CASSERT( !m_isReading );
+        if ( count == 0 ) {
+            data.SetEmpty();
+            return;
+        }
+
+        char* memory = m_blobMemory + Allocate( sizeof( T ) * count, alignof( T ) );
+        if ( source ) {
+            memcpy( memory, source, sizeof( T ) * count );
+        }
+        data.Set( memory, count );
+    }
+
+    template <typename T>
+    T* BlobSerializer::Read( Allocator* allocator, u32 version, sizet size, char* blobMemory, sizet blobSize, bool forceSerialization ) {
+        static_assert( alignof( T ) <= k_blob_root_offset );
+
+        m_allocator = allocator;
+        m_blobMemory = blobMemory;
+        m_dataMemory = nullptr;
+        m_isReading = true;
+        m_hasAllocatedMemory = false;
+        m_hasError = false;
+        m_serializerVersion = version;
+
+        if ( blobSize < k_blob_root_offset ) {
+            error( "BlobSerializer: {} bytes are too few to contain a blob", blobSize );
+            return nullptr;
+        }
+
+        const BlobHeader* header = ( const BlobHeader* )blobMemory;
+        m_dataVersion = header->version;
+        m_isMappable = header->mappable != 0;
+        m_blobSize = header->size;
+
+        // Blobs written before the size was stored have 0 there.
+        if ( m_blobSize < k_blob_root_offset || m_blobSize > blobSize ) {
+            error( "BlobSerializer: blob size {} is invalid for {} bytes of data", m_blobSize, blobSize );
+            return nullptr;
+        }
+
+        if ( m_dataVersion == m_serializerVersion && m_isMappable && !forceSerialization ) {
+            T* root = ( T* )( blobMemory + k_blob_root_offset );
+            if ( m_blobSize < k_blob_root_offset + sizeof( T ) ) {
+                error( "BlobSerializer: blob size {} is too small for its root", m_blobSize );
+                return nullptr;
+            }
+            // Nothing is copied, so nothing gets checked on the way: the type checks what it uses in place.
+            if constexpr ( requires { { BlobValidate( this, root ) } -> std::same_as<bool>; } ) {
+                if ( !BlobValidate( this, root ) ) {
+                    error( "BlobSerializer: mapped blob references data outside of its {} bytes", m_blobSize );
+                    return nullptr;
+                }
+            }
+            return root;
+        }
+
+        if ( m_dataVersion > m_serializerVersion ) {
+            error( "BlobSerializer: data version {} is newer than the code version {}", m_dataVersion, m_serializerVersion );
+            return nullptr;
+        }
+
+        // Migrated data has no header, root comes first.
+        m_totalSize = size;
+        m_dataMemory = callocaa<char>( size, allocator, k_cache_line_size );
+        memset( m_dataMemory, 0, size );
+        m_hasAllocatedMemory = true;
+
+        m_serializedOffset = k_blob_root_offset;
+        m_allocatedOffset = sizeof( T );
+
+        T* root = ( T* )m_dataMemory;
+        Serialize( root );
+        if ( m_hasError ) {
+            error( "BlobSerializer: cannot migrate blob version {} to {}", m_dataVersion, m_serializerVersion );
+            Shutdown();
+            return nullptr;
+        }
+        return root;
+    }
+
+    template <typename T>
+    const T* BlobSerializer::Map( const MappedFile& file, u32 version, Allocator* allocator, sizet migrationSize ) {
+        if ( !file.IsOpen() ) {
+            error( "BlobSerializer: mapped file is not open" );
+            return nullptr;
+        }
+
+        // Reading never writes into the blob, so the read only mapping can be used directly.
+        return Read<T>( allocator, version, migrationSize, ( char* )file.m_data, file.m_size );
+    }
+
+    template <typename T>
+    bool BlobSerializer::IsInBlob( const RelativeArray<T>& array ) const {
+        if ( array.m_size == 0 ) {
+            return true;
+        }
+
+        // Compared as integers, the offset can point anywhere.
+        const sizet address = ( sizet )array.Get();
+        const sizet start = ( sizet )m_blobMemory;
+        return address % alignof( T ) == 0 && address >= start + k_blob_root_offset && ( u64 )( address - start ) + ( u64 )array.m_size * sizeof( T ) <= m_blobSize;
+    }
+
+    template <typename T>
+    void BlobSerializer::Serialize( T* data ) {
+        if constexpr ( std::is_arithmetic_v<T> || std::is_enum_v<T> ) {
+            SerializeMemory( data, sizeof( T ), alignof( T ) );
+        } else if constexpr ( std::is_array_v<T> ) {
+            for ( sizet i = 0; i < std::extent_v<T>; ++i ) {
+                Serialize( &( *data )[ i ] );
+            }
+        } else {
+            // Structures start and end at their alignment, matching their in memory layout.
+            m_serializedOffset = ( u32 )MemoryAlign( m_serializedOffset, alignof( T ) );
+            BlobSerialize( this, data );
+            m_serializedOffset = ( u32 )MemoryAlign( m_serializedOffset, alignof( T ) );
+        }
+    }
+
+    template <typename T>
+    void BlobSerializer::Serialize( RelativePointer<T>* data ) {
+        m_serializedOffset = ( u32 )MemoryAlign( m_serializedOffset, alignof( i32 ) );
+        const u32 pointerOffset = m_serializedOffset;
+        m_serializedOffset += sizeof( i32 );
+
+        if ( m_isReading ) {
+            i32 sourceOffset = 0;
+            if ( !CheckSourceRange( pointerOffset, sizeof( i32 ) ) ) {
+                return;
+            }
+            memcpy( &sourceOffset, m_blobMemory + pointerOffset, sizeof( i32 ) );
+            if ( sourceOffset == 0 ) {
+                data->SetNull();
+                return;
+            }
+
+            // Fields are range checked as they are read, the target only has to start inside the blob.
+            const i64 target = ( i64 )pointerOffset + sourceOffset;
+            if ( !CheckSourceRange( target, 0 ) ) {
+                data->SetNull();
+                return;
+            }
+
+            T* destination = ( T* )( m_dataMemory + Allocate( sizeof( T ), alignof( T ) ) );
+            if ( m_hasError ) {
+                data->SetNull();
+                return;
+            }
+            data->Set( destination );
+
+            const u32 cachedOffset = m_serializedOffset;
+            m_serializedOffset = ( u32 )target;
+            Serialize( destination );
+            m_serializedOffset = cachedOffset;
+        } else {
+            if ( data->IsNull() ) {
+                i32 nullOffset = 0;
+                SerializeRelativeOffset( pointerOffset, &nullOffset );
+                return;
+            }
+
+            const u32 target = Allocate( sizeof( T ), alignof( T ) );
+            i32 relativeOffset = ( i32 )( target - pointerOffset );
+            SerializeRelativeOffset( pointerOffset, &relativeOffset );
+
+            const u32 cachedOffset = m_serializedOffset;
+            m_serializedOffset = target;
+            Serialize( data->Get() );
+            m_serializedOffset = cachedOffset;
+        }
+    }
+
+    template <typename T>
+    void BlobSerializer::Serialize( RelativeArray<T>* data ) {
+        SerializeRelativeArray( data, 0 );
+    }
+
+    template <typename T>
+    void BlobSerializer::SerializeRelativeArray( RelativeArray<T>* data, u32 terminatorCount ) {
+        SerializeMemory( &data->m_size, sizeof( u32 ), alignof( u32 ) );
+
+        m_serializedOffset = ( u32 )MemoryAlign( m_serializedOffset, alignof( i32 ) );
+        const u32 pointerOffset = m_serializedOffset;
+        m_serializedOffset += sizeof( i32 );
+
+        const u32 count = data->m_size ? data->m_size + terminatorCount : 0;
+        if ( count == 0 || ( m_isReading && !CheckSourceRange( pointerOffset, sizeof( i32 ) ) ) ) {
+            if ( m_isReading ) {
+                data->SetEmpty();
+            } else {
+                i32 nullOffset = 0;
+                SerializeRelativeOffset( pointerOffset, &nullOffset );
+            }
+            return;
+        }
+
+        T* elements = nullptr;
+        u32 sourceOffset = 0;
+        if ( m_isReading ) {
+            i32 relativeOffset = 0;
+            memcpy( &relativeOffset, m_blobMemory + pointerOffset, sizeof( i32 ) );
+            const i64 target = ( i64 )pointerOffset + relativeOffset;
+
+            // The elements of older versions can be smaller, only their start is checked here and their fields as they are read.
+            if ( !CheckSourceRange( target, 0 ) ) {
+                data->SetEmpty();
+                return;
+            }
+            elements = ( T* )( m_dataMemory + Allocate( sizeof( T ) * count, alignof( T ) ) );
+            if ( m_hasError ) {
+                data->SetEmpty();
+                return;
+            }
+            sourceOffset = ( u32 )target;
+            data->m_data.Set( elements );
+        } else {
+            sourceOffset = Allocate( sizeof( T ) * count, alignof( T ) );
+            i32 relativeOffset = ( i32 )( sourceOffset - pointerOffset );
+            SerializeRelativeOffset( pointerOffset, &relativeOffset );
+
+            elements = data->Get();
+        }
+
+        const u32 cachedOffset = m_serializedOffset;
+        m_serializedOffset = sourceOffset;
+        if constexpr ( std::is_arithmetic_v<T> || std::is_enum_v<T> ) {
+            // No nested relative data, copy in one go.
+            SerializeMemory( elements, sizeof( T ) * count, alignof( T ) );
+        } else {
+            for ( u32 i = 0; i < count && !m_hasError; ++i ) {
+                Serialize( &elements[ i ] );
+            }
+        }
+        m_serializedOffset = cachedOffset;
+
+        // Terminators are written by the code, never trusted from the blob.
+        if ( m_isReading && terminatorCount && !m_hasError ) {
+            memset( elements + data->m_size, 0, sizeof( T ) * terminatorCount );
+        }
+    }
+}
+
+namespace Caustix {
+    void BlobSerializer::Begin( Allocator* allocator, u32 version, sizet size, sizet rootSize ) {
+        CASSERT( size >= k_blob_root_offset + rootSize );
+
+        m_allocator = allocator;
+        m_totalSize = size;
+        m_blobMemory = callocaa<char>( size, allocator, k_cache_line_size );
+        memset( m_blobMemory, 0, size );
+        m_dataMemory = nullptr;
+
+        m_isReading = false;
+        m_isMappable = true;
+        m_hasAllocatedMemory = true;
+        m_serializerVersion = version;
+        m_dataVersion = version;
+
+        m_serializedOffset = k_blob_root_offset;
+        m_allocatedOffset = ( u32 )( k_blob_root_offset + rootSize );
+
+        BlobHeader* header = ( BlobHeader* )m_blobMemory;
+        header->version = version;
+        header->mappable = 1;
+        header->size = m_allocatedOffset;
+    }
+
+    u32 BlobSerializer::Allocate( sizet size, sizet alignment ) {
+        const sizet offset = MemoryAlign( m_allocatedOffset, alignment );
+        if ( offset + size > m_totalSize ) {
+            error( "BlobSerializer: out of memory allocating {} bytes, {} of {} bytes used", size, m_allocatedOffset, m_totalSize );
+            // Counts read from a malformed blob can ask for anything, reading fails instead.
+            if ( m_isReading ) {
+                m_hasError = true;
+                return 0;
+            }
+            // Relative offsets are taken as soon as memory is allocated, it cannot grow.
+            CASSERT( false );
+            abort();
+        }
+
+        m_allocatedOffset = ( u32 )( offset + size );
+        if ( !m_isReading ) {
+            ( ( BlobHeader* )m_blobMemory )->size = m_allocatedOffset;
+        }
+        return ( u32 )offset;
+    }
+
+    void* BlobSerializer::AllocateStatic( sizet size, sizet alignment ) {
+        char* memory = m_isReading ? m_dataMemory : m_blobMemory;
+        return memory + Allocate( size, alignment );
+    }
+
+    void BlobSerializer::AllocateAndSet( RelativeString& string, cstring source ) {
+        CASSERT( !m_isReading );
+        const u32 length = source ? ( u32 )strlen( source ) : 0;
+        if ( length == 0 ) {
+            string.SetEmpty();
+            return;
+        }
+
+        char* memory = m_blobMemory + Allocate( length + 1, 1 );
+        memcpy( memory, source, length + 1 );
+        string.Set( memory, length );
+    }
+
+    bool BlobSerializer::Save( cstring filename ) const {
+        CASSERT( !m_isReading && m_blobMemory );
+        return FileWriteBinary( filename, m_blobMemory, m_allocatedOffset );
+    }
+
+    void BlobSerializer::Shutdown() {
+        if ( m_hasAllocatedMemory ) {
+            cfree( m_isReading ? m_dataMemory : m_blobMemory, m_allocator );
+        }
+
+        m_blobMemory = nullptr;
+        m_dataMemory = nullptr;
+        m_hasAllocatedMemory = false;
+        m_serializedOffset = 0;
+        m_allocatedOffset = 0;
+    }
+
+    void BlobSerializer::Serialize( RelativeString* data ) {
+        SerializeRelativeArray<char>( data, 1 );
+    }
+
+    void BlobSerializer::SerializeMemory( void* data, sizet size, sizet alignment ) {
+        m_serializedOffset = ( u32 )MemoryAlign( m_serializedOffset, alignment );
+        if ( m_isReading ) {
+            if ( !CheckSourceRange( m_serializedOffset, size ) ) {
+                return;
+            }
+            memcpy( data, m_blobMemory + m_serializedOffset, size );
+        } else {
+            memcpy( m_blobMemory + m_serializedOffset, data, size );
+        }
+        m_serializedOffset += ( u32 )size;
+    }
+
+    void BlobSerializer::SerializeRelativeOffset( u32 pointerOffset, i32* relativeOffset ) {
+        memcpy( m_blobMemory + pointerOffset, relativeOffset, sizeof( i32 ) );
+    }
+
+    bool BlobSerializer::CheckSourceRange( i64 offset, u64 size ) {
+        if ( m_hasError ) {
+            return false;
+        }
+
+        if ( offset < k_blob_root_offset || ( u64 )offset + size > m_blobSize ) {
+            error( "BlobSerializer: {} bytes at offset {} are outside of the {} bytes blob", size, offset, m_blobSize );
+            m_hasError = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool BlobSerializer::IsInBlob( const RelativeString& string ) const {
+        if ( string.m_size == 0 ) {
+            return true;
+        }
+
+        const sizet address = ( sizet )string.Get();
+        const sizet start = ( sizet )m_blobMemory;
+        return address >= start + k_blob_root_offset && ( u64 )( address - start ) + string.m_size + 1 <= m_blobSize && string.Get()[ string.m_size ] == '\0';
+    }
 }
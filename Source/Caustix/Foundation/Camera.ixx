@@ -44,6 +44,9 @@ export namespace Caustix {
 
         static void YawPitchFromDirection(const vec3s &direction, f32 &yaw, f32 &pitch);
 
+        // Pixels covered by a length facing the camera at the given view distance, for screen space error metrics.
+        f32 ProjectLength(f32 length, f32 distance, f32 viewportHeight) const;
+
         mat4s m_view;
         mat4s m_projection;
         mat4s m_viewProjection;
@@ -185,6 +188,11 @@ namespace Caustix {
         glm_ortho(0, m_viewportWidth * m_zoom, 0, m_viewportHeight * m_zoom, -1.f, 1.f, outMatrix);
     }
 
+    f32 Camera::ProjectLength(f32 length, f32 distance, f32 viewportHeight) const {
+        const f32 pixels = length * m_projection.m11 * viewportHeight * 0.5f;
+        return m_perspective ? pixels / glm_max(distance, m_nearPlane) : pixels;
+    }
+
     void Camera::YawPitchFromDirection(const vec3s &direction, f32 &yaw, f32 &pitch) {
         yaw = glm_deg(atan2f(direction.z, direction.x));
         pitch = glm_deg(asinf(direction.y));
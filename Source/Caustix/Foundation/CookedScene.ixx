@@ -0,0 +1,163 @@
+export module Foundation.CookedScene;
+
+import Foundation.Blob;
+import Foundation.Platform;
+
+export namespace Caustix {
+    // Binary scene produced offline from glTF by the Cooker.
+    // Everything is stored the way the renderer consumes it: vertex and index streams ready to be
+    // copied into GPU buffers, nodes with their world matrices already composed and textures decoded
+    // to RGBA8. The file is a Blob, so when its version matches it is memory mapped and used in place.
+    static constexpr u32        k_cooked_scene_version      = 1;
+    static constexpr u32        k_cooked_invalid_index      = u32_max;
+    static constexpr cstring    k_cooked_scene_extension    = ".cscene";
+
+    // Vertex streams inside CookedScene::m_vertexData start at this alignment.
+    static constexpr u32        k_cooked_stream_alignment   = 16;
+
+    enum CookedTextureSlot : u32 {
+        CookedTextureSlot_Color,
+        CookedTextureSlot_MetallicRoughness,
+        CookedTextureSlot_Occlusion,
+        CookedTextureSlot_Emissive,
+        CookedTextureSlot_Normal,
+        CookedTextureSlot_Count
+    };
+
+    enum CookedIndexType : u32 {
+        CookedIndexType_Uint16,
+        CookedIndexType_Uint32
+    };
+
+    // RGBA8 pixels, a single mip.
+    struct CookedTexture {
+        u32                         m_width;
+        u32                         m_height;
+        RelativeArray<u8>           m_pixels;
+        RelativeString              m_name;
+    };
+
+    // glTF filter and wrap enumerants.
+    struct CookedSampler {
+        i32                         m_minFilter;
+        i32                         m_magFilter;
+        i32                         m_wrapS;
+        i32                         m_wrapT;
+    };
+
+    struct CookedMaterial {
+        f32                         m_baseColorFactor[ 4 ];
+        f32                         m_emissiveFactor[ 3 ];
+        f32                         m_metallicFactor;
+        f32                         m_roughnessFactor;
+        f32                         m_occlusionFactor;
+
+        // Indices in CookedScene::m_textures and m_samplers, k_cooked_invalid_index when unused.
+        u32                         m_textures[ CookedTextureSlot_Count ];
+        u32                         m_samplers[ CookedTextureSlot_Count ];
+    };
+
+    // Nodes are sorted so that parents come before their children.
+    struct CookedNode {
+        u32                         m_parent;
+        f32                         m_localMatrix[ 16 ];
+        f32                         m_worldMatrix[ 16 ];
+    };
+
+    // Offsets are in bytes inside the scene vertex and index data, k_cooked_invalid_index for missing attributes.
+    struct CookedPrimitive {
+        u32                         m_node;
+        u32                         m_material;
+
+        u32                         m_indexType;
+        u32                         m_indexCount;
+        u32                         m_indexOffset;
+
+        u32                         m_vertexCount;
+        u32                         m_positionOffset;   // f32 x3
+        u32                         m_tangentOffset;    // f32 x4
+        u32                         m_normalOffset;     // f32 x3
+        u32                         m_texcoordOffset;   // f32 x2
+    };
+
+    struct CookedScene {
+        RelativeArray<CookedNode>       m_nodes;
+        RelativeArray<CookedPrimitive>  m_primitives;
+        RelativeArray<CookedMaterial>   m_materials;
+        RelativeArray<CookedTexture>    m_textures;
+        RelativeArray<CookedSampler>    m_samplers;
+
+        RelativeArray<u8>               m_vertexData;
+        RelativeArray<u8>               m_indexData;
+    };
+
+    void BlobSerialize( BlobSerializer* serializer, CookedTexture* data ) {
+        serializer->Serialize( &data->m_width );
+        serializer->Serialize( &data->m_height );
+        serializer->Serialize( &data->m_pixels );
+        serializer->Serialize( &data->m_name );
+    }
+
+    void BlobSerialize( BlobSerializer* serializer, CookedSampler* data ) {
+        serializer->Serialize( &data->m_minFilter );
+        serializer->Serialize( &data->m_magFilter );
+        serializer->Serialize( &data->m_wrapS );
+        serializer->Serialize( &data->m_wrapT );
+    }
+
+    void BlobSerialize( BlobSerializer* serializer, CookedMaterial* data ) {
+        serializer->Serialize( &data->m_baseColorFactor );
+        serializer->Serialize( &data->m_emissiveFactor );
+        serializer->Serialize( &data->m_metallicFactor );
+        serializer->Serialize( &data->m_roughnessFactor );
+        serializer->Serialize( &data->m_occlusionFactor );
+        serializer->Serialize( &data->m_textures );
+        serializer->Serialize( &data->m_samplers );
+    }
+
+    void BlobSerialize( BlobSerializer* serializer, CookedNode* data ) {
+        serializer->Serialize( &data->m_parent );
+        serializer->Serialize( &data->m_localMatrix );
+        serializer->Serialize( &data->m_worldMatrix );
+    }
+
+    void BlobSerialize( BlobSerializer* serializer, CookedPrimitive* data ) {
+        serializer->Serialize( &data->m_node );
+        serializer->Serialize( &data->m_material );
+        serializer->Serialize( &data->m_indexType );
+        serializer->Serialize( &data->m_indexCount );
+        serializer->Serialize( &data->m_indexOffset );
+        serializer->Serialize( &data->m_vertexCount );
+        serializer->Serialize( &data->m_positionOffset );
+        serializer->Serialize( &data->m_tangentOffset );
+        serializer->Serialize( &data->m_normalOffset );
+        serializer->Serialize( &data->m_texcoordOffset );
+    }
+
+    // A mapped scene is used in place: its arrays and the textures uploaded from them have to stay inside the file.
+    bool BlobValidate( const BlobSerializer* serializer, const CookedScene* data ) {
+        if ( !serializer->IsInBlob( data->m_nodes ) || !serializer->IsInBlob( data->m_primitives ) || !serializer->IsInBlob( data->m_materials ) ||
+             !serializer->IsInBlob( data->m_textures ) || !serializer->IsInBlob( data->m_samplers ) ||
+             !serializer->IsInBlob( data->m_vertexData ) || !serializer->IsInBlob( data->m_indexData ) ) {
+            return false;
+        }
+
+        for ( const CookedTexture& texture : data->m_textures ) {
+            if ( !serializer->IsInBlob( texture.m_pixels ) || !serializer->IsInBlob( texture.m_name ) ||
+                 ( u64 )texture.m_width * texture.m_height * 4 > texture.m_pixels.m_size ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void BlobSerialize( BlobSerializer* serializer, CookedScene* data ) {
+        serializer->Serialize( &data->m_nodes );
+        serializer->Serialize( &data->m_primitives );
+        serializer->Serialize( &data->m_materials );
+        serializer->Serialize( &data->m_textures );
+        serializer->Serialize( &data->m_samplers );
+        serializer->Serialize( &data->m_vertexData );
+        serializer->Serialize( &data->m_indexData );
+    }
+}
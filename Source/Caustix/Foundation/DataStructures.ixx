@@ -1,5 +1,7 @@
 module;
 
+#include <bit>
+#include <string.h>
 #include <string>
 
 export module Foundation.DataStructures;
@@ -11,27 +13,68 @@ import Foundation.Log;
 
 export namespace Caustix {
 
+    // Handles returned by the pools pack the slot index in the low bits and the slot generation in the high bits,
+    // so a handle kept after its resource was released does not alias the next resource using the same slot.
+    static constexpr u32 k_resource_index_bits      = 20;
+    static constexpr u32 k_resource_index_mask      = ( 1u << k_resource_index_bits ) - 1;
+    static constexpr u32 k_resource_generation_mask = ( 1u << ( 32 - k_resource_index_bits ) ) - 1;
+
+    // Resources, generations and liveness bits of a page of the pool.
+    // Pages are never moved, so pointers to resources stay valid when the pool grows.
+    struct ResourcePage {
+        u8*         m_memory        = nullptr;
+        u16*        m_generations   = nullptr;
+        u64*        m_alive         = nullptr;
+    };
+
     struct ResourcePool {
         ResourcePool(Allocator* allocator, u32 poolSize, u32 resourceSize);
         ~ResourcePool();
 
-        u32     ObtainResource();      // Returns an index to the resource
-        void    ReleaseResource( u32 index );
+        u32     ObtainResource();      // Returns a handle to the resource
+        void    ReleaseResource( u32 handle );
         void    FreeAllResources();
 
-        void*           AccessResource( u32 index );
-        const void*     AccessResource( u32 index ) const;
+        void*           AccessResource( u32 handle );
+        const void*     AccessResource( u32 handle ) const;
 
-        u8*         m_memory        = nullptr;
-        u32*        m_freeIndices   = nullptr;
-        Allocator*  m_allocator     = nullptr;
+        bool            IsAlive( u32 handle ) const;
 
-        u32     m_freeIndicesHead   = 0;
-        u32     m_poolSize          = 16;
+        // Calls func( handle ) for every live resource, skipping free slots 64 at a time.
+        template <typename Func>
+        void            ForEachAlive( Func&& func ) const;
+
+        bool            AddPage();
+
+        ResourcePage*   m_pages         = nullptr;
+        u32*            m_freeIndices   = nullptr;
+        Allocator*      m_allocator     = nullptr;
+
+        u32     m_freeIndicesCount  = 0;
+        u32     m_pageCount         = 0;
+        u32     m_pageCapacity      = 0;
+        u32     m_pageSize          = 64;   // Resources per page, power of two and multiple of 64.
+        u32     m_pageShift         = 6;
+        u32     m_capacity          = 0;
         u32     m_resourceSize      = 4;
         u32     m_usedIndices       = 0;
     };
 
+    template <typename Func>
+    inline void ResourcePool::ForEachAlive( Func&& func ) const {
+        for ( u32 p = 0; p < m_pageCount; ++p ) {
+            const ResourcePage& page = m_pages[ p ];
+            for ( u32 w = 0; w < m_pageSize / 64; ++w ) {
+                u64 bits = page.m_alive[ w ];
+                while ( bits ) {
+                    const u32 local = w * 64 + std::countr_zero( bits );
+                    bits &= bits - 1;
+                    func( ( ( u32 )page.m_generations[ local ] << k_resource_index_bits ) | ( ( p << m_pageShift ) + local ) );
+                }
+            }
+        }
+    }
+
     template <typename T>
     struct ResourcePoolTyped : public ResourcePool {
         ResourcePoolTyped( Allocator* allocator, u32 pool_size );
@@ -85,75 +128,138 @@ namespace Caustix {
 // Resource Pool ////////////////////////////////////////////////////////////////
     ResourcePool::ResourcePool(Caustix::Allocator *allocator, u32 poolSize, u32 resourceSize)
     : m_allocator(allocator)
-    , m_poolSize(poolSize)
     , m_resourceSize(resourceSize) {
-        // Group allocate ( resource size + u32 )
-        sizet allocation_size = poolSize * (resourceSize + sizeof(u32));
-        m_memory = (u8*)allocator->allocate( allocation_size, 1 );
-        memset( m_memory, 0, allocation_size );
+        // Page size is the initial pool size rounded to a power of two, so slot lookup is a shift and a mask.
+        m_pageSize = std::bit_ceil( poolSize < 64 ? 64u : poolSize );
+        m_pageShift = std::countr_zero( m_pageSize );
+
+        AddPage();
+    }
 
-        // Allocate and add free indices
-        m_freeIndices = ( u32* )( m_memory + m_poolSize * m_resourceSize );
-        m_freeIndicesHead = 0;
+    ResourcePool::~ResourcePool() {
+        if ( m_usedIndices != 0 ) {
+            info( "Resource pool has unfreed resources." );
 
-        for ( u32 i = 0; i < m_poolSize; ++i ) {
-            m_freeIndices[i] = i;
+            ForEachAlive( []( u32 handle ) {
+                info( "\tResource {} generation {}", handle & k_resource_index_mask, handle >> k_resource_index_bits );
+            } );
         }
 
-        m_usedIndices = 0;
+        CASSERT( m_usedIndices == 0 );
+
+        for ( u32 i = 0; i < m_pageCount; ++i ) {
+            m_allocator->deallocate( m_pages[ i ].m_memory );
+        }
+        m_allocator->deallocate( m_pages );
+        m_allocator->deallocate( m_freeIndices );
     }
 
-    ResourcePool::~ResourcePool() {
-        if ( m_freeIndicesHead != 0 ) {
-            info( "Resource pool has unfreed resources.\n" );
+    bool ResourcePool::AddPage() {
+        if ( m_capacity + m_pageSize > k_resource_index_mask ) {
+            error( "Resource pool reached the maximum of {} resources", m_capacity );
+            return false;
+        }
 
-            for ( u32 i = 0; i < m_freeIndicesHead; ++i ) {
-                info( "\tResource {}", m_freeIndices[ i ] );
+        if ( m_pageCount == m_pageCapacity ) {
+            const u32 new_page_capacity = m_pageCapacity ? m_pageCapacity * 2 : 4;
+            ResourcePage* new_pages = ( ResourcePage* )m_allocator->allocate( sizeof( ResourcePage ) * new_page_capacity, alignof( ResourcePage ) );
+            if ( m_pages ) {
+                memcpy( new_pages, m_pages, sizeof( ResourcePage ) * m_pageCount );
+                m_allocator->deallocate( m_pages );
             }
+            m_pages = new_pages;
+            m_pageCapacity = new_page_capacity;
         }
 
-        CASSERT( m_usedIndices == 0 );
+        // Group allocate ( resources + liveness bits + generations )
+        const sizet resources_size = MemoryAlign( ( sizet )m_pageSize * m_resourceSize, 64 );
+        const sizet alive_size = m_pageSize / 8;
+        const sizet allocation_size = resources_size + alive_size + m_pageSize * sizeof( u16 );
+        u8* memory = ( u8* )m_allocator->allocate( allocation_size, 64 );
+        memset( memory, 0, allocation_size );
+
+        ResourcePage& page = m_pages[ m_pageCount ];
+        page.m_memory = memory;
+        page.m_alive = ( u64* )( memory + resources_size );
+        page.m_generations = ( u16* )( memory + resources_size + alive_size );
+
+        // Free indices of all the pages always fit, the list is sized for the whole capacity.
+        const u32 new_capacity = m_capacity + m_pageSize;
+        u32* new_free_indices = ( u32* )m_allocator->allocate( sizeof( u32 ) * new_capacity, alignof( u32 ) );
+        // New slots go below the existing free ones, lowest index first.
+        for ( u32 i = 0; i < m_pageSize; ++i ) {
+            new_free_indices[ i ] = new_capacity - 1 - i;
+        }
+        if ( m_freeIndices ) {
+            memcpy( new_free_indices + m_pageSize, m_freeIndices, sizeof( u32 ) * m_freeIndicesCount );
+            m_allocator->deallocate( m_freeIndices );
+        }
+        m_freeIndices = new_free_indices;
+        m_freeIndicesCount += m_pageSize;
 
-        m_allocator->deallocate( m_memory );
+        m_capacity = new_capacity;
+        ++m_pageCount;
+        return true;
     }
 
     void ResourcePool::FreeAllResources() {
-        m_freeIndicesHead = 0;
-        m_usedIndices = 0;
-
-        for ( uint32_t i = 0; i < m_poolSize; ++i ) {
-            m_freeIndices[i] = i;
-        }
+        ForEachAlive( [this]( u32 handle ) {
+            ReleaseResource( handle );
+        } );
     }
 
     u32 ResourcePool::ObtainResource() {
-        // TODO: add bits for checking if resource is alive and use bitmasks.
-        if ( m_freeIndicesHead < m_poolSize ) {
-            const u32 free_index = m_freeIndices[m_freeIndicesHead++];
-            ++m_usedIndices;
-            return free_index;
+        if ( m_freeIndicesCount == 0 && !AddPage() ) {
+            // Error: no more resources left!
+            CASSERT( false );
+            return k_invalid_index;
         }
-        // Error: no more resources left!
-        CASSERT( false );
-        return k_invalid_index;
+
+        const u32 index = m_freeIndices[ --m_freeIndicesCount ];
+        ResourcePage& page = m_pages[ index >> m_pageShift ];
+        const u32 local = index & ( m_pageSize - 1 );
+        page.m_alive[ local / 64 ] |= 1ull << ( local % 64 );
+        ++m_usedIndices;
+
+        return ( ( u32 )page.m_generations[ local ] << k_resource_index_bits ) | index;
     }
 
-    void ResourcePool::ReleaseResource(u32 index) {
-        // TODO: add bits for checking if resource is alive and use bitmasks.
-        m_freeIndices[--m_freeIndicesHead] = index;
+    void ResourcePool::ReleaseResource(u32 handle) {
+        if ( !IsAlive( handle ) ) {
+            error( "Resource pool: releasing stale or invalid handle {} generation {}", handle & k_resource_index_mask, handle >> k_resource_index_bits );
+            return;
+        }
+
+        const u32 index = handle & k_resource_index_mask;
+        ResourcePage& page = m_pages[ index >> m_pageShift ];
+        const u32 local = index & ( m_pageSize - 1 );
+        page.m_alive[ local / 64 ] &= ~( 1ull << ( local % 64 ) );
+        // Invalidate all the outstanding handles to this slot.
+        page.m_generations[ local ] = ( u16 )( ( page.m_generations[ local ] + 1 ) & k_resource_generation_mask );
+
+        m_freeIndices[ m_freeIndicesCount++ ] = index;
         --m_usedIndices;
     }
 
-    void* ResourcePool::AccessResource( u32 index ) {
-        if ( index != k_invalid_index ) {
-            return &m_memory[index * m_resourceSize];
+    bool ResourcePool::IsAlive( u32 handle ) const {
+        const u32 index = handle & k_resource_index_mask;
+        if ( handle == k_invalid_index || index >= m_capacity ) {
+            return false;
         }
-        return nullptr;
+
+        const ResourcePage& page = m_pages[ index >> m_pageShift ];
+        const u32 local = index & ( m_pageSize - 1 );
+        return ( page.m_alive[ local / 64 ] & ( 1ull << ( local % 64 ) ) ) && page.m_generations[ local ] == ( handle >> k_resource_index_bits );
+    }
+
+    void* ResourcePool::AccessResource( u32 handle ) {
+        return const_cast<void*>( static_cast<const ResourcePool*>( this )->AccessResource( handle ) );
     }
 
-    const void* ResourcePool::AccessResource( u32 index ) const {
-        if ( index != k_invalid_index ) {
-            return &m_memory[index * m_resourceSize];
+    const void* ResourcePool::AccessResource( u32 handle ) const {
+        if ( IsAlive( handle ) ) {
+            const u32 index = handle & k_resource_index_mask;
+            return &m_pages[ index >> m_pageShift ].m_memory[ ( index & ( m_pageSize - 1 ) ) * m_resourceSize ];
         }
         return nullptr;
     }
@@ -3,6 +3,17 @@ module;
 #include <stdio.h>
 
 #include <filesystem>
+#include <span>
+
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 export module Foundation.File;
 
@@ -23,8 +34,42 @@ export namespace Caustix {
     FileReadResult  FileReadBinary(cstring filename, Allocator* allocator);
     FileReadResult  FileReadText(cstring filename, Allocator* allocator);
 
+    bool            FileWriteBinary(cstring filename, const void* memory, sizet size);
+
     void FileDirectoryFromPath( char* path );
     void FileNameFromPath( char* path );
+
+    enum class FileAccessHint {
+        Normal,
+        Sequential,     // Read once front to back, aggressive read-ahead.
+        Random,         // Sparse reads, no read-ahead.
+        WillNeed        // Whole range is needed soon, start reading it in the background.
+    };
+
+    // Read-only memory mapping of a whole file.
+    // Data is paged in from the page cache on access, nothing is copied into the heap.
+    // Open fails for empty files, a successful Open always leaves IsOpen() true.
+    struct MappedFile {
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile( const MappedFile& ) = delete;
+        MappedFile&             operator=( const MappedFile& ) = delete;
+        MappedFile( MappedFile&& other ) noexcept;
+        MappedFile&             operator=( MappedFile&& other ) noexcept;
+
+        bool                    Open( cstring filename, FileAccessHint hint = FileAccessHint::Sequential );
+        void                    Close();
+
+        void                    Advise( sizet offset, sizet size, FileAccessHint hint );
+
+        std::span<const u8>     GetSpan() const                                 { return { m_data, m_size }; }
+        std::span<const u8>     GetSpan( sizet offset, sizet size ) const       { return { m_data + offset, size }; }
+        bool                    IsOpen() const                                  { return m_data != nullptr; }
+
+        const u8*               m_data          = nullptr;
+        sizet                   m_size          = 0;
+    };
 }
 
 namespace Caustix {
@@ -91,6 +136,19 @@ namespace Caustix {
         return result;
     }
 
+    bool FileWriteBinary(cstring filename, const void* memory, sizet size) {
+        FILE* file = fopen( filename, "wb" );
+        if ( !file ) {
+            error( "Error opening {} for writing", filename );
+            return false;
+        }
+
+        const sizet written = fwrite( memory, 1, size, file );
+        fclose( file );
+
+        return written == size;
+    }
+
     FileReadResult  FileReadText(cstring filename, Allocator* allocator) {
         FileReadResult result{ nullptr, 0 };
 
@@ -148,4 +206,162 @@ namespace Caustix {
             path[ name_length ] = 0;
         }
     }
+
+    // MappedFile /////////////////////////////////////////////////////////////
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    MappedFile::MappedFile( MappedFile&& other ) noexcept
+    : m_data( other.m_data )
+    , m_size( other.m_size ) {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept {
+        if ( this != &other ) {
+            Close();
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+#if defined(_MSC_VER)
+
+    bool MappedFile::Open( cstring filename, FileAccessHint hint ) {
+        Close();
+
+        const DWORD flags = hint == FileAccessHint::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : ( hint == FileAccessHint::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL );
+        HANDLE file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr );
+        if ( file == INVALID_HANDLE_VALUE ) {
+            error( "Cannot open file {}", filename );
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        GetFileSizeEx( file, &file_size );
+        m_size = ( sizet )file_size.QuadPart;
+
+        // Nothing to map, fail so that the result always agrees with IsOpen().
+        if ( m_size == 0 ) {
+            error( "Cannot map empty file {}", filename );
+            CloseHandle( file );
+            return false;
+        }
+
+        // The view keeps the file referenced, both handles can be closed right away.
+        HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        CloseHandle( file );
+        if ( mapping == nullptr ) {
+            error( "Cannot map file {}", filename );
+            m_size = 0;
+            return false;
+        }
+
+        m_data = ( const u8* )MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+        CloseHandle( mapping );
+        if ( m_data == nullptr ) {
+            error( "Cannot map file {}", filename );
+            m_size = 0;
+            return false;
+        }
+
+        if ( hint == FileAccessHint::WillNeed ) {
+            Advise( 0, m_size, hint );
+        }
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if ( m_data ) {
+            UnmapViewOfFile( m_data );
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    void MappedFile::Advise( sizet offset, sizet size, FileAccessHint hint ) {
+        // Only prefetching has an equivalent on a mapped view.
+        if ( hint == FileAccessHint::WillNeed && m_data ) {
+            WIN32_MEMORY_RANGE_ENTRY range{ ( PVOID )( m_data + offset ), size };
+            PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+        }
+    }
+
+#else
+
+    static i32 MappedFileAdvice( FileAccessHint hint ) {
+        switch ( hint ) {
+            case FileAccessHint::Sequential:
+                return MADV_SEQUENTIAL;
+            case FileAccessHint::Random:
+                return MADV_RANDOM;
+            case FileAccessHint::WillNeed:
+                return MADV_WILLNEED;
+            default:
+                return MADV_NORMAL;
+        }
+    }
+
+    bool MappedFile::Open( cstring filename, FileAccessHint hint ) {
+        Close();
+
+        const i32 file = open( filename, O_RDONLY );
+        if ( file < 0 ) {
+            error( "Cannot open file {}", filename );
+            return false;
+        }
+
+        struct stat file_stat;
+        if ( fstat( file, &file_stat ) != 0 ) {
+            error( "Cannot read size of file {}", filename );
+            close( file );
+            return false;
+        }
+        m_size = ( sizet )file_stat.st_size;
+
+        // Nothing to map, fail so that the result always agrees with IsOpen().
+        if ( m_size == 0 ) {
+            error( "Cannot map empty file {}", filename );
+            close( file );
+            return false;
+        }
+
+        // The mapping keeps the file referenced, the descriptor can be closed right away.
+        void* data = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0 );
+        close( file );
+        if ( data == MAP_FAILED ) {
+            error( "Cannot map file {}", filename );
+            m_size = 0;
+            return false;
+        }
+
+        m_data = ( const u8* )data;
+        Advise( 0, m_size, hint );
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if ( m_data ) {
+            munmap( ( void* )m_data, m_size );
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    void MappedFile::Advise( sizet offset, sizet size, FileAccessHint hint ) {
+        if ( m_data == nullptr ) {
+            return;
+        }
+        // madvise needs a page aligned start.
+        const sizet page_size = ( sizet )sysconf( _SC_PAGESIZE );
+        const sizet aligned_offset = offset & ~( page_size - 1 );
+        madvise( ( void* )( m_data + aligned_offset ), size + ( offset - aligned_offset ), MappedFileAdvice( hint ) );
+    }
+
+#endif // _MSC_VER
 }
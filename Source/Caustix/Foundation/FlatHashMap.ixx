@@ -0,0 +1,376 @@
+module;
+
+#include <string.h>
+
+#include <bit>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CAUSTIX_FLAT_HASH_MAP_SSE2
+#endif
+
+export module Foundation.FlatHashMap;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Platform;
+import Foundation.Assert;
+
+export namespace Caustix {
+
+    template <typename K>
+    struct FlatHash {
+        u64 operator()( const K& key ) const { return HashCalculate( key ); }
+    };
+
+    // Open addressing hash map with Swiss table style control bytes.
+    // Every slot has a control byte holding 7 bits of the hash, or k_empty. Lookups compare 16 control bytes
+    // at once and only touch the slots whose hash bits match.
+    // Probing is linear and erase shifts the following entries back, so there are no tombstones:
+    // the first empty control byte always ends a probe sequence, however many erases happened.
+    // Iteration starts after an empty slot and wraps around to it. A shift never crosses an empty slot, so
+    // erasing while iterating only ever moves entries that have not been visited yet.
+    template <typename K, typename V, typename Hash = FlatHash<K>>
+    struct FlatHashMap {
+        using value_type = std::pair<const K, V>;
+
+        static constexpr u32    k_group_size        = 16;
+        static constexpr u32    k_min_capacity      = 16;
+        static constexpr u8     k_empty             = 0x80;
+
+        template <typename M, typename T>
+        struct IteratorBase {
+            T&              operator*() const   { return m_map->m_slots[ m_index ]; }
+            T*              operator->() const  { return &m_map->m_slots[ m_index ]; }
+
+            IteratorBase&   operator++() {
+                if ( m_stop == u32_max ) {
+                    m_stop = m_map->FirstEmpty();
+                }
+                m_index = m_map->NextFull( m_index + 1, m_stop );
+                return *this;
+            }
+            IteratorBase    operator++( int )   { IteratorBase result = *this; ++( *this ); return result; }
+
+            bool            operator==( const IteratorBase& other ) const { return m_index == other.m_index; }
+            bool            operator!=( const IteratorBase& other ) const { return m_index != other.m_index; }
+
+            M*              m_map;
+            u32             m_index;
+            u32             m_stop          = u32_max;  // Empty slot ending the iteration, found on first use.
+        };
+
+        using iterator          = IteratorBase<FlatHashMap, value_type>;
+        using const_iterator    = IteratorBase<const FlatHashMap, const value_type>;
+
+        FlatHashMap( Allocator& allocator );
+        ~FlatHashMap();
+
+        FlatHashMap( const FlatHashMap& ) = delete;
+        FlatHashMap&        operator=( const FlatHashMap& ) = delete;
+
+        iterator            find( const K& key );
+        const_iterator      find( const K& key ) const;
+        bool                contains( const K& key ) const      { return FindIndex( key ) != m_capacity; }
+
+        template <typename... Args>
+        std::pair<iterator, bool> emplace( const K& key, Args&&... args );
+        std::pair<iterator, bool> insert( const value_type& value ) { return emplace( value.first, value.second ); }
+        V&                  operator[]( const K& key );
+
+        sizet               erase( const K& key );
+        iterator            erase( iterator it );
+
+        void                reserve( sizet count );
+        void                clear();
+
+        sizet               size() const                        { return m_size; }
+        bool                empty() const                       { return m_size == 0; }
+
+        iterator            begin()                             { const u32 stop = FirstEmpty(); return { this, NextFull( stop + 1, stop ), stop }; }
+        iterator            end()                               { return { this, m_capacity }; }
+        const_iterator      begin() const                       { const u32 stop = FirstEmpty(); return { this, NextFull( stop + 1, stop ), stop }; }
+        const_iterator      end() const                         { return { this, m_capacity }; }
+
+        // Internals
+        static u8           H2( u64 hash )                      { return ( u8 )( hash & 0x7f ); }
+        u32                 H1( u64 hash ) const                { return ( u32 )( hash >> 7 ) & ( m_capacity - 1 ); }
+
+        u32                 MatchGroup( u32 position, u8 h2 ) const;
+        u32                 EmptyGroup( u32 position ) const;
+
+        u32                 FindIndex( const K& key ) const;
+        u32                 FirstEmpty() const;
+        u32                 NextFull( u32 index, u32 stop ) const;
+        void                SetControl( u32 index, u8 control );
+        void                Rehash( u32 newCapacity );
+
+        Allocator*          m_allocator     = nullptr;
+        // Capacity control bytes followed by a copy of the first k_group_size ones, so groups never wrap.
+        u8*                 m_control       = nullptr;
+        value_type*         m_slots         = nullptr;
+        u32                 m_capacity      = 0;
+        u32                 m_size          = 0;
+        u32                 m_growthLeft    = 0;
+    };
+
+    template <typename K, typename V, typename Hash>
+    FlatHashMap<K, V, Hash>::FlatHashMap( Allocator& allocator )
+    : m_allocator( &allocator ) {
+    }
+
+    template <typename K, typename V, typename Hash>
+    FlatHashMap<K, V, Hash>::~FlatHashMap() {
+        clear();
+        if ( m_control ) {
+            m_allocator->deallocate( m_control );
+        }
+    }
+
+    template <typename K, typename V, typename Hash>
+    inline u32 FlatHashMap<K, V, Hash>::MatchGroup( u32 position, u8 h2 ) const {
+#if defined(CAUSTIX_FLAT_HASH_MAP_SSE2)
+        const __m128i group = _mm_loadu_si128( ( const __m128i* )( m_control + position ) );
+        return ( u32 )_mm_movemask_epi8( _mm_cmpeq_epi8( group, _mm_set1_epi8( ( char )h2 ) ) );
+#else
+        u32 mask = 0;
+        for ( u32 i = 0; i < k_group_size; ++i ) {
+            mask |= ( m_control[ position + i ] == h2 ) << i;
+        }
+        return mask;
+#endif // CAUSTIX_FLAT_HASH_MAP_SSE2
+    }
+
+    template <typename K, typename V, typename Hash>
+    inline u32 FlatHashMap<K, V, Hash>::EmptyGroup( u32 position ) const {
+#if defined(CAUSTIX_FLAT_HASH_MAP_SSE2)
+        // Only empty control bytes have the high bit set.
+        const __m128i group = _mm_loadu_si128( ( const __m128i* )( m_control + position ) );
+        return ( u32 )_mm_movemask_epi8( group );
+#else
+        u32 mask = 0;
+        for ( u32 i = 0; i < k_group_size; ++i ) {
+            mask |= ( ( m_control[ position + i ] & k_empty ) != 0 ) << i;
+        }
+        return mask;
+#endif // CAUSTIX_FLAT_HASH_MAP_SSE2
+    }
+
+    template <typename K, typename V, typename Hash>
+    u32 FlatHashMap<K, V, Hash>::FindIndex( const K& key ) const {
+        if ( m_size == 0 ) {
+            return m_capacity;
+        }
+
+        const u64 hash = Hash{}( key );
+        const u8 h2 = H2( hash );
+        const u32 mask = m_capacity - 1;
+        u32 position = H1( hash );
+
+        while ( true ) {
+            u32 matches = MatchGroup( position, h2 );
+            while ( matches ) {
+                const u32 index = ( position + std::countr_zero( matches ) ) & mask;
+                if ( m_slots[ index ].first == key ) {
+                    return index;
+                }
+                matches &= matches - 1;
+            }
+
+            if ( EmptyGroup( position ) ) {
+                return m_capacity;
+            }
+            position = ( position + k_group_size ) & mask;
+        }
+    }
+
+    template <typename K, typename V, typename Hash>
+    u32 FlatHashMap<K, V, Hash>::FirstEmpty() const {
+        // The load factor keeps at least one slot empty.
+        for ( u32 position = 0; position < m_capacity; position += k_group_size ) {
+            const u32 empties = EmptyGroup( position );
+            if ( empties ) {
+                return ( position + std::countr_zero( empties ) ) & ( m_capacity - 1 );
+            }
+        }
+        return 0;
+    }
+
+    // Next full slot from index on, wrapping around, or m_capacity once the stop slot is reached.
+    template <typename K, typename V, typename Hash>
+    u32 FlatHashMap<K, V, Hash>::NextFull( u32 index, u32 stop ) const {
+        if ( m_size == 0 ) {
+            return m_capacity;
+        }
+
+        const u32 mask = m_capacity - 1;
+        for ( index &= mask; index != stop; index = ( index + 1 ) & mask ) {
+            if ( !( m_control[ index ] & k_empty ) ) {
+                return index;
+            }
+        }
+        return m_capacity;
+    }
+
+    template <typename K, typename V, typename Hash>
+    inline void FlatHashMap<K, V, Hash>::SetControl( u32 index, u8 control ) {
+        m_control[ index ] = control;
+        if ( index < k_group_size ) {
+            m_control[ m_capacity + index ] = control;
+        }
+    }
+
+    template <typename K, typename V, typename Hash>
+    typename FlatHashMap<K, V, Hash>::iterator FlatHashMap<K, V, Hash>::find( const K& key ) {
+        return { this, FindIndex( key ) };
+    }
+
+    template <typename K, typename V, typename Hash>
+    typename FlatHashMap<K, V, Hash>::const_iterator FlatHashMap<K, V, Hash>::find( const K& key ) const {
+        return { this, FindIndex( key ) };
+    }
+
+    template <typename K, typename V, typename Hash>
+    template <typename... Args>
+    std::pair<typename FlatHashMap<K, V, Hash>::iterator, bool> FlatHashMap<K, V, Hash>::emplace( const K& key, Args&&... args ) {
+        const u32 existing = FindIndex( key );
+        if ( existing != m_capacity ) {
+            return { { this, existing }, false };
+        }
+
+        if ( m_growthLeft == 0 ) {
+            Rehash( m_capacity ? m_capacity * 2 : k_min_capacity );
+        }
+
+        const u64 hash = Hash{}( key );
+        const u32 mask = m_capacity - 1;
+        u32 position = H1( hash );
+        u32 empties = EmptyGroup( position );
+        while ( empties == 0 ) {
+            position = ( position + k_group_size ) & mask;
+            empties = EmptyGroup( position );
+        }
+
+        const u32 index = ( position + std::countr_zero( empties ) ) & mask;
+        new ( &m_slots[ index ] ) value_type( key, V( std::forward<Args>( args )... ) );
+        SetControl( index, H2( hash ) );
+        ++m_size;
+        --m_growthLeft;
+
+        return { { this, index }, true };
+    }
+
+    template <typename K, typename V, typename Hash>
+    V& FlatHashMap<K, V, Hash>::operator[]( const K& key ) {
+        return emplace( key ).first->second;
+    }
+
+    template <typename K, typename V, typename Hash>
+    sizet FlatHashMap<K, V, Hash>::erase( const K& key ) {
+        const u32 index = FindIndex( key );
+        if ( index == m_capacity ) {
+            return 0;
+        }
+        erase( iterator{ this, index } );
+        return 1;
+    }
+
+    template <typename K, typename V, typename Hash>
+    typename FlatHashMap<K, V, Hash>::iterator FlatHashMap<K, V, Hash>::erase( iterator it ) {
+        const u32 mask = m_capacity - 1;
+        u32 hole = it.m_index;
+        m_slots[ hole ].~value_type();
+
+        // Backward shift: pull back every following entry whose probe sequence passes over the hole.
+        u32 next = ( hole + 1 ) & mask;
+        while ( !( m_control[ next ] & k_empty ) ) {
+            const u32 home = H1( Hash{}( m_slots[ next ].first ) );
+            if ( ( ( next - home ) & mask ) >= ( ( next - hole ) & mask ) ) {
+                new ( &m_slots[ hole ] ) value_type( std::move( m_slots[ next ] ) );
+                m_slots[ next ].~value_type();
+                SetControl( hole, m_control[ next ] );
+                hole = next;
+            }
+            next = ( next + 1 ) & mask;
+        }
+
+        SetControl( hole, k_empty );
+        --m_size;
+        ++m_growthLeft;
+
+        // The entry moved into the erased slot has not been visited yet.
+        iterator result = { this, it.m_index, it.m_stop };
+        if ( hole == it.m_index || ( m_control[ it.m_index ] & k_empty ) ) {
+            ++result;
+        }
+        return result;
+    }
+
+    template <typename K, typename V, typename Hash>
+    void FlatHashMap<K, V, Hash>::reserve( sizet count ) {
+        // Keep the load factor under 7/8.
+        const u32 needed = ( u32 )std::bit_ceil( ( count * 8 + 6 ) / 7 );
+        if ( needed > m_capacity ) {
+            Rehash( needed < k_min_capacity ? k_min_capacity : needed );
+        }
+    }
+
+    template <typename K, typename V, typename Hash>
+    void FlatHashMap<K, V, Hash>::clear() {
+        for ( u32 i = 0; i < m_capacity; ++i ) {
+            if ( !( m_control[ i ] & k_empty ) ) {
+                m_slots[ i ].~value_type();
+            }
+        }
+        if ( m_control ) {
+            memset( m_control, k_empty, m_capacity + k_group_size );
+        }
+        m_size = 0;
+        m_growthLeft = m_capacity - m_capacity / 8;
+    }
+
+    template <typename K, typename V, typename Hash>
+    void FlatHashMap<K, V, Hash>::Rehash( u32 newCapacity ) {
+        CASSERT( std::has_single_bit( newCapacity ) && newCapacity >= k_min_capacity );
+
+        u8* old_control = m_control;
+        value_type* old_slots = m_slots;
+        const u32 old_capacity = m_capacity;
+
+        // Control bytes and slots in a single allocation.
+        const sizet control_size = MemoryAlign( newCapacity + k_group_size, alignof( value_type ) > 16 ? alignof( value_type ) : 16 );
+        u8* memory = ( u8* )m_allocator->allocate( control_size + sizeof( value_type ) * newCapacity, alignof( value_type ) > 16 ? alignof( value_type ) : 16 );
+        memset( memory, k_empty, newCapacity + k_group_size );
+
+        m_control = memory;
+        m_slots = ( value_type* )( memory + control_size );
+        m_capacity = newCapacity;
+        m_size = 0;
+        m_growthLeft = newCapacity - newCapacity / 8;
+
+        for ( u32 i = 0; i < old_capacity; ++i ) {
+            if ( !( old_control[ i ] & k_empty ) ) {
+                const u64 hash = Hash{}( old_slots[ i ].first );
+                const u32 mask = m_capacity - 1;
+                u32 position = H1( hash );
+                u32 empties = EmptyGroup( position );
+                while ( empties == 0 ) {
+                    position = ( position + k_group_size ) & mask;
+                    empties = EmptyGroup( position );
+                }
+
+                const u32 index = ( position + std::countr_zero( empties ) ) & mask;
+                new ( &m_slots[ index ] ) value_type( std::move( old_slots[ i ] ) );
+                old_slots[ i ].~value_type();
+                SetControl( index, H2( hash ) );
+                ++m_size;
+                --m_growthLeft;
+            }
+        }
+
+        if ( old_control ) {
+            m_allocator->deallocate( old_control );
+        }
+    }
+}
@@ -0,0 +1,226 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CAUSTIX_FRUSTUM_CULLING_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CAUSTIX_FRUSTUM_CULLING_SSE2
+#endif
+
+export module Foundation.FrustumCulling;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Jobs;
+import Foundation.Meshlets;
+import Foundation.Platform;
+import Foundation.Assert;
+
+export namespace Caustix {
+
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    // Objects tested per iteration of the culling kernel, the bounds arrays are padded to a multiple of it.
+    constexpr u32 k_culling_batch_size = 8;
+
+    // Bounds of many objects as structure of arrays: an axis aligned box ( center and half extents ) and the radius of a sphere
+    // around the same center. Each side of a plane is tested against the tighter of the two.
+    struct CullingBounds {
+        CullingBounds( Allocator& allocator );
+
+        // Objects added by the resize have empty bounds until set.
+        void                        Resize( u32 count );
+        void                        Clear();
+
+        // Box of boxMin, boxMax transformed by a column major affine matrix. The sphere is the one around the source box,
+        // scaled by the largest axis of the matrix, which is tighter than the world box for rotated objects.
+        void                        SetBox( u32 index, const f32* boxMin, const f32* boxMax, const f32* matrix );
+
+        u32                         m_count         = 0;
+
+        Array(f32)                  m_centerX;
+        Array(f32)                  m_centerY;
+        Array(f32)                  m_centerZ;
+        Array(f32)                  m_extentX;
+        Array(f32)                  m_extentY;
+        Array(f32)                  m_extentZ;
+        Array(f32)                  m_radius;
+    };
+
+    // visible[ i ] is 1 when object i is at least partially inside the planes, 0 otherwise. Batches are split
+    // across the job system for large counts. Returns the number of visible objects.
+    u32     CullBounds( const CullingBounds& bounds, const FrustumPlanes& planes, u8* visible, JobSystem* jobSystem = nullptr );
+}
+
+namespace Caustix {
+
+    // Batches per job.
+    static constexpr u32 k_culling_grain_size = 64;
+
+    CullingBounds::CullingBounds( Allocator& allocator )
+    : m_centerX( allocator )
+    , m_centerY( allocator )
+    , m_centerZ( allocator )
+    , m_extentX( allocator )
+    , m_extentY( allocator )
+    , m_extentZ( allocator )
+    , m_radius( allocator ) {
+    }
+
+    void CullingBounds::Resize( u32 count ) {
+        m_count = count;
+
+        // The kernel loads whole batches, the results of the padding are ignored.
+        const u32 padded = ( count + k_culling_batch_size - 1 ) / k_culling_batch_size * k_culling_batch_size;
+        for ( Array(f32)* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius } ) {
+            array->assign( padded, 0.0f );
+        }
+    }
+
+    void CullingBounds::Clear() {
+        m_count = 0;
+        for ( Array(f32)* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_radius } ) {
+            array->clear();
+        }
+    }
+
+    void CullingBounds::SetBox( u32 index, const f32* boxMin, const f32* boxMax, const f32* matrix ) {
+        CASSERT( index < m_count );
+
+        f32 center[ 3 ], extent[ 3 ];
+        for ( u32 k = 0; k < 3; ++k ) {
+            center[ k ] = ( boxMin[ k ] + boxMax[ k ] ) * 0.5f;
+            extent[ k ] = ( boxMax[ k ] - boxMin[ k ] ) * 0.5f;
+        }
+
+        // Center transformed as a point, extents by the absolute value of the linear part.
+        f32 worldCenter[ 3 ], worldExtent[ 3 ];
+        for ( u32 row = 0; row < 3; ++row ) {
+            worldCenter[ row ] = matrix[ 12 + row ];
+            worldExtent[ row ] = 0.0f;
+            for ( u32 column = 0; column < 3; ++column ) {
+                worldCenter[ row ] += matrix[ column * 4 + row ] * center[ column ];
+                worldExtent[ row ] += fabsf( matrix[ column * 4 + row ] ) * extent[ column ];
+            }
+        }
+
+        f32 scale = 0.0f;
+        for ( u32 column = 0; column < 3; ++column ) {
+            const f32* axis = matrix + column * 4;
+            scale = std::max( scale, axis[ 0 ] * axis[ 0 ] + axis[ 1 ] * axis[ 1 ] + axis[ 2 ] * axis[ 2 ] );
+        }
+
+        m_centerX[ index ] = worldCenter[ 0 ];
+        m_centerY[ index ] = worldCenter[ 1 ];
+        m_centerZ[ index ] = worldCenter[ 2 ];
+        m_extentX[ index ] = worldExtent[ 0 ];
+        m_extentY[ index ] = worldExtent[ 1 ];
+        m_extentZ[ index ] = worldExtent[ 2 ];
+        m_radius[ index ] = sqrtf( ( extent[ 0 ] * extent[ 0 ] + extent[ 1 ] * extent[ 1 ] + extent[ 2 ] * extent[ 2 ] ) * scale );
+    }
+
+    template <typename Func>
+    static void RunSplit( u32 count, u32 grainSize, JobSystem* jobSystem, Func&& func ) {
+        if ( jobSystem && count > grainSize ) {
+            jobSystem->ParallelFor( count, func, grainSize );
+        } else if ( count ) {
+            func( 0, count );
+        }
+    }
+
+    // One bit per object of the batch starting at first, set when visible.
+    static u32 CullBatch( const CullingBounds& bounds, const FrustumPlanes& planes, u32 first ) {
+#if defined( CAUSTIX_FRUSTUM_CULLING_AVX2 )
+        const __m256 centerX = _mm256_loadu_ps( &bounds.m_centerX[ first ] );
+        const __m256 centerY = _mm256_loadu_ps( &bounds.m_centerY[ first ] );
+        const __m256 centerZ = _mm256_loadu_ps( &bounds.m_centerZ[ first ] );
+        const __m256 extentX = _mm256_loadu_ps( &bounds.m_extentX[ first ] );
+        const __m256 extentY = _mm256_loadu_ps( &bounds.m_extentY[ first ] );
+        const __m256 extentZ = _mm256_loadu_ps( &bounds.m_extentZ[ first ] );
+        const __m256 radius = _mm256_loadu_ps( &bounds.m_radius[ first ] );
+
+        __m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+        for ( const f32* plane : planes.m_planes ) {
+            const __m256 distance = _mm256_fmadd_ps( centerX, _mm256_set1_ps( plane[ 0 ] ),
+                                    _mm256_fmadd_ps( centerY, _mm256_set1_ps( plane[ 1 ] ),
+                                    _mm256_fmadd_ps( centerZ, _mm256_set1_ps( plane[ 2 ] ), _mm256_set1_ps( plane[ 3 ] ) ) ) );
+            const __m256 boxRadius = _mm256_fmadd_ps( extentX, _mm256_set1_ps( fabsf( plane[ 0 ] ) ),
+                                     _mm256_fmadd_ps( extentY, _mm256_set1_ps( fabsf( plane[ 1 ] ) ),
+                                     _mm256_mul_ps( extentZ, _mm256_set1_ps( fabsf( plane[ 2 ] ) ) ) ) );
+            const __m256 reach = _mm256_min_ps( radius, boxRadius );
+            inside = _mm256_and_ps( inside, _mm256_cmp_ps( _mm256_add_ps( distance, reach ), _mm256_setzero_ps(), _CMP_GE_OQ ) );
+        }
+        return ( u32 )_mm256_movemask_ps( inside );
+#elif defined( CAUSTIX_FRUSTUM_CULLING_SSE2 )
+        // Two halves of four.
+        u32 mask = 0;
+        for ( u32 half = 0; half < 2; ++half ) {
+            const u32 offset = first + half * 4;
+            const __m128 centerX = _mm_loadu_ps( &bounds.m_centerX[ offset ] );
+            const __m128 centerY = _mm_loadu_ps( &bounds.m_centerY[ offset ] );
+            const __m128 centerZ = _mm_loadu_ps( &bounds.m_centerZ[ offset ] );
+            const __m128 extentX = _mm_loadu_ps( &bounds.m_extentX[ offset ] );
+            const __m128 extentY = _mm_loadu_ps( &bounds.m_extentY[ offset ] );
+            const __m128 extentZ = _mm_loadu_ps( &bounds.m_extentZ[ offset ] );
+            const __m128 radius = _mm_loadu_ps( &bounds.m_radius[ offset ] );
+
+            __m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+            for ( const f32* plane : planes.m_planes ) {
+                __m128 distance = _mm_add_ps( _mm_mul_ps( centerX, _mm_set1_ps( plane[ 0 ] ) ), _mm_set1_ps( plane[ 3 ] ) );
+                distance = _mm_add_ps( distance, _mm_mul_ps( centerY, _mm_set1_ps( plane[ 1 ] ) ) );
+                distance = _mm_add_ps( distance, _mm_mul_ps( centerZ, _mm_set1_ps( plane[ 2 ] ) ) );
+                __m128 boxRadius = _mm_mul_ps( extentX, _mm_set1_ps( fabsf( plane[ 0 ] ) ) );
+                boxRadius = _mm_add_ps( boxRadius, _mm_mul_ps( extentY, _mm_set1_ps( fabsf( plane[ 1 ] ) ) ) );
+                boxRadius = _mm_add_ps( boxRadius, _mm_mul_ps( extentZ, _mm_set1_ps( fabsf( plane[ 2 ] ) ) ) );
+                const __m128 reach = _mm_min_ps( radius, boxRadius );
+                inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( distance, reach ), _mm_setzero_ps() ) );
+            }
+            mask |= ( u32 )_mm_movemask_ps( inside ) << ( half * 4 );
+        }
+        return mask;
+#else
+        u32 mask = 0;
+        for ( u32 lane = 0; lane < k_culling_batch_size; ++lane ) {
+            const u32 i = first + lane;
+            bool inside = true;
+            for ( const f32* plane : planes.m_planes ) {
+                const f32 distance = plane[ 0 ] * bounds.m_centerX[ i ] + plane[ 1 ] * bounds.m_centerY[ i ] + plane[ 2 ] * bounds.m_centerZ[ i ] + plane[ 3 ];
+                const f32 boxRadius = fabsf( plane[ 0 ] ) * bounds.m_extentX[ i ] + fabsf( plane[ 1 ] ) * bounds.m_extentY[ i ] + fabsf( plane[ 2 ] ) * bounds.m_extentZ[ i ];
+                inside &= distance + std::min( bounds.m_radius[ i ], boxRadius ) >= 0.0f;
+            }
+            mask |= ( u32 )inside << lane;
+        }
+        return mask;
+#endif // CAUSTIX_FRUSTUM_CULLING_AVX2
+    }
+
+    u32 CullBounds( const CullingBounds& bounds, const FrustumPlanes& planes, u8* visible, JobSystem* jobSystem ) {
+        const u32 batchCount = ( bounds.m_count + k_culling_batch_size - 1 ) / k_culling_batch_size;
+
+        std::atomic<u32> visibleCount{ 0 };
+        RunSplit( batchCount, k_culling_grain_size, jobSystem, [ & ]( u32 begin, u32 end ) {
+            u32 rangeVisible = 0;
+            for ( u32 batch = begin; batch < end; ++batch ) {
+                const u32 first = batch * k_culling_batch_size;
+                // Only the last batch has padding lanes to leave out.
+                const u32 lanes = std::min( k_culling_batch_size, bounds.m_count - first );
+                const u32 mask = CullBatch( bounds, planes, first ) & ( ( 1u << lanes ) - 1 );
+                for ( u32 lane = 0; lane < lanes; ++lane ) {
+                    visible[ first + lane ] = ( u8 )( ( mask >> lane ) & 1 );
+                }
+                rangeVisible += std::popcount( mask );
+            }
+            visibleCount.fetch_add( rangeVisible, std::memory_order_relaxed );
+        } );
+
+        return visibleCount.load( std::memory_order_relaxed );
+    }
+}
@@ -0,0 +1,628 @@
+module;
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CAUSTIX_GEOMETRY_IMPORT_SSE2
+#endif
+
+export module Foundation.GeometryImport;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.glTF;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Assert;
+import Foundation.Log;
+
+export namespace Caustix {
+
+    // Accessor resolved to the memory of its buffer.
+    struct AccessorView {
+        const u8*                   m_data          = nullptr;  // First element, null when the accessor has no buffer view and is all zeros.
+        u32                         m_stride        = 0;
+        u32                         m_elementSize   = 0;
+        u32                         m_count         = 0;
+        u32                         m_components    = 0;
+        u32                         m_rows          = 0;        // Components per matrix column, m_components for vectors.
+        u32                         m_columnStride  = 0;        // Matrix columns of 8 and 16 bit components are 4 bytes aligned.
+        u32                         m_componentSize = 0;
+        i32                         m_componentType = 0;
+        bool                        m_normalized    = false;
+    };
+
+    // Bytes read and time spent decoding, per source component type.
+    struct GeometryImportStatistics {
+        static constexpr u32        k_component_types = 7;      // Indexed by component type - glTF::Accessor::BYTE.
+
+        void                        Add( i32 componentType, u64 bytes, u64 nanoseconds );
+        void                        Log() const;
+
+        u32                         m_accessors[ k_component_types ]    = {};
+        u64                         m_bytes[ k_component_types ]        = {};
+        u64                         m_nanoseconds[ k_component_types ]  = {};
+    };
+
+    u32     GetAccessorComponentCount( glTF::Accessor::Type type );
+    u32     GetAccessorComponentSize( i32 componentType );
+
+    // buffers holds the memory of every glTF buffer, each at least its declared byte length.
+    // Fails when the accessor, its buffer view or its sparse data reach outside their buffer.
+    bool    GetAccessorView( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, AccessorView& view );
+
+    // Decodes an accessor to floats: outputComponents floats per element, outputStride bytes apart, so both separate and
+    // interleaved layouts can be targeted. Normalized integers follow the glTF rules, the others are converted as they are.
+    // Components the accessor lacks are zero, sparse values are applied over the dense ones.
+    // Large accessors are split across the job system when one is given.
+    bool    DecodeAccessor( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, f32* output, u32 outputComponents, u32 outputStride,
+                            JobSystem* jobSystem = nullptr, GeometryImportStatistics* statistics = nullptr );
+
+    // Decodes an index accessor of any integer type. 16 bit output is for meshes with fewer than 65536 vertices.
+    bool    DecodeIndices( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, u32* output,
+                           JobSystem* jobSystem = nullptr, GeometryImportStatistics* statistics = nullptr );
+    bool    DecodeIndices( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, u16* output,
+                           JobSystem* jobSystem = nullptr, GeometryImportStatistics* statistics = nullptr );
+}
+
+namespace Caustix {
+
+    // Accessors with more elements are split in ranges across the job system.
+    static constexpr u32 k_geometry_import_parallel_count   = 64 * 1024;
+    static constexpr u32 k_geometry_import_grain_size       = 16 * 1024;
+
+    static constexpr cstring k_component_type_names[ GeometryImportStatistics::k_component_types ] = { "i8", "u8", "i16", "u16", "", "u32", "f32" };
+
+    void GeometryImportStatistics::Add( i32 componentType, u64 bytes, u64 nanoseconds ) {
+        const u32 index = ( u32 )( componentType - glTF::Accessor::BYTE );
+        if ( index >= k_component_types ) {
+            return;
+        }
+
+        ++m_accessors[ index ];
+        m_bytes[ index ] += bytes;
+        m_nanoseconds[ index ] += nanoseconds;
+    }
+
+    void GeometryImportStatistics::Log() const {
+        for ( u32 index = 0; index < k_component_types; ++index ) {
+            if ( m_accessors[ index ] == 0 ) {
+                continue;
+            }
+
+            const f64 seconds = m_nanoseconds[ index ] * 1e-9;
+            const f64 gigabytesPerSecond = seconds > 0.0 ? m_bytes[ index ] / seconds * 1e-9 : 0.0;
+            info( "Geometry import {}: {} accessors, {:.2f} MB in {:.3f} ms, {:.2f} GB/s", k_component_type_names[ index ], m_accessors[ index ],
+                  m_bytes[ index ] / ( 1024.0 * 1024.0 ), seconds * 1e3, gigabytesPerSecond );
+        }
+    }
+
+    u32 GetAccessorComponentCount( glTF::Accessor::Type type ) {
+        switch ( type ) {
+            case glTF::Accessor::Scalar:
+                return 1;
+            case glTF::Accessor::Vec2:
+                return 2;
+            case glTF::Accessor::Vec3:
+                return 3;
+            case glTF::Accessor::Vec4:
+            case glTF::Accessor::Mat2:
+                return 4;
+            case glTF::Accessor::Mat3:
+                return 9;
+            case glTF::Accessor::Mat4:
+                return 16;
+        }
+        return 0;
+    }
+
+    u32 GetAccessorComponentSize( i32 componentType ) {
+        switch ( componentType ) {
+            case glTF::Accessor::BYTE:
+            case glTF::Accessor::UNSIGNED_BYTE:
+                return 1;
+            case glTF::Accessor::SHORT:
+            case glTF::Accessor::UNSIGNED_SHORT:
+                return 2;
+            case glTF::Accessor::UNSIGNED_INT:
+            case glTF::Accessor::FLOAT:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    static u32 GetAccessorRowCount( glTF::Accessor::Type type ) {
+        switch ( type ) {
+            case glTF::Accessor::Mat2:
+                return 2;
+            case glTF::Accessor::Mat3:
+                return 3;
+            case glTF::Accessor::Mat4:
+                return 4;
+            default:
+                return GetAccessorComponentCount( type );
+        }
+    }
+
+    // Resolves byteOffset inside a buffer view. Fails unless size bytes from there stay inside both the view and its buffer,
+    // so a malformed file cannot make the decoders read outside the mapped memory.
+    static bool GetBufferViewData( const glTF::glTF& scene, const u8* const* buffers, i32 bufferViewIndex, i32 byteOffset, u64 size, const u8*& data ) {
+        if ( bufferViewIndex < 0 || ( u32 )bufferViewIndex >= scene.buffer_views_count ) {
+            error( "Geometry import: invalid buffer view {}", bufferViewIndex );
+            return false;
+        }
+
+        const glTF::BufferView& bufferView = scene.buffer_views[ bufferViewIndex ];
+        if ( bufferView.buffer < 0 || ( u32 )bufferView.buffer >= scene.buffers_count ) {
+            error( "Geometry import: buffer view {} references invalid buffer {}", bufferViewIndex, bufferView.buffer );
+            return false;
+        }
+
+        // Lengths are required, offsets default to 0.
+        const glTF::Buffer& buffer = scene.buffers[ bufferView.buffer ];
+        const i64 viewOffset = bufferView.byte_offset == glTF::INVALID_INT_VALUE ? 0 : bufferView.byte_offset;
+        const i64 offset = byteOffset == glTF::INVALID_INT_VALUE ? 0 : byteOffset;
+        const i64 viewLength = bufferView.byte_length == glTF::INVALID_INT_VALUE ? -1 : bufferView.byte_length;
+        const i64 bufferLength = buffer.byte_length == glTF::INVALID_INT_VALUE ? -1 : buffer.byte_length;
+        if ( viewOffset < 0 || offset < 0 || viewLength < 0 || bufferLength < 0 || viewOffset + viewLength > bufferLength || ( u64 )offset + size > ( u64 )viewLength ) {
+            error( "Geometry import: {} bytes at offset {} overrun buffer view {}", size, offset, bufferViewIndex );
+            return false;
+        }
+
+        data = buffers[ bufferView.buffer ];
+        if ( !data ) {
+            error( "Geometry import: buffer {} is not loaded", bufferView.buffer );
+            return false;
+        }
+        data += viewOffset + offset;
+        return true;
+    }
+
+    bool GetAccessorView( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, AccessorView& view ) {
+        if ( accessorIndex < 0 || ( u32 )accessorIndex >= scene.accessors_count ) {
+            error( "Geometry import: invalid accessor {}", accessorIndex );
+            return false;
+        }
+
+        const glTF::Accessor& accessor = scene.accessors[ accessorIndex ];
+        view.m_componentSize = GetAccessorComponentSize( accessor.component_type );
+        if ( view.m_componentSize == 0 || accessor.count == glTF::INVALID_INT_VALUE || accessor.count < 0 ) {
+            error( "Geometry import: accessor {} has an invalid component type or count", accessorIndex );
+            return false;
+        }
+
+        view.m_componentType = accessor.component_type;
+        view.m_normalized = accessor.normalized;
+        view.m_count = ( u32 )accessor.count;
+        view.m_components = GetAccessorComponentCount( accessor.type );
+        view.m_rows = GetAccessorRowCount( accessor.type );
+        view.m_columnStride = view.m_rows * view.m_componentSize;
+        if ( view.m_rows != view.m_components ) {
+            view.m_columnStride = ( u32 )MemoryAlign( view.m_columnStride, 4 );
+        }
+        view.m_elementSize = view.m_columnStride * ( view.m_components / view.m_rows );
+        view.m_stride = view.m_elementSize;
+        view.m_data = nullptr;
+
+        if ( accessor.buffer_view != glTF::INVALID_INT_VALUE ) {
+            if ( accessor.buffer_view < 0 || ( u32 )accessor.buffer_view >= scene.buffer_views_count ) {
+                error( "Geometry import: accessor {} has invalid buffer view {}", accessorIndex, accessor.buffer_view );
+                return false;
+            }
+
+            const i32 byteStride = scene.buffer_views[ accessor.buffer_view ].byte_stride;
+            if ( byteStride != glTF::INVALID_INT_VALUE && byteStride != 0 ) {
+                if ( byteStride < 0 ) {
+                    error( "Geometry import: accessor {} has invalid stride {}", accessorIndex, byteStride );
+                    return false;
+                }
+                view.m_stride = ( u32 )byteStride;
+            }
+
+            // The last element ends at ( count - 1 ) * stride + elementSize.
+            const u64 size = view.m_count ? ( u64 )( view.m_count - 1 ) * view.m_stride + view.m_elementSize : 0;
+            if ( !GetBufferViewData( scene, buffers, accessor.buffer_view, accessor.byte_offset, size, view.m_data ) ) {
+                error( "Geometry import: accessor {} data is not available", accessorIndex );
+                view.m_data = nullptr;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Scalar conversion ///////////////////////////////////////////////////////
+
+    static f32 DecodeComponent( const u8* source, i32 componentType, bool normalized ) {
+        switch ( componentType ) {
+            case glTF::Accessor::BYTE: {
+                const i8 value = ( i8 )*source;
+                return normalized ? std::max( value / 127.0f, -1.0f ) : ( f32 )value;
+            }
+            case glTF::Accessor::UNSIGNED_BYTE:
+                return normalized ? *source / 255.0f : ( f32 )*source;
+            case glTF::Accessor::SHORT: {
+                i16 value;
+                memcpy( &value, source, sizeof( i16 ) );
+                return normalized ? std::max( value / 32767.0f, -1.0f ) : ( f32 )value;
+            }
+            case glTF::Accessor::UNSIGNED_SHORT: {
+                u16 value;
+                memcpy( &value, source, sizeof( u16 ) );
+                return normalized ? value / 65535.0f : ( f32 )value;
+            }
+            case glTF::Accessor::UNSIGNED_INT: {
+                u32 value;
+                memcpy( &value, source, sizeof( u32 ) );
+                return ( f32 )value;
+            }
+            default: {
+                f32 value;
+                memcpy( &value, source, sizeof( f32 ) );
+                return value;
+            }
+        }
+    }
+
+    static u32 DecodeIndex( const u8* source, i32 componentType ) {
+        switch ( componentType ) {
+            case glTF::Accessor::UNSIGNED_BYTE:
+                return *source;
+            case glTF::Accessor::UNSIGNED_SHORT: {
+                u16 value;
+                memcpy( &value, source, sizeof( u16 ) );
+                return value;
+            }
+            default: {
+                u32 value;
+                memcpy( &value, source, sizeof( u32 ) );
+                return value;
+            }
+        }
+    }
+
+    static void DecodeElement( const AccessorView& view, const u8* element, f32* output, u32 outputComponents ) {
+        const u32 components = std::min( view.m_components, outputComponents );
+        if ( view.m_componentType == glTF::Accessor::FLOAT && view.m_rows == view.m_components ) {
+            memcpy( output, element, components * sizeof( f32 ) );
+        } else {
+            for ( u32 c = 0; c < components; ++c ) {
+                const u32 column = c / view.m_rows;
+                const u32 row = c % view.m_rows;
+                output[ c ] = DecodeComponent( element + column * view.m_columnStride + row * view.m_componentSize, view.m_componentType, view.m_normalized );
+            }
+        }
+
+        for ( u32 c = components; c < outputComponents; ++c ) {
+            output[ c ] = 0.0f;
+        }
+    }
+
+    // Packed streams //////////////////////////////////////////////////////////
+    // Tightly packed accessors decoded to the same component count are flat arrays of scalars on both sides.
+
+    static void ConvertU8( const u8* source, f32* output, sizet count, f32 scale ) {
+        sizet i = 0;
+#if defined(CAUSTIX_GEOMETRY_IMPORT_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale4 = _mm_set1_ps( scale );
+        for ( ; i + 16 <= count; i += 16 ) {
+            const __m128i bytes = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+            const __m128i low = _mm_unpacklo_epi8( bytes, zero );
+            const __m128i high = _mm_unpackhi_epi8( bytes, zero );
+            _mm_storeu_ps( output + i, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( low, zero ) ), scale4 ) );
+            _mm_storeu_ps( output + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( low, zero ) ), scale4 ) );
+            _mm_storeu_ps( output + i + 8, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( high, zero ) ), scale4 ) );
+            _mm_storeu_ps( output + i + 12, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( high, zero ) ), scale4 ) );
+        }
+#endif
+        for ( ; i < count; ++i ) {
+            output[ i ] = source[ i ] * scale;
+        }
+    }
+
+    static void ConvertI8( const u8* source, f32* output, sizet count, f32 scale, f32 minimum ) {
+        sizet i = 0;
+#if defined(CAUSTIX_GEOMETRY_IMPORT_SSE2)
+        const __m128 scale4 = _mm_set1_ps( scale );
+        const __m128 minimum4 = _mm_set1_ps( minimum );
+        for ( ; i + 16 <= count; i += 16 ) {
+            const __m128i bytes = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+            // Sign extension: duplicate each byte in the high half and shift it back down.
+            const __m128i low = _mm_srai_epi16( _mm_unpacklo_epi8( bytes, bytes ), 8 );
+            const __m128i high = _mm_srai_epi16( _mm_unpackhi_epi8( bytes, bytes ), 8 );
+            _mm_storeu_ps( output + i, _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( low, low ), 16 ) ), scale4 ), minimum4 ) );
+            _mm_storeu_ps( output + i + 4, _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( low, low ), 16 ) ), scale4 ), minimum4 ) );
+            _mm_storeu_ps( output + i + 8, _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( high, high ), 16 ) ), scale4 ), minimum4 ) );
+            _mm_storeu_ps( output + i + 12, _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( high, high ), 16 ) ), scale4 ), minimum4 ) );
+        }
+#endif
+        for ( ; i < count; ++i ) {
+            output[ i ] = std::max( ( i8 )source[ i ] * scale, minimum );
+        }
+    }
+
+    static void ConvertU16( const u8* source, f32* output, sizet count, f32 scale ) {
+        sizet i = 0;
+#if defined(CAUSTIX_GEOMETRY_IMPORT_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale4 = _mm_set1_ps( scale );
+        for ( ; i + 8 <= count; i += 8 ) {
+            const __m128i shorts = _mm_loadu_si128( ( const __m128i* )( source + i * 2 ) );
+            _mm_storeu_ps( output + i, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( shorts, zero ) ), scale4 ) );
+            _mm_storeu_ps( output + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( shorts, zero ) ), scale4 ) );
+        }
+#endif
+        for ( ; i < count; ++i ) {
+            u16 value;
+            memcpy( &value, source + i * 2, sizeof( u16 ) );
+            output[ i ] = value * scale;
+        }
+    }
+
+    static void ConvertI16( const u8* source, f32* output, sizet count, f32 scale, f32 minimum ) {
+        sizet i = 0;
+#if defined(CAUSTIX_GEOMETRY_IMPORT_SSE2)
+        const __m128 scale4 = _mm_set1_ps( scale );
+        const __m128 minimum4 = _mm_set1_ps( minimum );
+        for ( ; i + 8 <= count; i += 8 ) {
+            const __m128i shorts = _mm_loadu_si128( ( const __m128i* )( source + i * 2 ) );
+            const __m128i low = _mm_srai_epi32( _mm_unpacklo_epi16( shorts, shorts ), 16 );
+            const __m128i high = _mm_srai_epi32( _mm_unpackhi_epi16( shorts, shorts ), 16 );
+            _mm_storeu_ps( output + i, _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( low ), scale4 ), minimum4 ) );
+            _mm_storeu_ps( output + i + 4, _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( high ), scale4 ), minimum4 ) );
+        }
+#endif
+        for ( ; i < count; ++i ) {
+            i16 value;
+            memcpy( &value, source + i * 2, sizeof( i16 ) );
+            output[ i ] = std::max( value * scale, minimum );
+        }
+    }
+
+    static void ConvertU32( const u8* source, f32* output, sizet count ) {
+        for ( sizet i = 0; i < count; ++i ) {
+            u32 value;
+            memcpy( &value, source + i * 4, sizeof( u32 ) );
+            output[ i ] = ( f32 )value;
+        }
+    }
+
+    static void ConvertComponents( const AccessorView& view, const u8* source, f32* output, sizet count ) {
+        // Signed normalized values are clamped to -1, plain integers are not clamped at all.
+        const f32 signedMinimum = view.m_normalized ? -1.0f : std::numeric_limits<f32>::lowest();
+        switch ( view.m_componentType ) {
+            case glTF::Accessor::BYTE:
+                ConvertI8( source, output, count, view.m_normalized ? 1.0f / 127.0f : 1.0f, signedMinimum );
+                break;
+            case glTF::Accessor::UNSIGNED_BYTE:
+                ConvertU8( source, output, count, view.m_normalized ? 1.0f / 255.0f : 1.0f );
+                break;
+            case glTF::Accessor::SHORT:
+                ConvertI16( source, output, count, view.m_normalized ? 1.0f / 32767.0f : 1.0f, signedMinimum );
+                break;
+            case glTF::Accessor::UNSIGNED_SHORT:
+                ConvertU16( source, output, count, view.m_normalized ? 1.0f / 65535.0f : 1.0f );
+                break;
+            case glTF::Accessor::UNSIGNED_INT:
+                ConvertU32( source, output, count );
+                break;
+            default:
+                memcpy( output, source, count * sizeof( f32 ) );
+                break;
+        }
+    }
+
+    static void DecodeRange( const AccessorView& view, u32 begin, u32 end, f32* output, u32 outputComponents, u32 outputStride ) {
+        if ( !view.m_data ) {
+            for ( u32 i = begin; i < end; ++i ) {
+                memset( ( u8* )output + ( sizet )i * outputStride, 0, outputComponents * sizeof( f32 ) );
+            }
+            return;
+        }
+
+        const bool packed = view.m_stride == view.m_elementSize && view.m_rows == view.m_components &&
+                            outputComponents == view.m_components && outputStride == outputComponents * sizeof( f32 );
+        if ( packed ) {
+            const sizet first = ( sizet )begin * view.m_components;
+            ConvertComponents( view, view.m_data + first * view.m_componentSize, output + first, ( sizet )( end - begin ) * view.m_components );
+            return;
+        }
+
+        for ( u32 i = begin; i < end; ++i ) {
+            DecodeElement( view, view.m_data + ( sizet )i * view.m_stride, ( f32* )( ( u8* )output + ( sizet )i * outputStride ), outputComponents );
+        }
+    }
+
+    template <typename T>
+    static void WidenIndices( const u8* source, u32 componentSize, T* output, sizet count ) {
+        sizet i = 0;
+#if defined(CAUSTIX_GEOMETRY_IMPORT_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        if ( componentSize == 1 && sizeof( T ) == 2 ) {
+            for ( ; i + 16 <= count; i += 16 ) {
+                const __m128i bytes = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+                _mm_storeu_si128( ( __m128i* )( output + i ), _mm_unpacklo_epi8( bytes, zero ) );
+                _mm_storeu_si128( ( __m128i* )( output + i + 8 ), _mm_unpackhi_epi8( bytes, zero ) );
+            }
+        } else if ( componentSize == 1 && sizeof( T ) == 4 ) {
+            for ( ; i + 16 <= count; i += 16 ) {
+                const __m128i bytes = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+                const __m128i low = _mm_unpacklo_epi8( bytes, zero );
+                const __m128i high = _mm_unpackhi_epi8( bytes, zero );
+                _mm_storeu_si128( ( __m128i* )( output + i ), _mm_unpacklo_epi16( low, zero ) );
+                _mm_storeu_si128( ( __m128i* )( output + i + 4 ), _mm_unpackhi_epi16( low, zero ) );
+                _mm_storeu_si128( ( __m128i* )( output + i + 8 ), _mm_unpacklo_epi16( high, zero ) );
+                _mm_storeu_si128( ( __m128i* )( output + i + 12 ), _mm_unpackhi_epi16( high, zero ) );
+            }
+        } else if ( componentSize == 2 && sizeof( T ) == 4 ) {
+            for ( ; i + 8 <= count; i += 8 ) {
+                const __m128i shorts = _mm_loadu_si128( ( const __m128i* )( source + i * 2 ) );
+                _mm_storeu_si128( ( __m128i* )( output + i ), _mm_unpacklo_epi16( shorts, zero ) );
+                _mm_storeu_si128( ( __m128i* )( output + i + 4 ), _mm_unpackhi_epi16( shorts, zero ) );
+            }
+        }
+#endif
+        if ( componentSize == sizeof( T ) ) {
+            memcpy( output + i, source + i * componentSize, ( count - i ) * sizeof( T ) );
+            return;
+        }
+
+        const i32 componentType = componentSize == 1 ? glTF::Accessor::UNSIGNED_BYTE : ( componentSize == 2 ? glTF::Accessor::UNSIGNED_SHORT : glTF::Accessor::UNSIGNED_INT );
+        for ( ; i < count; ++i ) {
+            output[ i ] = ( T )DecodeIndex( source + i * componentSize, componentType );
+        }
+    }
+
+    template <typename T>
+    static void DecodeIndexRange( const AccessorView& view, u32 begin, u32 end, T* output ) {
+        if ( !view.m_data ) {
+            memset( output + begin, 0, ( sizet )( end - begin ) * sizeof( T ) );
+            return;
+        }
+
+        if ( view.m_stride == view.m_componentSize ) {
+            WidenIndices( view.m_data + ( sizet )begin * view.m_componentSize, view.m_componentSize, output + begin, end - begin );
+            return;
+        }
+
+        for ( u32 i = begin; i < end; ++i ) {
+            output[ i ] = ( T )DecodeIndex( view.m_data + ( sizet )i * view.m_stride, view.m_componentType );
+        }
+    }
+
+    // Sparse accessors //////////////////////////////////////////////////////
+
+    struct SparseView {
+        const u8*                   m_indices       = nullptr;
+        const u8*                   m_values        = nullptr;
+        i32                         m_indexType     = 0;
+        u32                         m_indexSize     = 0;
+        u32                         m_count         = 0;
+    };
+
+    static bool GetSparseView( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, const AccessorView& view, SparseView& sparseView ) {
+        const glTF::AccessorSparse* sparse = scene.accessors[ accessorIndex ].sparse;
+        if ( !sparse || sparse->count <= 0 || sparse->count == glTF::INVALID_INT_VALUE ) {
+            return true;
+        }
+
+        sparseView.m_indexType = sparse->indices.component_type;
+        sparseView.m_indexSize = GetAccessorComponentSize( sparseView.m_indexType );
+        sparseView.m_count = ( u32 )sparse->count;
+
+        if ( sparseView.m_indexType == glTF::Accessor::FLOAT || sparseView.m_indexSize == 0 ||
+             !GetBufferViewData( scene, buffers, sparse->indices.buffer_view, sparse->indices.byte_offset, ( u64 )sparseView.m_count * sparseView.m_indexSize, sparseView.m_indices ) ||
+             !GetBufferViewData( scene, buffers, sparse->values.bufferView, sparse->values.byteOffset, ( u64 )sparseView.m_count * view.m_elementSize, sparseView.m_values ) ) {
+            error( "Geometry import: accessor {} has invalid sparse data", accessorIndex );
+            return false;
+        }
+        return true;
+    }
+
+    static bool ApplySparse( const AccessorView& view, const SparseView& sparseView, f32* output, u32 outputComponents, u32 outputStride ) {
+        for ( u32 i = 0; i < sparseView.m_count; ++i ) {
+            const u32 index = DecodeIndex( sparseView.m_indices + ( sizet )i * sparseView.m_indexSize, sparseView.m_indexType );
+            if ( index >= view.m_count ) {
+                error( "Geometry import: sparse index {} out of range", index );
+                return false;
+            }
+            DecodeElement( view, sparseView.m_values + ( sizet )i * view.m_elementSize, ( f32* )( ( u8* )output + ( sizet )index * outputStride ), outputComponents );
+        }
+        return true;
+    }
+
+    template <typename T>
+    static bool ApplySparseIndices( const AccessorView& view, const SparseView& sparseView, T* output ) {
+        for ( u32 i = 0; i < sparseView.m_count; ++i ) {
+            const u32 index = DecodeIndex( sparseView.m_indices + ( sizet )i * sparseView.m_indexSize, sparseView.m_indexType );
+            if ( index >= view.m_count ) {
+                error( "Geometry import: sparse index {} out of range", index );
+                return false;
+            }
+            output[ index ] = ( T )DecodeIndex( sparseView.m_values + ( sizet )i * view.m_componentSize, view.m_componentType );
+        }
+        return true;
+    }
+
+    // Decoding ///////////////////////////////////////////////////////////////
+
+    template <typename Func>
+    static void DecodeSplit( u32 count, JobSystem* jobSystem, Func&& decodeRange ) {
+        if ( jobSystem && count >= k_geometry_import_parallel_count ) {
+            jobSystem->ParallelFor( count, decodeRange, k_geometry_import_grain_size );
+        } else {
+            decodeRange( 0, count );
+        }
+    }
+
+    bool DecodeAccessor( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, f32* output, u32 outputComponents, u32 outputStride,
+                         JobSystem* jobSystem, GeometryImportStatistics* statistics ) {
+        const auto start = std::chrono::steady_clock::now();
+
+        AccessorView view;
+        SparseView sparseView;
+        if ( !GetAccessorView( scene, buffers, accessorIndex, view ) || !GetSparseView( scene, buffers, accessorIndex, view, sparseView ) ) {
+            return false;
+        }
+        CASSERT( outputStride >= outputComponents * sizeof( f32 ) );
+
+        DecodeSplit( view.m_count, jobSystem, [ &view, output, outputComponents, outputStride ]( u32 begin, u32 end ) {
+            DecodeRange( view, begin, end, output, outputComponents, outputStride );
+        } );
+
+        if ( !ApplySparse( view, sparseView, output, outputComponents, outputStride ) ) {
+            return false;
+        }
+
+        if ( statistics ) {
+            const u64 nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+            statistics->Add( view.m_componentType, ( u64 )view.m_count * view.m_elementSize, nanoseconds );
+        }
+        return true;
+    }
+
+    template <typename T>
+    static bool DecodeIndicesTyped( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, T* output,
+                                    JobSystem* jobSystem, GeometryImportStatistics* statistics ) {
+        const auto start = std::chrono::steady_clock::now();
+
+        AccessorView view;
+        SparseView sparseView;
+        if ( !GetAccessorView( scene, buffers, accessorIndex, view ) || !GetSparseView( scene, buffers, accessorIndex, view, sparseView ) ) {
+            return false;
+        }
+
+        if ( view.m_components != 1 || view.m_componentType == glTF::Accessor::FLOAT || view.m_componentType == glTF::Accessor::BYTE || view.m_componentType == glTF::Accessor::SHORT ) {
+            error( "Geometry import: accessor {} is not an index accessor", accessorIndex );
+            return false;
+        }
+
+        DecodeSplit( view.m_count, jobSystem, [ &view, output ]( u32 begin, u32 end ) {
+            DecodeIndexRange( view, begin, end, output );
+        } );
+
+        if ( !ApplySparseIndices( view, sparseView, output ) ) {
+            return false;
+        }
+
+        if ( statistics ) {
+            const u64 nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+            statistics->Add( view.m_componentType, ( u64 )view.m_count * view.m_elementSize, nanoseconds );
+        }
+        return true;
+    }
+
+    bool DecodeIndices( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, u32* output, JobSystem* jobSystem, GeometryImportStatistics* statistics ) {
+        return DecodeIndicesTyped( scene, buffers, accessorIndex, output, jobSystem, statistics );
+    }
+
+    bool DecodeIndices( const glTF::glTF& scene, const u8* const* buffers, i32 accessorIndex, u16* output, JobSystem* jobSystem, GeometryImportStatistics* statistics ) {
+        return DecodeIndicesTyped( scene, buffers, accessorIndex, output, jobSystem, statistics );
+    }
+}
@@ -0,0 +1,613 @@
+module;
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <imgui.h>
+
+export module Foundation.Jobs;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Services.Service;
+import Foundation.Platform;
+import Foundation.Assert;
+import Foundation.Log;
+
+export namespace Caustix {
+    static constexpr u32    k_max_job_workers   = 64;
+    static constexpr u32    k_job_queue_size    = 4096;     // Per worker, power of two.
+    static constexpr u32    k_job_pool_size     = 4096;     // Jobs in flight created by a single worker, power of two. More run inline.
+    static constexpr u32    k_job_external_worker = u32_max; // Worker index of the threads that don't belong to the system.
+
+    // Jobs receive the range they have to process, single jobs get an empty one.
+    using JobFunction = void ( * )( void* data, u32 begin, u32 end );
+
+    // Number of unfinished jobs of a group, Wait returns when it drops to zero.
+    struct JobCounter {
+        std::atomic<u32>                m_value             { 0 };
+
+        bool                            IsDone() const      { return m_value.load( std::memory_order_acquire ) == 0; }
+    };
+
+    struct Job {
+        JobFunction                     m_function          = nullptr;
+        void*                           m_data              = nullptr;
+        JobCounter*                     m_counter           = nullptr;
+        u32                             m_begin             = 0;
+        u32                             m_end               = 0;
+        std::atomic<bool>               m_finished          { true };
+    };
+
+    // Chase-Lev work stealing deque of fixed capacity.
+    // The owner worker pushes and pops at the bottom, the other workers steal from the top.
+    struct JobQueue {
+        bool                            Push( Job* job );
+        Job*                            Pop();
+        Job*                            Steal();
+        // Owner only, a stale answer just delays a split.
+        bool                            IsEmpty() const;
+
+        std::atomic<i64>                m_top               { 0 };
+        std::atomic<i64>                m_bottom            { 0 };
+        std::atomic<Job*>               m_jobs[ k_job_queue_size ];
+    };
+
+    struct alignas( k_cache_line_size ) JobWorkerStatistics {
+        std::atomic<u64>                m_jobsExecuted      { 0 };
+        std::atomic<u64>                m_jobsStolen        { 0 };
+        std::atomic<u64>                m_busyNanoseconds   { 0 };
+    };
+
+    struct alignas( k_cache_line_size ) JobWorker {
+        JobQueue                        m_queue;
+        // Only touched by the owner thread.
+        Job                             m_jobs[ k_job_pool_size ];
+        u32                             m_jobsAllocated     = 0;
+        u32                             m_stealSeed         = 0;
+
+        JobWorkerStatistics             m_statistics;
+        std::thread                     m_thread;
+    };
+
+    // Jobs run from threads outside the system, the deques accept pushes from their owner only.
+    // Workers take them first in first out after their own queue, before stealing.
+    struct JobInjectionQueue {
+        std::mutex                      m_mutex;
+        Job*                            m_jobs[ k_job_queue_size ];
+        u32                             m_head              = 0;
+        u32                             m_tail              = 0;
+        std::atomic<u32>                m_count             { 0 };      // Checked without the lock.
+
+        Job                             m_pool[ k_job_pool_size ];
+        u32                             m_jobsAllocated     = 0;
+    };
+
+    struct JobSystemConfiguration {
+        Allocator*                      m_allocator         = nullptr;
+        u32                             m_workerCount       = 0;        // Including the main thread, 0 uses all the hardware threads.
+        bool                            m_pinThreads        = true;     // Pin worker i to core i.
+    };
+
+    // Fixed pool of workers with work stealing.
+    // The thread creating the system becomes worker 0 and runs jobs while it waits on counters.
+    // Other threads can run jobs and wait too, their jobs go through the injection queue.
+    struct JobSystem : public Service {
+        JobSystem() = delete;
+        explicit JobSystem( const JobSystemConfiguration& configuration );
+        ~JobSystem();
+
+        void                            Shutdown();
+
+        void                            Run( JobFunction function, void* data, JobCounter* counter );
+        void                            Run( JobFunction function, void* data, u32 begin, u32 end, JobCounter* counter );
+        void                            Wait( JobCounter* counter );
+
+        // Calls func( begin, end ) over [0, count) split in ranges of at most the grain size, returns when all of them are done.
+        // Splitting is lazy: a job hands out the second half of what it has left only when its worker's queue is empty,
+        // so busy workers run their range without scheduling overhead and idle ones steal the big halves first.
+        // Grain size 0 picks one that gives every worker about 8 ranges.
+        template <typename Func>
+        void                            ParallelFor( u32 count, Func&& func, u32 grainSize = 0 );
+
+        u32                             GetWorkerIndex() const;
+        u32                             GetWorkerCount() const      { return m_workerCount; }
+
+        void                            ResetStatistics();
+        void                            debug_ui();
+
+        static JobSystem*               Create( const JobSystemConfiguration& configuration ) {
+            static std::unique_ptr<JobSystem> instance{ new JobSystem( configuration ) };
+            return instance.get();
+        }
+
+        // Internals
+        Job*                            AllocateJob( JobWorker& worker );
+        void                            Submit( JobWorker& worker, Job* job );
+        bool                            Inject( Job& job );
+        Job*                            TakeInjected();
+        void                            WakeWorker();
+        bool                            ShouldSplit( u32 workerIndex ) const;
+        bool                            RunOne( u32 workerIndex );
+        void                            Execute( u32 workerIndex, Job* job );
+        void                            WorkerLoop( u32 workerIndex );
+
+        template <typename Func>
+        static void                     ParallelForJob( void* data, u32 begin, u32 end );
+
+        Allocator*                      m_allocator         = nullptr;
+        JobWorker*                      m_workers           = nullptr;
+        JobInjectionQueue*              m_injection         = nullptr;
+        u32                             m_workerCount       = 0;
+        u32                             m_instanceId        = 0;
+
+        std::atomic<u32>                m_queuedJobs        { 0 };
+        std::atomic<u32>                m_sleepingWorkers   { 0 };
+        std::atomic<bool>               m_quit              { false };
+        std::mutex                      m_sleepMutex;
+        std::condition_variable         m_sleepCondition;
+
+        std::chrono::steady_clock::time_point m_statisticsStart;
+
+        static constexpr cstring        m_name = "caustix_job_system";
+    };
+
+    template <typename Func>
+    struct ParallelForData {
+        JobSystem*                      m_system;
+        Func*                           m_func;
+        JobCounter*                     m_counter;
+        u32                             m_grainSize;
+    };
+
+    template <typename Func>
+    void JobSystem::ParallelForJob( void* data, u32 begin, u32 end ) {
+        ParallelForData<Func>* parallel_for = ( ParallelForData<Func>* )data;
+        JobSystem* system = parallel_for->m_system;
+        const u32 grain_size = parallel_for->m_grainSize;
+        const u32 worker_index = system->GetWorkerIndex();
+
+        while ( begin < end ) {
+            // Nothing left in the queue for the thieves: keep the first half and hand out the second one.
+            if ( end - begin > grain_size && system->ShouldSplit( worker_index ) ) {
+                const u32 middle = begin + ( end - begin ) / 2;
+                system->Run( &JobSystem::ParallelForJob<Func>, data, middle, end, parallel_for->m_counter );
+                end = middle;
+                continue;
+            }
+
+            const u32 range_end = end - begin > grain_size ? begin + grain_size : end;
+            ( *parallel_for->m_func )( begin, range_end );
+            begin = range_end;
+        }
+    }
+
+    template <typename Func>
+    void JobSystem::ParallelFor( u32 count, Func&& func, u32 grainSize ) {
+        if ( count == 0 ) {
+            return;
+        }
+
+        using FuncType = std::remove_reference_t<Func>;
+        JobCounter counter;
+        ParallelForData<FuncType> data{ this, &func, &counter, grainSize ? grainSize : 1 };
+        if ( grainSize == 0 ) {
+            const u32 target_ranges = m_workerCount * 8;
+            data.m_grainSize = count > target_ranges ? ( count + target_ranges - 1 ) / target_ranges : 1;
+        }
+
+        Run( &JobSystem::ParallelForJob<FuncType>, &data, 0, count, &counter );
+        Wait( &counter );
+    }
+}
+
+namespace Caustix {
+    struct JobWorkerCache {
+        u32                 m_instanceId    = 0;
+        u32                 m_workerIndex   = 0;
+        u32                 m_executeDepth  = 0;    // Jobs running on this thread, nested ones run inside a Wait.
+        u32                 m_stealSeed     = 0x9E3779B9u;  // Victim choice of threads outside the system.
+    };
+
+    static std::atomic<u32>             s_jobSystemInstanceCounter{ 0 };
+    static thread_local JobWorkerCache  t_jobWorkerCache;
+
+    // JobQueue ///////////////////////////////////////////////////////////////
+    bool JobQueue::Push( Job* job ) {
+        const i64 bottom = m_bottom.load( std::memory_order_relaxed );
+        const i64 top = m_top.load( std::memory_order_acquire );
+        if ( bottom - top >= ( i64 )k_job_queue_size ) {
+            return false;
+        }
+
+        m_jobs[ bottom & ( k_job_queue_size - 1 ) ].store( job, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+        return true;
+    }
+
+    Job* JobQueue::Pop() {
+        const i64 bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+        m_bottom.store( bottom, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        i64 top = m_top.load( std::memory_order_relaxed );
+
+        if ( top > bottom ) {
+            // Empty queue.
+            m_bottom.store( bottom + 1, std::memory_order_relaxed );
+            return nullptr;
+        }
+
+        Job* job = m_jobs[ bottom & ( k_job_queue_size - 1 ) ].load( std::memory_order_relaxed );
+        if ( top == bottom ) {
+            // Last job, race against the thieves for it.
+            if ( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+                job = nullptr;
+            }
+            m_bottom.store( bottom + 1, std::memory_order_relaxed );
+        }
+        return job;
+    }
+
+    Job* JobQueue::Steal() {
+        i64 top = m_top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        const i64 bottom = m_bottom.load( std::memory_order_acquire );
+
+        if ( top >= bottom ) {
+            return nullptr;
+        }
+
+        Job* job = m_jobs[ top & ( k_job_queue_size - 1 ) ].load( std::memory_order_relaxed );
+        if ( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    bool JobQueue::IsEmpty() const {
+        return m_bottom.load( std::memory_order_relaxed ) <= m_top.load( std::memory_order_relaxed );
+    }
+
+    // JobSystem //////////////////////////////////////////////////////////////
+    static void PinThread( std::thread::native_handle_type handle, u32 core ) {
+#if defined(_MSC_VER)
+        SetThreadAffinityMask( ( HANDLE )handle, 1ull << ( core % 64 ) );
+#elif defined(__linux__)
+        cpu_set_t cpu_set;
+        CPU_ZERO( &cpu_set );
+        CPU_SET( core, &cpu_set );
+        pthread_setaffinity_np( handle, sizeof( cpu_set_t ), &cpu_set );
+#endif
+    }
+
+    JobSystem::JobSystem( const JobSystemConfiguration& configuration ) {
+        m_allocator = configuration.m_allocator;
+        m_instanceId = ++s_jobSystemInstanceCounter;
+
+        const u32 hardware_threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+        m_workerCount = configuration.m_workerCount ? configuration.m_workerCount : hardware_threads;
+        m_workerCount = m_workerCount < k_max_job_workers ? m_workerCount : k_max_job_workers;
+
+        m_workers = ( JobWorker* )m_allocator->allocate( sizeof( JobWorker ) * m_workerCount, alignof( JobWorker ) );
+        for ( u32 i = 0; i < m_workerCount; ++i ) {
+            new ( &m_workers[ i ] ) JobWorker();
+            m_workers[ i ].m_stealSeed = i * 2654435761u + 1;
+        }
+        m_injection = ( JobInjectionQueue* )m_allocator->allocate( sizeof( JobInjectionQueue ), alignof( JobInjectionQueue ) );
+        new ( m_injection ) JobInjectionQueue();
+
+        // The creating thread is worker 0.
+        t_jobWorkerCache.m_instanceId = m_instanceId;
+        t_jobWorkerCache.m_workerIndex = 0;
+        m_statisticsStart = std::chrono::steady_clock::now();
+
+        for ( u32 i = 1; i < m_workerCount; ++i ) {
+            m_workers[ i ].m_thread = std::thread( &JobSystem::WorkerLoop, this, i );
+            if ( configuration.m_pinThreads && i < hardware_threads ) {
+                PinThread( m_workers[ i ].m_thread.native_handle(), i );
+            }
+        }
+
+        info( "JobSystem created with {} workers", m_workerCount );
+    }
+
+    JobSystem::~JobSystem() {
+        Shutdown();
+    }
+
+    void JobSystem::Shutdown() {
+        if ( m_workers == nullptr ) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_sleepMutex );
+            m_quit.store( true, std::memory_order_release );
+        }
+        m_sleepCondition.notify_all();
+
+        for ( u32 i = 0; i < m_workerCount; ++i ) {
+            if ( m_workers[ i ].m_thread.joinable() ) {
+                m_workers[ i ].m_thread.join();
+            }
+            m_workers[ i ].~JobWorker();
+        }
+
+        m_allocator->deallocate( m_workers );
+        m_workers = nullptr;
+
+        m_injection->~JobInjectionQueue();
+        m_allocator->deallocate( m_injection );
+        m_injection = nullptr;
+    }
+
+    u32 JobSystem::GetWorkerIndex() const {
+        // The cache can hold the index of another system, or nothing for threads no system created.
+        if ( t_jobWorkerCache.m_instanceId != m_instanceId ) {
+            return k_job_external_worker;
+        }
+        return t_jobWorkerCache.m_workerIndex;
+    }
+
+    Job* JobSystem::AllocateJob( JobWorker& worker ) {
+        Job* job = &worker.m_jobs[ worker.m_jobsAllocated & ( k_job_pool_size - 1 ) ];
+        // The ring wrapped around on a job still queued or running: too many jobs in flight from this worker.
+        // Small grain parallel fors get there, the first halves they push wait in the queue until the end.
+        if ( !job->m_finished.load( std::memory_order_acquire ) ) {
+            return nullptr;
+        }
+        ++worker.m_jobsAllocated;
+        job->m_finished.store( false, std::memory_order_relaxed );
+        return job;
+    }
+
+    void JobSystem::Submit( JobWorker& worker, Job* job ) {
+        if ( job->m_counter ) {
+            job->m_counter->m_value.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        // Counted before the push, so a thief can never see it drop below zero.
+        // Sequentially consistent with the sleeping count below: a store then a load is not ordered by acquire and release,
+        // either this sees the sleeping worker or the worker sees the queued job.
+        m_queuedJobs.fetch_add( 1, std::memory_order_seq_cst );
+        if ( !worker.m_queue.Push( job ) ) {
+            // Queue full, run it now rather than failing.
+            m_queuedJobs.fetch_sub( 1, std::memory_order_relaxed );
+            Execute( GetWorkerIndex(), job );
+            return;
+        }
+        WakeWorker();
+    }
+
+    void JobSystem::WakeWorker() {
+        if ( m_sleepingWorkers.load( std::memory_order_seq_cst ) > 0 ) {
+            // Taking the lock orders this wake up after a worker checking the queue before sleeping.
+            { std::lock_guard<std::mutex> lock( m_sleepMutex ); }
+            m_sleepCondition.notify_one();
+        }
+    }
+
+    bool JobSystem::Inject( Job& job ) {
+        JobInjectionQueue& injection = *m_injection;
+        {
+            std::lock_guard<std::mutex> lock( injection.m_mutex );
+            Job* pooled = &injection.m_pool[ injection.m_jobsAllocated & ( k_job_pool_size - 1 ) ];
+            if ( injection.m_tail - injection.m_head >= k_job_queue_size || !pooled->m_finished.load( std::memory_order_acquire ) ) {
+                return false;
+            }
+            ++injection.m_jobsAllocated;
+
+            pooled->m_function = job.m_function;
+            pooled->m_data = job.m_data;
+            pooled->m_counter = job.m_counter;
+            pooled->m_begin = job.m_begin;
+            pooled->m_end = job.m_end;
+            pooled->m_finished.store( false, std::memory_order_relaxed );
+            if ( job.m_counter ) {
+                job.m_counter->m_value.fetch_add( 1, std::memory_order_relaxed );
+            }
+
+            // Same ordering against the sleeping workers as Submit.
+            m_queuedJobs.fetch_add( 1, std::memory_order_seq_cst );
+            injection.m_jobs[ injection.m_tail++ & ( k_job_queue_size - 1 ) ] = pooled;
+            injection.m_count.fetch_add( 1, std::memory_order_release );
+        }
+        WakeWorker();
+        return true;
+    }
+
+    Job* JobSystem::TakeInjected() {
+        JobInjectionQueue& injection = *m_injection;
+        if ( injection.m_count.load( std::memory_order_acquire ) == 0 ) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock( injection.m_mutex );
+        if ( injection.m_head == injection.m_tail ) {
+            return nullptr;
+        }
+        injection.m_count.fetch_sub( 1, std::memory_order_relaxed );
+        return injection.m_jobs[ injection.m_head++ & ( k_job_queue_size - 1 ) ];
+    }
+
+    bool JobSystem::ShouldSplit( u32 workerIndex ) const {
+        // Threads outside the system have no queue, what they split goes to the injection queue.
+        return workerIndex == k_job_external_worker || m_workers[ workerIndex ].m_queue.IsEmpty();
+    }
+
+    void JobSystem::Run( JobFunction function, void* data, JobCounter* counter ) {
+        Run( function, data, 0, 0, counter );
+    }
+
+    void JobSystem::Run( JobFunction function, void* data, u32 begin, u32 end, JobCounter* counter ) {
+        const u32 worker_index = GetWorkerIndex();
+        Job* job = worker_index != k_job_external_worker ? AllocateJob( m_workers[ worker_index ] ) : nullptr;
+
+        // Threads outside the system copy the job into the injection queue. Without a free job in the pool
+        // or room in the injection queue, it runs now like Submit does when the queue is full.
+        Job inlineJob;
+        const bool pooled = job != nullptr;
+        if ( !pooled ) {
+            job = &inlineJob;
+        }
+
+        job->m_function = function;
+        job->m_data = data;
+        job->m_counter = counter;
+        job->m_begin = begin;
+        job->m_end = end;
+
+        if ( pooled ) {
+            Submit( m_workers[ worker_index ], job );
+            return;
+        }
+        if ( worker_index == k_job_external_worker && Inject( *job ) ) {
+            return;
+        }
+        if ( counter ) {
+            counter->m_value.fetch_add( 1, std::memory_order_relaxed );
+        }
+        Execute( worker_index, job );
+    }
+
+    void JobSystem::Execute( u32 workerIndex, Job* job ) {
+        // Only the workers keep statistics.
+        JobWorkerStatistics* statistics = workerIndex != k_job_external_worker ? &m_workers[ workerIndex ].m_statistics : nullptr;
+        const auto start = std::chrono::steady_clock::now();
+
+        // Jobs run by a nested Wait are inside the time of the outermost one.
+        const bool outermost = t_jobWorkerCache.m_executeDepth++ == 0;
+        JobCounter* counter = job->m_counter;
+        job->m_function( job->m_data, job->m_begin, job->m_end );
+        --t_jobWorkerCache.m_executeDepth;
+        job->m_finished.store( true, std::memory_order_release );
+
+        if ( counter ) {
+            counter->m_value.fetch_sub( 1, std::memory_order_acq_rel );
+        }
+
+        if ( statistics == nullptr ) {
+            return;
+        }
+        if ( outermost ) {
+            const u64 elapsed = ( u64 )std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+            statistics->m_busyNanoseconds.fetch_add( elapsed, std::memory_order_relaxed );
+        }
+        statistics->m_jobsExecuted.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    bool JobSystem::RunOne( u32 workerIndex ) {
+        const bool external = workerIndex == k_job_external_worker;
+        Job* job = external ? nullptr : m_workers[ workerIndex ].m_queue.Pop();
+        if ( job == nullptr ) {
+            job = TakeInjected();
+        }
+
+        if ( job == nullptr && ( m_workerCount > 1 || external ) ) {
+            // Steal starting from a random victim, xorshift keeps it cheap.
+            u32& seed = external ? t_jobWorkerCache.m_stealSeed : m_workers[ workerIndex ].m_stealSeed;
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            const u32 first = seed % m_workerCount;
+            for ( u32 i = 0; i < m_workerCount && job == nullptr; ++i ) {
+                const u32 victim = ( first + i ) % m_workerCount;
+                if ( victim != workerIndex ) {
+                    job = m_workers[ victim ].m_queue.Steal();
+                }
+            }
+            if ( job && !external ) {
+                m_workers[ workerIndex ].m_statistics.m_jobsStolen.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+
+        if ( job == nullptr ) {
+            return false;
+        }
+
+        m_queuedJobs.fetch_sub( 1, std::memory_order_relaxed );
+        Execute( workerIndex, job );
+        return true;
+    }
+
+    void JobSystem::Wait( JobCounter* counter ) {
+        const u32 worker_index = GetWorkerIndex();
+        while ( !counter->IsDone() ) {
+            // Help instead of blocking, this also makes nested waits from inside jobs safe.
+            if ( !RunOne( worker_index ) ) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::WorkerLoop( u32 workerIndex ) {
+        t_jobWorkerCache.m_instanceId = m_instanceId;
+        t_jobWorkerCache.m_workerIndex = workerIndex;
+
+        u32 idle_spins = 0;
+        while ( !m_quit.load( std::memory_order_acquire ) ) {
+            if ( RunOne( workerIndex ) ) {
+                idle_spins = 0;
+                continue;
+            }
+
+            if ( ++idle_spins < 64 ) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock( m_sleepMutex );
+            // Pairs with Submit, see there.
+            m_sleepingWorkers.fetch_add( 1, std::memory_order_seq_cst );
+            m_sleepCondition.wait( lock, [ this ]() {
+                return m_queuedJobs.load( std::memory_order_seq_cst ) > 0 || m_quit.load( std::memory_order_acquire );
+            } );
+            m_sleepingWorkers.fetch_sub( 1, std::memory_order_acq_rel );
+            idle_spins = 0;
+        }
+    }
+
+    void JobSystem::ResetStatistics() {
+        for ( u32 i = 0; i < m_workerCount; ++i ) {
+            JobWorkerStatistics& statistics = m_workers[ i ].m_statistics;
+            statistics.m_jobsExecuted.store( 0, std::memory_order_relaxed );
+            statistics.m_jobsStolen.store( 0, std::memory_order_relaxed );
+            statistics.m_busyNanoseconds.store( 0, std::memory_order_relaxed );
+        }
+        m_statisticsStart = std::chrono::steady_clock::now();
+    }
+
+    void JobSystem::debug_ui() {
+        if ( ImGui::Begin( "Job System" ) ) {
+            const f64 elapsed = ( f64 )std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_statisticsStart ).count();
+            ImGui::Text( "%u workers, %u queued jobs", m_workerCount, m_queuedJobs.load( std::memory_order_relaxed ) );
+            for ( u32 i = 0; i < m_workerCount; ++i ) {
+                const JobWorkerStatistics& statistics = m_workers[ i ].m_statistics;
+                const f32 utilization = elapsed > 0.0 ? ( f32 )( ( f64 )statistics.m_busyNanoseconds.load( std::memory_order_relaxed ) / elapsed ) : 0.f;
+                ImGui::Text( "Worker %2u: %llu jobs, %llu stolen", i, ( unsigned long long )statistics.m_jobsExecuted.load( std::memory_order_relaxed ),
+                             ( unsigned long long )statistics.m_jobsStolen.load( std::memory_order_relaxed ) );
+                ImGui::SameLine();
+                ImGui::ProgressBar( utilization, ImVec2( 120.f, 0.f ) );
+            }
+            if ( ImGui::Button( "Reset statistics" ) ) {
+                ResetStatistics();
+            }
+        }
+        ImGui::End();
+    }
+}
@@ -0,0 +1,613 @@
+module;
+
+#include <string.h>
+
+#include <bit>
+#include <charconv>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CAUSTIX_JSON_SSE2
+#endif
+
+export module Foundation.Json;
+
+import Foundation.Platform;
+
+export namespace Caustix {
+
+    enum class JsonType : u8 {
+        Invalid, Object, Array, String, Number, Bool, Null
+    };
+
+    // Forward only pull parser over a JSON document in memory.
+    // Nothing is allocated and the document is never written, so it can be parsed straight from a read only mapping.
+    // Strings without escapes are views into the document. Strings with escapes are unescaped run by run, straight into
+    // the destination with ReadString( out ), or into a small scratch buffer for the string_view overload, used for keys
+    // and enumerants. Values are consumed in document order and the caller skips the ones it does not care about with Skip().
+    // Errors are sticky: after the first one the cursor moves to the end, reads return defaults and
+    // NextKey/NextElement return false, so nested loaders unwind without checking every call.
+    struct JsonReader {
+
+        static constexpr u32 k_scratch_size = 256;
+
+        JsonReader( const char* data, sizet size );
+
+        JsonType            Peek();
+
+        // Return false, skipping the value, when the next value is not an object/array.
+        bool                BeginObject();
+        bool                BeginArray();
+
+        // Move to the next member/element. Return false once the closing bracket has been consumed.
+        bool                NextKey( std::string_view& key );
+        bool                NextElement();
+
+        // The view is valid until the next read. Escaped strings longer than k_scratch_size fail.
+        std::string_view    ReadString();
+        // Replaces the content of out, which needs clear() and append( const char*, sizet ).
+        template <typename String>
+        void                ReadString( String& out );
+        // Integers written as 1.0 or 1e3 are accepted, fractions and values outside of i32 fail.
+        i32                 ReadInt( i32 defaultValue = 0 );
+        f32                 ReadFloat( f32 defaultValue = 0.0f );
+        f64                 ReadDouble( f64 defaultValue = 0.0 );
+        bool                ReadBool( bool defaultValue = false );
+        void                Skip();
+
+        bool                HasError() const    { return m_error; }
+        sizet               GetErrorOffset() const { return m_errorOffset; }
+
+        void                SkipWhitespace();
+        void                Fail();
+
+        // Moves inside the string at the cursor.
+        bool                OpenString();
+        // Next piece of the string: a run of plain text or one decoded escape. Returns false once the closing quote
+        // has been consumed, or on error.
+        bool                NextStringRun( std::string_view& run );
+
+        // Returns the character after the bracket closing the container opening at start.
+        const char*         ScanContainer( const char* start );
+        const char*         ScanNumber( const char* start );
+
+        const char*         m_begin;
+        const char*         m_cursor;
+        const char*         m_end;
+
+        sizet               m_errorOffset   = 0;
+        bool                m_error         = false;
+
+        char                m_escape[ 4 ];              // UTF-8 of the last decoded escape.
+        char                m_scratch[ k_scratch_size ];
+    };
+
+    template <typename String>
+    void JsonReader::ReadString( String& out ) {
+        out.clear();
+        if ( !OpenString() ) {
+            return;
+        }
+
+        std::string_view run;
+        while ( NextStringRun( run ) ) {
+            out.append( run.data(), run.size() );
+        }
+    }
+}
+
+namespace Caustix {
+
+    // First '"' or '\\' in [start, end), end when there is none.
+    static const char* FindStringSpecial( const char* start, const char* end ) {
+        const char* p = start;
+#if defined(CAUSTIX_JSON_SSE2)
+        const __m128i quote = _mm_set1_epi8( '"' );
+        const __m128i backslash = _mm_set1_epi8( '\\' );
+        for ( ; p + 16 <= end; p += 16 ) {
+            const __m128i chunk = _mm_loadu_si128( ( const __m128i* )p );
+            const u32 mask = ( u32 )_mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( chunk, quote ), _mm_cmpeq_epi8( chunk, backslash ) ) );
+            if ( mask ) {
+                return p + std::countr_zero( mask );
+            }
+        }
+#endif
+        for ( ; p < end; ++p ) {
+            if ( *p == '"' || *p == '\\' ) {
+                return p;
+            }
+        }
+        return end;
+    }
+
+    static bool ReadHex4( const char* text, u32& value ) {
+        value = 0;
+        for ( u32 i = 0; i < 4; ++i ) {
+            const char c = text[ i ];
+            u32 digit;
+            if ( c >= '0' && c <= '9' ) {
+                digit = c - '0';
+            } else if ( c >= 'a' && c <= 'f' ) {
+                digit = c - 'a' + 10;
+            } else if ( c >= 'A' && c <= 'F' ) {
+                digit = c - 'A' + 10;
+            } else {
+                return false;
+            }
+            value = ( value << 4 ) | digit;
+        }
+        return true;
+    }
+
+    static char* EncodeUtf8( char* out, u32 codepoint ) {
+        if ( codepoint < 0x80 ) {
+            *out++ = ( char )codepoint;
+        } else if ( codepoint < 0x800 ) {
+            *out++ = ( char )( 0xC0 | ( codepoint >> 6 ) );
+            *out++ = ( char )( 0x80 | ( codepoint & 0x3F ) );
+        } else if ( codepoint < 0x10000 ) {
+            *out++ = ( char )( 0xE0 | ( codepoint >> 12 ) );
+            *out++ = ( char )( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+            *out++ = ( char )( 0x80 | ( codepoint & 0x3F ) );
+        } else {
+            *out++ = ( char )( 0xF0 | ( codepoint >> 18 ) );
+            *out++ = ( char )( 0x80 | ( ( codepoint >> 12 ) & 0x3F ) );
+            *out++ = ( char )( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+            *out++ = ( char )( 0x80 | ( codepoint & 0x3F ) );
+        }
+        return out;
+    }
+
+    JsonReader::JsonReader( const char* data, sizet size ) : m_begin( data ), m_cursor( data ), m_end( data + size ) {
+        // UTF-8 byte order mark.
+        if ( size >= 3 && ( u8 )data[ 0 ] == 0xEF && ( u8 )data[ 1 ] == 0xBB && ( u8 )data[ 2 ] == 0xBF ) {
+            m_cursor += 3;
+        }
+    }
+
+    void JsonReader::Fail() {
+        if ( !m_error ) {
+            m_error = true;
+            m_errorOffset = m_cursor - m_begin;
+        }
+        m_cursor = m_end;
+    }
+
+    void JsonReader::SkipWhitespace() {
+        const char* p = m_cursor;
+        // Minified documents never get past this check.
+        if ( p < m_end && ( u8 )*p > ' ' ) {
+            return;
+        }
+#if defined(CAUSTIX_JSON_SSE2)
+        // Outside strings the only bytes not above ' ' are whitespace. max_epu8 gives an unsigned compare.
+        const __m128i nonWhitespace = _mm_set1_epi8( ' ' + 1 );
+        for ( ; p + 16 <= m_end; p += 16 ) {
+            const __m128i chunk = _mm_loadu_si128( ( const __m128i* )p );
+            const u32 mask = ( u32 )_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_max_epu8( chunk, nonWhitespace ), chunk ) );
+            if ( mask ) {
+                m_cursor = p + std::countr_zero( mask );
+                return;
+            }
+        }
+#endif
+        while ( p < m_end && ( u8 )*p <= ' ' ) {
+            ++p;
+        }
+        m_cursor = p;
+    }
+
+    JsonType JsonReader::Peek() {
+        SkipWhitespace();
+        if ( m_cursor >= m_end ) {
+            return JsonType::Invalid;
+        }
+
+        switch ( *m_cursor ) {
+            case '{':
+                return JsonType::Object;
+            case '[':
+                return JsonType::Array;
+            case '"':
+                return JsonType::String;
+            case 't':
+            case 'f':
+                return JsonType::Bool;
+            case 'n':
+                return JsonType::Null;
+            case '-':
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                return JsonType::Number;
+            default:
+                return JsonType::Invalid;
+        }
+    }
+
+    bool JsonReader::BeginObject() {
+        if ( Peek() != JsonType::Object ) {
+            Skip();
+            return false;
+        }
+        ++m_cursor;
+        return true;
+    }
+
+    bool JsonReader::BeginArray() {
+        if ( Peek() != JsonType::Array ) {
+            Skip();
+            return false;
+        }
+        ++m_cursor;
+        return true;
+    }
+
+    bool JsonReader::NextKey( std::string_view& key ) {
+        if ( m_error ) {
+            return false;
+        }
+
+        SkipWhitespace();
+        if ( m_cursor >= m_end ) {
+            Fail();
+            return false;
+        }
+        if ( *m_cursor == '}' ) {
+            ++m_cursor;
+            return false;
+        }
+        if ( *m_cursor == ',' ) {
+            ++m_cursor;
+        }
+
+        key = ReadString();
+        SkipWhitespace();
+        if ( m_error || m_cursor >= m_end || *m_cursor != ':' ) {
+            Fail();
+            return false;
+        }
+        ++m_cursor;
+        return true;
+    }
+
+    bool JsonReader::NextElement() {
+        if ( m_error ) {
+            return false;
+        }
+
+        SkipWhitespace();
+        if ( m_cursor >= m_end ) {
+            Fail();
+            return false;
+        }
+        if ( *m_cursor == ']' ) {
+            ++m_cursor;
+            return false;
+        }
+        if ( *m_cursor == ',' ) {
+            ++m_cursor;
+        }
+        return true;
+    }
+
+    bool JsonReader::OpenString() {
+        if ( Peek() != JsonType::String ) {
+            Fail();
+            return false;
+        }
+        ++m_cursor;
+        return true;
+    }
+
+    bool JsonReader::NextStringRun( std::string_view& run ) {
+        if ( m_error ) {
+            return false;
+        }
+
+        const char* special = FindStringSpecial( m_cursor, m_end );
+        if ( special != m_cursor ) {
+            if ( special >= m_end ) {
+                Fail();
+                return false;
+            }
+            run = { m_cursor, ( sizet )( special - m_cursor ) };
+            m_cursor = special;
+            return true;
+        }
+
+        if ( special >= m_end ) {
+            Fail();
+            return false;
+        }
+        if ( *special == '"' ) {
+            m_cursor = special + 1;
+            return false;
+        }
+        if ( special + 1 >= m_end ) {
+            Fail();
+            return false;
+        }
+
+        const char* p = special + 2;
+        char* out = m_escape;
+        switch ( special[ 1 ] ) {
+            case '"':  *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/':  *out++ = '/'; break;
+            case 'b':  *out++ = '\b'; break;
+            case 'f':  *out++ = '\f'; break;
+            case 'n':  *out++ = '\n'; break;
+            case 'r':  *out++ = '\r'; break;
+            case 't':  *out++ = '\t'; break;
+            case 'u': {
+                u32 codepoint;
+                if ( p + 4 > m_end || !ReadHex4( p, codepoint ) ) {
+                    Fail();
+                    return false;
+                }
+                p += 4;
+
+                // Surrogate pair.
+                u32 low;
+                if ( codepoint >= 0xD800 && codepoint < 0xDC00 && p + 6 <= m_end && p[ 0 ] == '\\' && p[ 1 ] == 'u' &&
+                     ReadHex4( p + 2, low ) && low >= 0xDC00 && low < 0xE000 ) {
+                    codepoint = 0x10000 + ( ( codepoint - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                    p += 6;
+                }
+                out = EncodeUtf8( out, codepoint );
+                break;
+            }
+            default:
+                Fail();
+                return false;
+        }
+
+        m_cursor = p;
+        run = { m_escape, ( sizet )( out - m_escape ) };
+        return true;
+    }
+
+    std::string_view JsonReader::ReadString() {
+        if ( !OpenString() ) {
+            return {};
+        }
+
+        // Most strings have no escapes and are returned in place.
+        const char* start = m_cursor;
+        const char* special = FindStringSpecial( start, m_end );
+        if ( special < m_end && *special == '"' ) {
+            m_cursor = special + 1;
+            return { start, ( sizet )( special - start ) };
+        }
+
+        sizet size = 0;
+        std::string_view run;
+        while ( NextStringRun( run ) ) {
+            if ( size + run.size() > k_scratch_size ) {
+                Fail();
+                return {};
+            }
+            memcpy( m_scratch + size, run.data(), run.size() );
+            size += run.size();
+        }
+        return m_error ? std::string_view{} : std::string_view{ m_scratch, size };
+    }
+
+    const char* JsonReader::ScanNumber( const char* start ) {
+        const char* p = start;
+        while ( p < m_end ) {
+            const char c = *p;
+            if ( ( c >= '0' && c <= '9' ) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' ) {
+                ++p;
+            } else {
+                break;
+            }
+        }
+        return p;
+    }
+
+    f64 JsonReader::ReadDouble( f64 defaultValue ) {
+        if ( Peek() != JsonType::Number ) {
+            Skip();
+            return defaultValue;
+        }
+
+        f64 value = defaultValue;
+        const std::from_chars_result result = std::from_chars( m_cursor, m_end, value );
+        if ( result.ec != std::errc() ) {
+            Fail();
+            return defaultValue;
+        }
+        m_cursor = result.ptr;
+        return value;
+    }
+
+    f32 JsonReader::ReadFloat( f32 defaultValue ) {
+        return ( f32 )ReadDouble( defaultValue );
+    }
+
+    i32 JsonReader::ReadInt( i32 defaultValue ) {
+        if ( Peek() != JsonType::Number ) {
+            Skip();
+            return defaultValue;
+        }
+
+        i32 value = defaultValue;
+        const std::from_chars_result result = std::from_chars( m_cursor, m_end, value );
+        const char* end = result.ptr;
+        if ( result.ec == std::errc() && !( end < m_end && ( *end == '.' || *end == 'e' || *end == 'E' ) ) ) {
+            m_cursor = end;
+            return value;
+        }
+
+        // Integers written as 1.0 or 1e3 by some exporters. Anything else does not fit in an i32,
+        // and converting it would be undefined.
+        const char* start = m_cursor;
+        const f64 number = ReadDouble( defaultValue );
+        if ( m_error || !( number >= -( f64 )i32_max - 1.0 && number <= ( f64 )i32_max ) || number != ( f64 )( i32 )number ) {
+            m_cursor = start;
+            Fail();
+            return defaultValue;
+        }
+        return ( i32 )number;
+    }
+
+    bool JsonReader::ReadBool( bool defaultValue ) {
+        if ( Peek() != JsonType::Bool ) {
+            Skip();
+            return defaultValue;
+        }
+
+        if ( m_end - m_cursor >= 4 && memcmp( m_cursor, "true", 4 ) == 0 ) {
+            m_cursor += 4;
+            return true;
+        }
+        if ( m_end - m_cursor >= 5 && memcmp( m_cursor, "false", 5 ) == 0 ) {
+            m_cursor += 5;
+            return false;
+        }
+
+        Fail();
+        return defaultValue;
+    }
+
+    void JsonReader::Skip() {
+        switch ( Peek() ) {
+            case JsonType::Object:
+            case JsonType::Array:
+                m_cursor = ScanContainer( m_cursor );
+                break;
+            case JsonType::String: {
+                // No need to unescape a string nobody reads.
+                const char* p = m_cursor + 1;
+                for ( ;; ) {
+                    p = FindStringSpecial( p, m_end );
+                    if ( p >= m_end ) {
+                        Fail();
+                        return;
+                    }
+                    if ( *p == '"' ) {
+                        m_cursor = p + 1;
+                        return;
+                    }
+                    p += 2;
+                }
+            }
+            case JsonType::Number:
+                m_cursor = ScanNumber( m_cursor );
+                break;
+            case JsonType::Bool:
+                ReadBool();
+                break;
+            case JsonType::Null:
+                if ( m_end - m_cursor >= 4 && memcmp( m_cursor, "null", 4 ) == 0 ) {
+                    m_cursor += 4;
+                } else {
+                    Fail();
+                }
+                break;
+            case JsonType::Invalid:
+                Fail();
+                break;
+        }
+    }
+
+    const char* JsonReader::ScanContainer( const char* start ) {
+        u32 depth = 0;
+        bool inString = false;
+
+        const char* p = start;
+#if defined(CAUSTIX_JSON_SSE2)
+        // Only quotes, backslashes and brackets change the scanner state: find them 16 bytes at a time
+        // and walk the matches, so long strings and runs of numbers cost a few instructions per chunk.
+        const __m128i quote = _mm_set1_epi8( '"' );
+        const __m128i backslash = _mm_set1_epi8( '\\' );
+        const __m128i openArray = _mm_set1_epi8( '[' );
+        const __m128i closeArray = _mm_set1_epi8( ']' );
+        const __m128i openObject = _mm_set1_epi8( '{' );
+        const __m128i closeObject = _mm_set1_epi8( '}' );
+
+        while ( p + 16 <= m_end ) {
+            const __m128i chunk = _mm_loadu_si128( ( const __m128i* )p );
+            const __m128i strings = _mm_or_si128( _mm_cmpeq_epi8( chunk, quote ), _mm_cmpeq_epi8( chunk, backslash ) );
+            const __m128i brackets = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chunk, openArray ), _mm_cmpeq_epi8( chunk, closeArray ) ),
+                                                   _mm_or_si128( _mm_cmpeq_epi8( chunk, openObject ), _mm_cmpeq_epi8( chunk, closeObject ) ) );
+            u32 mask = ( u32 )_mm_movemask_epi8( _mm_or_si128( strings, brackets ) );
+
+            u32 advance = 16;
+            while ( mask ) {
+                const u32 bit = std::countr_zero( mask );
+                mask &= mask - 1;
+
+                const char c = p[ bit ];
+                if ( inString ) {
+                    if ( c == '"' ) {
+                        inString = false;
+                    } else if ( c == '\\' ) {
+                        // Drop the escaped character, which may be the first of the next chunk.
+                        if ( bit == 15 ) {
+                            advance = 17;
+                        } else {
+                            mask &= ~( 1u << ( bit + 1 ) );
+                        }
+                    }
+                    continue;
+                }
+
+                switch ( c ) {
+                    case '"':
+                        inString = true;
+                        break;
+                    case '[':
+                    case '{':
+                        ++depth;
+                        break;
+                    case ']':
+                    case '}':
+                        if ( --depth == 0 ) {
+                            return p + bit + 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+            p += advance;
+        }
+#endif
+        for ( ; p < m_end; ++p ) {
+            const char c = *p;
+            if ( inString ) {
+                if ( c == '"' ) {
+                    inString = false;
+                } else if ( c == '\\' ) {
+                    ++p;
+                }
+                continue;
+            }
+
+            switch ( c ) {
+                case '"':
+                    inString = true;
+                    break;
+                case '[':
+                case '{':
+                    ++depth;
+                    break;
+                case ']':
+                case '}':
+                    if ( --depth == 0 ) {
+                        return p + 1;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Unterminated container.
+        Fail();
+        return m_end;
+    }
+}
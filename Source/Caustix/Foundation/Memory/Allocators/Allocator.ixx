@@ -41,7 +41,7 @@ export namespace Caustix {
         [[nodiscard]] constexpr T* allocate(sizet n)
         {
             return reinterpret_cast<T*>
-            (m_allocator.allocate(n * sizeof(T), sizeof(T)));
+            (m_allocator.allocate(n * sizeof(T), alignof(T)));
         }
 
         constexpr void deallocate(T* p, [[maybe_unused]] sizet n)
@@ -0,0 +1,122 @@
+module;
+
+#include <cstdlib>
+
+#include <imgui.h>
+
+export module Foundation.Memory.Allocators.FrameAllocator;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryTracker;
+import Foundation.Log;
+
+export namespace Caustix {
+    static const u32 k_max_frame_allocator_frames = 4;
+
+    // Linear allocator with one region per frame in flight.
+    // A region is rewound only by BeginFrame with its index, which the GpuDevice calls after waiting
+    // on that frame fence, so per-frame data stays valid until the GPU is done with it.
+    struct FrameAllocator : public Allocator {
+        FrameAllocator() = default;
+        FrameAllocator( sizet frameSize, u32 frameCount );
+        ~FrameAllocator();
+
+        void*   allocate( sizet size, sizet alignment ) override;
+        void*   allocate( sizet size, sizet alignment, cstring file, i32 line ) override;
+
+        void    deallocate( void* pointer ) override;
+
+        void    BeginFrame( u32 frameIndex );
+
+        void    debug_ui();
+
+        u8*     m_memory            = nullptr;
+        sizet   m_frameSize         = 0;
+        u32     m_frameCount        = 0;
+        u32     m_currentFrame      = 0;
+
+        sizet   m_allocatedSize     = 0;    // Inside the current frame region.
+        sizet   m_lastFrameSize     = 0;    // Bytes used by the previous frame.
+        sizet   m_highWaterMark     = 0;    // Peak usage of any single frame.
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        MemoryTracker m_tracker;
+#endif // CAUSTIX_MEMORY_TRACKING
+    };
+}
+
+namespace Caustix {
+    FrameAllocator::FrameAllocator( sizet frameSize, u32 frameCount ) {
+        CASSERT( frameCount > 0 && frameCount <= k_max_frame_allocator_frames );
+
+        m_frameSize = MemoryAlign( frameSize, 64 );
+        m_frameCount = frameCount;
+        m_memory = ( u8* )malloc( m_frameSize * m_frameCount );
+        m_currentFrame = 0;
+        m_allocatedSize = 0;
+    }
+
+    FrameAllocator::~FrameAllocator() {
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.Report( "FrameAllocator" );
+#endif // CAUSTIX_MEMORY_TRACKING
+        info( "FrameAllocator: high water mark {} of {} bytes per frame", m_highWaterMark, m_frameSize );
+        free( m_memory );
+    }
+
+    void FrameAllocator::BeginFrame( u32 frameIndex ) {
+        CASSERT( frameIndex < m_frameCount );
+
+        m_highWaterMark = m_allocatedSize > m_highWaterMark ? m_allocatedSize : m_highWaterMark;
+
+        m_currentFrame = frameIndex;
+        u8* region = m_memory + m_frameSize * m_currentFrame;
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnDeallocateRange( region, region + m_frameSize );
+#endif // CAUSTIX_MEMORY_TRACKING
+
+        m_lastFrameSize = m_allocatedSize;
+        m_allocatedSize = 0;
+    }
+
+    void* FrameAllocator::allocate( sizet size, sizet alignment ) {
+        return FrameAllocator::allocate( size, alignment, nullptr, 0 );
+    }
+
+    void* FrameAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+        CASSERT( size > 0 );
+        u8* region = m_memory + m_frameSize * m_currentFrame;
+        const sizet new_start = MemoryAlign( ( sizet )region + m_allocatedSize, alignment ) - ( sizet )region;
+        const sizet new_allocated_size = new_start + size;
+        if ( new_allocated_size > m_frameSize ) {
+            // Returning nullptr would only move the crash somewhere less obvious.
+            error( "FrameAllocator: frame {} overflow allocating {} bytes, {} of {} bytes used. Raise the frame size.", m_currentFrame, size, m_allocatedSize, m_frameSize );
+            if ( file ) {
+                error( "FrameAllocator: allocation from {}({})", file, line );
+            }
+            CASSERT( false );
+            abort();
+        }
+
+        m_allocatedSize = new_allocated_size;
+        void* pointer = region + new_start;
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnAllocate( pointer, size, file, line );
+#endif // CAUSTIX_MEMORY_TRACKING
+        return pointer;
+    }
+
+    void FrameAllocator::deallocate( void* pointer ) {
+        // Memory is given back all at once when the frame region is reused.
+    }
+
+    void FrameAllocator::debug_ui() {
+        ImGui::Separator();
+        ImGui::Text( "Frame Allocator" );
+        ImGui::Separator();
+        ImGui::Text( "Frame %u of %u, used %llu of %llu bytes", m_currentFrame, m_frameCount, ( unsigned long long )m_allocatedSize, ( unsigned long long )m_frameSize );
+        ImGui::Text( "Previous frame used %llu bytes", ( unsigned long long )m_lastFrameSize );
+        ImGui::Text( "High water mark %llu bytes", ( unsigned long long )m_highWaterMark );
+        ImGui::ProgressBar( m_frameSize ? ( f32 )m_highWaterMark / ( f32 )m_frameSize : 0.f );
+    }
+}
@@ -3,21 +3,77 @@ module;
 #include "External/tlsf/tlsf.h"
 #include <cstdlib>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <imgui.h>
 
 export module Foundation.Memory.Allocators.HeapAllocator;
 
 import Foundation.Memory.Allocators.Allocator;
 import Foundation.Memory.MemoryDefines;
+import Foundation.Memory.VirtualMemory;
+import Foundation.Memory.MemoryTracker;
 import Foundation.Log;
 import Foundation.Assert;
 
 export namespace Caustix {
+    static constexpr u32 k_max_heap_arenas = 32;
+    static constexpr u32 k_max_heap_pools  = 128;
+
+    // A contiguous memory range added to a TLSF instance.
+    // The first pool of every arena is carved from the initial heap memory, the others are
+    // mapped on demand when the arena runs out of memory and can be given back to the OS.
+    // The range is read by threads looking for the owner of a pointer while the arena owner adds or releases the pool.
+    // Released slots are reused, so the range is written under a sequence lock: m_generation is odd while it changes.
+    struct HeapPool {
+        std::atomic<u32>                m_generation        { 0 };
+        std::atomic<u8*>                m_memory            { nullptr };
+        std::atomic<sizet>              m_size              { 0 };
+        sizet                           m_allocatedBytes    = 0;
+        void*                           m_pool              = nullptr;
+        bool                            m_growth            = false;
+
+        bool                            Contains( void* pointer ) const;
+        void                            SetRange( u8* memory, sizet size );
+    };
+
+    // A TLSF instance owning a set of pools.
+    // In concurrent mode every arena but the last one is claimed by a single thread, that
+    // is the only one allowed to call tlsf on it. Blocks freed by other threads are pushed
+    // onto m_remoteFrees and given back to tlsf by the owner on its next allocation.
+    // The last arena is shared by the threads that could not claim one and is mutex protected.
+    // A claim ends when its thread exits: the remote frees are drained and the arena can be claimed by another thread,
+    // which adopts the blocks still allocated in it.
+    struct HeapArena {
+        void*                           m_tlsfHandle        = nullptr;
+
+        HeapPool                        m_pools[ k_max_heap_pools ];
+        std::atomic<u32>                m_poolCount         { 0 };
+        sizet                           m_committedBytes    = 0;
+        sizet                           m_allocatedBytes    = 0;
+
+        std::atomic<void*>              m_remoteFrees       { nullptr };
+        std::atomic<std::thread::id>    m_owner             { std::thread::id{} };
+        std::mutex                      m_mutex;
+
+        HeapPool*                       FindPool( void* pointer );
+    };
+
+    struct HeapAllocatorConfiguration {
+        sizet                           m_size              = cmega( 32 );
+        u32                             m_threadArenas      = 0;    // 0 keeps the heap single threaded.
+        sizet                           m_growSize          = 0;    // Minimum size of a pool mapped when an arena is full, 0 disables growth.
+        sizet                           m_retainedSize      = 0;    // Free bytes an arena keeps before giving empty pools back to the OS.
+    };
+
     struct HeapAllocator : public Allocator {
         ~HeapAllocator() override;
 
         HeapAllocator() = delete;
         HeapAllocator(sizet size);
+        HeapAllocator(const HeapAllocatorConfiguration& configuration);
 
         void*   allocate(sizet size, sizet alignment) override;
         void*   allocate(sizet size, sizet alignment, cstring file, i32 line) override;
@@ -26,6 +82,37 @@ export namespace Caustix {
 
         void    debug_ui();
 
+        void*       AllocateInternal( sizet size, sizet alignment );
+
+        HeapArena*  GetThreadArena();
+        HeapArena*  GetOwnerArena( void* pointer );
+        void        DrainRemoteFrees( HeapArena& arena );
+        void        ReleaseThreadArena( HeapArena& arena );
+
+        void*       AllocateFromArena( HeapArena& arena, sizet size, sizet alignment );
+        void        FreeFromArena( HeapArena& arena, void* pointer );
+
+        bool        AddPool( HeapArena& arena, sizet size );
+        void        ReleasePool( HeapArena& arena, HeapPool& pool );
+
+        sizet       GetCommittedSize() const;
+
+        bool        IsSharedArena( const HeapArena* arena ) const { return arena == &m_arenas[ m_arenaCount - 1 ]; }
+
+        HeapArena   m_arenas[ k_max_heap_arenas ];
+        u32         m_arenaCount = 1;
+        u32         m_instanceId = 0;
+        bool        m_concurrent = false;
+
+        HeapAllocator* m_nextLive = nullptr;     // Live heaps list, checked by exiting threads before releasing their arenas.
+
+        sizet       m_growSize = 0;
+        sizet       m_retainedSize = 0;
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        MemoryTracker m_tracker;
+#endif // CAUSTIX_MEMORY_TRACKING
+
         void*   m_tlsfHandle;
         void*   m_memory;
         sizet   m_allocatedSize = 0;
@@ -34,22 +121,132 @@ export namespace Caustix {
 }
 
 namespace Caustix {
+    // Intrusive node written inside a block freed from a thread that does not own its arena.
+    struct RemoteFreeNode {
+        RemoteFreeNode*     m_next;
+    };
+
+    struct HeapArenaCache {
+        u32                 m_instanceId    = 0;
+        HeapArena*          m_arena         = nullptr;
+    };
+
+    static constexpr u32 k_max_heap_arena_claims = 16;
+
+    struct HeapArenaClaim {
+        HeapAllocator*      m_heap          = nullptr;
+        u32                 m_instanceId    = 0;
+        HeapArena*          m_arena         = nullptr;
+    };
+
+    // Arenas claimed by a thread, released by the destructor when the thread exits.
+    struct HeapArenaClaims {
+        ~HeapArenaClaims();
+
+        HeapArenaClaim      m_claims[ k_max_heap_arena_claims ];
+        u32                 m_count         = 0;
+    };
+
+    static std::atomic<u32>             s_heapInstanceCounter{ 0 };
+    static thread_local HeapArenaCache  t_heapArenaCache;
+    static thread_local HeapArenaClaims t_heapArenaClaims;
+
+    // A heap can be destroyed before the threads that claimed its arenas exit.
+    static std::mutex                   s_liveHeapsMutex;
+    static HeapAllocator*               s_liveHeaps = nullptr;
+
+    HeapArenaClaims::~HeapArenaClaims() {
+        std::lock_guard<std::mutex> lock( s_liveHeapsMutex );
+        for ( u32 i = 0; i < m_count; ++i ) {
+            const HeapArenaClaim& claim = m_claims[ i ];
+            for ( HeapAllocator* heap = s_liveHeaps; heap; heap = heap->m_nextLive ) {
+                if ( heap == claim.m_heap && heap->m_instanceId == claim.m_instanceId ) {
+                    heap->ReleaseThreadArena( *claim.m_arena );
+                    break;
+                }
+            }
+        }
+        m_count = 0;
+        t_heapArenaCache = {};
+    }
+
+    bool HeapPool::Contains( void* pointer ) const {
+        // A slot being added or released holds no live block, so a range changing under the read can't be the one searched.
+        const u32 generation = m_generation.load( std::memory_order_acquire );
+        if ( generation & 1 ) {
+            return false;
+        }
+
+        u8* memory = m_memory.load( std::memory_order_relaxed );
+        const sizet size = m_size.load( std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( m_generation.load( std::memory_order_relaxed ) != generation ) {
+            return false;
+        }
+        return ( u8* )pointer >= memory && ( u8* )pointer < memory + size;
+    }
+
+    void HeapPool::SetRange( u8* memory, sizet size ) {
+        const u32 generation = m_generation.load( std::memory_order_relaxed );
+        m_generation.store( generation + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        m_memory.store( memory, std::memory_order_relaxed );
+        m_size.store( size, std::memory_order_relaxed );
+
+        m_generation.store( generation + 2, std::memory_order_release );
+    }
+
+    HeapPool* HeapArena::FindPool( void* pointer ) {
+        const u32 pool_count = m_poolCount.load( std::memory_order_acquire );
+        for ( u32 i = 0; i < pool_count; ++i ) {
+            if ( m_pools[ i ].Contains( pointer ) ) {
+                return &m_pools[ i ];
+            }
+        }
+        return nullptr;
+    }
+
     void exitWalker( void* ptr, size_t size, int used, void* user ) {
         MemoryStatistics* stats = ( MemoryStatistics* )user;
         stats->add( used ? size : 0 );
 
         if ( used )
-            info( "Found active allocation %p, %llu\n", ptr, size );
+            info( "Found active allocation {}, {}", ptr, size );
     }
 
     HeapAllocator::~HeapAllocator() {
+        if ( m_concurrent ) {
+            std::lock_guard<std::mutex> lock( s_liveHeapsMutex );
+            for ( HeapAllocator** link = &s_liveHeaps; *link; link = &( *link )->m_nextLive ) {
+                if ( *link == this ) {
+                    *link = m_nextLive;
+                    break;
+                }
+            }
+        }
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.Report( "HeapAllocator" );
+#endif // CAUSTIX_MEMORY_TRACKING
+
         // Check memory at the application exit.
-        MemoryStatistics stats{ 0, m_maxSize };
-        pool_t pool = tlsf_get_pool( m_tlsfHandle );
-        tlsf_walk_pool( pool, exitWalker, ( void* )&stats );
+        MemoryStatistics stats{ 0, GetCommittedSize() };
+        for ( u32 i = 0; i < m_arenaCount; ++i ) {
+            HeapArena& arena = m_arenas[ i ];
+            // Blocks still sitting in a remote free list are free memory, give them back before walking.
+            DrainRemoteFrees( arena );
+
+            const u32 pool_count = arena.m_poolCount.load( std::memory_order_acquire );
+            for ( u32 p = 0; p < pool_count; ++p ) {
+                if ( arena.m_pools[ p ].m_pool ) {
+                    tlsf_walk_pool( arena.m_pools[ p ].m_pool, exitWalker, ( void* )&stats );
+                }
+            }
+        }
 
         if ( stats.m_allocatedBytes ) {
-            error( "HeapAllocator Shutdown.\n===============\nFAILURE! Allocated memory detected. allocated %llu, total %llu\n===============\n\n", stats.m_allocatedBytes, stats.m_totalBytes );
+            error( "HeapAllocator Shutdown.\n===============\nFAILURE! Allocated memory detected. allocated {}, total {}\n===============\n\n", stats.m_allocatedBytes, stats.m_totalBytes );
         } else {
             info( "HeapAllocator Shutdown - all memory free!" );
         }
@@ -60,33 +257,308 @@ namespace Caustix {
         }
         CASSERT( stats.m_allocatedBytes == 0);
 
-        tlsf_destroy( m_tlsfHandle );
+        for ( u32 i = 0; i < m_arenaCount; ++i ) {
+            HeapArena& arena = m_arenas[ i ];
+            const u32 pool_count = arena.m_poolCount.load( std::memory_order_acquire );
+            for ( u32 p = 0; p < pool_count; ++p ) {
+                HeapPool& pool = arena.m_pools[ p ];
+                if ( pool.m_growth && pool.m_pool ) {
+                    tlsf_remove_pool( arena.m_tlsfHandle, pool.m_pool );
+                    VirtualMemoryRelease( pool.m_memory.load( std::memory_order_relaxed ), pool.m_size.load( std::memory_order_relaxed ) );
+                }
+            }
+            tlsf_destroy( arena.m_tlsfHandle );
+        }
 
         free( m_memory );
     }
 
-    HeapAllocator::HeapAllocator( sizet size ) {
+    HeapAllocator::HeapAllocator( sizet size )
+    : HeapAllocator( HeapAllocatorConfiguration{ size } ) {
+    }
+
+    HeapAllocator::HeapAllocator( const HeapAllocatorConfiguration& configuration ) {
+        const sizet size = configuration.m_size;
         // Allocate
         m_memory = malloc( size );
         m_maxSize = size;
         m_allocatedSize = 0;
+        m_instanceId = ++s_heapInstanceCounter;
+
+        m_growSize = configuration.m_growSize;
+        m_retainedSize = configuration.m_retainedSize;
+
+        // Thread arenas plus the shared one.
+        m_concurrent = configuration.m_threadArenas > 0;
+        m_arenaCount = m_concurrent ? ( configuration.m_threadArenas + 1 < k_max_heap_arenas ? configuration.m_threadArenas + 1 : k_max_heap_arenas ) : 1;
+
+        const sizet arenaSize = ( size / m_arenaCount ) & ~( tlsf_align_size() - 1 );
+        u8* arenaMemory = ( u8* )m_memory;
+        for ( u32 i = 0; i < m_arenaCount; ++i ) {
+            HeapArena& arena = m_arenas[ i ];
+            HeapPool& pool = arena.m_pools[ 0 ];
+            const sizet poolSize = ( i == m_arenaCount - 1 ) ? ( ( u8* )m_memory + size ) - arenaMemory : arenaSize;
+            pool.SetRange( arenaMemory, poolSize );
+            arena.m_tlsfHandle = tlsf_create_with_pool( arenaMemory, poolSize );
+            pool.m_pool = tlsf_get_pool( arena.m_tlsfHandle );
+
+            arena.m_committedBytes = poolSize;
+            arena.m_poolCount.store( 1, std::memory_order_release );
+
+            arenaMemory += poolSize;
+        }
 
-        m_tlsfHandle = tlsf_create_with_pool( m_memory, size );
+        // The shared arena is also the one used when concurrency is disabled.
+        m_tlsfHandle = m_arenas[ m_arenaCount - 1 ].m_tlsfHandle;
 
-        info( "HeapAllocator of size {} created", size );
+        if ( m_concurrent ) {
+            std::lock_guard<std::mutex> lock( s_liveHeapsMutex );
+            m_nextLive = s_liveHeaps;
+            s_liveHeaps = this;
+        }
+
+        info( "HeapAllocator of size {} created with {} arenas, grow size {}", size, m_arenaCount, m_growSize );
     }
 
-    void* HeapAllocator::allocate( sizet size, sizet alignment ) {
-        return tlsf_malloc( m_tlsfHandle, size );
+    HeapArena* HeapAllocator::GetThreadArena() {
+        if ( t_heapArenaCache.m_instanceId == m_instanceId ) {
+            return t_heapArenaCache.m_arena;
+        }
+
+        const std::thread::id threadId = std::this_thread::get_id();
+        HeapArena* result = &m_arenas[ m_arenaCount - 1 ];
+
+        // Search for an arena already owned by this thread, then try to claim a free one.
+        bool found = false;
+        for ( u32 i = 0; i < m_arenaCount - 1; ++i ) {
+            if ( m_arenas[ i ].m_owner.load( std::memory_order_acquire ) == threadId ) {
+                result = &m_arenas[ i ];
+                found = true;
+                break;
+            }
+        }
+
+        // Claims are released at thread exit, a thread that can't record one more stays on the shared arena.
+        // An arena released by an exited thread is adopted as is, its remote frees are drained on the next allocation.
+        for ( u32 i = 0; !found && t_heapArenaClaims.m_count < k_max_heap_arena_claims && i < m_arenaCount - 1; ++i ) {
+            std::thread::id noOwner{};
+            if ( m_arenas[ i ].m_owner.compare_exchange_strong( noOwner, threadId, std::memory_order_acq_rel ) ) {
+                result = &m_arenas[ i ];
+                found = true;
+                t_heapArenaClaims.m_claims[ t_heapArenaClaims.m_count++ ] = { this, m_instanceId, result };
+            }
+        }
+
+        t_heapArenaCache.m_instanceId = m_instanceId;
+        t_heapArenaCache.m_arena = result;
+        return result;
+    }
+
+    HeapArena* HeapAllocator::GetOwnerArena( void* pointer ) {
+        for ( u32 i = 0; i < m_arenaCount; ++i ) {
+            if ( m_arenas[ i ].FindPool( pointer ) ) {
+                return &m_arenas[ i ];
+            }
+        }
+        return nullptr;
+    }
+
+    void HeapAllocator::DrainRemoteFrees( HeapArena& arena ) {
+        // Take the whole list at once: producers only push, so there is no ABA to care about.
+        RemoteFreeNode* node = ( RemoteFreeNode* )arena.m_remoteFrees.exchange( nullptr, std::memory_order_acquire );
+        while ( node ) {
+            RemoteFreeNode* next = node->m_next;
+            FreeFromArena( arena, node );
+            node = next;
+        }
+    }
+
+    void HeapAllocator::ReleaseThreadArena( HeapArena& arena ) {
+        CASSERT( arena.m_owner.load( std::memory_order_relaxed ) == std::this_thread::get_id() );
+
+        // Still the owner here, so the frees queued so far go back to tlsf now instead of waiting for the next owner.
+        // Blocks pushed after the drain stay queued until the arena is claimed again or the heap is destroyed.
+        DrainRemoteFrees( arena );
+        arena.m_owner.store( std::thread::id{}, std::memory_order_release );
+    }
+
+    bool HeapAllocator::AddPool( HeapArena& arena, sizet size ) {
+        // Released slots first, other threads searching them are protected by the pool generation.
+        u32 slot = arena.m_poolCount.load( std::memory_order_relaxed );
+        for ( u32 i = 0; i < slot; ++i ) {
+            if ( arena.m_pools[ i ].m_pool == nullptr ) {
+                slot = i;
+                break;
+            }
+        }
+
+        if ( slot >= k_max_heap_pools ) {
+            error( "HeapAllocator: maximum number of pools {} reached", k_max_heap_pools );
+            return false;
+        }
+
+        const sizet page_size = VirtualMemoryPageSize();
+        sizet pool_size = MemoryAlign( size + tlsf_pool_overhead() + tlsf_alloc_overhead(), page_size );
+        pool_size = pool_size > m_growSize ? pool_size : MemoryAlign( m_growSize, page_size );
+
+        u8* memory = ( u8* )VirtualMemoryReserve( pool_size );
+        if ( memory == nullptr || !VirtualMemoryCommit( memory, pool_size ) ) {
+            error( "HeapAllocator: failed mapping a pool of {} bytes", pool_size );
+            if ( memory ) {
+                VirtualMemoryRelease( memory, pool_size );
+            }
+            return false;
+        }
+
+        HeapPool& pool = arena.m_pools[ slot ];
+        pool.m_allocatedBytes = 0;
+        pool.m_growth = true;
+        pool.m_pool = tlsf_add_pool( arena.m_tlsfHandle, memory, pool_size );
+        pool.SetRange( memory, pool_size );
+
+        arena.m_committedBytes += pool_size;
+        if ( slot == arena.m_poolCount.load( std::memory_order_relaxed ) ) {
+            arena.m_poolCount.store( slot + 1, std::memory_order_release );
+        }
+
+        info( "HeapAllocator: added pool of {} bytes", pool_size );
+        return true;
+    }
+
+    void HeapAllocator::ReleasePool( HeapArena& arena, HeapPool& pool ) {
+        // Empty range before unmapping, so searches from other threads can never match the released memory.
+        u8* memory = pool.m_memory.load( std::memory_order_relaxed );
+        const sizet size = pool.m_size.load( std::memory_order_relaxed );
+        pool.SetRange( nullptr, 0 );
+
+        tlsf_remove_pool( arena.m_tlsfHandle, pool.m_pool );
+        VirtualMemoryRelease( memory, size );
+
+        arena.m_committedBytes -= size;
+        pool.m_pool = nullptr;
+    }
+
+    static void* TlsfAllocate( tlsf_t handle, sizet size, sizet alignment ) {
+        // Every TLSF block is already aligned to tlsf_align_size, memalign is only needed above it.
+        if ( alignment <= tlsf_align_size() ) {
+            return tlsf_malloc( handle, size );
+        }
+        return tlsf_memalign( handle, alignment, size );
+    }
+
+    void* HeapAllocator::AllocateFromArena( HeapArena& arena, sizet size, sizet alignment ) {
+        CASSERT( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+
+        void* pointer = TlsfAllocate( arena.m_tlsfHandle, size, alignment );
+        // Worst case memalign needs a full alignment of padding in front of the block.
+        if ( pointer == nullptr && m_growSize > 0 && AddPool( arena, size + alignment ) ) {
+            pointer = TlsfAllocate( arena.m_tlsfHandle, size, alignment );
+        }
+
+        if ( pointer == nullptr ) {
+            error( "HeapAllocator: out of memory allocating {} bytes aligned to {}", size, alignment );
+            return nullptr;
+        }
+        CASSERT( ( ( sizet )pointer & ( alignment - 1 ) ) == 0 );
+
+        const sizet block_size = tlsf_block_size( pointer );
+        HeapPool* pool = arena.FindPool( pointer );
+        pool->m_allocatedBytes += block_size;
+        arena.m_allocatedBytes += block_size;
+
+        return pointer;
+    }
+
+    void HeapAllocator::FreeFromArena( HeapArena& arena, void* pointer ) {
+        HeapPool* pool = arena.FindPool( pointer );
+        CASSERT( pool != nullptr );
+
+        const sizet block_size = tlsf_block_size( pointer );
+        tlsf_free( arena.m_tlsfHandle, pointer );
+
+        pool->m_allocatedBytes -= block_size;
+        arena.m_allocatedBytes -= block_size;
+
+        // High-water policy: an empty growth pool goes back to the OS only when the arena
+        // still keeps more than the retained size free, to avoid map/unmap ping-pong.
+        if ( pool->m_growth && pool->m_allocatedBytes == 0 && ( arena.m_committedBytes - arena.m_allocatedBytes - pool->m_size.load( std::memory_order_relaxed ) ) >= m_retainedSize ) {
+            ReleasePool( arena, *pool );
+        }
+    }
+
+    void* HeapAllocator::AllocateInternal( sizet size, sizet alignment ) {
+        if ( !m_concurrent ) {
+            return AllocateFromArena( m_arenas[ 0 ], size, alignment );
+        }
+
+        HeapArena* arena = GetThreadArena();
+        if ( IsSharedArena( arena ) ) {
+            std::lock_guard<std::mutex> lock( arena->m_mutex );
+            DrainRemoteFrees( *arena );
+            return AllocateFromArena( *arena, size, alignment );
+        }
+
+        if ( arena->m_remoteFrees.load( std::memory_order_relaxed ) ) {
+            DrainRemoteFrees( *arena );
+        }
+        return AllocateFromArena( *arena, size, alignment );
     }
 
 
+    void* HeapAllocator::allocate( sizet size, sizet alignment ) {
+        return HeapAllocator::allocate( size, alignment, nullptr, 0 );
+    }
+
     void* HeapAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
-        return allocate( size, alignment );
+        void* pointer = AllocateInternal( size, alignment );
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnAllocate( pointer, size, file, line );
+#endif // CAUSTIX_MEMORY_TRACKING
+        return pointer;
     }
 
     void HeapAllocator::deallocate( void* pointer ) {
-        tlsf_free( m_tlsfHandle, pointer );
+        if ( pointer == nullptr ) {
+            return;
+        }
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnDeallocate( pointer );
+#endif // CAUSTIX_MEMORY_TRACKING
+
+        if ( !m_concurrent ) {
+            FreeFromArena( m_arenas[ 0 ], pointer );
+            return;
+        }
+
+        HeapArena* owner = GetOwnerArena( pointer );
+        CASSERT( owner != nullptr );
+
+        if ( IsSharedArena( owner ) ) {
+            std::lock_guard<std::mutex> lock( owner->m_mutex );
+            FreeFromArena( *owner, pointer );
+            return;
+        }
+
+        if ( owner == GetThreadArena() ) {
+            FreeFromArena( *owner, pointer );
+            return;
+        }
+
+        // Remote free: push the block on the owner list, it will be released on its next allocation.
+        RemoteFreeNode* node = ( RemoteFreeNode* )pointer;
+        void* head = owner->m_remoteFrees.load( std::memory_order_relaxed );
+        do {
+            node->m_next = ( RemoteFreeNode* )head;
+        } while ( !owner->m_remoteFrees.compare_exchange_weak( head, node, std::memory_order_release, std::memory_order_relaxed ) );
+    }
+
+    sizet HeapAllocator::GetCommittedSize() const {
+        sizet committed = 0;
+        for ( u32 i = 0; i < m_arenaCount; ++i ) {
+            committed += m_arenas[ i ].m_committedBytes;
+        }
+        return committed;
     }
 
     void imgui_walker( void* ptr, size_t size, int used, void* user ) {
@@ -107,17 +579,46 @@ namespace Caustix {
         stats->add( used ? size : 0 );
     }
 
+    static void imgui_walk_arena( HeapArena& arena, MemoryStatistics& stats ) {
+        const u32 pool_count = arena.m_poolCount.load( std::memory_order_acquire );
+        for ( u32 p = 0; p < pool_count; ++p ) {
+            HeapPool& pool = arena.m_pools[ p ];
+            if ( pool.m_pool == nullptr ) {
+                continue;
+            }
+            ImGui::Text( "Pool %u %s size %llu Mb", p, pool.m_growth ? "(growth)" : "", pool.m_size.load( std::memory_order_relaxed ) / ( 1024 * 1024 ) );
+            tlsf_walk_pool( pool.m_pool, imgui_walker, ( void* )&stats );
+        }
+    }
+
     void HeapAllocator::debug_ui() {
 
         ImGui::Separator();
         ImGui::Text( "Heap Allocator" );
         ImGui::Separator();
-        MemoryStatistics stats{ 0, m_maxSize };
-        pool_t pool = tlsf_get_pool( m_tlsfHandle );
-        tlsf_walk_pool( pool, imgui_walker, ( void* )&stats );
+        const sizet committed_size = GetCommittedSize();
+        MemoryStatistics stats{ 0, committed_size };
+        for ( u32 i = 0; i < m_arenaCount; ++i ) {
+            HeapArena& arena = m_arenas[ i ];
+            if ( !m_concurrent ) {
+                imgui_walk_arena( arena, stats );
+                continue;
+            }
+
+            ImGui::Text( "Arena %u %s", i, IsSharedArena( &arena ) ? "(shared)" : "" );
+            // Thread arenas are only walked by their owner, others may be allocating from them.
+            if ( IsSharedArena( &arena ) ) {
+                std::lock_guard<std::mutex> lock( arena.m_mutex );
+                imgui_walk_arena( arena, stats );
+            } else if ( arena.m_owner.load( std::memory_order_acquire ) == std::this_thread::get_id() ) {
+                imgui_walk_arena( arena, stats );
+            } else {
+                ImGui::Text( "\tOwned by another thread, not walked" );
+            }
+        }
 
         ImGui::Separator();
         ImGui::Text( "\tAllocation count %d", stats.m_allocationCount );
-        ImGui::Text( "\tAllocated %llu K, free %llu Mb, total %llu Mb", stats.m_allocatedBytes / (1024 * 1024), ( m_maxSize - stats.m_allocatedBytes ) / ( 1024 * 1024 ), m_maxSize / ( 1024 * 1024 ) );
+        ImGui::Text( "\tAllocated %llu K, free %llu Mb, total %llu Mb", stats.m_allocatedBytes / (1024 * 1024), ( committed_size - stats.m_allocatedBytes ) / ( 1024 * 1024 ), committed_size / ( 1024 * 1024 ) );
     }
-}
\ No newline at end of file
+}
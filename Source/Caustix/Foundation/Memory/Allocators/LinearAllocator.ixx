@@ -5,25 +5,48 @@ module;
 export module Foundation.Memory.Allocators.LinearAllocator;
 
 import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryTracker;
+import Foundation.Memory.VirtualMemory;
 
 export namespace Caustix {
     struct LinearAllocator : public Allocator {
         ~LinearAllocator() {
+#if defined(CAUSTIX_MEMORY_TRACKING)
+            m_tracker.Report( "LinearAllocator" );
+#endif // CAUSTIX_MEMORY_TRACKING
             m_allocatedSize = 0;
-            free(m_memory);
+            if ( m_virtual ) {
+                VirtualMemoryRelease( m_memory, m_totalSize );
+            } else {
+                free(m_memory);
+            }
         };
 
         LinearAllocator() = default;
         explicit LinearAllocator(sizet size);
+        // Reserves the address range only, pages are committed as the allocation offset advances.
+        explicit LinearAllocator(const VirtualAllocatorConfiguration& configuration);
 
         void*   allocate( sizet size, sizet alignment ) override;
         void*   allocate( sizet size, sizet alignment, cstring file, i32 line ) override;
 
         void    deallocate( void* pointer ) override;
 
+        void    Clear();
+
         u8*     m_memory          = nullptr;
         sizet   m_totalSize      = 0;
         sizet   m_allocatedSize  = 0;
+
+        // Virtual memory mode
+        sizet   m_committedSize     = 0;
+        sizet   m_commitGranularity = 0;
+        bool    m_virtual           = false;
+        bool    m_decommitOnFree    = false;
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        MemoryTracker m_tracker;
+#endif // CAUSTIX_MEMORY_TRACKING
     };
 }
 
@@ -34,24 +57,54 @@ namespace Caustix {
         m_totalSize = size;
     }
 
+    LinearAllocator::LinearAllocator(const VirtualAllocatorConfiguration& configuration) {
+        const sizet page_size = VirtualMemoryPageSize();
+        m_totalSize = MemoryAlign( configuration.m_reserveSize, page_size );
+        m_commitGranularity = MemoryAlign( configuration.m_commitGranularity, page_size );
+        m_decommitOnFree = configuration.m_decommitOnFree;
+        m_virtual = true;
+        m_memory = ( u8* )VirtualMemoryReserve( m_totalSize );
+        CASSERT( m_memory != nullptr );
+        m_allocatedSize = 0;
+        m_committedSize = 0;
+    }
+
     void* LinearAllocator::allocate(sizet size, sizet alignment) {
+        return LinearAllocator::allocate( size, alignment, nullptr, 0 );
+    }
+
+    void* LinearAllocator::allocate(sizet size, sizet alignment, cstring file, i32 line) {
         CASSERT(size > 0);
-        const sizet new_start = MemoryAlign(m_allocatedSize, alignment);
+        // Align the address rather than the offset, the base pointer is only malloc aligned.
+        const sizet new_start = MemoryAlign( ( sizet )m_memory + m_allocatedSize, alignment ) - ( sizet )m_memory;
         CASSERT(new_start < m_totalSize);
         const sizet new_allocated_size = new_start + size;
         if (new_allocated_size > m_totalSize) {
             return nullptr;
         }
+        if ( m_virtual && !VirtualMemoryCommitUpTo( m_memory, m_committedSize, new_allocated_size, m_commitGranularity, m_totalSize ) ) {
+            return nullptr;
+        }
 
         m_allocatedSize = new_allocated_size;
-        return m_memory + new_start;
-    }
-
-    void* LinearAllocator::allocate(sizet size, sizet alignment, cstring file, i32 line) {
-        return allocate( size, alignment );
+        void* pointer = m_memory + new_start;
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnAllocate( pointer, size, file, line );
+#endif // CAUSTIX_MEMORY_TRACKING
+        return pointer;
     }
 
     void LinearAllocator::deallocate(void *pointer) {
         // This allocator does not allocate on a per-pointer base!
     }
+
+    void LinearAllocator::Clear() {
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnDeallocateRange( m_memory, m_memory + m_allocatedSize );
+#endif // CAUSTIX_MEMORY_TRACKING
+        m_allocatedSize = 0;
+        if ( m_virtual && m_decommitOnFree ) {
+            VirtualMemoryDecommitAfter( m_memory, m_committedSize, 0, m_commitGranularity );
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,551 @@
+module;
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <imgui.h>
+
+export module Foundation.Memory.Allocators.SlabAllocator;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Memory.VirtualMemory;
+import Foundation.Memory.MemoryTracker;
+import Foundation.Log;
+import Foundation.Assert;
+
+export namespace Caustix {
+    static constexpr u32    k_slab_class_count      = 12;
+    static constexpr u32    k_slab_class_sizes[ k_slab_class_count ] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+    static constexpr u32    k_slab_max_block_size   = 1024;
+    static constexpr sizet  k_slab_size             = 64 * 1024;
+    // Blocks start after the slab header, at an offset that keeps 64 bytes alignment for the classes multiple of it.
+    static constexpr sizet  k_slab_header_size      = 64;
+    static constexpr u32    k_max_slab_magazines    = 32;
+    static constexpr u32    k_slab_magazine_size    = 32;
+
+    struct SlabAllocatorConfiguration {
+        sizet                           m_reserveSize       = cgiga( 1 );   // Address range all the slabs are carved from.
+        u32                             m_threadMagazines   = 0;            // Per-thread block caches, 0 keeps the allocator single threaded.
+        Allocator*                      m_fallback          = nullptr;      // Used for blocks bigger than k_slab_max_block_size or over aligned.
+    };
+
+    // A slab is a k_slab_size aligned range holding blocks of a single size class.
+    // Free blocks are linked through their first bytes, blocks never handed out are carved from m_bumpIndex.
+    struct SlabHeader {
+        SlabHeader*                     m_next              = nullptr;
+        SlabHeader*                     m_prev              = nullptr;
+        void*                           m_freeList          = nullptr;
+        u32                             m_classIndex        = 0;
+        u32                             m_usedCount         = 0;
+        u32                             m_bumpIndex         = 0;
+        u32                             m_index             = 0;
+    };
+
+    struct SlabClass {
+        SlabHeader*                     m_partialSlabs      = nullptr;      // Slabs with at least one free block.
+        u32                             m_blockSize         = 0;
+        u32                             m_blocksPerSlab     = 0;
+
+        // Statistics
+        u32                             m_slabCount         = 0;
+        u64                             m_usedBlocks        = 0;            // Blocks cached in thread magazines count as used.
+        u64                             m_peakUsedBlocks    = 0;
+        u64                             m_allocationCount   = 0;
+    };
+
+    // Per-thread cache of free blocks for each class, claimed by a single thread.
+    // Allocation and free only touch the magazine, the central slabs are locked once
+    // every k_slab_magazine_size / 2 operations to refill or flush it.
+    // The blocks go back to the slabs and the magazine can be claimed again when its thread exits.
+    struct SlabMagazine {
+        std::atomic<std::thread::id>    m_owner             { std::thread::id{} };
+        u32                             m_count[ k_slab_class_count ] = {};
+        void*                           m_blocks[ k_slab_class_count ][ k_slab_magazine_size ];
+    };
+
+    // Fixed size allocator for small hot objects, allocation and free are O(1).
+    struct SlabAllocator : public Allocator {
+        SlabAllocator() = delete;
+        explicit SlabAllocator( const SlabAllocatorConfiguration& configuration );
+        ~SlabAllocator() override;
+
+        void*       allocate( sizet size, sizet alignment ) override;
+        void*       allocate( sizet size, sizet alignment, cstring file, i32 line ) override;
+
+        void        deallocate( void* pointer ) override;
+
+        void        debug_ui();
+
+        bool        Owns( void* pointer ) const { return ( u8* )pointer >= m_slabsMemory && ( u8* )pointer < m_slabsMemory + m_slabsSize; }
+        u32         GetClassIndex( sizet size, sizet alignment ) const;
+
+        void*       AllocateInternal( sizet size, sizet alignment );
+
+        void*       AllocateBlock( u32 classIndex );
+        void        FreeBlock( void* pointer );
+
+        SlabHeader* AddSlab( u32 classIndex );
+        void        ReleaseSlab( SlabHeader* slab );
+
+        SlabMagazine* GetThreadMagazine();
+        void        RefillMagazine( SlabMagazine& magazine, u32 classIndex );
+        void        FlushMagazine( SlabMagazine& magazine, u32 classIndex );
+        // Gives every cached block back to the slabs, m_mutex must be held.
+        void        EmptyMagazine( SlabMagazine& magazine );
+        void        ReleaseThreadMagazine( SlabMagazine& magazine );
+
+        SlabClass   m_classes[ k_slab_class_count ];
+        u8          m_sizeToClass[ k_slab_max_block_size / 16 + 1 ];
+
+        u8*         m_reservedMemory    = nullptr;
+        sizet       m_reservedSize      = 0;
+        u8*         m_slabsMemory       = nullptr;
+        sizet       m_slabsSize         = 0;
+
+        // Indices of decommitted slabs ready to be reused, stored at the beginning of the reserved range.
+        u32*        m_freeSlabIndices   = nullptr;
+        u32         m_freeSlabCount     = 0;
+        u32         m_slabBumpIndex     = 0;
+        u32         m_maxSlabs          = 0;
+
+        Allocator*  m_fallback          = nullptr;
+
+        SlabMagazine m_magazines[ k_max_slab_magazines ];
+        u32         m_magazineCount     = 0;
+        u32         m_instanceId        = 0;
+        bool        m_concurrent        = false;
+        std::mutex  m_mutex;
+
+        SlabAllocator* m_nextLive       = nullptr;      // Live allocators list, checked by exiting threads before releasing their magazines.
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        MemoryTracker m_tracker;
+#endif // CAUSTIX_MEMORY_TRACKING
+    };
+}
+
+namespace Caustix {
+    struct SlabFreeNode {
+        SlabFreeNode*       m_next;
+    };
+
+    struct SlabMagazineCache {
+        u32                 m_instanceId    = 0;
+        SlabMagazine*       m_magazine      = nullptr;
+    };
+
+    static constexpr u32 k_max_slab_magazine_claims = 16;
+
+    struct SlabMagazineClaim {
+        SlabAllocator*      m_allocator     = nullptr;
+        u32                 m_instanceId    = 0;
+        SlabMagazine*       m_magazine      = nullptr;
+    };
+
+    // Magazines claimed by a thread, released by the destructor when the thread exits.
+    struct SlabMagazineClaims {
+        ~SlabMagazineClaims();
+
+        SlabMagazineClaim   m_claims[ k_max_slab_magazine_claims ];
+        u32                 m_count         = 0;
+    };
+
+    static std::atomic<u32>                 s_slabInstanceCounter{ 0 };
+    static thread_local SlabMagazineCache   t_slabMagazineCache;
+    static thread_local SlabMagazineClaims  t_slabMagazineClaims;
+
+    // An allocator can be destroyed before the threads that claimed its magazines exit.
+    static std::mutex                       s_liveSlabsMutex;
+    static SlabAllocator*                   s_liveSlabs = nullptr;
+
+    SlabMagazineClaims::~SlabMagazineClaims() {
+        std::lock_guard<std::mutex> lock( s_liveSlabsMutex );
+        for ( u32 i = 0; i < m_count; ++i ) {
+            const SlabMagazineClaim& claim = m_claims[ i ];
+            for ( SlabAllocator* allocator = s_liveSlabs; allocator; allocator = allocator->m_nextLive ) {
+                if ( allocator == claim.m_allocator && allocator->m_instanceId == claim.m_instanceId ) {
+                    allocator->ReleaseThreadMagazine( *claim.m_magazine );
+                    break;
+                }
+            }
+        }
+        m_count = 0;
+        t_slabMagazineCache = {};
+    }
+
+    static SlabHeader* GetSlabHeader( void* pointer ) {
+        return ( SlabHeader* )( ( sizet )pointer & ~( k_slab_size - 1 ) );
+    }
+
+    SlabAllocator::SlabAllocator( const SlabAllocatorConfiguration& configuration ) {
+        m_fallback = configuration.m_fallback;
+        m_instanceId = ++s_slabInstanceCounter;
+        m_concurrent = configuration.m_threadMagazines > 0;
+        m_magazineCount = configuration.m_threadMagazines < k_max_slab_magazines ? configuration.m_threadMagazines : k_max_slab_magazines;
+
+        for ( u32 i = 0; i < k_slab_class_count; ++i ) {
+            SlabClass& slab_class = m_classes[ i ];
+            slab_class.m_blockSize = k_slab_class_sizes[ i ];
+            slab_class.m_blocksPerSlab = ( u32 )( ( k_slab_size - k_slab_header_size ) / slab_class.m_blockSize );
+        }
+
+        // Size to class lookup in 16 bytes steps.
+        u32 class_index = 0;
+        for ( u32 i = 0; i <= k_slab_max_block_size / 16; ++i ) {
+            while ( k_slab_class_sizes[ class_index ] < i * 16 ) {
+                ++class_index;
+            }
+            m_sizeToClass[ i ] = ( u8 )class_index;
+        }
+
+        // Reserve one extra slab to align the range, slab headers are found by masking block addresses.
+        m_reservedSize = MemoryAlign( configuration.m_reserveSize, k_slab_size ) + k_slab_size;
+        m_reservedMemory = ( u8* )VirtualMemoryReserve( m_reservedSize );
+        CASSERT( m_reservedMemory != nullptr );
+
+        u8* aligned_memory = ( u8* )MemoryAlign( ( sizet )m_reservedMemory, k_slab_size );
+        const sizet available_size = m_reservedSize - ( aligned_memory - m_reservedMemory ) - k_slab_size;
+        const u32 total_slabs = ( u32 )( available_size / k_slab_size );
+
+        // The free slab index table lives in the first slabs of the range.
+        const sizet table_size = MemoryAlign( total_slabs * sizeof( u32 ), k_slab_size );
+        VirtualMemoryCommit( aligned_memory, table_size );
+        m_freeSlabIndices = ( u32* )aligned_memory;
+
+        m_slabsMemory = aligned_memory + table_size;
+        m_maxSlabs = total_slabs - ( u32 )( table_size / k_slab_size );
+        m_slabsSize = ( sizet )m_maxSlabs * k_slab_size;
+
+        if ( m_concurrent ) {
+            std::lock_guard<std::mutex> lock( s_liveSlabsMutex );
+            m_nextLive = s_liveSlabs;
+            s_liveSlabs = this;
+        }
+
+        info( "SlabAllocator created with {} slabs of {} bytes, {} thread magazines", m_maxSlabs, k_slab_size, m_magazineCount );
+    }
+
+    SlabAllocator::~SlabAllocator() {
+        if ( m_concurrent ) {
+            std::lock_guard<std::mutex> lock( s_liveSlabsMutex );
+            for ( SlabAllocator** link = &s_liveSlabs; *link; link = &( *link )->m_nextLive ) {
+                if ( *link == this ) {
+                    *link = m_nextLive;
+                    break;
+                }
+            }
+        }
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.Report( "SlabAllocator" );
+#endif // CAUSTIX_MEMORY_TRACKING
+
+        // Magazines of threads still running hold free blocks too, only the blocks left after emptying them are leaks.
+        u64 used_blocks = 0;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            for ( u32 i = 0; i < m_magazineCount; ++i ) {
+                EmptyMagazine( m_magazines[ i ] );
+            }
+            for ( u32 i = 0; i < k_slab_class_count; ++i ) {
+                const SlabClass& slab_class = m_classes[ i ];
+                if ( slab_class.m_usedBlocks ) {
+                    error( "SlabAllocator: {} blocks of {} bytes still allocated", slab_class.m_usedBlocks, slab_class.m_blockSize );
+                }
+                used_blocks += slab_class.m_usedBlocks;
+            }
+        }
+
+        if ( used_blocks ) {
+            error( "SlabAllocator Shutdown.\n===============\nFAILURE! {} allocated blocks detected\n===============\n\n", used_blocks );
+        } else {
+            info( "SlabAllocator Shutdown - all memory free!" );
+        }
+
+        VirtualMemoryRelease( m_reservedMemory, m_reservedSize );
+    }
+
+    u32 SlabAllocator::GetClassIndex( sizet size, sizet alignment ) const {
+        u32 class_index = m_sizeToClass[ ( size + 15 ) / 16 ];
+        if ( alignment <= 16 ) {
+            return class_index;
+        }
+        // Blocks are aligned to their size as long as it is a multiple of the alignment, up to the header alignment.
+        if ( alignment > k_slab_header_size ) {
+            return k_slab_class_count;
+        }
+        while ( class_index < k_slab_class_count && ( k_slab_class_sizes[ class_index ] % alignment ) != 0 ) {
+            ++class_index;
+        }
+        return class_index;
+    }
+
+    SlabHeader* SlabAllocator::AddSlab( u32 classIndex ) {
+        u32 slab_index;
+        if ( m_freeSlabCount > 0 ) {
+            slab_index = m_freeSlabIndices[ --m_freeSlabCount ];
+        } else if ( m_slabBumpIndex < m_maxSlabs ) {
+            slab_index = m_slabBumpIndex++;
+        } else {
+            return nullptr;
+        }
+
+        u8* memory = m_slabsMemory + ( sizet )slab_index * k_slab_size;
+        if ( !VirtualMemoryCommit( memory, k_slab_size ) ) {
+            m_freeSlabIndices[ m_freeSlabCount++ ] = slab_index;
+            return nullptr;
+        }
+
+        SlabHeader* slab = ( SlabHeader* )memory;
+        *slab = SlabHeader{};
+        slab->m_classIndex = classIndex;
+        slab->m_index = slab_index;
+
+        SlabClass& slab_class = m_classes[ classIndex ];
+        slab->m_next = slab_class.m_partialSlabs;
+        if ( slab_class.m_partialSlabs ) {
+            slab_class.m_partialSlabs->m_prev = slab;
+        }
+        slab_class.m_partialSlabs = slab;
+        ++slab_class.m_slabCount;
+
+        return slab;
+    }
+
+    void SlabAllocator::ReleaseSlab( SlabHeader* slab ) {
+        SlabClass& slab_class = m_classes[ slab->m_classIndex ];
+        if ( slab->m_prev ) {
+            slab->m_prev->m_next = slab->m_next;
+        } else {
+            slab_class.m_partialSlabs = slab->m_next;
+        }
+        if ( slab->m_next ) {
+            slab->m_next->m_prev = slab->m_prev;
+        }
+        --slab_class.m_slabCount;
+
+        m_freeSlabIndices[ m_freeSlabCount++ ] = slab->m_index;
+        VirtualMemoryDecommit( slab, k_slab_size );
+    }
+
+    void* SlabAllocator::AllocateBlock( u32 classIndex ) {
+        SlabClass& slab_class = m_classes[ classIndex ];
+        SlabHeader* slab = slab_class.m_partialSlabs;
+        if ( slab == nullptr ) {
+            slab = AddSlab( classIndex );
+            if ( slab == nullptr ) {
+                error( "SlabAllocator: out of slabs allocating a {} bytes block", slab_class.m_blockSize );
+                return nullptr;
+            }
+        }
+
+        void* block;
+        if ( slab->m_freeList ) {
+            SlabFreeNode* node = ( SlabFreeNode* )slab->m_freeList;
+            slab->m_freeList = node->m_next;
+            block = node;
+        } else {
+            block = ( u8* )slab + k_slab_header_size + ( sizet )slab->m_bumpIndex * slab_class.m_blockSize;
+            ++slab->m_bumpIndex;
+        }
+
+        // Full slabs leave the partial list, they come back on the next free.
+        if ( ++slab->m_usedCount == slab_class.m_blocksPerSlab ) {
+            slab_class.m_partialSlabs = slab->m_next;
+            if ( slab->m_next ) {
+                slab->m_next->m_prev = nullptr;
+            }
+            slab->m_next = slab->m_prev = nullptr;
+        }
+
+        ++slab_class.m_allocationCount;
+        ++slab_class.m_usedBlocks;
+        slab_class.m_peakUsedBlocks = slab_class.m_usedBlocks > slab_class.m_peakUsedBlocks ? slab_class.m_usedBlocks : slab_class.m_peakUsedBlocks;
+
+        return block;
+    }
+
+    void SlabAllocator::FreeBlock( void* pointer ) {
+        SlabHeader* slab = GetSlabHeader( pointer );
+        SlabClass& slab_class = m_classes[ slab->m_classIndex ];
+
+        SlabFreeNode* node = ( SlabFreeNode* )pointer;
+        node->m_next = ( SlabFreeNode* )slab->m_freeList;
+        slab->m_freeList = node;
+
+        if ( slab->m_usedCount-- == slab_class.m_blocksPerSlab ) {
+            slab->m_prev = nullptr;
+            slab->m_next = slab_class.m_partialSlabs;
+            if ( slab_class.m_partialSlabs ) {
+                slab_class.m_partialSlabs->m_prev = slab;
+            }
+            slab_class.m_partialSlabs = slab;
+        }
+        --slab_class.m_usedBlocks;
+
+        // Keep at least one slab per class to avoid commit/decommit ping-pong on a single block.
+        if ( slab->m_usedCount == 0 && ( slab->m_prev || slab->m_next ) ) {
+            ReleaseSlab( slab );
+        }
+    }
+
+    SlabMagazine* SlabAllocator::GetThreadMagazine() {
+        if ( t_slabMagazineCache.m_instanceId == m_instanceId ) {
+            return t_slabMagazineCache.m_magazine;
+        }
+
+        const std::thread::id threadId = std::this_thread::get_id();
+        SlabMagazine* result = nullptr;
+
+        for ( u32 i = 0; i < m_magazineCount; ++i ) {
+            if ( m_magazines[ i ].m_owner.load( std::memory_order_acquire ) == threadId ) {
+                result = &m_magazines[ i ];
+                break;
+            }
+        }
+
+        // Threads that cannot claim a magazine, or record one more claim to release at exit, go through the locked central slabs.
+        for ( u32 i = 0; result == nullptr && t_slabMagazineClaims.m_count < k_max_slab_magazine_claims && i < m_magazineCount; ++i ) {
+            std::thread::id noOwner{};
+            if ( m_magazines[ i ].m_owner.compare_exchange_strong( noOwner, threadId, std::memory_order_acq_rel ) ) {
+                result = &m_magazines[ i ];
+                t_slabMagazineClaims.m_claims[ t_slabMagazineClaims.m_count++ ] = { this, m_instanceId, result };
+            }
+        }
+
+        t_slabMagazineCache.m_instanceId = m_instanceId;
+        t_slabMagazineCache.m_magazine = result;
+        return result;
+    }
+
+    void SlabAllocator::RefillMagazine( SlabMagazine& magazine, u32 classIndex ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        u32& count = magazine.m_count[ classIndex ];
+        while ( count < k_slab_magazine_size / 2 ) {
+            void* block = AllocateBlock( classIndex );
+            if ( block == nullptr ) {
+                break;
+            }
+            magazine.m_blocks[ classIndex ][ count++ ] = block;
+        }
+    }
+
+    void SlabAllocator::FlushMagazine( SlabMagazine& magazine, u32 classIndex ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        u32& count = magazine.m_count[ classIndex ];
+        while ( count > k_slab_magazine_size / 2 ) {
+            FreeBlock( magazine.m_blocks[ classIndex ][ --count ] );
+        }
+    }
+
+    void SlabAllocator::EmptyMagazine( SlabMagazine& magazine ) {
+        for ( u32 class_index = 0; class_index < k_slab_class_count; ++class_index ) {
+            u32& count = magazine.m_count[ class_index ];
+            while ( count > 0 ) {
+                FreeBlock( magazine.m_blocks[ class_index ][ --count ] );
+            }
+        }
+    }
+
+    void SlabAllocator::ReleaseThreadMagazine( SlabMagazine& magazine ) {
+        CASSERT( magazine.m_owner.load( std::memory_order_relaxed ) == std::this_thread::get_id() );
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            EmptyMagazine( magazine );
+        }
+        magazine.m_owner.store( std::thread::id{}, std::memory_order_release );
+    }
+
+    void* SlabAllocator::AllocateInternal( sizet size, sizet alignment ) {
+        const u32 class_index = size <= k_slab_max_block_size ? GetClassIndex( size, alignment ) : k_slab_class_count;
+        if ( class_index >= k_slab_class_count ) {
+            CASSERT( m_fallback != nullptr );
+            return m_fallback->allocate( size, alignment );
+        }
+
+        if ( !m_concurrent ) {
+            return AllocateBlock( class_index );
+        }
+
+        SlabMagazine* magazine = GetThreadMagazine();
+        if ( magazine == nullptr ) {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            return AllocateBlock( class_index );
+        }
+
+        if ( magazine->m_count[ class_index ] == 0 ) {
+            RefillMagazine( *magazine, class_index );
+            if ( magazine->m_count[ class_index ] == 0 ) {
+                return nullptr;
+            }
+        }
+        return magazine->m_blocks[ class_index ][ --magazine->m_count[ class_index ] ];
+    }
+
+    void* SlabAllocator::allocate( sizet size, sizet alignment ) {
+        return SlabAllocator::allocate( size, alignment, nullptr, 0 );
+    }
+
+    void* SlabAllocator::allocate( sizet size, sizet alignment, cstring file, i32 line ) {
+        void* pointer = AllocateInternal( size, alignment );
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnAllocate( pointer, size, file, line );
+#endif // CAUSTIX_MEMORY_TRACKING
+        return pointer;
+    }
+
+    void SlabAllocator::deallocate( void* pointer ) {
+        if ( pointer == nullptr ) {
+            return;
+        }
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnDeallocate( pointer );
+#endif // CAUSTIX_MEMORY_TRACKING
+
+        if ( !Owns( pointer ) ) {
+            CASSERT( m_fallback != nullptr );
+            m_fallback->deallocate( pointer );
+            return;
+        }
+
+        if ( !m_concurrent ) {
+            FreeBlock( pointer );
+            return;
+        }
+
+        SlabMagazine* magazine = GetThreadMagazine();
+        if ( magazine == nullptr ) {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            FreeBlock( pointer );
+            return;
+        }
+
+        // Blocks can be freed from any thread, the class is read from the slab header.
+        const u32 class_index = GetSlabHeader( pointer )->m_classIndex;
+        if ( magazine->m_count[ class_index ] == k_slab_magazine_size ) {
+            FlushMagazine( *magazine, class_index );
+        }
+        magazine->m_blocks[ class_index ][ magazine->m_count[ class_index ]++ ] = pointer;
+    }
+
+    void SlabAllocator::debug_ui() {
+        ImGui::Separator();
+        ImGui::Text( "Slab Allocator" );
+        ImGui::Separator();
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        u32 total_slabs = 0;
+        for ( u32 i = 0; i < k_slab_class_count; ++i ) {
+            const SlabClass& slab_class = m_classes[ i ];
+            const u64 capacity = ( u64 )slab_class.m_slabCount * slab_class.m_blocksPerSlab;
+            const f32 occupancy = capacity ? ( f32 )slab_class.m_usedBlocks / ( f32 )capacity : 0.f;
+            ImGui::Text( "%4u bytes: %u slabs, %llu used, %llu peak, %llu allocations, %.1f%% occupancy", slab_class.m_blockSize, slab_class.m_slabCount,
+                         ( unsigned long long )slab_class.m_usedBlocks, ( unsigned long long )slab_class.m_peakUsedBlocks,
+                         ( unsigned long long )slab_class.m_allocationCount, occupancy * 100.f );
+            total_slabs += slab_class.m_slabCount;
+        }
+        ImGui::Text( "Committed %u of %u slabs", total_slabs, m_maxSlabs );
+    }
+}
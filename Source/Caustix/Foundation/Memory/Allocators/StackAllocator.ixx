@@ -5,6 +5,8 @@ module;
 export module Foundation.Memory.Allocators.StackAllocator;
 
 import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryTracker;
+import Foundation.Memory.VirtualMemory;
 import Foundation.Platform;
 
 export namespace Caustix {
@@ -13,6 +15,8 @@ export namespace Caustix {
 
         StackAllocator() = delete;
         StackAllocator(sizet size);
+        // Reserves the address range only, pages are committed as the allocation offset advances.
+        StackAllocator(const VirtualAllocatorConfiguration& configuration);
 
         void*   allocate(sizet size, sizet alignment) override;
         void*   allocate(sizet size, sizet alignment, cstring file, i32 line) override;
@@ -25,14 +29,31 @@ export namespace Caustix {
         u8*     m_memory        = nullptr;
         sizet   m_totalSize     = 0;
         sizet   m_allocatedSize = 0;
+
+        // Virtual memory mode
+        sizet   m_committedSize     = 0;
+        sizet   m_commitGranularity = 0;
+        bool    m_virtual           = false;
+        bool    m_decommitOnFree    = false;
+
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        MemoryTracker m_tracker;
+#endif // CAUSTIX_MEMORY_TRACKING
     };
 }
 
 namespace Caustix {
 
     StackAllocator::~StackAllocator() {
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.Report( "StackAllocator" );
+#endif // CAUSTIX_MEMORY_TRACKING
         m_allocatedSize = 0;
-        free(m_memory);
+        if ( m_virtual ) {
+            VirtualMemoryRelease( m_memory, m_totalSize );
+        } else {
+            free(m_memory);
+        }
     }
 
     StackAllocator::StackAllocator(sizet size) {
@@ -41,21 +62,41 @@ namespace Caustix {
         m_totalSize = size;
     }
 
+    StackAllocator::StackAllocator(const VirtualAllocatorConfiguration& configuration) {
+        const sizet page_size = VirtualMemoryPageSize();
+        m_totalSize = MemoryAlign( configuration.m_reserveSize, page_size );
+        m_commitGranularity = MemoryAlign( configuration.m_commitGranularity, page_size );
+        m_decommitOnFree = configuration.m_decommitOnFree;
+        m_virtual = true;
+        m_memory = ( u8* )VirtualMemoryReserve( m_totalSize );
+        CASSERT( m_memory != nullptr );
+        m_allocatedSize = 0;
+        m_committedSize = 0;
+    }
+
     void* StackAllocator::allocate(sizet size, sizet alignment) {
+        return StackAllocator::allocate( size, alignment, nullptr, 0 );
+    }
+
+    void* StackAllocator::allocate(sizet size, sizet alignment, cstring file, i32 line) {
         CASSERT(size > 0);
-        const sizet new_start = MemoryAlign(m_allocatedSize, alignment);
+        // Align the address rather than the offset, the base pointer is only malloc aligned.
+        const sizet new_start = MemoryAlign( ( sizet )m_memory + m_allocatedSize, alignment ) - ( sizet )m_memory;
         CASSERT(new_start < m_totalSize);
         const sizet new_allocated_size = new_start + size;
         if (new_allocated_size > m_totalSize) {
             return nullptr;
         }
+        if ( m_virtual && !VirtualMemoryCommitUpTo( m_memory, m_committedSize, new_allocated_size, m_commitGranularity, m_totalSize ) ) {
+            return nullptr;
+        }
 
         m_allocatedSize = new_allocated_size;
-        return m_memory + new_start;
-    }
-
-    void* StackAllocator::allocate(sizet size, sizet alignment, cstring file, i32 line) {
-        return allocate( size, alignment );
+        void* pointer = m_memory + new_start;
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnAllocate( pointer, size, file, line );
+#endif // CAUSTIX_MEMORY_TRACKING
+        return pointer;
     }
 
     void StackAllocator::deallocate(void *pointer) {
@@ -67,7 +108,14 @@ namespace Caustix {
 
         const sizet size_at_pointer = ( u8* )pointer - m_memory;
 
+#if defined(CAUSTIX_MEMORY_TRACKING)
+        m_tracker.OnDeallocateRange( pointer, m_memory + m_allocatedSize );
+#endif // CAUSTIX_MEMORY_TRACKING
+
         m_allocatedSize = size_at_pointer;
+        if ( m_virtual && m_decommitOnFree ) {
+            VirtualMemoryDecommitAfter( m_memory, m_committedSize, m_allocatedSize, m_commitGranularity );
+        }
     }
 
     sizet StackAllocator::GetMarker() const {
@@ -77,7 +125,13 @@ namespace Caustix {
     void StackAllocator::FreeMarker(sizet marker) {
         const sizet difference = marker - m_allocatedSize;
         if ( difference > 0 ) {
+#if defined(CAUSTIX_MEMORY_TRACKING)
+            m_tracker.OnDeallocateRange( m_memory + marker, m_memory + m_allocatedSize );
+#endif // CAUSTIX_MEMORY_TRACKING
             m_allocatedSize = marker;
+            if ( m_virtual && m_decommitOnFree ) {
+                VirtualMemoryDecommitAfter( m_memory, m_committedSize, m_allocatedSize, m_commitGranularity );
+            }
         }
     }
 }
\ No newline at end of file
@@ -22,6 +22,24 @@ export namespace Caustix {
         return static_cast<u8*>(allocator->allocate( size, 1, location.file_name(), location.line() ));
     }
 
+    constexpr sizet k_cache_line_size   = 64;
+    // Widest vector register in use (AVX-512), also a multiple of the cache line.
+    constexpr sizet k_simd_alignment    = 64;
+
+    // Allocates an uninitialized array of count elements, by default aligned for full width SIMD loads.
+    template <typename T, typename A>
+    requires std::derived_from<A, Allocator>
+    T* callocaa(sizet count, A* allocator, sizet alignment = k_simd_alignment, const std::source_location location = std::source_location::current()) {
+        alignment = alignment > alignof( T ) ? alignment : alignof( T );
+        return static_cast<T*>(allocator->allocate( sizeof( T ) * count, alignment, location.file_name(), location.line() ));
+    }
+
+    // Pads a value to its own cache line, for per-thread data written concurrently.
+    template <typename T>
+    struct alignas( k_cache_line_size ) CacheLineAligned {
+        T       m_value;
+    };
+
     template <typename A>
     requires std::derived_from<A, Allocator>
     void cfree(void* pointer, A* allocator){
@@ -57,7 +75,15 @@ export namespace Caustix {
     };
 
     struct MemoryServiceConfiguration {
-        sizet   m_maximumDynamicSize = 32 * 1024 * 1024;    // Defaults to max 32MB of dynamic memory.
-        sizet   m_scratchBufferSize  = cmega(8);
+        sizet   m_maximumDynamicSize = 32 * 1024 * 1024;    // Initial dynamic memory, defaults to 32MB.
+        sizet   m_dynamicGrowSize    = cmega(64);           // Minimum size of the pools added when the heap is full, 0 makes the heap fixed size.
+        sizet   m_dynamicRetainedSize = cmega(128);         // Free memory kept resident before empty pools are given back to the OS.
+        sizet   m_scratchBufferSize  = cgiga(4);            // Reserved address space only, pages are committed when touched.
+        bool    m_scratchDecommit    = true;                // Give scratch pages back to the OS when it is cleared.
+        sizet   m_frameBufferSize    = cmega(4);            // Per frame region of the frame allocator.
+        u32     m_frameCount         = 3;                   // Frame allocator regions, must match the frames in flight of the GpuDevice.
+        sizet   m_smallObjectsSize   = cgiga(1);            // Reserved address space for the slab allocator.
+        u32     m_smallObjectsThreadMagazines = 0;          // Per-thread block caches of the slab allocator, 0 keeps it single threaded.
+        u32     m_systemThreadArenas = 0;                   // Per-thread TLSF arenas for the system heap, 0 keeps it single threaded.
     };
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+module;
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+export module Foundation.Memory.MemoryTracker;
+
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Statistics of a single allocation call site.
+    struct AllocationSite {
+        cstring                         m_file              = nullptr;
+        i32                             m_line              = 0;
+
+        sizet                           m_liveBytes         = 0;
+        sizet                           m_peakBytes         = 0;
+        sizet                           m_totalBytes        = 0;
+        u64                             m_allocationCount   = 0;
+        u64                             m_liveCount         = 0;
+    };
+
+    // Records allocations per call site, used by the allocators when CAUSTIX_MEMORY_TRACKING is defined.
+    // Allocations coming without a file (STLAdaptor, direct allocate calls) are grouped in a single unknown site.
+    // Internal containers use the standard allocator, so tracking never recurses into the tracked allocator.
+    struct MemoryTracker {
+
+        void                            OnAllocate( void* pointer, sizet size, cstring file, i32 line );
+        void                            OnDeallocate( void* pointer );
+        // Releases every live allocation inside [begin, end), used by linear and stack allocators when rewinding.
+        void                            OnDeallocateRange( void* begin, void* end );
+
+        void                            Report( cstring allocatorName );
+        bool                            ReportJson( cstring allocatorName, cstring path );
+
+        struct LiveAllocation {
+            u64                         m_site;
+            sizet                       m_size;
+        };
+
+        void                            CollectSortedSites( std::vector<AllocationSite>& outSites );
+        void                            ReleaseLive( const LiveAllocation& allocation );
+
+        std::mutex                      m_mutex;
+        std::unordered_map<u64, AllocationSite>     m_sites;
+        std::unordered_map<void*, LiveAllocation>   m_live;
+    };
+}
+
+namespace Caustix {
+    static u64 SiteKey( cstring file, i32 line ) {
+        if ( file == nullptr ) {
+            return 0;
+        }
+        return HashBytes( ( void* )file, strlen( file ), ( sizet )line );
+    }
+
+    void MemoryTracker::OnAllocate( void* pointer, sizet size, cstring file, i32 line ) {
+        if ( pointer == nullptr ) {
+            return;
+        }
+
+        const u64 key = SiteKey( file, line );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        AllocationSite& site = m_sites[ key ];
+        site.m_file = file;
+        site.m_line = line;
+        site.m_liveBytes += size;
+        site.m_totalBytes += size;
+        ++site.m_allocationCount;
+        ++site.m_liveCount;
+        site.m_peakBytes = site.m_liveBytes > site.m_peakBytes ? site.m_liveBytes : site.m_peakBytes;
+
+        m_live[ pointer ] = { key, size };
+    }
+
+    void MemoryTracker::ReleaseLive( const LiveAllocation& allocation ) {
+        auto it = m_sites.find( allocation.m_site );
+        if ( it != m_sites.end() ) {
+            it->second.m_liveBytes -= allocation.m_size;
+            --it->second.m_liveCount;
+        }
+    }
+
+    void MemoryTracker::OnDeallocate( void* pointer ) {
+        if ( pointer == nullptr ) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto it = m_live.find( pointer );
+        if ( it == m_live.end() ) {
+            return;
+        }
+
+        ReleaseLive( it->second );
+        m_live.erase( it );
+    }
+
+    void MemoryTracker::OnDeallocateRange( void* begin, void* end ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        for ( auto it = m_live.begin(); it != m_live.end(); ) {
+            if ( it->first >= begin && it->first < end ) {
+                ReleaseLive( it->second );
+                it = m_live.erase( it );
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void MemoryTracker::CollectSortedSites( std::vector<AllocationSite>& outSites ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            outSites.reserve( m_sites.size() );
+            for ( auto& it : m_sites ) {
+                outSites.push_back( it.second );
+            }
+        }
+
+        // Hotspots first: sites that churned the most bytes.
+        std::sort( outSites.begin(), outSites.end(), []( const AllocationSite& a, const AllocationSite& b ) {
+            return a.m_totalBytes > b.m_totalBytes;
+        } );
+    }
+
+    void MemoryTracker::Report( cstring allocatorName ) {
+        std::vector<AllocationSite> sites;
+        CollectSortedSites( sites );
+
+        info( "Allocation report for {} - {} call sites", allocatorName, sites.size() );
+        info( "{:>14} {:>14} {:>14} {:>10} {:>10}  {}", "total", "live", "peak", "count", "live count", "call site" );
+        for ( const AllocationSite& site : sites ) {
+            info( "{:>14} {:>14} {:>14} {:>10} {:>10}  {}({})", site.m_totalBytes, site.m_liveBytes, site.m_peakBytes, site.m_allocationCount, site.m_liveCount, site.m_file ? site.m_file : "unknown", site.m_line );
+        }
+    }
+
+    bool MemoryTracker::ReportJson( cstring allocatorName, cstring path ) {
+        FILE* file = fopen( path, "w" );
+        if ( file == nullptr ) {
+            error( "Cannot write allocation report {}", path );
+            return false;
+        }
+
+        std::vector<AllocationSite> sites;
+        CollectSortedSites( sites );
+
+        fprintf( file, "{\n  \"allocator\": \"%s\",\n  \"sites\": [\n", allocatorName );
+        for ( sizet i = 0; i < sites.size(); ++i ) {
+            const AllocationSite& site = sites[ i ];
+            // Escape windows path separators.
+            fprintf( file, "    { \"file\": \"" );
+            for ( cstring c = site.m_file ? site.m_file : "unknown"; *c; ++c ) {
+                if ( *c == '\\' || *c == '"' ) {
+                    fputc( '\\', file );
+                }
+                fputc( *c, file );
+            }
+            fprintf( file, "\", \"line\": %d, \"total_bytes\": %llu, \"live_bytes\": %llu, \"peak_bytes\": %llu, \"count\": %llu, \"live_count\": %llu }%s\n",
+                     site.m_line, ( unsigned long long )site.m_totalBytes, ( unsigned long long )site.m_liveBytes, ( unsigned long long )site.m_peakBytes,
+                     ( unsigned long long )site.m_allocationCount, ( unsigned long long )site.m_liveCount, i + 1 < sites.size() ? "," : "" );
+        }
+        fprintf( file, "  ]\n}\n" );
+
+        fclose( file );
+        return true;
+    }
+}
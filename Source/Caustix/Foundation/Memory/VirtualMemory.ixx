@@ -0,0 +1,145 @@
+module;
+
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+export module Foundation.Memory.VirtualMemory;
+
+import Foundation.Platform;
+
+export namespace Caustix {
+    // Thin wrappers over the OS virtual memory calls.
+    // Reserved ranges cost only address space, pages become resident once committed and touched.
+    sizet           VirtualMemoryPageSize();
+
+    void*           VirtualMemoryReserve( sizet size );
+    bool            VirtualMemoryCommit( void* address, sizet size );
+    void            VirtualMemoryDecommit( void* address, sizet size );
+    void            VirtualMemoryRelease( void* address, sizet size );
+
+    // Bytes of the process currently resident in physical memory, for reports and benchmarks.
+    sizet           VirtualMemoryResidentSize();
+
+    // Reserve/commit setup for the linear allocators: the whole range is reserved up front
+    // and committed in steps of m_commitGranularity as the allocation offset advances.
+    struct VirtualAllocatorConfiguration {
+        sizet       m_reserveSize       = 0;
+        sizet       m_commitGranularity = 64 * 1024;
+        bool        m_decommitOnFree    = false;    // Give pages back to the OS when rewinding.
+    };
+
+    // Commits [committed, required) rounded to the granularity, updates committed.
+    bool            VirtualMemoryCommitUpTo( u8* base, sizet& committed, sizet required, sizet granularity, sizet reserved );
+    // Decommits everything after keep rounded to the granularity, updates committed.
+    void            VirtualMemoryDecommitAfter( u8* base, sizet& committed, sizet keep, sizet granularity );
+}
+
+namespace Caustix {
+#if defined(_MSC_VER)
+
+    sizet VirtualMemoryPageSize() {
+        SYSTEM_INFO system_info;
+        GetSystemInfo( &system_info );
+        return system_info.dwPageSize;
+    }
+
+    void* VirtualMemoryReserve( sizet size ) {
+        return VirtualAlloc( nullptr, size, MEM_RESERVE, PAGE_NOACCESS );
+    }
+
+    bool VirtualMemoryCommit( void* address, sizet size ) {
+        return VirtualAlloc( address, size, MEM_COMMIT, PAGE_READWRITE ) != nullptr;
+    }
+
+    void VirtualMemoryDecommit( void* address, sizet size ) {
+        VirtualFree( address, size, MEM_DECOMMIT );
+    }
+
+    void VirtualMemoryRelease( void* address, sizet size ) {
+        VirtualFree( address, 0, MEM_RELEASE );
+    }
+
+    sizet VirtualMemoryResidentSize() {
+        PROCESS_MEMORY_COUNTERS counters;
+        if ( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) ) {
+            return 0;
+        }
+        return counters.WorkingSetSize;
+    }
+
+#else
+
+    sizet VirtualMemoryPageSize() {
+        static const sizet page_size = ( sizet )sysconf( _SC_PAGESIZE );
+        return page_size;
+    }
+
+    void* VirtualMemoryReserve( sizet size ) {
+        void* address = mmap( nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    bool VirtualMemoryCommit( void* address, sizet size ) {
+        return mprotect( address, size, PROT_READ | PROT_WRITE ) == 0;
+    }
+
+    void VirtualMemoryDecommit( void* address, sizet size ) {
+        // Drop the physical pages, next commit will see zero filled memory.
+        madvise( address, size, MADV_DONTNEED );
+        mprotect( address, size, PROT_NONE );
+    }
+
+    void VirtualMemoryRelease( void* address, sizet size ) {
+        munmap( address, size );
+    }
+
+    sizet VirtualMemoryResidentSize() {
+        // Second field of statm, in pages.
+        FILE* file = fopen( "/proc/self/statm", "r" );
+        if ( file == nullptr ) {
+            return 0;
+        }
+        unsigned long long pages = 0;
+        const bool read = fscanf( file, "%*llu %llu", &pages ) == 1;
+        fclose( file );
+        return read ? ( sizet )pages * VirtualMemoryPageSize() : 0;
+    }
+
+#endif // _MSC_VER
+
+    static sizet AlignToGranularity( sizet size, sizet granularity ) {
+        return ( size + granularity - 1 ) / granularity * granularity;
+    }
+
+    bool VirtualMemoryCommitUpTo( u8* base, sizet& committed, sizet required, sizet granularity, sizet reserved ) {
+        if ( required <= committed ) {
+            return true;
+        }
+
+        sizet new_committed = AlignToGranularity( required, granularity );
+        new_committed = new_committed < reserved ? new_committed : reserved;
+        if ( required > new_committed || !VirtualMemoryCommit( base + committed, new_committed - committed ) ) {
+            return false;
+        }
+
+        committed = new_committed;
+        return true;
+    }
+
+    void VirtualMemoryDecommitAfter( u8* base, sizet& committed, sizet keep, sizet granularity ) {
+        const sizet new_committed = AlignToGranularity( keep, granularity );
+        if ( new_committed >= committed ) {
+            return;
+        }
+
+        VirtualMemoryDecommit( base + new_committed, committed - new_committed );
+        committed = new_committed;
+    }
+}
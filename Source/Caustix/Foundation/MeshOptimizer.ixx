@@ -0,0 +1,559 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+export module Foundation.MeshOptimizer;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Platform;
+import Foundation.Assert;
+
+export namespace Caustix {
+
+    // Post transform cache modelled as a FIFO, the size of the caches of current GPUs.
+    constexpr u32 k_vertex_cache_size       = 16;
+    constexpr u32 k_vertex_cache_size_max   = 32;
+
+    struct VertexCacheStatistics {
+        u32                         m_vertexTransforms  = 0;
+        f32                         m_acmr              = 0.0f;     // Vertices transformed per triangle, 0.5 is the ideal for grids and 3 the worst.
+        f32                         m_atvr              = 0.0f;     // Vertices transformed per referenced vertex, 1 is ideal.
+    };
+
+    // One tightly packed vertex attribute, m_size bytes per vertex.
+    struct VertexStream {
+        void*                       m_data;
+        u32                         m_size;
+    };
+
+    struct MeshOptimizerConfiguration {
+        u32                         m_cacheSize         = k_vertex_cache_size;
+        // Triangles are reordered for overdraw as long as the vertex cache efficiency stays within this factor.
+        f32                         m_overdrawThreshold = 1.05f;
+        bool                        m_weldVertices      = true;
+        bool                        m_optimizeOverdraw  = true;
+    };
+
+    struct MeshOptimizerReport {
+        VertexCacheStatistics       m_before;
+        VertexCacheStatistics       m_after;
+        u32                         m_verticesBefore    = 0;
+        u32                         m_verticesAfter     = 0;
+    };
+
+    VertexCacheStatistics   AnalyzeVertexCache( const u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize, Allocator* allocator );
+
+    // Points every index at the first vertex with the same content in all the streams. Returns the number of unique vertices.
+    u32     WeldVertices( u32* indices, u32 indexCount, const VertexStream* streams, u32 streamCount, u32 vertexCount, Allocator* allocator );
+
+    // Reorders triangles for the post transform cache, greedily picking the best scored triangle around the cache
+    // with the scores of Tom Forsyth's linear speed vertex cache optimisation. destination must not alias indices.
+    void    OptimizeVertexCache( u32* destination, const u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize, Allocator* allocator );
+
+    // Splits cache optimized triangles in clusters where the cache restarts, and further while the cache efficiency
+    // stays within threshold, then draws the clusters facing out of the mesh first. destination must not alias indices.
+    void    OptimizeOverdraw( u32* destination, const u32* indices, u32 indexCount, const f32* positions, u32 positionStride, u32 vertexCount,
+                              u32 cacheSize, f32 threshold, Allocator* allocator );
+
+    // Renumbers vertices in order of first use and moves the stream data accordingly, dropping unused vertices.
+    // Returns the new vertex count.
+    u32     OptimizeVertexFetch( u32* indices, u32 indexCount, VertexStream* streams, u32 streamCount, u32 vertexCount, Allocator* allocator );
+
+    // Weld, vertex cache, overdraw and vertex fetch passes in place. Positions are 3 floats at the start of streams[ positionStream ].
+    // Returns the new vertex count, stream data past it is unused.
+    u32     OptimizeMesh( u32* indices, u32 indexCount, VertexStream* streams, u32 streamCount, u32 vertexCount, u32 positionStream,
+                          Allocator* allocator, const MeshOptimizerConfiguration& configuration = {}, MeshOptimizerReport* report = nullptr );
+}
+
+namespace Caustix {
+
+    static constexpr u32 k_invalid_vertex       = ~0u;
+
+    // Forsyth scoring constants.
+    static constexpr f32 k_cache_decay_power    = 1.5f;
+    static constexpr f32 k_last_triangle_score  = 0.75f;
+    static constexpr f32 k_valence_boost_scale  = 2.0f;
+    static constexpr f32 k_valence_boost_power  = 0.5f;
+    static constexpr u32 k_valence_max          = 32;
+
+    // FIFO cache simulation: a vertex is in the cache when fewer than cacheSize vertices were inserted since its own insertion.
+    static u32 UpdateCache( u32 vertex, u32 cacheSize, u32* timestamps, u32& timestamp ) {
+        if ( timestamp - timestamps[ vertex ] > cacheSize ) {
+            timestamps[ vertex ] = timestamp++;
+            return 1;
+        }
+        return 0;
+    }
+
+    VertexCacheStatistics AnalyzeVertexCache( const u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize, Allocator* allocator ) {
+        VertexCacheStatistics statistics;
+        if ( indexCount < 3 ) {
+            return statistics;
+        }
+
+        u32* timestamps = callocaa<u32>( vertexCount, allocator );
+        memset( timestamps, 0, vertexCount * sizeof( u32 ) );
+
+        // Starting past the cache size puts every vertex out of the cache.
+        u32 timestamp = cacheSize + 1;
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            statistics.m_vertexTransforms += UpdateCache( indices[ i ], cacheSize, timestamps, timestamp );
+        }
+
+        u32 referenced = 0;
+        for ( u32 vertex = 0; vertex < vertexCount; ++vertex ) {
+            referenced += timestamps[ vertex ] != 0;
+        }
+
+        statistics.m_acmr = ( f32 )statistics.m_vertexTransforms / ( indexCount / 3 );
+        statistics.m_atvr = referenced ? ( f32 )statistics.m_vertexTransforms / referenced : 0.0f;
+
+        cfree( timestamps, allocator );
+        return statistics;
+    }
+
+    // Welding ////////////////////////////////////////////////////////////////
+
+    static u64 HashVertex( const VertexStream* streams, u32 streamCount, u32 vertex ) {
+        // FNV-1a over the bytes of the vertex in every stream.
+        u64 hash = 0xcbf29ce484222325ull;
+        for ( u32 s = 0; s < streamCount; ++s ) {
+            const u8* data = ( const u8* )streams[ s ].m_data + ( sizet )vertex * streams[ s ].m_size;
+            for ( u32 b = 0; b < streams[ s ].m_size; ++b ) {
+                hash = ( hash ^ data[ b ] ) * 0x100000001b3ull;
+            }
+        }
+        return hash;
+    }
+
+    static bool EqualVertices( const VertexStream* streams, u32 streamCount, u32 a, u32 b ) {
+        for ( u32 s = 0; s < streamCount; ++s ) {
+            const u8* data = ( const u8* )streams[ s ].m_data;
+            if ( memcmp( data + ( sizet )a * streams[ s ].m_size, data + ( sizet )b * streams[ s ].m_size, streams[ s ].m_size ) != 0 ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    u32 WeldVertices( u32* indices, u32 indexCount, const VertexStream* streams, u32 streamCount, u32 vertexCount, Allocator* allocator ) {
+        if ( vertexCount == 0 ) {
+            return 0;
+        }
+
+        // Open addressing table of vertex ids, at most half full.
+        u32 tableSize = 1;
+        while ( tableSize < vertexCount * 2 ) {
+            tableSize *= 2;
+        }
+
+        u32* table = callocaa<u32>( tableSize, allocator );
+        u32* remap = callocaa<u32>( vertexCount, allocator );
+        memset( table, 0xFF, tableSize * sizeof( u32 ) );
+
+        u32 unique = 0;
+        for ( u32 vertex = 0; vertex < vertexCount; ++vertex ) {
+            u32 slot = ( u32 )HashVertex( streams, streamCount, vertex ) & ( tableSize - 1 );
+            while ( table[ slot ] != k_invalid_vertex && !EqualVertices( streams, streamCount, table[ slot ], vertex ) ) {
+                slot = ( slot + 1 ) & ( tableSize - 1 );
+            }
+
+            if ( table[ slot ] == k_invalid_vertex ) {
+                table[ slot ] = vertex;
+                ++unique;
+            }
+            remap[ vertex ] = table[ slot ];
+        }
+
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            indices[ i ] = remap[ indices[ i ] ];
+        }
+
+        cfree( remap, allocator );
+        cfree( table, allocator );
+        return unique;
+    }
+
+    // Vertex cache ///////////////////////////////////////////////////////////
+
+    struct VertexScoreTable {
+        f32                         m_cache[ k_vertex_cache_size_max + 3 ];
+        f32                         m_valence[ k_valence_max + 1 ];
+
+        VertexScoreTable( u32 cacheSize ) {
+            for ( u32 position = 0; position < k_vertex_cache_size_max + 3; ++position ) {
+                if ( position < 3 ) {
+                    // The last triangle gets a fixed score, so that the next one does not simply reuse its edge.
+                    m_cache[ position ] = k_last_triangle_score;
+                } else if ( position < cacheSize ) {
+                    m_cache[ position ] = powf( 1.0f - ( f32 )( position - 3 ) / ( cacheSize - 3 ), k_cache_decay_power );
+                } else {
+                    m_cache[ position ] = 0.0f;
+                }
+            }
+
+            m_valence[ 0 ] = 0.0f;
+            for ( u32 valence = 1; valence <= k_valence_max; ++valence ) {
+                // Vertices with few triangles left are finished first, so they leave the working set.
+                m_valence[ valence ] = k_valence_boost_scale * powf( ( f32 )valence, -k_valence_boost_power );
+            }
+        }
+
+        f32 Score( i32 cachePosition, u32 liveTriangles ) const {
+            if ( liveTriangles == 0 ) {
+                return -1.0f;
+            }
+            const f32 cacheScore = cachePosition < 0 ? 0.0f : m_cache[ cachePosition ];
+            return cacheScore + m_valence[ std::min( liveTriangles, k_valence_max ) ];
+        }
+    };
+
+    void OptimizeVertexCache( u32* destination, const u32* indices, u32 indexCount, u32 vertexCount, u32 cacheSize, Allocator* allocator ) {
+        CASSERT( destination != indices );
+        const u32 triangleCount = indexCount / 3;
+        if ( triangleCount == 0 ) {
+            return;
+        }
+
+        cacheSize = std::clamp( cacheSize, 4u, k_vertex_cache_size_max );
+        const VertexScoreTable scoreTable( cacheSize );
+
+        // Vertex to triangle adjacency, the live triangles of a vertex are kept at the front of its range.
+        u32* offsets = callocaa<u32>( vertexCount + 1, allocator );
+        u32* liveTriangles = callocaa<u32>( vertexCount, allocator );
+        u32* adjacency = callocaa<u32>( indexCount, allocator );
+        memset( liveTriangles, 0, vertexCount * sizeof( u32 ) );
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            ++liveTriangles[ indices[ i ] ];
+        }
+        offsets[ 0 ] = 0;
+        for ( u32 vertex = 0; vertex < vertexCount; ++vertex ) {
+            offsets[ vertex + 1 ] = offsets[ vertex ] + liveTriangles[ vertex ];
+            liveTriangles[ vertex ] = 0;
+        }
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            const u32 vertex = indices[ i ];
+            adjacency[ offsets[ vertex ] + liveTriangles[ vertex ]++ ] = i / 3;
+        }
+
+        i32* cachePositions = callocaa<i32>( vertexCount, allocator );
+        f32* vertexScores = callocaa<f32>( vertexCount, allocator );
+        f32* triangleScores = callocaa<f32>( triangleCount, allocator );
+        bool* emitted = callocaa<bool>( triangleCount, allocator );
+        memset( emitted, 0, triangleCount * sizeof( bool ) );
+
+        for ( u32 vertex = 0; vertex < vertexCount; ++vertex ) {
+            cachePositions[ vertex ] = -1;
+            vertexScores[ vertex ] = scoreTable.Score( -1, liveTriangles[ vertex ] );
+        }
+        for ( u32 triangle = 0; triangle < triangleCount; ++triangle ) {
+            triangleScores[ triangle ] = vertexScores[ indices[ triangle * 3 ] ] + vertexScores[ indices[ triangle * 3 + 1 ] ] + vertexScores[ indices[ triangle * 3 + 2 ] ];
+        }
+
+        // Vertices of emitted triangles, searched for live triangles when the cache runs dry.
+        u32* deadEndStack = callocaa<u32>( indexCount, allocator );
+        u32 deadEndCount = 0;
+        u32 inputCursor = 0;
+
+        u32 cache[ k_vertex_cache_size_max + 3 ];
+        u32 newCache[ k_vertex_cache_size_max + 3 ];
+        u32 cacheCount = 0;
+
+        u32 bestTriangle = 0;
+        for ( u32 output = 0; output < triangleCount; ++output ) {
+            if ( bestTriangle == k_invalid_vertex ) {
+                // Dead end: the best triangle of a recently used vertex, or the next one in input order.
+                while ( deadEndCount && bestTriangle == k_invalid_vertex ) {
+                    const u32 vertex = deadEndStack[ --deadEndCount ];
+                    f32 bestScore = -1.0f;
+                    for ( u32 i = offsets[ vertex ]; i < offsets[ vertex ] + liveTriangles[ vertex ]; ++i ) {
+                        if ( triangleScores[ adjacency[ i ] ] > bestScore ) {
+                            bestScore = triangleScores[ adjacency[ i ] ];
+                            bestTriangle = adjacency[ i ];
+                        }
+                    }
+                }
+                while ( bestTriangle == k_invalid_vertex ) {
+                    if ( !emitted[ inputCursor ] ) {
+                        bestTriangle = inputCursor;
+                    }
+                    ++inputCursor;
+                }
+            }
+
+            const u32* triangle = indices + ( sizet )bestTriangle * 3;
+            memcpy( destination + ( sizet )output * 3, triangle, sizeof( u32 ) * 3 );
+            emitted[ bestTriangle ] = true;
+
+            // Remove the triangle from the live lists of its vertices.
+            for ( u32 corner = 0; corner < 3; ++corner ) {
+                const u32 vertex = triangle[ corner ];
+                u32* live = adjacency + offsets[ vertex ];
+                for ( u32 i = 0; i < liveTriangles[ vertex ]; ++i ) {
+                    if ( live[ i ] == bestTriangle ) {
+                        live[ i ] = live[ --liveTriangles[ vertex ] ];
+                        break;
+                    }
+                }
+                deadEndStack[ deadEndCount++ ] = vertex;
+            }
+
+            // Its vertices move to the front of the cache, the others shift back.
+            u32 newCacheCount = 0;
+            for ( u32 corner = 0; corner < 3; ++corner ) {
+                const u32 vertex = triangle[ corner ];
+                if ( std::find( newCache, newCache + newCacheCount, vertex ) == newCache + newCacheCount ) {
+                    newCache[ newCacheCount++ ] = vertex;
+                }
+            }
+            for ( u32 i = 0; i < cacheCount; ++i ) {
+                const u32 vertex = cache[ i ];
+                if ( vertex != triangle[ 0 ] && vertex != triangle[ 1 ] && vertex != triangle[ 2 ] ) {
+                    newCache[ newCacheCount++ ] = vertex;
+                }
+            }
+
+            // Rescore the vertices that moved, including the ones pushed out, and their live triangles.
+            for ( u32 i = 0; i < newCacheCount; ++i ) {
+                const u32 vertex = newCache[ i ];
+                cachePositions[ vertex ] = i < cacheSize ? ( i32 )i : -1;
+                vertexScores[ vertex ] = scoreTable.Score( cachePositions[ vertex ], liveTriangles[ vertex ] );
+            }
+
+            bestTriangle = k_invalid_vertex;
+            f32 bestScore = -1.0f;
+            for ( u32 i = 0; i < newCacheCount; ++i ) {
+                const u32 vertex = newCache[ i ];
+                for ( u32 a = offsets[ vertex ]; a < offsets[ vertex ] + liveTriangles[ vertex ]; ++a ) {
+                    const u32 candidate = adjacency[ a ];
+                    const u32* corners = indices + ( sizet )candidate * 3;
+                    const f32 score = vertexScores[ corners[ 0 ] ] + vertexScores[ corners[ 1 ] ] + vertexScores[ corners[ 2 ] ];
+                    triangleScores[ candidate ] = score;
+                    if ( score > bestScore ) {
+                        bestScore = score;
+                        bestTriangle = candidate;
+                    }
+                }
+            }
+
+            cacheCount = std::min( newCacheCount, cacheSize );
+            memcpy( cache, newCache, cacheCount * sizeof( u32 ) );
+        }
+
+        cfree( deadEndStack, allocator );
+        cfree( emitted, allocator );
+        cfree( triangleScores, allocator );
+        cfree( vertexScores, allocator );
+        cfree( cachePositions, allocator );
+        cfree( adjacency, allocator );
+        cfree( liveTriangles, allocator );
+        cfree( offsets, allocator );
+    }
+
+    // Overdraw ///////////////////////////////////////////////////////////////
+
+    void OptimizeOverdraw( u32* destination, const u32* indices, u32 indexCount, const f32* positions, u32 positionStride, u32 vertexCount,
+                           u32 cacheSize, f32 threshold, Allocator* allocator ) {
+        CASSERT( destination != indices );
+        const u32 triangleCount = indexCount / 3;
+        if ( triangleCount == 0 ) {
+            return;
+        }
+
+        u32* timestamps = callocaa<u32>( vertexCount, allocator );
+        u32* clusters = callocaa<u32>( triangleCount + 1, allocator );
+        u32* softClusters = callocaa<u32>( triangleCount + 1, allocator );
+
+        // Hard boundaries: triangles missing the cache on all 3 vertices usually start a new patch of the mesh.
+        memset( timestamps, 0, vertexCount * sizeof( u32 ) );
+        u32 timestamp = cacheSize + 1;
+        u32 clusterCount = 0;
+        for ( u32 t = 0; t < triangleCount; ++t ) {
+            u32 misses = 0;
+            for ( u32 corner = 0; corner < 3; ++corner ) {
+                misses += UpdateCache( indices[ t * 3 + corner ], cacheSize, timestamps, timestamp );
+            }
+            if ( t == 0 || misses == 3 ) {
+                clusters[ clusterCount++ ] = t;
+            }
+        }
+        clusters[ clusterCount ] = triangleCount;
+
+        // Soft boundaries: a cluster is split again every time the cache efficiency from its start reaches
+        // the efficiency of the whole cluster scaled by the threshold.
+        u32 softClusterCount = 0;
+        for ( u32 c = 0; c < clusterCount; ++c ) {
+            const u32 start = clusters[ c ];
+            const u32 end = clusters[ c + 1 ];
+
+            timestamp += cacheSize + 1;
+            u32 clusterMisses = 0;
+            for ( u32 t = start; t < end; ++t ) {
+                for ( u32 corner = 0; corner < 3; ++corner ) {
+                    clusterMisses += UpdateCache( indices[ t * 3 + corner ], cacheSize, timestamps, timestamp );
+                }
+            }
+            const f32 clusterThreshold = threshold * ( f32 )clusterMisses / ( end - start );
+
+            softClusters[ softClusterCount++ ] = start;
+            timestamp += cacheSize + 1;
+            u32 runningMisses = 0;
+            u32 runningTriangles = 0;
+            for ( u32 t = start; t < end; ++t ) {
+                for ( u32 corner = 0; corner < 3; ++corner ) {
+                    runningMisses += UpdateCache( indices[ t * 3 + corner ], cacheSize, timestamps, timestamp );
+                }
+                ++runningTriangles;
+
+                if ( t + 1 < end && ( f32 )runningMisses / runningTriangles <= clusterThreshold ) {
+                    softClusters[ softClusterCount++ ] = t + 1;
+                    timestamp += cacheSize + 1;
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+        }
+        softClusters[ softClusterCount ] = triangleCount;
+
+        // Clusters facing away from the mesh centroid are drawn first, they are the most likely to occlude the others.
+        f32 meshCentroid[ 3 ] = { 0.0f, 0.0f, 0.0f };
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            const f32* p = ( const f32* )( ( const u8* )positions + ( sizet )indices[ i ] * positionStride );
+            meshCentroid[ 0 ] += p[ 0 ];
+            meshCentroid[ 1 ] += p[ 1 ];
+            meshCentroid[ 2 ] += p[ 2 ];
+        }
+        for ( f32& component : meshCentroid ) {
+            component /= indexCount;
+        }
+
+        f32* sortKeys = callocaa<f32>( softClusterCount, allocator );
+        u32* order = callocaa<u32>( softClusterCount, allocator );
+        for ( u32 c = 0; c < softClusterCount; ++c ) {
+            f32 area = 0.0f;
+            f32 centroid[ 3 ] = { 0.0f, 0.0f, 0.0f };
+            f32 normal[ 3 ] = { 0.0f, 0.0f, 0.0f };
+
+            for ( u32 t = softClusters[ c ]; t < softClusters[ c + 1 ]; ++t ) {
+                const f32* p0 = ( const f32* )( ( const u8* )positions + ( sizet )indices[ t * 3 ] * positionStride );
+                const f32* p1 = ( const f32* )( ( const u8* )positions + ( sizet )indices[ t * 3 + 1 ] * positionStride );
+                const f32* p2 = ( const f32* )( ( const u8* )positions + ( sizet )indices[ t * 3 + 2 ] * positionStride );
+
+                const f32 ax = p1[ 0 ] - p0[ 0 ], ay = p1[ 1 ] - p0[ 1 ], az = p1[ 2 ] - p0[ 2 ];
+                const f32 bx = p2[ 0 ] - p0[ 0 ], by = p2[ 1 ] - p0[ 1 ], bz = p2[ 2 ] - p0[ 2 ];
+                const f32 nx = ay * bz - az * by, ny = az * bx - ax * bz, nz = ax * by - ay * bx;
+                const f32 triangleArea = sqrtf( nx * nx + ny * ny + nz * nz );
+
+                for ( u32 k = 0; k < 3; ++k ) {
+                    centroid[ k ] += ( p0[ k ] + p1[ k ] + p2[ k ] ) / 3.0f * triangleArea;
+                }
+                normal[ 0 ] += nx;
+                normal[ 1 ] += ny;
+                normal[ 2 ] += nz;
+                area += triangleArea;
+            }
+
+            const f32 inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+            const f32 normalLength = sqrtf( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+            const f32 inverseNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+            f32 key = 0.0f;
+            for ( u32 k = 0; k < 3; ++k ) {
+                key += ( centroid[ k ] * inverseArea - meshCentroid[ k ] ) * normal[ k ] * inverseNormalLength;
+            }
+            sortKeys[ c ] = key;
+            order[ c ] = c;
+        }
+
+        std::stable_sort( order, order + softClusterCount, [ sortKeys ]( u32 a, u32 b ) { return sortKeys[ a ] > sortKeys[ b ]; } );
+
+        u32 output = 0;
+        for ( u32 i = 0; i < softClusterCount; ++i ) {
+            const u32 c = order[ i ];
+            const u32 count = ( softClusters[ c + 1 ] - softClusters[ c ] ) * 3;
+            memcpy( destination + output, indices + ( sizet )softClusters[ c ] * 3, count * sizeof( u32 ) );
+            output += count;
+        }
+
+        cfree( order, allocator );
+        cfree( sortKeys, allocator );
+        cfree( softClusters, allocator );
+        cfree( clusters, allocator );
+        cfree( timestamps, allocator );
+    }
+
+    // Vertex fetch ///////////////////////////////////////////////////////////
+
+    u32 OptimizeVertexFetch( u32* indices, u32 indexCount, VertexStream* streams, u32 streamCount, u32 vertexCount, Allocator* allocator ) {
+        u32* remap = callocaa<u32>( vertexCount, allocator );
+        memset( remap, 0xFF, vertexCount * sizeof( u32 ) );
+
+        u32 newVertexCount = 0;
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            u32& target = remap[ indices[ i ] ];
+            if ( target == k_invalid_vertex ) {
+                target = newVertexCount++;
+            }
+            indices[ i ] = target;
+        }
+
+        u32 maxSize = 0;
+        for ( u32 s = 0; s < streamCount; ++s ) {
+            maxSize = std::max( maxSize, streams[ s ].m_size );
+        }
+
+        u8* scratch = callocaa<u8>( ( sizet )std::max( newVertexCount, 1u ) * maxSize, allocator );
+        for ( u32 s = 0; s < streamCount; ++s ) {
+            u8* data = ( u8* )streams[ s ].m_data;
+            const u32 size = streams[ s ].m_size;
+            for ( u32 vertex = 0; vertex < vertexCount; ++vertex ) {
+                if ( remap[ vertex ] != k_invalid_vertex ) {
+                    memcpy( scratch + ( sizet )remap[ vertex ] * size, data + ( sizet )vertex * size, size );
+                }
+            }
+            memcpy( data, scratch, ( sizet )newVertexCount * size );
+        }
+
+        cfree( scratch, allocator );
+        cfree( remap, allocator );
+        return newVertexCount;
+    }
+
+    u32 OptimizeMesh( u32* indices, u32 indexCount, VertexStream* streams, u32 streamCount, u32 vertexCount, u32 positionStream,
+                      Allocator* allocator, const MeshOptimizerConfiguration& configuration, MeshOptimizerReport* report ) {
+        CASSERT( positionStream < streamCount );
+        indexCount -= indexCount % 3;
+
+        if ( report ) {
+            report->m_before = AnalyzeVertexCache( indices, indexCount, vertexCount, configuration.m_cacheSize, allocator );
+            report->m_verticesBefore = vertexCount;
+        }
+
+        if ( configuration.m_weldVertices ) {
+            WeldVertices( indices, indexCount, streams, streamCount, vertexCount, allocator );
+        }
+
+        u32* scratch = callocaa<u32>( std::max( indexCount, 1u ), allocator );
+        OptimizeVertexCache( scratch, indices, indexCount, vertexCount, configuration.m_cacheSize, allocator );
+        if ( configuration.m_optimizeOverdraw ) {
+            const VertexStream& positions = streams[ positionStream ];
+            OptimizeOverdraw( indices, scratch, indexCount, ( const f32* )positions.m_data, positions.m_size, vertexCount,
+                              configuration.m_cacheSize, configuration.m_overdrawThreshold, allocator );
+        } else {
+            memcpy( indices, scratch, indexCount * sizeof( u32 ) );
+        }
+        cfree( scratch, allocator );
+
+        vertexCount = OptimizeVertexFetch( indices, indexCount, streams, streamCount, vertexCount, allocator );
+
+        if ( report ) {
+            report->m_after = AnalyzeVertexCache( indices, indexCount, vertexCount, configuration.m_cacheSize, allocator );
+            report->m_verticesAfter = vertexCount;
+        }
+        return vertexCount;
+    }
+}
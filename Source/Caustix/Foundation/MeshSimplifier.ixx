@@ -0,0 +1,487 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+export module Foundation.MeshSimplifier;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Platform;
+import Foundation.Assert;
+
+export namespace Caustix {
+
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    constexpr u32 k_simplifier_max_attributes   = 8;    // Floats per vertex over all the attribute streams.
+    constexpr u32 k_max_mesh_lods               = 8;
+
+    // A float vertex attribute taking part in the simplification error, like normals or uvs.
+    struct SimplifierAttribute {
+        const f32*                  m_data          = nullptr;
+        u32                         m_stride        = 0;        // Bytes between vertices.
+        u32                         m_components    = 0;
+        f32                         m_weight        = 1.0f;     // Error of a unit difference, in fractions of the mesh extent.
+    };
+
+    struct MeshLod {
+        u32                         m_indexOffset;
+        u32                         m_indexCount;
+        // Model space distance from the full detail mesh: the level can be drawn while this projects to less than
+        // the screen space error the application accepts. 0 for level 0.
+        f32                         m_error;
+    };
+
+    struct MeshLodConfiguration {
+        u32                         m_maxLevels     = 6;        // Including the full detail level, at most k_max_mesh_lods.
+        f32                         m_reduction     = 0.5f;     // Triangles of a level relative to the previous one.
+        f32                         m_maxError      = 0.05f;    // In fractions of the mesh extent, no level goes past it.
+        u32                         m_minTriangles  = 32;       // No level goes below it.
+    };
+
+    // Quadric error metric edge collapses: vertices collapse onto a neighbour, so the result indexes the same vertices.
+    // The error sums the area weighted plane distances and attribute differences of everything merged into a vertex.
+    // Vertices on borders, uv or normal seams and non manifold edges stay in place, keeping meshes sharing them watertight.
+    // Stops at targetIndexCount or when the next collapse goes past targetError, in fractions of the mesh extent.
+    // destination may alias indices. Returns the index count, resultError receives the model space error.
+    u32     SimplifyMesh( u32* destination, const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount,
+                          const SimplifierAttribute* attributes, u32 attributeCount, u32 targetIndexCount, f32 targetError,
+                          Allocator* allocator, f32* resultError = nullptr );
+
+    // Level 0 is indices as they are, every next level continues collapsing the previous one, so errors only grow.
+    // Levels are appended to lodIndices, lods receives up to configuration.m_maxLevels entries. Returns the level count.
+    u32     GenerateMeshLods( const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount,
+                              const SimplifierAttribute* attributes, u32 attributeCount, Array(u32)& lodIndices, MeshLod* lods,
+                              Allocator* allocator, const MeshLodConfiguration& configuration = {} );
+
+    // Coarsest level whose error stays within pixelThreshold pixels, pixelsPerUnit projecting model units at the draw distance.
+    u32     SelectMeshLod( const MeshLod* lods, u32 lodCount, f32 pixelsPerUnit, f32 pixelThreshold );
+}
+
+namespace Caustix {
+
+    // Collapses within a pass stay below this factor of the cost the pass goal needs, so cheap collapses
+    // blocked by their neighbours wait for the next pass instead of letting expensive ones through.
+    static constexpr f32 k_pass_error_factor    = 1.5f * 1.5f;
+    // Collapses rotating a triangle normal by more than about 75 degrees are rejected.
+    static constexpr f32 k_flip_threshold       = 0.25f;
+    // Levels removing fewer triangles than this are not worth the memory.
+    static constexpr f32 k_min_lod_reduction    = 0.1f;
+
+    struct VertexQuadric {
+        // Symmetric plane quadric and its area weight.
+        f32                         m_a00, m_a11, m_a22, m_a10, m_a20, m_a21;
+        f32                         m_b0, m_b1, m_b2;
+        f32                         m_c;
+        f32                         m_weight;
+        // Area weighted sums of the attributes and of their squares.
+        f32                         m_attributes[ k_simplifier_max_attributes ];
+        f32                         m_squares;
+    };
+
+    struct CollapseCandidate {
+        u32                         m_from;
+        u32                         m_to;
+        f32                         m_cost;
+    };
+
+    // Scratch of a simplification, collapses can be resumed with lower targets.
+    struct SimplifierState {
+        Allocator*                  m_allocator;
+        u32                         m_vertexCount;
+        u32                         m_attributeCount;
+        f32                         m_extent;           // Positions are scaled to a unit box, errors are relative to it.
+
+        f32*                        m_positions;
+        f32*                        m_attributes;
+        VertexQuadric*              m_quadrics;
+        u32*                        m_remap;
+        u8*                         m_locked;
+        u8*                         m_touched;
+
+        u32*                        m_indices;
+        u32                         m_indexCount;
+        u32*                        m_offsets;          // Triangles around each vertex.
+        u32*                        m_triangles;
+        CollapseCandidate*          m_candidates;
+
+        f32                         m_error;            // Largest collapse cost so far, squared and relative.
+    };
+
+    static void AddPlane( VertexQuadric& q, f32 a, f32 b, f32 c, f32 d, f32 weight ) {
+        q.m_a00 += weight * a * a;
+        q.m_a11 += weight * b * b;
+        q.m_a22 += weight * c * c;
+        q.m_a10 += weight * a * b;
+        q.m_a20 += weight * a * c;
+        q.m_a21 += weight * b * c;
+        q.m_b0 += weight * a * d;
+        q.m_b1 += weight * b * d;
+        q.m_b2 += weight * c * d;
+        q.m_c += weight * d * d;
+        q.m_weight += weight;
+    }
+
+    static void AddQuadric( VertexQuadric& destination, const VertexQuadric& source ) {
+        const f32* from = &source.m_a00;
+        f32* to = &destination.m_a00;
+        for ( u32 i = 0; i < sizeof( VertexQuadric ) / sizeof( f32 ); ++i ) {
+            to[ i ] += from[ i ];
+        }
+    }
+
+    // Squared error, relative to the unit box, of moving everything merged into from onto vertex to.
+    static f32 CollapseCost( const SimplifierState& state, u32 from, u32 to ) {
+        const VertexQuadric& q = state.m_quadrics[ from ];
+        const f32 x = state.m_positions[ to * 3 + 0 ], y = state.m_positions[ to * 3 + 1 ], z = state.m_positions[ to * 3 + 2 ];
+
+        f32 error = q.m_a00 * x * x + q.m_a11 * y * y + q.m_a22 * z * z
+                  + 2.0f * ( q.m_a10 * x * y + q.m_a20 * x * z + q.m_a21 * y * z )
+                  + 2.0f * ( q.m_b0 * x + q.m_b1 * y + q.m_b2 * z ) + q.m_c;
+
+        const f32* attributes = state.m_attributes + ( sizet )to * state.m_attributeCount;
+        for ( u32 k = 0; k < state.m_attributeCount; ++k ) {
+            error += attributes[ k ] * ( q.m_weight * attributes[ k ] - 2.0f * q.m_attributes[ k ] );
+        }
+        error += q.m_squares;
+
+        return fabsf( error ) / std::max( q.m_weight, 1e-20f );
+    }
+
+    // True when moving from onto to turns a remaining triangle around from over.
+    static bool CollapseFlips( const SimplifierState& state, u32 from, u32 to ) {
+        const f32* target = state.m_positions + ( sizet )to * 3;
+        const f32* source = state.m_positions + ( sizet )from * 3;
+
+        for ( u32 t = state.m_offsets[ from ]; t < state.m_offsets[ from + 1 ]; ++t ) {
+            const u32* corners = state.m_indices + ( sizet )state.m_triangles[ t ] * 3;
+            if ( corners[ 0 ] == to || corners[ 1 ] == to || corners[ 2 ] == to ) {
+                continue;
+            }
+
+            // Other two corners in winding order after from.
+            const u32 k = corners[ 0 ] == from ? 0 : corners[ 1 ] == from ? 1 : 2;
+            const f32* b = state.m_positions + ( sizet )corners[ ( k + 1 ) % 3 ] * 3;
+            const f32* c = state.m_positions + ( sizet )corners[ ( k + 2 ) % 3 ] * 3;
+
+            const f32 bcx = c[ 0 ] - b[ 0 ], bcy = c[ 1 ] - b[ 1 ], bcz = c[ 2 ] - b[ 2 ];
+            const f32 bsx = source[ 0 ] - b[ 0 ], bsy = source[ 1 ] - b[ 1 ], bsz = source[ 2 ] - b[ 2 ];
+            const f32 btx = target[ 0 ] - b[ 0 ], bty = target[ 1 ] - b[ 1 ], btz = target[ 2 ] - b[ 2 ];
+
+            const f32 n0x = bcy * bsz - bcz * bsy, n0y = bcz * bsx - bcx * bsz, n0z = bcx * bsy - bcy * bsx;
+            const f32 n1x = bcy * btz - bcz * bty, n1y = bcz * btx - bcx * btz, n1z = bcx * bty - bcy * btx;
+
+            const f32 dot = n0x * n1x + n0y * n1y + n0z * n1z;
+            const f32 lengths = ( n0x * n0x + n0y * n0y + n0z * n0z ) * ( n1x * n1x + n1y * n1y + n1z * n1z );
+            if ( dot <= 0.0f || dot * dot < k_flip_threshold * k_flip_threshold * lengths ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void BuildAdjacency( SimplifierState& state ) {
+        memset( state.m_offsets, 0, ( state.m_vertexCount + 1 ) * sizeof( u32 ) );
+        for ( u32 i = 0; i < state.m_indexCount; ++i ) {
+            ++state.m_offsets[ state.m_indices[ i ] + 1 ];
+        }
+        for ( u32 v = 0; v < state.m_vertexCount; ++v ) {
+            state.m_offsets[ v + 1 ] += state.m_offsets[ v ];
+        }
+        // Filling advances every start to the end of its vertex, the start of the next one.
+        for ( u32 i = 0; i < state.m_indexCount; ++i ) {
+            state.m_triangles[ state.m_offsets[ state.m_indices[ i ] ]++ ] = i / 3;
+        }
+        for ( u32 v = state.m_vertexCount; v > 0; --v ) {
+            state.m_offsets[ v ] = state.m_offsets[ v - 1 ];
+        }
+        state.m_offsets[ 0 ] = 0;
+    }
+
+    // Locks the vertices of edges without exactly one opposite edge: borders, seams and non manifold edges.
+    static void LockBorders( SimplifierState& state ) {
+        u64* edges = callocaa<u64>( std::max( state.m_indexCount, 1u ), state.m_allocator );
+        for ( u32 i = 0; i < state.m_indexCount; ++i ) {
+            const u32 a = state.m_indices[ i ];
+            const u32 b = state.m_indices[ i - i % 3 + ( i + 1 ) % 3 ];
+            edges[ i ] = ( ( u64 )a << 32 ) | b;
+        }
+        std::sort( edges, edges + state.m_indexCount );
+
+        for ( u32 i = 0; i < state.m_indexCount; ++i ) {
+            const u32 a = ( u32 )( edges[ i ] >> 32 );
+            const u32 b = ( u32 )edges[ i ];
+            const u64 opposite = ( ( u64 )b << 32 ) | a;
+            const auto range = std::equal_range( edges, edges + state.m_indexCount, opposite );
+            const bool repeated = ( i > 0 && edges[ i - 1 ] == edges[ i ] ) || ( i + 1 < state.m_indexCount && edges[ i + 1 ] == edges[ i ] );
+            if ( range.second - range.first != 1 || repeated ) {
+                state.m_locked[ a ] = 1;
+                state.m_locked[ b ] = 1;
+            }
+        }
+
+        cfree( edges, state.m_allocator );
+    }
+
+    static void InitializeSimplifier( SimplifierState& state, const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount,
+                                      const SimplifierAttribute* attributes, u32 attributeCount, Allocator* allocator ) {
+        state.m_allocator = allocator;
+        state.m_vertexCount = vertexCount;
+        state.m_attributeCount = 0;
+        for ( u32 s = 0; s < attributeCount; ++s ) {
+            state.m_attributeCount += attributes[ s ].m_components;
+        }
+        CASSERT( state.m_attributeCount <= k_simplifier_max_attributes );
+
+        state.m_positions = callocaa<f32>( ( sizet )vertexCount * 3 + 1, allocator );
+        state.m_attributes = callocaa<f32>( ( sizet )vertexCount * state.m_attributeCount + 1, allocator );
+        state.m_quadrics = callocaa<VertexQuadric>( vertexCount + 1, allocator );
+        state.m_remap = callocaa<u32>( vertexCount + 1, allocator );
+        state.m_locked = callocaa<u8>( vertexCount + 1, allocator );
+        state.m_touched = callocaa<u8>( vertexCount + 1, allocator );
+        state.m_indices = callocaa<u32>( indexCount + 1, allocator );
+        state.m_offsets = callocaa<u32>( vertexCount + 1, allocator );
+        state.m_triangles = callocaa<u32>( indexCount + 1, allocator );
+        state.m_candidates = callocaa<CollapseCandidate>( indexCount + 1, allocator );
+
+        memcpy( state.m_indices, indices, indexCount * sizeof( u32 ) );
+        state.m_indexCount = indexCount;
+        state.m_error = 0.0f;
+
+        // Unit box positions keep the quadrics well conditioned and the errors independent of the mesh scale.
+        f32 boxMin[ 3 ] = { 0.0f, 0.0f, 0.0f }, boxMax[ 3 ] = { 0.0f, 0.0f, 0.0f };
+        for ( u32 v = 0; v < vertexCount; ++v ) {
+            for ( u32 k = 0; k < 3; ++k ) {
+                const f32 value = positions[ v * 3 + k ];
+                boxMin[ k ] = v == 0 ? value : std::min( boxMin[ k ], value );
+                boxMax[ k ] = v == 0 ? value : std::max( boxMax[ k ], value );
+            }
+        }
+        state.m_extent = std::max( { boxMax[ 0 ] - boxMin[ 0 ], boxMax[ 1 ] - boxMin[ 1 ], boxMax[ 2 ] - boxMin[ 2 ] } );
+        const f32 scale = state.m_extent > 0.0f ? 1.0f / state.m_extent : 0.0f;
+
+        for ( u32 v = 0; v < vertexCount; ++v ) {
+            for ( u32 k = 0; k < 3; ++k ) {
+                state.m_positions[ v * 3 + k ] = ( positions[ v * 3 + k ] - boxMin[ k ] ) * scale;
+            }
+
+            f32* vertexAttributes = state.m_attributes + ( sizet )v * state.m_attributeCount;
+            for ( u32 s = 0; s < attributeCount; ++s ) {
+                const f32* data = ( const f32* )( ( const u8* )attributes[ s ].m_data + ( sizet )v * attributes[ s ].m_stride );
+                for ( u32 k = 0; k < attributes[ s ].m_components; ++k ) {
+                    *vertexAttributes++ = data[ k ] * attributes[ s ].m_weight;
+                }
+            }
+            state.m_remap[ v ] = v;
+        }
+        memset( state.m_quadrics, 0, vertexCount * sizeof( VertexQuadric ) );
+        memset( state.m_locked, 0, vertexCount );
+
+        for ( u32 i = 0; i < indexCount; i += 3 ) {
+            const f32* p0 = state.m_positions + ( sizet )indices[ i + 0 ] * 3;
+            const f32* p1 = state.m_positions + ( sizet )indices[ i + 1 ] * 3;
+            const f32* p2 = state.m_positions + ( sizet )indices[ i + 2 ] * 3;
+
+            const f32 ax = p1[ 0 ] - p0[ 0 ], ay = p1[ 1 ] - p0[ 1 ], az = p1[ 2 ] - p0[ 2 ];
+            const f32 bx = p2[ 0 ] - p0[ 0 ], by = p2[ 1 ] - p0[ 1 ], bz = p2[ 2 ] - p0[ 2 ];
+            f32 nx = ay * bz - az * by, ny = az * bx - ax * bz, nz = ax * by - ay * bx;
+            const f32 length = sqrtf( nx * nx + ny * ny + nz * nz );
+            if ( length == 0.0f ) {
+                continue;
+            }
+            nx /= length;
+            ny /= length;
+            nz /= length;
+            const f32 area = length * 0.5f;
+            const f32 distance = -( nx * p0[ 0 ] + ny * p0[ 1 ] + nz * p0[ 2 ] );
+
+            for ( u32 c = 0; c < 3; ++c ) {
+                const u32 vertex = indices[ i + c ];
+                VertexQuadric& q = state.m_quadrics[ vertex ];
+                AddPlane( q, nx, ny, nz, distance, area );
+
+                // Every vertex starts at no attribute error from itself.
+                const f32* vertexAttributes = state.m_attributes + ( sizet )vertex * state.m_attributeCount;
+                for ( u32 k = 0; k < state.m_attributeCount; ++k ) {
+                    q.m_attributes[ k ] += area * vertexAttributes[ k ];
+                    q.m_squares += area * vertexAttributes[ k ] * vertexAttributes[ k ];
+                }
+            }
+        }
+
+        LockBorders( state );
+    }
+
+    static void ReleaseSimplifier( SimplifierState& state ) {
+        cfree( state.m_candidates, state.m_allocator );
+        cfree( state.m_triangles, state.m_allocator );
+        cfree( state.m_offsets, state.m_allocator );
+        cfree( state.m_indices, state.m_allocator );
+        cfree( state.m_touched, state.m_allocator );
+        cfree( state.m_locked, state.m_allocator );
+        cfree( state.m_remap, state.m_allocator );
+        cfree( state.m_quadrics, state.m_allocator );
+        cfree( state.m_attributes, state.m_allocator );
+        cfree( state.m_positions, state.m_allocator );
+    }
+
+    // Applies the sorted candidates that touch no vertex moved by a previous one. Returns the collapse count.
+    static u32 PerformCollapses( SimplifierState& state, u32 candidateCount, u32 triangleGoal, f32 costLimit ) {
+        memset( state.m_touched, 0, state.m_vertexCount );
+        u32 removedTriangles = 0;
+        u32 collapses = 0;
+        for ( u32 c = 0; c < candidateCount && removedTriangles < triangleGoal; ++c ) {
+            const CollapseCandidate& candidate = state.m_candidates[ c ];
+            if ( candidate.m_cost > costLimit ) {
+                break;
+            }
+            if ( state.m_touched[ candidate.m_from ] || state.m_touched[ candidate.m_to ] || CollapseFlips( state, candidate.m_from, candidate.m_to ) ) {
+                continue;
+            }
+
+            // The triangles around from change, so their vertices wait for the next pass.
+            for ( u32 t = state.m_offsets[ candidate.m_from ]; t < state.m_offsets[ candidate.m_from + 1 ]; ++t ) {
+                const u32* corners = state.m_indices + ( sizet )state.m_triangles[ t ] * 3;
+                state.m_touched[ corners[ 0 ] ] = state.m_touched[ corners[ 1 ] ] = state.m_touched[ corners[ 2 ] ] = 1;
+                removedTriangles += corners[ 0 ] == candidate.m_to || corners[ 1 ] == candidate.m_to || corners[ 2 ] == candidate.m_to;
+            }
+
+            state.m_remap[ candidate.m_from ] = candidate.m_to;
+            AddQuadric( state.m_quadrics[ candidate.m_to ], state.m_quadrics[ candidate.m_from ] );
+            state.m_error = std::max( state.m_error, candidate.m_cost );
+            ++collapses;
+        }
+        return collapses;
+    }
+
+    // Passes of independent collapses, cheapest first, until the target or the error limit is reached.
+    static void Simplify( SimplifierState& state, u32 targetIndexCount, f32 targetError ) {
+        const f32 errorLimit = targetError * targetError;
+
+        while ( state.m_indexCount > targetIndexCount ) {
+            BuildAdjacency( state );
+
+            // Every manifold edge is seen from the two triangles sharing it, once in each direction.
+            u32 candidateCount = 0;
+            for ( u32 i = 0; i < state.m_indexCount; ++i ) {
+                const u32 a = state.m_indices[ i ];
+                const u32 b = state.m_indices[ i - i % 3 + ( i + 1 ) % 3 ];
+                if ( a >= b || ( state.m_locked[ a ] && state.m_locked[ b ] ) ) {
+                    continue;
+                }
+
+                const f32 costAB = state.m_locked[ a ] ? 0.0f : CollapseCost( state, a, b );
+                const f32 costBA = state.m_locked[ b ] ? 0.0f : CollapseCost( state, b, a );
+                if ( state.m_locked[ b ] || ( !state.m_locked[ a ] && costAB <= costBA ) ) {
+                    state.m_candidates[ candidateCount++ ] = { a, b, costAB };
+                } else {
+                    state.m_candidates[ candidateCount++ ] = { b, a, costBA };
+                }
+            }
+            if ( candidateCount == 0 ) {
+                break;
+            }
+
+            std::sort( state.m_candidates, state.m_candidates + candidateCount, []( const CollapseCandidate& l, const CollapseCandidate& r ) {
+                return l.m_cost != r.m_cost ? l.m_cost < r.m_cost : l.m_from != r.m_from ? l.m_from < r.m_from : l.m_to < r.m_to;
+            } );
+
+            // A collapse removes two triangles of a manifold.
+            const u32 triangleGoal = ( state.m_indexCount - targetIndexCount ) / 3;
+            const u32 goalCandidate = std::min( ( triangleGoal + 1 ) / 2, candidateCount - 1 );
+            const f32 passLimit = std::min( errorLimit, state.m_candidates[ goalCandidate ].m_cost * k_pass_error_factor );
+
+            u32 collapses = PerformCollapses( state, candidateCount, triangleGoal, passLimit );
+            // The cheapest candidates may all flip, the rest of the error budget is then open.
+            if ( collapses == 0 && passLimit < errorLimit ) {
+                collapses = PerformCollapses( state, candidateCount, triangleGoal, errorLimit );
+            }
+            if ( collapses == 0 ) {
+                break;
+            }
+
+            // Collapsed vertices are never referenced again, their remap entries can stay.
+            u32 writeIndex = 0;
+            for ( u32 i = 0; i < state.m_indexCount; i += 3 ) {
+                const u32 a = state.m_remap[ state.m_indices[ i + 0 ] ];
+                const u32 b = state.m_remap[ state.m_indices[ i + 1 ] ];
+                const u32 c = state.m_remap[ state.m_indices[ i + 2 ] ];
+                if ( a == b || a == c || b == c ) {
+                    continue;
+                }
+                state.m_indices[ writeIndex++ ] = a;
+                state.m_indices[ writeIndex++ ] = b;
+                state.m_indices[ writeIndex++ ] = c;
+            }
+            state.m_indexCount = writeIndex;
+        }
+    }
+
+    u32 SimplifyMesh( u32* destination, const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount,
+                      const SimplifierAttribute* attributes, u32 attributeCount, u32 targetIndexCount, f32 targetError,
+                      Allocator* allocator, f32* resultError ) {
+        CASSERT( ( indexCount % 3 ) == 0 );
+
+        SimplifierState state;
+        InitializeSimplifier( state, indices, indexCount, positions, vertexCount, attributes, attributeCount, allocator );
+        Simplify( state, targetIndexCount, targetError );
+
+        const u32 resultCount = state.m_indexCount;
+        memcpy( destination, state.m_indices, resultCount * sizeof( u32 ) );
+        if ( resultError ) {
+            *resultError = sqrtf( state.m_error ) * state.m_extent;
+        }
+
+        ReleaseSimplifier( state );
+        return resultCount;
+    }
+
+    u32 GenerateMeshLods( const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount,
+                          const SimplifierAttribute* attributes, u32 attributeCount, Array(u32)& lodIndices, MeshLod* lods,
+                          Allocator* allocator, const MeshLodConfiguration& configuration ) {
+        CASSERT( ( indexCount % 3 ) == 0 );
+        const u32 maxLevels = std::min( std::max( configuration.m_maxLevels, 1u ), k_max_mesh_lods );
+
+        lods[ 0 ] = { ( u32 )lodIndices.size(), indexCount, 0.0f };
+        lodIndices.insert( lodIndices.end(), indices, indices + indexCount );
+
+        u32 levelCount = 1;
+        if ( maxLevels == 1 || indexCount / 3 <= configuration.m_minTriangles ) {
+            return levelCount;
+        }
+
+        SimplifierState state;
+        InitializeSimplifier( state, indices, indexCount, positions, vertexCount, attributes, attributeCount, allocator );
+
+        for ( ; levelCount < maxLevels; ++levelCount ) {
+            const u32 previousCount = lods[ levelCount - 1 ].m_indexCount;
+            const u32 targetTriangles = ( u32 )( previousCount / 3 * configuration.m_reduction );
+            if ( targetTriangles < configuration.m_minTriangles ) {
+                break;
+            }
+
+            Simplify( state, targetTriangles * 3, configuration.m_maxError );
+            if ( state.m_indexCount > previousCount * ( 1.0f - k_min_lod_reduction ) ) {
+                break;
+            }
+
+            lods[ levelCount ] = { ( u32 )lodIndices.size(), state.m_indexCount, sqrtf( state.m_error ) * state.m_extent };
+            lodIndices.insert( lodIndices.end(), state.m_indices, state.m_indices + state.m_indexCount );
+        }
+
+        ReleaseSimplifier( state );
+        return levelCount;
+    }
+
+    u32 SelectMeshLod( const MeshLod* lods, u32 lodCount, f32 pixelsPerUnit, f32 pixelThreshold ) {
+        u32 selected = 0;
+        for ( u32 level = 1; level < lodCount && lods[ level ].m_error * pixelsPerUnit <= pixelThreshold; ++level ) {
+            selected = level;
+        }
+        return selected;
+    }
+}
@@ -0,0 +1,431 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+export module Foundation.Meshlets;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Assert;
+
+export namespace Caustix {
+
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    // Limits fitting the mesh shader output of every vendor.
+    constexpr u32 k_meshlet_max_vertices    = 64;
+    constexpr u32 k_meshlet_max_triangles   = 124;
+
+    struct Meshlet {
+        u32                         m_vertexOffset;     // Into MeshletMesh::m_vertices.
+        u32                         m_triangleOffset;   // Into MeshletMesh::m_triangles, 3 local indices per triangle.
+        u32                         m_vertexCount;
+        u32                         m_triangleCount;
+    };
+
+    // Model space bounds. The cluster faces away from a camera at position p when
+    // dot( normalize( m_coneApex - p ), m_coneAxis ) >= m_coneCutoff, a cutoff of 1 never culls.
+    struct MeshletBounds {
+        f32                         m_center[ 3 ];
+        f32                         m_radius;
+        f32                         m_aabbMin[ 3 ];
+        f32                         m_aabbMax[ 3 ];
+        f32                         m_coneApex[ 3 ];
+        f32                         m_coneAxis[ 3 ];
+        f32                         m_coneCutoff;
+    };
+
+    // Meshlets of any number of primitives, BuildMeshlets appends to it.
+    struct MeshletMesh {
+        MeshletMesh( Allocator& allocator );
+
+        void                        Clear();
+
+        Array(Meshlet)              m_meshlets;
+        Array(MeshletBounds)        m_bounds;
+        Array(u32)                  m_vertices;         // Indices in the vertex buffer of the primitive.
+        Array(u8)                   m_triangles;
+    };
+
+    struct MeshletConfiguration {
+        u32                         m_maxVertices   = k_meshlet_max_vertices;
+        u32                         m_maxTriangles  = k_meshlet_max_triangles;
+    };
+
+    // Inward facing planes, dot( xyz, p ) + w >= 0 inside.
+    struct FrustumPlanes {
+        f32                         m_planes[ 6 ][ 4 ];
+    };
+
+    // Splits a triangle list in meshlets in index order, so cache optimized indices give compact clusters,
+    // and appends them with their bounds to output. positions are tightly packed vec3.
+    // The triangles are split in fixed chunks built in parallel and concatenated in order:
+    // the result is the same whatever the thread count. Returns the index of the first meshlet added.
+    u32     BuildMeshlets( const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount, MeshletMesh& output,
+                           JobSystem* jobSystem = nullptr, const MeshletConfiguration& configuration = {} );
+
+    // Planes of the frustum of a column major clip matrix, in the space the matrix transforms from:
+    // a model view projection matrix gives model space planes. Near uses the -w..w depth range, which also
+    // holds for 0..w projections.
+    void    ExtractFrustumPlanes( const f32* matrix, FrustumPlanes& planes );
+
+    // Reference culler: frustum test of the bounding spheres and normal cone backface test, in the space of the bounds.
+    // Writes the indices of the visible meshlets of [first, first + count) and returns how many there are.
+    u32     CullMeshlets( const MeshletMesh& mesh, u32 first, u32 count, const FrustumPlanes& planes, const f32* cameraPosition, u32* visible );
+}
+
+namespace Caustix {
+
+    // Triangles per chunk of the parallel build, meshlets never cross a chunk.
+    static constexpr u32 k_meshlet_chunk_triangles  = 16 * 1024;
+    // Cones wider than this are not worth testing.
+    static constexpr f32 k_meshlet_min_cone_dot     = 0.1f;
+    static constexpr u32 k_meshlet_bounds_grain     = 256;
+
+    MeshletMesh::MeshletMesh( Allocator& allocator )
+    : m_meshlets( allocator )
+    , m_bounds( allocator )
+    , m_vertices( allocator )
+    , m_triangles( allocator ) {
+    }
+
+    void MeshletMesh::Clear() {
+        m_meshlets.clear();
+        m_bounds.clear();
+        m_vertices.clear();
+        m_triangles.clear();
+    }
+
+    template <typename Func>
+    static void RunSplit( u32 count, u32 grainSize, JobSystem* jobSystem, Func&& func ) {
+        if ( jobSystem && count > grainSize ) {
+            jobSystem->ParallelFor( count, func, grainSize );
+        } else if ( count ) {
+            func( 0, count );
+        }
+    }
+
+    struct MeshletChunk {
+        u32                         m_meshlets      = 0;
+        u32                         m_vertices      = 0;
+        u32                         m_triangles     = 0;
+    };
+
+    // Output cursors of a chunk, null for the counting pass.
+    struct MeshletWriter {
+        Meshlet*                    m_meshlets;
+        u32*                        m_vertices;
+        u8*                         m_triangles;
+        u32                         m_vertexBase;
+        u32                         m_triangleBase;
+    };
+
+    static MeshletChunk BuildChunk( const u32* indices, u32 triangleBegin, u32 triangleEnd, const MeshletConfiguration& configuration, MeshletWriter* writer ) {
+        MeshletChunk chunk;
+        u32 local[ 256 ];
+        u32 vertexCount = 0;
+        u32 triangleCount = 0;
+
+        auto flush = [ & ]() {
+            if ( triangleCount == 0 ) {
+                return;
+            }
+            if ( writer ) {
+                writer->m_meshlets[ chunk.m_meshlets ] = { writer->m_vertexBase + chunk.m_vertices, writer->m_triangleBase + chunk.m_triangles * 3, vertexCount, triangleCount };
+                memcpy( writer->m_vertices + chunk.m_vertices, local, vertexCount * sizeof( u32 ) );
+            }
+            ++chunk.m_meshlets;
+            chunk.m_vertices += vertexCount;
+            chunk.m_triangles += triangleCount;
+            vertexCount = 0;
+            triangleCount = 0;
+        };
+
+        auto findLocal = [ & ]( u32 vertex ) -> u32 {
+            for ( u32 i = 0; i < vertexCount; ++i ) {
+                if ( local[ i ] == vertex ) {
+                    return i;
+                }
+            }
+            return ~0u;
+        };
+
+        for ( u32 triangle = triangleBegin; triangle < triangleEnd; ++triangle ) {
+            const u32* corners = indices + ( sizet )triangle * 3;
+
+            u32 slots[ 3 ];
+            u32 newVertices = 0;
+            for ( u32 c = 0; c < 3; ++c ) {
+                slots[ c ] = findLocal( corners[ c ] );
+                const bool repeated = ( c > 0 && corners[ c ] == corners[ 0 ] ) || ( c > 1 && corners[ c ] == corners[ 1 ] );
+                newVertices += !repeated && slots[ c ] == ~0u;
+            }
+            if ( vertexCount + newVertices > configuration.m_maxVertices || triangleCount + 1 > configuration.m_maxTriangles ) {
+                flush();
+                slots[ 0 ] = slots[ 1 ] = slots[ 2 ] = ~0u;
+            }
+
+            for ( u32 c = 0; c < 3; ++c ) {
+                if ( slots[ c ] == ~0u ) {
+                    // A corner repeating a vertex added by the previous corners of the triangle.
+                    slots[ c ] = c > 0 && corners[ c ] == corners[ 0 ] ? slots[ 0 ] : c > 1 && corners[ c ] == corners[ 1 ] ? slots[ 1 ] : ~0u;
+                }
+                if ( slots[ c ] == ~0u ) {
+                    slots[ c ] = vertexCount;
+                    local[ vertexCount++ ] = corners[ c ];
+                }
+                if ( writer ) {
+                    writer->m_triangles[ ( chunk.m_triangles + triangleCount ) * 3 + c ] = ( u8 )slots[ c ];
+                }
+            }
+            ++triangleCount;
+        }
+        flush();
+        return chunk;
+    }
+
+    static void Normalize( f32* v ) {
+        const f32 length = sqrtf( v[ 0 ] * v[ 0 ] + v[ 1 ] * v[ 1 ] + v[ 2 ] * v[ 2 ] );
+        if ( length > 0.0f ) {
+            v[ 0 ] /= length;
+            v[ 1 ] /= length;
+            v[ 2 ] /= length;
+        }
+    }
+
+    static f32 Distance( const f32* a, const f32* b ) {
+        const f32 x = a[ 0 ] - b[ 0 ], y = a[ 1 ] - b[ 1 ], z = a[ 2 ] - b[ 2 ];
+        return sqrtf( x * x + y * y + z * z );
+    }
+
+    static void ComputeMeshletBounds( const Meshlet& meshlet, const u32* vertices, const u8* triangles, const f32* positions, MeshletBounds& bounds ) {
+        const f32* first = positions + ( sizet )vertices[ meshlet.m_vertexOffset ] * 3;
+
+        // Bounding sphere: the most distant pair of axis extremes, grown to contain every vertex.
+        u32 extremes[ 6 ];
+        for ( u32 axis = 0; axis < 3; ++axis ) {
+            extremes[ axis * 2 ] = extremes[ axis * 2 + 1 ] = vertices[ meshlet.m_vertexOffset ];
+            bounds.m_aabbMin[ axis ] = bounds.m_aabbMax[ axis ] = first[ axis ];
+        }
+        for ( u32 i = 0; i < meshlet.m_vertexCount; ++i ) {
+            const u32 vertex = vertices[ meshlet.m_vertexOffset + i ];
+            const f32* p = positions + ( sizet )vertex * 3;
+            for ( u32 axis = 0; axis < 3; ++axis ) {
+                if ( p[ axis ] < bounds.m_aabbMin[ axis ] ) {
+                    bounds.m_aabbMin[ axis ] = p[ axis ];
+                    extremes[ axis * 2 ] = vertex;
+                }
+                if ( p[ axis ] > bounds.m_aabbMax[ axis ] ) {
+                    bounds.m_aabbMax[ axis ] = p[ axis ];
+                    extremes[ axis * 2 + 1 ] = vertex;
+                }
+            }
+        }
+
+        u32 widestAxis = 0;
+        f32 widest = -1.0f;
+        for ( u32 axis = 0; axis < 3; ++axis ) {
+            const f32 distance = Distance( positions + ( sizet )extremes[ axis * 2 ] * 3, positions + ( sizet )extremes[ axis * 2 + 1 ] * 3 );
+            if ( distance > widest ) {
+                widest = distance;
+                widestAxis = axis;
+            }
+        }
+
+        const f32* pMin = positions + ( sizet )extremes[ widestAxis * 2 ] * 3;
+        const f32* pMax = positions + ( sizet )extremes[ widestAxis * 2 + 1 ] * 3;
+        for ( u32 k = 0; k < 3; ++k ) {
+            bounds.m_center[ k ] = ( pMin[ k ] + pMax[ k ] ) * 0.5f;
+        }
+        bounds.m_radius = widest * 0.5f;
+
+        for ( u32 i = 0; i < meshlet.m_vertexCount; ++i ) {
+            const f32* p = positions + ( sizet )vertices[ meshlet.m_vertexOffset + i ] * 3;
+            const f32 distance = Distance( p, bounds.m_center );
+            if ( distance > bounds.m_radius ) {
+                // Move the center towards p just enough to reach it, keeping the opposite side in.
+                const f32 radius = ( bounds.m_radius + distance ) * 0.5f;
+                const f32 shift = ( radius - bounds.m_radius ) / distance;
+                for ( u32 k = 0; k < 3; ++k ) {
+                    bounds.m_center[ k ] += ( p[ k ] - bounds.m_center[ k ] ) * shift;
+                }
+                bounds.m_radius = radius;
+            }
+        }
+
+        // Normal cone: average of the triangle normals, opened to the widest of them.
+        f32 normals[ k_meshlet_max_triangles * 2 ][ 3 ];
+        const u32 triangleCount = std::min( meshlet.m_triangleCount, ( u32 )( sizeof( normals ) / sizeof( normals[ 0 ] ) ) );
+        f32 axis[ 3 ] = { 0.0f, 0.0f, 0.0f };
+        u32 validTriangles = 0;
+        for ( u32 t = 0; t < triangleCount; ++t ) {
+            const u8* corners = triangles + meshlet.m_triangleOffset + t * 3;
+            const f32* p0 = positions + ( sizet )vertices[ meshlet.m_vertexOffset + corners[ 0 ] ] * 3;
+            const f32* p1 = positions + ( sizet )vertices[ meshlet.m_vertexOffset + corners[ 1 ] ] * 3;
+            const f32* p2 = positions + ( sizet )vertices[ meshlet.m_vertexOffset + corners[ 2 ] ] * 3;
+
+            const f32 ax = p1[ 0 ] - p0[ 0 ], ay = p1[ 1 ] - p0[ 1 ], az = p1[ 2 ] - p0[ 2 ];
+            const f32 bx = p2[ 0 ] - p0[ 0 ], by = p2[ 1 ] - p0[ 1 ], bz = p2[ 2 ] - p0[ 2 ];
+            f32* normal = normals[ validTriangles ];
+            normal[ 0 ] = ay * bz - az * by;
+            normal[ 1 ] = az * bx - ax * bz;
+            normal[ 2 ] = ax * by - ay * bx;
+
+            if ( normal[ 0 ] == 0.0f && normal[ 1 ] == 0.0f && normal[ 2 ] == 0.0f ) {
+                continue;
+            }
+            Normalize( normal );
+            axis[ 0 ] += normal[ 0 ];
+            axis[ 1 ] += normal[ 1 ];
+            axis[ 2 ] += normal[ 2 ];
+            ++validTriangles;
+        }
+        Normalize( axis );
+
+        f32 minDot = 1.0f;
+        for ( u32 t = 0; t < validTriangles; ++t ) {
+            minDot = std::min( minDot, normals[ t ][ 0 ] * axis[ 0 ] + normals[ t ][ 1 ] * axis[ 1 ] + normals[ t ][ 2 ] * axis[ 2 ] );
+        }
+
+        memcpy( bounds.m_coneAxis, axis, sizeof( axis ) );
+        memcpy( bounds.m_coneApex, bounds.m_center, sizeof( bounds.m_center ) );
+        bounds.m_coneCutoff = 1.0f;
+        if ( validTriangles == 0 || minDot <= k_meshlet_min_cone_dot ) {
+            return;
+        }
+
+        // The apex goes back along the axis until every triangle plane is in front of it.
+        f32 maxT = 0.0f;
+        u32 normalIndex = 0;
+        for ( u32 t = 0; t < triangleCount; ++t ) {
+            const u8* corners = triangles + meshlet.m_triangleOffset + t * 3;
+            const f32* p0 = positions + ( sizet )vertices[ meshlet.m_vertexOffset + corners[ 0 ] ] * 3;
+            const f32* p1 = positions + ( sizet )vertices[ meshlet.m_vertexOffset + corners[ 1 ] ] * 3;
+            const f32* p2 = positions + ( sizet )vertices[ meshlet.m_vertexOffset + corners[ 2 ] ] * 3;
+            const f32 ax = p1[ 0 ] - p0[ 0 ], ay = p1[ 1 ] - p0[ 1 ], az = p1[ 2 ] - p0[ 2 ];
+            const f32 bx = p2[ 0 ] - p0[ 0 ], by = p2[ 1 ] - p0[ 1 ], bz = p2[ 2 ] - p0[ 2 ];
+            if ( ay * bz - az * by == 0.0f && az * bx - ax * bz == 0.0f && ax * by - ay * bx == 0.0f ) {
+                continue;
+            }
+
+            const f32* normal = normals[ normalIndex++ ];
+            const f32 dc = ( bounds.m_center[ 0 ] - p0[ 0 ] ) * normal[ 0 ] + ( bounds.m_center[ 1 ] - p0[ 1 ] ) * normal[ 1 ] + ( bounds.m_center[ 2 ] - p0[ 2 ] ) * normal[ 2 ];
+            const f32 dn = axis[ 0 ] * normal[ 0 ] + axis[ 1 ] * normal[ 1 ] + axis[ 2 ] * normal[ 2 ];
+            maxT = std::max( maxT, dc / dn );
+        }
+
+        for ( u32 k = 0; k < 3; ++k ) {
+            bounds.m_coneApex[ k ] = bounds.m_center[ k ] - axis[ k ] * maxT;
+        }
+        // The normal cone is opened by 90 degrees on both sides and inverted: cos( a + 90 ) negated is sin( a ).
+        bounds.m_coneCutoff = sqrtf( 1.0f - minDot * minDot );
+    }
+
+    u32 BuildMeshlets( const u32* indices, u32 indexCount, const f32* positions, u32 vertexCount, MeshletMesh& output,
+                       JobSystem* jobSystem, const MeshletConfiguration& configuration ) {
+        CASSERT( configuration.m_maxVertices >= 3 && configuration.m_maxVertices <= 256 );
+        CASSERT( configuration.m_maxTriangles >= 1 && configuration.m_maxTriangles <= k_meshlet_max_triangles * 2 );
+
+        const u32 firstMeshlet = ( u32 )output.m_meshlets.size();
+        const u32 triangleCount = indexCount / 3;
+        if ( triangleCount == 0 ) {
+            return firstMeshlet;
+        }
+
+        const u32 chunkCount = ( triangleCount + k_meshlet_chunk_triangles - 1 ) / k_meshlet_chunk_triangles;
+        Array(MeshletChunk) chunks( output.m_meshlets.get_allocator() );
+        chunks.resize( chunkCount + 1 );
+
+        // Counting pass, then the chunks write at the prefix sums of the counts.
+        RunSplit( chunkCount, 1, jobSystem, [ & ]( u32 begin, u32 end ) {
+            for ( u32 c = begin; c < end; ++c ) {
+                chunks[ c + 1 ] = BuildChunk( indices, c * k_meshlet_chunk_triangles, std::min( ( c + 1 ) * k_meshlet_chunk_triangles, triangleCount ), configuration, nullptr );
+            }
+        } );
+
+        chunks[ 0 ] = { firstMeshlet, ( u32 )output.m_vertices.size(), ( u32 )output.m_triangles.size() / 3 };
+        for ( u32 c = 1; c <= chunkCount; ++c ) {
+            chunks[ c ].m_meshlets += chunks[ c - 1 ].m_meshlets;
+            chunks[ c ].m_vertices += chunks[ c - 1 ].m_vertices;
+            chunks[ c ].m_triangles += chunks[ c - 1 ].m_triangles;
+        }
+
+        output.m_meshlets.resize( chunks[ chunkCount ].m_meshlets );
+        output.m_bounds.resize( chunks[ chunkCount ].m_meshlets );
+        output.m_vertices.resize( chunks[ chunkCount ].m_vertices );
+        output.m_triangles.resize( ( sizet )chunks[ chunkCount ].m_triangles * 3 );
+
+        RunSplit( chunkCount, 1, jobSystem, [ & ]( u32 begin, u32 end ) {
+            for ( u32 c = begin; c < end; ++c ) {
+                const MeshletChunk& start = chunks[ c ];
+                MeshletWriter writer{ output.m_meshlets.data() + start.m_meshlets, output.m_vertices.data() + start.m_vertices,
+                                      output.m_triangles.data() + ( sizet )start.m_triangles * 3, start.m_vertices, start.m_triangles * 3 };
+                BuildChunk( indices, c * k_meshlet_chunk_triangles, std::min( ( c + 1 ) * k_meshlet_chunk_triangles, triangleCount ), configuration, &writer );
+            }
+        } );
+
+        const u32 meshletCount = chunks[ chunkCount ].m_meshlets - firstMeshlet;
+        RunSplit( meshletCount, k_meshlet_bounds_grain, jobSystem, [ & ]( u32 begin, u32 end ) {
+            for ( u32 m = firstMeshlet + begin; m < firstMeshlet + end; ++m ) {
+                ComputeMeshletBounds( output.m_meshlets[ m ], output.m_vertices.data(), output.m_triangles.data(), positions, output.m_bounds[ m ] );
+            }
+        } );
+
+        return firstMeshlet;
+    }
+
+    void ExtractFrustumPlanes( const f32* matrix, FrustumPlanes& planes ) {
+        // Row i of a column major matrix.
+        auto row = [ matrix ]( u32 i, u32 column ) { return matrix[ column * 4 + i ]; };
+
+        for ( u32 column = 0; column < 4; ++column ) {
+            planes.m_planes[ 0 ][ column ] = row( 3, column ) + row( 0, column );    // Left
+            planes.m_planes[ 1 ][ column ] = row( 3, column ) - row( 0, column );    // Right
+            planes.m_planes[ 2 ][ column ] = row( 3, column ) + row( 1, column );    // Bottom
+            planes.m_planes[ 3 ][ column ] = row( 3, column ) - row( 1, column );    // Top
+            planes.m_planes[ 4 ][ column ] = row( 3, column ) + row( 2, column );    // Near
+            planes.m_planes[ 5 ][ column ] = row( 3, column ) - row( 2, column );    // Far
+        }
+
+        for ( f32* plane : planes.m_planes ) {
+            const f32 length = sqrtf( plane[ 0 ] * plane[ 0 ] + plane[ 1 ] * plane[ 1 ] + plane[ 2 ] * plane[ 2 ] );
+            if ( length > 0.0f ) {
+                for ( u32 k = 0; k < 4; ++k ) {
+                    plane[ k ] /= length;
+                }
+            }
+        }
+    }
+
+    u32 CullMeshlets( const MeshletMesh& mesh, u32 first, u32 count, const FrustumPlanes& planes, const f32* cameraPosition, u32* visible ) {
+        u32 visibleCount = 0;
+        for ( u32 m = first; m < first + count; ++m ) {
+            const MeshletBounds& bounds = mesh.m_bounds[ m ];
+
+            bool inside = true;
+            for ( const f32* plane : planes.m_planes ) {
+                if ( plane[ 0 ] * bounds.m_center[ 0 ] + plane[ 1 ] * bounds.m_center[ 1 ] + plane[ 2 ] * bounds.m_center[ 2 ] + plane[ 3 ] < -bounds.m_radius ) {
+                    inside = false;
+                    break;
+                }
+            }
+            if ( !inside ) {
+                continue;
+            }
+
+            f32 view[ 3 ] = { bounds.m_coneApex[ 0 ] - cameraPosition[ 0 ], bounds.m_coneApex[ 1 ] - cameraPosition[ 1 ], bounds.m_coneApex[ 2 ] - cameraPosition[ 2 ] };
+            Normalize( view );
+            if ( view[ 0 ] * bounds.m_coneAxis[ 0 ] + view[ 1 ] * bounds.m_coneAxis[ 1 ] + view[ 2 ] * bounds.m_coneAxis[ 2 ] >= bounds.m_coneCutoff ) {
+                continue;
+            }
+
+            visible[ visibleCount++ ] = m;
+        }
+        return visibleCount;
+    }
+}
@@ -1,11 +1,11 @@
 module;
 
-#include <unordered_map>
 
 export module Foundation.ResourceManager;
 
 import Foundation.Memory.Allocators.Allocator;
 import Foundation.Platform;
+import Foundation.FlatHashMap;
 import Foundation.Assert;
 
 export namespace Caustix {
@@ -36,8 +36,6 @@ export namespace Caustix {
         virtual cstring GetBinaryPathFromName( cstring name ) = 0;
     };
 
-    #define FlatHashMap(key, value) std::unordered_map<key, value, std::hash<key>, std::equal_to<key>, STLAdaptor<std::pair<const key, value>>>
-
     struct ResourceManager {
         ResourceManager( Allocator* allocator, ResourceFilenameResolver* resolver );
         ~ResourceManager();
@@ -57,8 +55,8 @@ export namespace Caustix {
         void            SetLoader( cstring resourceType, ResourceLoader* loader );
         void            SetCompiler( cstring resourceType, ResourceCompiler* compiler );
 
-        FlatHashMap(u64, ResourceLoader*)       m_loaders;
-        FlatHashMap(u64, ResourceCompiler*)     m_compilers;
+        FlatHashMap<u64, ResourceLoader*>       m_loaders;
+        FlatHashMap<u64, ResourceCompiler*>     m_compilers;
 
         Allocator*      m_allocator;
         ResourceFilenameResolver* m_filenameResolver;
@@ -0,0 +1,248 @@
+module;
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CAUSTIX_SCENE_GRAPH_SSE2
+#endif
+
+export module Foundation.SceneGraph;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Platform;
+import Foundation.Assert;
+
+export namespace Caustix {
+
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    constexpr u32 k_scene_graph_root = u32_max;
+
+    // Column major node transforms as structures of arrays in depth first order: parents come before their children
+    // and every subtree is a contiguous range, so a changed node only recomputes the range of its subtree.
+    // Nodes are addressed by the indices given to Build.
+    struct SceneGraph {
+        SceneGraph( Allocator& allocator );
+
+        // parents[ node ] is k_scene_graph_root for roots, localMatrices holds 16 floats per node. Computes every world matrix.
+        void                        Build( const u32* parents, const f32* localMatrices, u32 nodeCount );
+        void                        Clear();
+
+        void                        SetLocalMatrix( u32 node, const f32* matrix );
+        const f32*                  GetLocalMatrix( u32 node ) const;
+        const f32*                  GetWorldMatrix( u32 node ) const;
+        u32                         GetParent( u32 node ) const;
+
+        // World matrices of the nodes changed since the last update and of their descendants.
+        // Returns how many were computed, 0 when nothing changed. The subtrees computed are left in m_updatedRanges.
+        u32                         Update();
+
+        u32                         m_nodeCount     = 0;
+
+        // Indexed by depth first order.
+        Array(u32)                  m_parents;          // Order of the parent, k_scene_graph_root for roots.
+        Array(u32)                  m_subtreeSizes;     // Including the node itself.
+        Array(f32)                  m_localMatrices;
+        Array(f32)                  m_worldMatrices;
+        Array(u8)                   m_dirty;
+        Array(u32)                  m_nodes;
+
+        Array(u32)                  m_orders;           // Indexed by node.
+        Array(u32)                  m_dirtyOrders;
+        Array(u32)                  m_updatedRanges;    // First and end depth first order of every subtree of the last update.
+    };
+}
+
+namespace Caustix {
+
+    static constexpr u32 k_matrix_floats = 16;
+
+    // result = a * b, column major. result must not alias the inputs.
+    static void MultiplyMatrices( const f32* a, const f32* b, f32* result ) {
+#if defined( CAUSTIX_SCENE_GRAPH_SSE2 )
+        const __m128 a0 = _mm_loadu_ps( a + 0 );
+        const __m128 a1 = _mm_loadu_ps( a + 4 );
+        const __m128 a2 = _mm_loadu_ps( a + 8 );
+        const __m128 a3 = _mm_loadu_ps( a + 12 );
+
+        for ( u32 column = 0; column < 4; ++column ) {
+            const f32* bColumn = b + column * 4;
+            __m128 r = _mm_mul_ps( a0, _mm_set1_ps( bColumn[ 0 ] ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a1, _mm_set1_ps( bColumn[ 1 ] ) ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a2, _mm_set1_ps( bColumn[ 2 ] ) ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a3, _mm_set1_ps( bColumn[ 3 ] ) ) );
+            _mm_storeu_ps( result + column * 4, r );
+        }
+#else
+        for ( u32 column = 0; column < 4; ++column ) {
+            for ( u32 row = 0; row < 4; ++row ) {
+                result[ column * 4 + row ] = a[ row ] * b[ column * 4 + 0 ] + a[ 4 + row ] * b[ column * 4 + 1 ]
+                                           + a[ 8 + row ] * b[ column * 4 + 2 ] + a[ 12 + row ] * b[ column * 4 + 3 ];
+            }
+        }
+#endif // CAUSTIX_SCENE_GRAPH_SSE2
+    }
+
+    SceneGraph::SceneGraph( Allocator& allocator )
+    : m_parents( allocator )
+    , m_subtreeSizes( allocator )
+    , m_localMatrices( allocator )
+    , m_worldMatrices( allocator )
+    , m_dirty( allocator )
+    , m_nodes( allocator )
+    , m_orders( allocator )
+    , m_dirtyOrders( allocator )
+    , m_updatedRanges( allocator ) {
+    }
+
+    void SceneGraph::Build( const u32* parents, const f32* localMatrices, u32 nodeCount ) {
+        Clear();
+        m_nodeCount = nodeCount;
+
+        m_parents.resize( nodeCount );
+        m_subtreeSizes.resize( nodeCount );
+        m_localMatrices.resize( ( sizet )nodeCount * k_matrix_floats );
+        m_worldMatrices.resize( ( sizet )nodeCount * k_matrix_floats );
+        m_dirty.assign( nodeCount, 0 );
+        m_nodes.resize( nodeCount );
+        m_orders.assign( nodeCount, k_scene_graph_root );
+
+        // Children of every node, in node order.
+        Array(u32) childOffsets( nodeCount + 1, 0, m_parents.get_allocator() );
+        Array(u32) children( nodeCount, 0, m_parents.get_allocator() );
+        for ( u32 node = 0; node < nodeCount; ++node ) {
+            if ( parents[ node ] != k_scene_graph_root ) {
+                CASSERT( parents[ node ] < nodeCount );
+                ++childOffsets[ parents[ node ] + 1 ];
+            }
+        }
+        for ( u32 node = 0; node < nodeCount; ++node ) {
+            childOffsets[ node + 1 ] += childOffsets[ node ];
+        }
+        Array(u32) cursors( childOffsets.begin(), childOffsets.end() - 1, m_parents.get_allocator() );
+        for ( u32 node = 0; node < nodeCount; ++node ) {
+            if ( parents[ node ] != k_scene_graph_root ) {
+                children[ cursors[ parents[ node ] ]++ ] = node;
+            }
+        }
+
+        // Depth first from every root, children pushed in reverse to be visited in order.
+        Array(u32) stack( m_parents.get_allocator() );
+        u32 order = 0;
+        for ( u32 root = 0; root < nodeCount; ++root ) {
+            if ( parents[ root ] != k_scene_graph_root ) {
+                continue;
+            }
+
+            stack.push_back( root );
+            while ( !stack.empty() ) {
+                const u32 node = stack.back();
+                stack.pop_back();
+
+                m_orders[ node ] = order;
+                m_nodes[ order ] = node;
+                m_parents[ order ] = parents[ node ] == k_scene_graph_root ? k_scene_graph_root : m_orders[ parents[ node ] ];
+                m_subtreeSizes[ order ] = 1;
+                memcpy( &m_localMatrices[ ( sizet )order * k_matrix_floats ], localMatrices + ( sizet )node * k_matrix_floats, k_matrix_floats * sizeof( f32 ) );
+                ++order;
+
+                for ( u32 child = childOffsets[ node + 1 ]; child > childOffsets[ node ]; --child ) {
+                    stack.push_back( children[ child - 1 ] );
+                }
+            }
+        }
+        // Nodes left out are part of a parent cycle.
+        CASSERT( order == nodeCount );
+
+        for ( u32 i = nodeCount; i > 0; --i ) {
+            if ( m_parents[ i - 1 ] != k_scene_graph_root ) {
+                m_subtreeSizes[ m_parents[ i - 1 ] ] += m_subtreeSizes[ i - 1 ];
+            }
+        }
+
+        // Every root subtree is dirty.
+        for ( u32 i = 0; i < nodeCount; i += m_subtreeSizes[ i ] ) {
+            m_dirty[ i ] = 1;
+            m_dirtyOrders.push_back( i );
+        }
+        Update();
+    }
+
+    void SceneGraph::Clear() {
+        m_nodeCount = 0;
+        m_parents.clear();
+        m_subtreeSizes.clear();
+        m_localMatrices.clear();
+        m_worldMatrices.clear();
+        m_dirty.clear();
+        m_nodes.clear();
+        m_orders.clear();
+        m_dirtyOrders.clear();
+        m_updatedRanges.clear();
+    }
+
+    void SceneGraph::SetLocalMatrix( u32 node, const f32* matrix ) {
+        const u32 order = m_orders[ node ];
+        memcpy( &m_localMatrices[ ( sizet )order * k_matrix_floats ], matrix, k_matrix_floats * sizeof( f32 ) );
+
+        if ( !m_dirty[ order ] ) {
+            m_dirty[ order ] = 1;
+            m_dirtyOrders.push_back( order );
+        }
+    }
+
+    const f32* SceneGraph::GetLocalMatrix( u32 node ) const {
+        return &m_localMatrices[ ( sizet )m_orders[ node ] * k_matrix_floats ];
+    }
+
+    const f32* SceneGraph::GetWorldMatrix( u32 node ) const {
+        return &m_worldMatrices[ ( sizet )m_orders[ node ] * k_matrix_floats ];
+    }
+
+    u32 SceneGraph::GetParent( u32 node ) const {
+        const u32 parent = m_parents[ m_orders[ node ] ];
+        return parent == k_scene_graph_root ? k_scene_graph_root : m_nodes[ parent ];
+    }
+
+    u32 SceneGraph::Update() {
+        m_updatedRanges.clear();
+        if ( m_dirtyOrders.empty() ) {
+            return 0;
+        }
+
+        // In order, a dirty node inside the subtree of a previous one is already covered.
+        std::sort( m_dirtyOrders.begin(), m_dirtyOrders.end() );
+
+        u32 updated = 0;
+        u32 coveredEnd = 0;
+        for ( const u32 dirtyOrder : m_dirtyOrders ) {
+            m_dirty[ dirtyOrder ] = 0;
+            if ( dirtyOrder < coveredEnd ) {
+                continue;
+            }
+
+            coveredEnd = dirtyOrder + m_subtreeSizes[ dirtyOrder ];
+            m_updatedRanges.push_back( dirtyOrder );
+            m_updatedRanges.push_back( coveredEnd );
+            for ( u32 order = dirtyOrder; order < coveredEnd; ++order ) {
+                const f32* local = &m_localMatrices[ ( sizet )order * k_matrix_floats ];
+                f32* world = &m_worldMatrices[ ( sizet )order * k_matrix_floats ];
+                const u32 parent = m_parents[ order ];
+
+                if ( parent == k_scene_graph_root ) {
+                    memcpy( world, local, k_matrix_floats * sizeof( f32 ) );
+                } else {
+                    MultiplyMatrices( &m_worldMatrices[ ( sizet )parent * k_matrix_floats ], local, world );
+                }
+            }
+            updated += coveredEnd - dirtyOrder;
+        }
+
+        m_dirtyOrders.clear();
+        return updated;
+    }
+}
@@ -0,0 +1,445 @@
+module;
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(CAUSTIX_IO_URING)
+#include <liburing.h>
+#endif
+
+export module Foundation.Services.IoService;
+
+import Foundation.Services.Service;
+import Foundation.Platform;
+import Foundation.Assert;
+import Foundation.Log;
+
+export namespace Caustix {
+    static constexpr u32 k_max_io_threads = 16;
+
+    // IoRequest::m_error values besides the OS error codes.
+    static constexpr i32 k_io_error_open        = -1;
+    static constexpr i32 k_io_error_end_of_file = -2;   // The file ended before m_size bytes were read.
+
+    enum class IoStatus : u32 {
+        Idle,
+        Pending,
+        Completed,
+        Failed
+    };
+
+    struct IoRequest;
+    // Called on the thread calling IoService::Update, once the request is completed or failed.
+    using IoCallback = void ( * )( IoRequest& request );
+
+    // A read of [m_offset, m_offset + m_size) of a file into m_destination.
+    // The request must stay alive until its status is not pending anymore, and with a callback until the callback has run:
+    // a request submitted again before that would be called back with the status of the new read.
+    struct IoRequest {
+        cstring                         m_path          = nullptr;
+        u64                             m_offset        = 0;
+        u64                             m_size          = 0;
+        void*                           m_destination   = nullptr;
+
+        IoCallback                      m_callback      = nullptr;
+        void*                           m_userData      = nullptr;
+
+        // Results
+        std::atomic<IoStatus>           m_status        { IoStatus::Idle };
+        u64                             m_bytesRead     = 0;
+        i32                             m_error         = 0;
+
+        // Internal
+        i64                             m_file          = -1;
+
+        bool                            IsDone() const  { const IoStatus status = m_status.load( std::memory_order_acquire ); return status == IoStatus::Completed || status == IoStatus::Failed; }
+    };
+
+    struct IoServiceConfiguration {
+        u32                             m_threadCount   = 4;        // Threads of the fallback path, reads block inside them.
+        u32                             m_queueDepth    = 256;      // io_uring submission queue entries.
+        bool                            m_useIoUring    = true;     // Only when built with CAUSTIX_IO_URING.
+    };
+
+    // Asynchronous file reads.
+    // Requests are submitted in batches through io_uring when available, otherwise they are executed
+    // by a small pool of threads doing blocking reads. Completion can be polled on the request or
+    // delivered through its callback from Update, so callbacks run on a thread chosen by the user.
+    struct IoService : public Service {
+        IoService() = delete;
+        explicit IoService( const IoServiceConfiguration& configuration );
+        ~IoService();
+
+        void                            Shutdown();
+
+        void                            Submit( IoRequest* requests, u32 count );
+        void                            Wait( IoRequest* requests, u32 count );
+
+        // Delivers completion callbacks, returns the number of callbacks called.
+        u32                             Update();
+
+        // Internals
+        void                            Complete( IoRequest* request, u64 bytesRead, i32 error );
+        void                            ExecuteBlocking( IoRequest* request );
+        void                            WorkerLoop();
+
+#if defined(CAUSTIX_IO_URING)
+        bool                            SubmitRing( IoRequest* request );
+        void                            CompletionLoop();
+
+        io_uring                        m_ring;
+        std::mutex                      m_ringMutex;
+        std::thread                     m_completionThread;
+#endif // CAUSTIX_IO_URING
+        bool                            m_ringEnabled   = false;
+
+        std::thread                     m_threads[ k_max_io_threads ];
+        u32                             m_threadCount   = 0;
+
+        std::vector<IoRequest*>         m_pending;
+        std::mutex                      m_pendingMutex;
+        std::condition_variable         m_pendingCondition;
+
+        std::vector<IoRequest*>         m_completed;
+        std::vector<IoRequest*>         m_completedSwap;
+        std::mutex                      m_completedMutex;
+
+        std::atomic<bool>               m_quit          { false };
+
+        static IoService*               Create( const IoServiceConfiguration& configuration ) {
+            static std::unique_ptr<IoService> instance{ new IoService( configuration ) };
+            return instance.get();
+        }
+
+        static constexpr cstring        m_name = "caustix_io_service";
+    };
+}
+
+namespace Caustix {
+    // Largest single read, io_uring takes 32 bit lengths and Linux never reads more than 2 GiB at once.
+    static constexpr u64 k_io_max_read_size = 0x40000000ull;
+
+    static i64 IoOpen( cstring path ) {
+#if defined(_MSC_VER)
+        HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+        return file == INVALID_HANDLE_VALUE ? -1 : ( i64 )file;
+#else
+        return open( path, O_RDONLY );
+#endif // _MSC_VER
+    }
+
+    static void IoClose( i64 file ) {
+#if defined(_MSC_VER)
+        CloseHandle( ( HANDLE )file );
+#else
+        close( ( i32 )file );
+#endif // _MSC_VER
+    }
+
+    IoService::IoService( const IoServiceConfiguration& configuration ) {
+        m_pending.reserve( 256 );
+        m_completed.reserve( 256 );
+        m_completedSwap.reserve( 256 );
+
+#if defined(CAUSTIX_IO_URING)
+        if ( configuration.m_useIoUring ) {
+            const i32 result = io_uring_queue_init( configuration.m_queueDepth, &m_ring, 0 );
+            if ( result == 0 ) {
+                m_ringEnabled = true;
+                m_completionThread = std::thread( &IoService::CompletionLoop, this );
+            } else {
+                // Old kernels or sandboxes without io_uring, use the threads.
+                error( "IoService: io_uring unavailable ({}), falling back to threads", -result );
+            }
+        }
+#endif // CAUSTIX_IO_URING
+
+        // Threads are also used by io_uring mode for the requests the ring refuses.
+        m_threadCount = configuration.m_threadCount < k_max_io_threads ? configuration.m_threadCount : k_max_io_threads;
+        m_threadCount = m_threadCount ? m_threadCount : 1;
+        for ( u32 i = 0; i < m_threadCount; ++i ) {
+            m_threads[ i ] = std::thread( &IoService::WorkerLoop, this );
+        }
+
+        info( "IoService created, io_uring {}, {} threads", m_ringEnabled ? "enabled" : "disabled", m_threadCount );
+    }
+
+    IoService::~IoService() {
+        Shutdown();
+    }
+
+    void IoService::Shutdown() {
+        if ( m_quit.exchange( true ) ) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_pendingMutex );
+        }
+        m_pendingCondition.notify_all();
+        for ( u32 i = 0; i < m_threadCount; ++i ) {
+            m_threads[ i ].join();
+        }
+
+#if defined(CAUSTIX_IO_URING)
+        if ( m_ringEnabled ) {
+            {
+                // A nop with no request wakes up the completion thread.
+                std::lock_guard<std::mutex> lock( m_ringMutex );
+                io_uring_sqe* sqe = io_uring_get_sqe( &m_ring );
+                io_uring_prep_nop( sqe );
+                io_uring_sqe_set_data( sqe, nullptr );
+                io_uring_submit( &m_ring );
+            }
+            m_completionThread.join();
+            io_uring_queue_exit( &m_ring );
+        }
+#endif // CAUSTIX_IO_URING
+    }
+
+    void IoService::Submit( IoRequest* requests, u32 count ) {
+        for ( u32 i = 0; i < count; ++i ) {
+            IoRequest& request = requests[ i ];
+            request.m_bytesRead = 0;
+            request.m_error = 0;
+            request.m_file = -1;
+            request.m_status.store( IoStatus::Pending, std::memory_order_relaxed );
+        }
+
+#if defined(CAUSTIX_IO_URING)
+        if ( m_ringEnabled ) {
+            u32 submitted = 0;
+            {
+                std::lock_guard<std::mutex> lock( m_ringMutex );
+                for ( ; submitted < count; ++submitted ) {
+                    if ( !SubmitRing( &requests[ submitted ] ) ) {
+                        break;
+                    }
+                }
+                // One syscall for the whole batch.
+                io_uring_submit( &m_ring );
+            }
+            requests += submitted;
+            count -= submitted;
+        }
+#endif // CAUSTIX_IO_URING
+
+        if ( count == 0 ) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_pendingMutex );
+            for ( u32 i = 0; i < count; ++i ) {
+                m_pending.push_back( &requests[ i ] );
+            }
+        }
+        m_pendingCondition.notify_all();
+    }
+
+    void IoService::Wait( IoRequest* requests, u32 count ) {
+        for ( u32 i = 0; i < count; ++i ) {
+            while ( !requests[ i ].IsDone() ) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    u32 IoService::Update() {
+        {
+            std::lock_guard<std::mutex> lock( m_completedMutex );
+            m_completedSwap.swap( m_completed );
+        }
+
+        for ( IoRequest* request : m_completedSwap ) {
+            request->m_callback( *request );
+        }
+
+        const u32 delivered = ( u32 )m_completedSwap.size();
+        m_completedSwap.clear();
+        return delivered;
+    }
+
+    void IoService::Complete( IoRequest* request, u64 bytesRead, i32 error ) {
+        if ( request->m_file >= 0 ) {
+            IoClose( request->m_file );
+            request->m_file = -1;
+        }
+
+        request->m_bytesRead = bytesRead;
+        request->m_error = error;
+
+        const IoStatus status = error == 0 ? IoStatus::Completed : IoStatus::Failed;
+        if ( request->m_callback == nullptr ) {
+            request->m_status.store( status, std::memory_order_release );
+            return;
+        }
+
+        // Published inside the lock, so Update never calls back a request whose status still reads pending.
+        std::lock_guard<std::mutex> lock( m_completedMutex );
+        request->m_status.store( status, std::memory_order_release );
+        m_completed.push_back( request );
+    }
+
+    void IoService::ExecuteBlocking( IoRequest* request ) {
+        if ( request->m_file >= 0 ) {
+            IoClose( request->m_file );
+            request->m_file = -1;
+        }
+
+        const i64 file = IoOpen( request->m_path );
+        if ( file < 0 ) {
+            error( "IoService: cannot open {}", request->m_path );
+            Complete( request, 0, k_io_error_open );
+            return;
+        }
+        request->m_file = file;
+
+        u64 bytes_read = 0;
+        i32 result_error = 0;
+        u8* destination = ( u8* )request->m_destination;
+        while ( bytes_read < request->m_size ) {
+#if defined(_MSC_VER)
+            const u64 offset = request->m_offset + bytes_read;
+            OVERLAPPED overlapped{};
+            overlapped.Offset = ( DWORD )offset;
+            overlapped.OffsetHigh = ( DWORD )( offset >> 32 );
+            const u64 remaining = request->m_size - bytes_read;
+            DWORD chunk = 0;
+            if ( !ReadFile( ( HANDLE )file, destination + bytes_read, ( DWORD )( remaining < k_io_max_read_size ? remaining : k_io_max_read_size ), &chunk, &overlapped ) ) {
+                result_error = ( i32 )GetLastError();
+                break;
+            }
+#else
+            const u64 remaining = request->m_size - bytes_read;
+            const ssize_t chunk = pread( ( i32 )file, destination + bytes_read, remaining < k_io_max_read_size ? remaining : k_io_max_read_size, ( off_t )( request->m_offset + bytes_read ) );
+            if ( chunk < 0 ) {
+                if ( errno == EINTR ) {
+                    continue;
+                }
+                result_error = errno;
+                break;
+            }
+#endif // _MSC_VER
+            if ( chunk == 0 ) {
+                // End of file, the read is shorter than requested.
+                result_error = k_io_error_end_of_file;
+                break;
+            }
+            bytes_read += ( u64 )chunk;
+        }
+
+        Complete( request, bytes_read, result_error );
+    }
+
+    void IoService::WorkerLoop() {
+        while ( true ) {
+            IoRequest* request = nullptr;
+            {
+                std::unique_lock<std::mutex> lock( m_pendingMutex );
+                m_pendingCondition.wait( lock, [ this ]() { return !m_pending.empty() || m_quit.load( std::memory_order_acquire ); } );
+                if ( m_pending.empty() ) {
+                    return;
+                }
+                request = m_pending.back();
+                m_pending.pop_back();
+            }
+
+            ExecuteBlocking( request );
+        }
+    }
+
+#if defined(CAUSTIX_IO_URING)
+    bool IoService::SubmitRing( IoRequest* request ) {
+        io_uring_sqe* sqe = io_uring_get_sqe( &m_ring );
+        if ( sqe == nullptr ) {
+            // Submission queue full, the remaining requests go to the threads.
+            return false;
+        }
+
+        if ( request->m_file < 0 ) {
+            request->m_file = IoOpen( request->m_path );
+            if ( request->m_file < 0 ) {
+                error( "IoService: cannot open {}", request->m_path );
+                io_uring_prep_nop( sqe );
+                io_uring_sqe_set_data( sqe, nullptr );
+                Complete( request, 0, k_io_error_open );
+                return true;
+            }
+        }
+
+        // Reads bigger than a single one go in pieces, each completion queues the next.
+        const u64 remaining = request->m_size - request->m_bytesRead;
+        io_uring_prep_read( sqe, ( i32 )request->m_file, ( u8* )request->m_destination + request->m_bytesRead,
+                            ( u32 )( remaining < k_io_max_read_size ? remaining : k_io_max_read_size ), request->m_offset + request->m_bytesRead );
+        io_uring_sqe_set_data( sqe, request );
+        return true;
+    }
+
+    void IoService::CompletionLoop() {
+        while ( true ) {
+            io_uring_cqe* cqe = nullptr;
+            if ( io_uring_wait_cqe( &m_ring, &cqe ) != 0 ) {
+                continue;
+            }
+
+            IoRequest* request = ( IoRequest* )io_uring_cqe_get_data( cqe );
+            const i32 result = cqe->res;
+            io_uring_cqe_seen( &m_ring, cqe );
+
+            if ( request == nullptr ) {
+                if ( m_quit.load( std::memory_order_acquire ) ) {
+                    return;
+                }
+                continue;
+            }
+
+            if ( result < 0 ) {
+                Complete( request, request->m_bytesRead, -result );
+                continue;
+            }
+
+            request->m_bytesRead += ( u64 )result;
+            if ( result == 0 && request->m_bytesRead < request->m_size ) {
+                Complete( request, request->m_bytesRead, k_io_error_end_of_file );
+                continue;
+            }
+
+            if ( request->m_bytesRead < request->m_size ) {
+                // Short read or next piece, queue the rest.
+                {
+                    std::lock_guard<std::mutex> lock( m_ringMutex );
+                    if ( SubmitRing( request ) ) {
+                        io_uring_submit( &m_ring );
+                        continue;
+                    }
+                }
+                // Ring is full, let the threads read it again from the start.
+                {
+                    std::lock_guard<std::mutex> lock( m_pendingMutex );
+                    m_pending.push_back( request );
+                }
+                m_pendingCondition.notify_one();
+                continue;
+            }
+
+            Complete( request, request->m_bytesRead, 0 );
+        }
+    }
+#endif // CAUSTIX_IO_URING
+}
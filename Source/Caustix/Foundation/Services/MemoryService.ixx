@@ -7,8 +7,11 @@ module;
 export module Foundation.Services.MemoryService;
 
 import Foundation.Memory.Allocators.LinearAllocator;
+import Foundation.Memory.Allocators.FrameAllocator;
+import Foundation.Memory.Allocators.SlabAllocator;
 import Foundation.Memory.Allocators.HeapAllocator;
 import Foundation.Memory.MemoryDefines;
+import Foundation.Memory.VirtualMemory;
 import Foundation.Services.Service;
 import Foundation.Platform;
 
@@ -18,7 +21,11 @@ export namespace Caustix {
         MemoryService(MemoryServiceConfiguration configuration);
         // Frame allocator
         LinearAllocator m_scratchAllocator;
+        // Per frame temporaries, rewound by the GpuDevice once the frame fence is signaled
+        FrameAllocator m_frameAllocator;
         HeapAllocator m_systemAllocator;
+        // Small fixed size objects, bigger requests fall back to the system allocator
+        SlabAllocator m_smallObjectsAllocator;
 
         void ImguiDraw();
 
@@ -33,12 +40,30 @@ export namespace Caustix {
 
 namespace Caustix {
     MemoryService::MemoryService(Caustix::MemoryServiceConfiguration configuration)
-    : m_systemAllocator(configuration.m_maximumDynamicSize)
-    , m_scratchAllocator(configuration.m_scratchBufferSize){}
+    : m_systemAllocator(HeapAllocatorConfiguration{ configuration.m_maximumDynamicSize, configuration.m_systemThreadArenas, configuration.m_dynamicGrowSize, configuration.m_dynamicRetainedSize })
+    , m_scratchAllocator(VirtualAllocatorConfiguration{ configuration.m_scratchBufferSize, ckilo(64), configuration.m_scratchDecommit })
+    , m_frameAllocator(configuration.m_frameBufferSize, configuration.m_frameCount)
+    , m_smallObjectsAllocator(SlabAllocatorConfiguration{ configuration.m_smallObjectsSize, configuration.m_smallObjectsThreadMagazines, &m_systemAllocator }){}
 
     void MemoryService::ImguiDraw() {
         if ( ImGui::Begin( "Memory Service" ) ) {
             m_systemAllocator.debug_ui();
+            m_frameAllocator.debug_ui();
+            m_smallObjectsAllocator.debug_ui();
+
+            ImGui::Separator();
+            ImGui::Text( "Scratch Allocator" );
+            ImGui::Separator();
+            ImGui::Text( "Allocated %llu, committed %llu of %llu reserved bytes", ( unsigned long long )m_scratchAllocator.m_allocatedSize,
+                         ( unsigned long long )m_scratchAllocator.m_committedSize, ( unsigned long long )m_scratchAllocator.m_totalSize );
+#if defined(CAUSTIX_MEMORY_TRACKING)
+            if ( ImGui::Button( "Dump allocation sites" ) ) {
+                m_systemAllocator.m_tracker.Report( "System" );
+                m_systemAllocator.m_tracker.ReportJson( "System", "system_allocations.json" );
+                m_scratchAllocator.m_tracker.Report( "Scratch" );
+                m_scratchAllocator.m_tracker.ReportJson( "Scratch", "scratch_allocations.json" );
+            }
+#endif // CAUSTIX_MEMORY_TRACKING
         }
         ImGui::End();
     }
@@ -0,0 +1,427 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CAUSTIX_TANGENT_SPACE_SSE2
+#endif
+
+export module Foundation.TangentSpace;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+
+    // Area weighted vertex normals from tightly packed vec3 positions, written as tightly packed vec3.
+    // Every vertex sums the faces around it in triangle order, so the result is the same whatever the thread count.
+    // Returns false on an index outside the vertices.
+    bool    GenerateNormals( const f32* positions, u32 vertexCount, const u32* indices, u32 indexCount, f32* normals,
+                             Allocator* allocator, JobSystem* jobSystem = nullptr );
+    bool    GenerateNormals( const f32* positions, u32 vertexCount, const u16* indices, u32 indexCount, f32* normals,
+                             Allocator* allocator, JobSystem* jobSystem = nullptr );
+
+    // MikkTSpace tangents as vec4 from vec3 positions and normals and vec2 texcoords, w is the bitangent sign.
+    // Same face tangents, corner angle weights and projection on the vertex normal as MikkTSpace, without splitting
+    // vertices shared by faces of opposite uv winding: glTF meshes are already split on uv seams.
+    bool    GenerateTangents( const f32* positions, const f32* normals, const f32* texcoords, u32 vertexCount, const u32* indices, u32 indexCount,
+                              f32* tangents, Allocator* allocator, JobSystem* jobSystem = nullptr );
+    bool    GenerateTangents( const f32* positions, const f32* normals, const f32* texcoords, u32 vertexCount, const u16* indices, u32 indexCount,
+                              f32* tangents, Allocator* allocator, JobSystem* jobSystem = nullptr );
+}
+
+namespace Caustix {
+
+    // Triangles are processed in fixed groups of 4, a group is never split between jobs so every triangle
+    // goes through the same code path whatever the thread count.
+    static constexpr u32 k_tangent_space_group_size     = 4;
+    static constexpr u32 k_tangent_space_grain_size     = 4 * 1024;
+
+    static constexpr f32 k_tangent_space_epsilon        = std::numeric_limits<f32>::min();
+
+    // Vertex to triangle adjacency in compressed rows: the triangles of vertex v are m_triangles[ m_offsets[ v ] .. m_offsets[ v + 1 ] ).
+    // Filled in triangle order, which is the summation order of every vertex.
+    struct VertexTriangles {
+        u32*                        m_offsets   = nullptr;
+        u32*                        m_triangles = nullptr;
+    };
+
+    // Face data as structure of arrays, one entry per triangle.
+    struct FaceStreams {
+        f32*                        m_x         = nullptr;
+        f32*                        m_y         = nullptr;
+        f32*                        m_z         = nullptr;
+        f32*                        m_w         = nullptr;  // Uv orientation of the face tangents, 0 for degenerate uvs.
+    };
+
+    template <typename Func>
+    static void RunSplit( u32 count, u32 grainSize, JobSystem* jobSystem, Func&& func ) {
+        if ( jobSystem && count > grainSize ) {
+            jobSystem->ParallelFor( count, func, grainSize );
+        } else if ( count ) {
+            func( 0, count );
+        }
+    }
+
+    template <typename T>
+    static bool BuildVertexTriangles( const T* indices, u32 indexCount, u32 vertexCount, VertexTriangles& adjacency, Allocator* allocator ) {
+        adjacency.m_offsets = callocaa<u32>( vertexCount + 1, allocator );
+        adjacency.m_triangles = callocaa<u32>( std::max( indexCount, 1u ), allocator );
+        memset( adjacency.m_offsets, 0, ( vertexCount + 1 ) * sizeof( u32 ) );
+
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            const u32 vertex = indices[ i ];
+            if ( vertex >= vertexCount ) {
+                error( "Tangent space: index {} out of {} vertices", vertex, vertexCount );
+                return false;
+            }
+            ++adjacency.m_offsets[ vertex + 1 ];
+        }
+
+        for ( u32 vertex = 0; vertex < vertexCount; ++vertex ) {
+            adjacency.m_offsets[ vertex + 1 ] += adjacency.m_offsets[ vertex ];
+        }
+
+        // Offsets are used as write cursors and shifted back by one vertex afterwards.
+        for ( u32 i = 0; i < indexCount; ++i ) {
+            adjacency.m_triangles[ adjacency.m_offsets[ indices[ i ] ]++ ] = i / 3;
+        }
+        for ( u32 vertex = vertexCount; vertex > 0; --vertex ) {
+            adjacency.m_offsets[ vertex ] = adjacency.m_offsets[ vertex - 1 ];
+        }
+        adjacency.m_offsets[ 0 ] = 0;
+        return true;
+    }
+
+    static void FreeVertexTriangles( VertexTriangles& adjacency, Allocator* allocator ) {
+        cfree( adjacency.m_offsets, allocator );
+        cfree( adjacency.m_triangles, allocator );
+    }
+
+    static FaceStreams AllocateFaceStreams( u32 triangleCount, Allocator* allocator ) {
+        // One block, each stream padded to whole groups.
+        const sizet streamSize = MemoryAlign( std::max( triangleCount, 1u ), k_tangent_space_group_size );
+        f32* block = callocaa<f32>( streamSize * 4, allocator );
+        return { block, block + streamSize, block + streamSize * 2, block + streamSize * 3 };
+    }
+
+    // Face normals ///////////////////////////////////////////////////////////
+
+    template <typename T>
+    static void FaceNormal( const f32* positions, const T* triangle, FaceStreams& faces, u32 face ) {
+        const f32* p0 = positions + ( sizet )triangle[ 0 ] * 3;
+        const f32* p1 = positions + ( sizet )triangle[ 1 ] * 3;
+        const f32* p2 = positions + ( sizet )triangle[ 2 ] * 3;
+
+        const f32 ax = p1[ 0 ] - p0[ 0 ], ay = p1[ 1 ] - p0[ 1 ], az = p1[ 2 ] - p0[ 2 ];
+        const f32 bx = p2[ 0 ] - p0[ 0 ], by = p2[ 1 ] - p0[ 1 ], bz = p2[ 2 ] - p0[ 2 ];
+
+        // The cross product length is twice the area, summing them unnormalized weights faces by area.
+        faces.m_x[ face ] = ay * bz - az * by;
+        faces.m_y[ face ] = az * bx - ax * bz;
+        faces.m_z[ face ] = ax * by - ay * bx;
+    }
+
+#if defined(CAUSTIX_TANGENT_SPACE_SSE2)
+    // Gathers one component of a corner of 4 consecutive triangles.
+    template <typename T>
+    static __m128 GatherCorner( const f32* stream, u32 components, const T* triangles, u32 corner, u32 component ) {
+        return _mm_setr_ps( stream[ ( sizet )triangles[ corner ] * components + component ],
+                            stream[ ( sizet )triangles[ 3 + corner ] * components + component ],
+                            stream[ ( sizet )triangles[ 6 + corner ] * components + component ],
+                            stream[ ( sizet )triangles[ 9 + corner ] * components + component ] );
+    }
+
+    template <typename T>
+    static void FaceNormalGroup( const f32* positions, const T* triangles, FaceStreams& faces, u32 face ) {
+        const __m128 p0x = GatherCorner( positions, 3, triangles, 0, 0 ), p0y = GatherCorner( positions, 3, triangles, 0, 1 ), p0z = GatherCorner( positions, 3, triangles, 0, 2 );
+        const __m128 ax = _mm_sub_ps( GatherCorner( positions, 3, triangles, 1, 0 ), p0x );
+        const __m128 ay = _mm_sub_ps( GatherCorner( positions, 3, triangles, 1, 1 ), p0y );
+        const __m128 az = _mm_sub_ps( GatherCorner( positions, 3, triangles, 1, 2 ), p0z );
+        const __m128 bx = _mm_sub_ps( GatherCorner( positions, 3, triangles, 2, 0 ), p0x );
+        const __m128 by = _mm_sub_ps( GatherCorner( positions, 3, triangles, 2, 1 ), p0y );
+        const __m128 bz = _mm_sub_ps( GatherCorner( positions, 3, triangles, 2, 2 ), p0z );
+
+        _mm_storeu_ps( faces.m_x + face, _mm_sub_ps( _mm_mul_ps( ay, bz ), _mm_mul_ps( az, by ) ) );
+        _mm_storeu_ps( faces.m_y + face, _mm_sub_ps( _mm_mul_ps( az, bx ), _mm_mul_ps( ax, bz ) ) );
+        _mm_storeu_ps( faces.m_z + face, _mm_sub_ps( _mm_mul_ps( ax, by ), _mm_mul_ps( ay, bx ) ) );
+    }
+#endif
+
+    template <typename T>
+    static void FaceNormalsRange( const f32* positions, const T* indices, u32 triangleCount, u32 groupBegin, u32 groupEnd, FaceStreams& faces ) {
+        for ( u32 group = groupBegin; group < groupEnd; ++group ) {
+            const u32 face = group * k_tangent_space_group_size;
+            const u32 faceEnd = std::min( face + k_tangent_space_group_size, triangleCount );
+#if defined(CAUSTIX_TANGENT_SPACE_SSE2)
+            if ( faceEnd - face == k_tangent_space_group_size ) {
+                FaceNormalGroup( positions, indices + ( sizet )face * 3, faces, face );
+                continue;
+            }
+#endif
+            for ( u32 f = face; f < faceEnd; ++f ) {
+                FaceNormal( positions, indices + ( sizet )f * 3, faces, f );
+            }
+        }
+    }
+
+    static void VertexNormalsRange( const VertexTriangles& adjacency, const FaceStreams& faces, u32 begin, u32 end, f32* normals ) {
+        for ( u32 vertex = begin; vertex < end; ++vertex ) {
+            f32 x = 0.0f, y = 0.0f, z = 0.0f;
+            for ( u32 i = adjacency.m_offsets[ vertex ]; i < adjacency.m_offsets[ vertex + 1 ]; ++i ) {
+                const u32 face = adjacency.m_triangles[ i ];
+                x += faces.m_x[ face ];
+                y += faces.m_y[ face ];
+                z += faces.m_z[ face ];
+            }
+
+            const f32 length = sqrtf( x * x + y * y + z * z );
+            const f32 scale = length > k_tangent_space_epsilon ? 1.0f / length : 0.0f;
+            normals[ ( sizet )vertex * 3 ] = x * scale;
+            normals[ ( sizet )vertex * 3 + 1 ] = y * scale;
+            normals[ ( sizet )vertex * 3 + 2 ] = z * scale;
+        }
+    }
+
+    template <typename T>
+    static bool GenerateNormalsTyped( const f32* positions, u32 vertexCount, const T* indices, u32 indexCount, f32* normals,
+                                      Allocator* allocator, JobSystem* jobSystem ) {
+        const u32 triangleCount = indexCount / 3;
+
+        VertexTriangles adjacency;
+        if ( !BuildVertexTriangles( indices, triangleCount * 3, vertexCount, adjacency, allocator ) ) {
+            FreeVertexTriangles( adjacency, allocator );
+            return false;
+        }
+
+        FaceStreams faces = AllocateFaceStreams( triangleCount, allocator );
+
+        const u32 groupCount = ( triangleCount + k_tangent_space_group_size - 1 ) / k_tangent_space_group_size;
+        RunSplit( groupCount, k_tangent_space_grain_size / k_tangent_space_group_size, jobSystem, [ & ]( u32 begin, u32 end ) {
+            FaceNormalsRange( positions, indices, triangleCount, begin, end, faces );
+        } );
+
+        RunSplit( vertexCount, k_tangent_space_grain_size, jobSystem, [ & ]( u32 begin, u32 end ) {
+            VertexNormalsRange( adjacency, faces, begin, end, normals );
+        } );
+
+        cfree( faces.m_x, allocator );
+        FreeVertexTriangles( adjacency, allocator );
+        return true;
+    }
+
+    bool GenerateNormals( const f32* positions, u32 vertexCount, const u32* indices, u32 indexCount, f32* normals, Allocator* allocator, JobSystem* jobSystem ) {
+        return GenerateNormalsTyped( positions, vertexCount, indices, indexCount, normals, allocator, jobSystem );
+    }
+
+    bool GenerateNormals( const f32* positions, u32 vertexCount, const u16* indices, u32 indexCount, f32* normals, Allocator* allocator, JobSystem* jobSystem ) {
+        return GenerateNormalsTyped( positions, vertexCount, indices, indexCount, normals, allocator, jobSystem );
+    }
+
+    // Face tangents //////////////////////////////////////////////////////////
+    // As in MikkTSpace: the direction of increasing u on the face, flipped on faces with mirrored uvs and normalized.
+
+    template <typename T>
+    static void FaceTangent( const f32* positions, const f32* texcoords, const T* triangle, FaceStreams& faces, u32 face ) {
+        const f32* p0 = positions + ( sizet )triangle[ 0 ] * 3;
+        const f32* p1 = positions + ( sizet )triangle[ 1 ] * 3;
+        const f32* p2 = positions + ( sizet )triangle[ 2 ] * 3;
+        const f32* t0 = texcoords + ( sizet )triangle[ 0 ] * 2;
+        const f32* t1 = texcoords + ( sizet )triangle[ 1 ] * 2;
+        const f32* t2 = texcoords + ( sizet )triangle[ 2 ] * 2;
+
+        const f32 d1x = p1[ 0 ] - p0[ 0 ], d1y = p1[ 1 ] - p0[ 1 ], d1z = p1[ 2 ] - p0[ 2 ];
+        const f32 d2x = p2[ 0 ] - p0[ 0 ], d2y = p2[ 1 ] - p0[ 1 ], d2z = p2[ 2 ] - p0[ 2 ];
+        const f32 s1 = t1[ 0 ] - t0[ 0 ], v1 = t1[ 1 ] - t0[ 1 ];
+        const f32 s2 = t2[ 0 ] - t0[ 0 ], v2 = t2[ 1 ] - t0[ 1 ];
+
+        const f32 area = s1 * v2 - v1 * s2;
+        const f32 x = v2 * d1x - v1 * d2x;
+        const f32 y = v2 * d1y - v1 * d2y;
+        const f32 z = v2 * d1z - v1 * d2z;
+
+        const f32 orientation = area > 0.0f ? 1.0f : -1.0f;
+        const f32 length = sqrtf( x * x + y * y + z * z );
+        const bool valid = fabsf( area ) > k_tangent_space_epsilon && length > k_tangent_space_epsilon;
+        const f32 scale = orientation / length;
+
+        faces.m_x[ face ] = valid ? x * scale : 0.0f;
+        faces.m_y[ face ] = valid ? y * scale : 0.0f;
+        faces.m_z[ face ] = valid ? z * scale : 0.0f;
+        faces.m_w[ face ] = valid ? orientation : 0.0f;
+    }
+
+#if defined(CAUSTIX_TANGENT_SPACE_SSE2)
+    template <typename T>
+    static void FaceTangentGroup( const f32* positions, const f32* texcoords, const T* triangles, FaceStreams& faces, u32 face ) {
+        const __m128 p0x = GatherCorner( positions, 3, triangles, 0, 0 ), p0y = GatherCorner( positions, 3, triangles, 0, 1 ), p0z = GatherCorner( positions, 3, triangles, 0, 2 );
+        const __m128 d1x = _mm_sub_ps( GatherCorner( positions, 3, triangles, 1, 0 ), p0x );
+        const __m128 d1y = _mm_sub_ps( GatherCorner( positions, 3, triangles, 1, 1 ), p0y );
+        const __m128 d1z = _mm_sub_ps( GatherCorner( positions, 3, triangles, 1, 2 ), p0z );
+        const __m128 d2x = _mm_sub_ps( GatherCorner( positions, 3, triangles, 2, 0 ), p0x );
+        const __m128 d2y = _mm_sub_ps( GatherCorner( positions, 3, triangles, 2, 1 ), p0y );
+        const __m128 d2z = _mm_sub_ps( GatherCorner( positions, 3, triangles, 2, 2 ), p0z );
+
+        const __m128 t0s = GatherCorner( texcoords, 2, triangles, 0, 0 ), t0v = GatherCorner( texcoords, 2, triangles, 0, 1 );
+        const __m128 s1 = _mm_sub_ps( GatherCorner( texcoords, 2, triangles, 1, 0 ), t0s );
+        const __m128 v1 = _mm_sub_ps( GatherCorner( texcoords, 2, triangles, 1, 1 ), t0v );
+        const __m128 s2 = _mm_sub_ps( GatherCorner( texcoords, 2, triangles, 2, 0 ), t0s );
+        const __m128 v2 = _mm_sub_ps( GatherCorner( texcoords, 2, triangles, 2, 1 ), t0v );
+
+        const __m128 area = _mm_sub_ps( _mm_mul_ps( s1, v2 ), _mm_mul_ps( v1, s2 ) );
+        const __m128 x = _mm_sub_ps( _mm_mul_ps( v2, d1x ), _mm_mul_ps( v1, d2x ) );
+        const __m128 y = _mm_sub_ps( _mm_mul_ps( v2, d1y ), _mm_mul_ps( v1, d2y ) );
+        const __m128 z = _mm_sub_ps( _mm_mul_ps( v2, d1z ), _mm_mul_ps( v1, d2z ) );
+
+        const __m128 one = _mm_set1_ps( 1.0f );
+        const __m128 epsilon = _mm_set1_ps( k_tangent_space_epsilon );
+        const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+
+        const __m128 positive = _mm_cmpgt_ps( area, _mm_setzero_ps() );
+        const __m128 orientation = _mm_or_ps( _mm_and_ps( positive, one ), _mm_andnot_ps( positive, _mm_set1_ps( -1.0f ) ) );
+        const __m128 length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) ) );
+        const __m128 valid = _mm_and_ps( _mm_cmpgt_ps( _mm_and_ps( area, absMask ), epsilon ), _mm_cmpgt_ps( length, epsilon ) );
+        const __m128 scale = _mm_div_ps( orientation, length );
+
+        _mm_storeu_ps( faces.m_x + face, _mm_and_ps( valid, _mm_mul_ps( x, scale ) ) );
+        _mm_storeu_ps( faces.m_y + face, _mm_and_ps( valid, _mm_mul_ps( y, scale ) ) );
+        _mm_storeu_ps( faces.m_z + face, _mm_and_ps( valid, _mm_mul_ps( z, scale ) ) );
+        _mm_storeu_ps( faces.m_w + face, _mm_and_ps( valid, orientation ) );
+    }
+#endif
+
+    template <typename T>
+    static void FaceTangentsRange( const f32* positions, const f32* texcoords, const T* indices, u32 triangleCount, u32 groupBegin, u32 groupEnd, FaceStreams& faces ) {
+        for ( u32 group = groupBegin; group < groupEnd; ++group ) {
+            const u32 face = group * k_tangent_space_group_size;
+            const u32 faceEnd = std::min( face + k_tangent_space_group_size, triangleCount );
+#if defined(CAUSTIX_TANGENT_SPACE_SSE2)
+            if ( faceEnd - face == k_tangent_space_group_size ) {
+                FaceTangentGroup( positions, texcoords, indices + ( sizet )face * 3, faces, face );
+                continue;
+            }
+#endif
+            for ( u32 f = face; f < faceEnd; ++f ) {
+                FaceTangent( positions, texcoords, indices + ( sizet )f * 3, faces, f );
+            }
+        }
+    }
+
+    // Removes the normal component of v and normalizes it, returns false when nothing is left.
+    static bool ProjectOnPlane( const f32* normal, f32& x, f32& y, f32& z ) {
+        const f32 d = normal[ 0 ] * x + normal[ 1 ] * y + normal[ 2 ] * z;
+        x -= normal[ 0 ] * d;
+        y -= normal[ 1 ] * d;
+        z -= normal[ 2 ] * d;
+
+        const f32 length = sqrtf( x * x + y * y + z * z );
+        if ( length <= k_tangent_space_epsilon ) {
+            return false;
+        }
+        x /= length;
+        y /= length;
+        z /= length;
+        return true;
+    }
+
+    template <typename T>
+    static void VertexTangentsRange( const f32* positions, const f32* normals, const T* indices, const VertexTriangles& adjacency, const FaceStreams& faces,
+                                     u32 begin, u32 end, f32* tangents ) {
+        for ( u32 vertex = begin; vertex < end; ++vertex ) {
+            const f32* normal = normals + ( sizet )vertex * 3;
+            const f32* p = positions + ( sizet )vertex * 3;
+
+            f32 x = 0.0f, y = 0.0f, z = 0.0f, orientation = 0.0f;
+            for ( u32 i = adjacency.m_offsets[ vertex ]; i < adjacency.m_offsets[ vertex + 1 ]; ++i ) {
+                const u32 face = adjacency.m_triangles[ i ];
+                if ( faces.m_w[ face ] == 0.0f ) {
+                    continue;
+                }
+
+                f32 tx = faces.m_x[ face ], ty = faces.m_y[ face ], tz = faces.m_z[ face ];
+                if ( !ProjectOnPlane( normal, tx, ty, tz ) ) {
+                    continue;
+                }
+
+                // Corner angle between the two edges leaving the vertex, measured in the tangent plane.
+                const T* triangle = indices + ( sizet )face * 3;
+                const u32 corner = triangle[ 0 ] == vertex ? 0 : ( triangle[ 1 ] == vertex ? 1 : 2 );
+                const f32* pNext = positions + ( sizet )triangle[ ( corner + 1 ) % 3 ] * 3;
+                const f32* pPrevious = positions + ( sizet )triangle[ ( corner + 2 ) % 3 ] * 3;
+
+                f32 e1x = pNext[ 0 ] - p[ 0 ], e1y = pNext[ 1 ] - p[ 1 ], e1z = pNext[ 2 ] - p[ 2 ];
+                f32 e2x = pPrevious[ 0 ] - p[ 0 ], e2y = pPrevious[ 1 ] - p[ 1 ], e2z = pPrevious[ 2 ] - p[ 2 ];
+                if ( !ProjectOnPlane( normal, e1x, e1y, e1z ) || !ProjectOnPlane( normal, e2x, e2y, e2z ) ) {
+                    continue;
+                }
+
+                const f32 angle = acosf( std::clamp( e1x * e2x + e1y * e2y + e1z * e2z, -1.0f, 1.0f ) );
+                x += tx * angle;
+                y += ty * angle;
+                z += tz * angle;
+                orientation += faces.m_w[ face ] * angle;
+            }
+
+            if ( !ProjectOnPlane( normal, x, y, z ) ) {
+                // No usable uvs around the vertex, any direction in the tangent plane.
+                x = fabsf( normal[ 0 ] ) < 0.9f ? 1.0f : 0.0f;
+                y = 1.0f - x;
+                z = 0.0f;
+                if ( !ProjectOnPlane( normal, x, y, z ) ) {
+                    x = 1.0f; y = 0.0f; z = 0.0f;
+                }
+            }
+
+            f32* tangent = tangents + ( sizet )vertex * 4;
+            tangent[ 0 ] = x;
+            tangent[ 1 ] = y;
+            tangent[ 2 ] = z;
+            tangent[ 3 ] = orientation < 0.0f ? -1.0f : 1.0f;
+        }
+    }
+
+    template <typename T>
+    static bool GenerateTangentsTyped( const f32* positions, const f32* normals, const f32* texcoords, u32 vertexCount, const T* indices, u32 indexCount,
+                                       f32* tangents, Allocator* allocator, JobSystem* jobSystem ) {
+        const u32 triangleCount = indexCount / 3;
+
+        VertexTriangles adjacency;
+        if ( !BuildVertexTriangles( indices, triangleCount * 3, vertexCount, adjacency, allocator ) ) {
+            FreeVertexTriangles( adjacency, allocator );
+            return false;
+        }
+
+        FaceStreams faces = AllocateFaceStreams( triangleCount, allocator );
+
+        const u32 groupCount = ( triangleCount + k_tangent_space_group_size - 1 ) / k_tangent_space_group_size;
+        RunSplit( groupCount, k_tangent_space_grain_size / k_tangent_space_group_size, jobSystem, [ & ]( u32 begin, u32 end ) {
+            FaceTangentsRange( positions, texcoords, indices, triangleCount, begin, end, faces );
+        } );
+
+        RunSplit( vertexCount, k_tangent_space_grain_size, jobSystem, [ & ]( u32 begin, u32 end ) {
+            VertexTangentsRange( positions, normals, indices, adjacency, faces, begin, end, tangents );
+        } );
+
+        cfree( faces.m_x, allocator );
+        FreeVertexTriangles( adjacency, allocator );
+        return true;
+    }
+
+    bool GenerateTangents( const f32* positions, const f32* normals, const f32* texcoords, u32 vertexCount, const u32* indices, u32 indexCount,
+                           f32* tangents, Allocator* allocator, JobSystem* jobSystem ) {
+        return GenerateTangentsTyped( positions, normals, texcoords, vertexCount, indices, indexCount, tangents, allocator, jobSystem );
+    }
+
+    bool GenerateTangents( const f32* positions, const f32* normals, const f32* texcoords, u32 vertexCount, const u16* indices, u32 indexCount,
+                           f32* tangents, Allocator* allocator, JobSystem* jobSystem ) {
+        return GenerateTangentsTyped( positions, normals, texcoords, vertexCount, indices, indexCount, tangents, allocator, jobSystem );
+    }
+}
@@ -0,0 +1,195 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+export module Foundation.VertexQuantization;
+
+import Foundation.Platform;
+
+export namespace Caustix {
+
+    // Bytes per vertex of the quantized streams.
+    constexpr u32 k_quantized_position_size     = 4 * sizeof( u16 );    // 16 bit unorm xyz in the mesh box, w holds the bitangent sign.
+    constexpr u32 k_quantized_unit_vector_size  = 2 * sizeof( i16 );    // Octahedral 16 bit snorm.
+    constexpr u32 k_quantized_texcoord_size     = 2 * sizeof( u16 );    // Half floats.
+
+    // Largest differences between the quantized and the source attributes.
+    struct VertexQuantizationReport {
+        void                        Add( const VertexQuantizationReport& other );
+
+        f32                         m_positionError     = 0.0f;     // Model space distance.
+        f32                         m_normalError       = 0.0f;     // Degrees.
+        f32                         m_tangentError      = 0.0f;     // Degrees.
+        f32                         m_texcoordError     = 0.0f;
+        u64                         m_bytesBefore       = 0;
+        u64                         m_bytesAfter        = 0;
+    };
+
+    u16     QuantizeHalf( f32 value );
+    f32     DequantizeHalf( u16 value );
+
+    // Unit vector to the octahedron unfolded on the xy square, decoded as the shaders do.
+    void    EncodeOctahedral( const f32* vector, i16* encoded );
+    void    DecodeOctahedral( const i16* encoded, f32* vector );
+
+    // Tightly packed vec3 positions to 4 u16 per vertex: position = quantized / 65535 * scale + offset, which folds into
+    // the model matrix. w is 65535 for a positive bitangent sign of tangents ( vec4, null when there are none ), 0 otherwise.
+    // Returns the largest position error.
+    f32     QuantizePositions( const f32* positions, const f32* tangents, u32 vertexCount, u16* output, f32* offset, f32* scale );
+
+    // Unit vectors stride bytes apart to 2 i16 per vertex. Returns the largest angle error in degrees.
+    f32     QuantizeUnitVectors( const f32* vectors, u32 stride, u32 vertexCount, i16* output );
+
+    // Tightly packed vec2 to 2 half floats per vertex. Returns the largest error.
+    f32     QuantizeTexcoords( const f32* texcoords, u32 vertexCount, u16* output );
+}
+
+namespace Caustix {
+
+    static constexpr f32 k_unorm16_max = 65535.0f;
+    static constexpr f32 k_snorm16_max = 32767.0f;
+
+    void VertexQuantizationReport::Add( const VertexQuantizationReport& other ) {
+        m_positionError = std::max( m_positionError, other.m_positionError );
+        m_normalError = std::max( m_normalError, other.m_normalError );
+        m_tangentError = std::max( m_tangentError, other.m_tangentError );
+        m_texcoordError = std::max( m_texcoordError, other.m_texcoordError );
+        m_bytesBefore += other.m_bytesBefore;
+        m_bytesAfter += other.m_bytesAfter;
+    }
+
+    u16 QuantizeHalf( f32 value ) {
+        u32 bits;
+        memcpy( &bits, &value, sizeof( bits ) );
+
+        const u32 sign = ( bits >> 16 ) & 0x8000;
+        const u32 magnitude = bits & 0x7fffffff;
+
+        // Rebias the exponent from 127 to 15 and round the mantissa to nearest.
+        u32 half = ( magnitude - ( 112 << 23 ) + ( 1 << 12 ) ) >> 13;
+        // Below the smallest normal half flushes to zero, above the largest goes to infinity, NaNs stay NaNs.
+        half = magnitude < ( 113 << 23 ) ? 0 : half;
+        half = magnitude >= ( 143 << 23 ) ? 0x7c00 : half;
+        half = magnitude > ( 255 << 23 ) ? 0x7e00 : half;
+
+        return ( u16 )( sign | half );
+    }
+
+    f32 DequantizeHalf( u16 value ) {
+        const u32 sign = ( u32 )( value & 0x8000 ) << 16;
+        const u32 magnitude = value & 0x7fff;
+
+        u32 bits = ( magnitude + ( 112 << 10 ) ) << 13;
+        bits = magnitude < ( 1 << 10 ) ? 0 : bits;
+        // Infinities and NaNs need the full float exponent.
+        bits += magnitude >= ( 31 << 10 ) ? ( 112 << 23 ) : 0;
+        bits |= sign;
+
+        f32 result;
+        memcpy( &result, &bits, sizeof( result ) );
+        return result;
+    }
+
+    static i16 QuantizeSnorm16( f32 value ) {
+        return ( i16 )lroundf( std::clamp( value, -1.0f, 1.0f ) * k_snorm16_max );
+    }
+
+    void EncodeOctahedral( const f32* vector, i16* encoded ) {
+        const f32 length = fabsf( vector[ 0 ] ) + fabsf( vector[ 1 ] ) + fabsf( vector[ 2 ] );
+        if ( length == 0.0f ) {
+            encoded[ 0 ] = encoded[ 1 ] = 0;
+            return;
+        }
+
+        f32 x = vector[ 0 ] / length, y = vector[ 1 ] / length;
+        if ( vector[ 2 ] < 0.0f ) {
+            // The lower half folds over the diagonals.
+            const f32 fx = ( 1.0f - fabsf( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+            const f32 fy = ( 1.0f - fabsf( x ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+            x = fx;
+            y = fy;
+        }
+
+        encoded[ 0 ] = QuantizeSnorm16( x );
+        encoded[ 1 ] = QuantizeSnorm16( y );
+    }
+
+    void DecodeOctahedral( const i16* encoded, f32* vector ) {
+        // Snorm decoding of the vertex fetch, -32768 clamps to -1.
+        const f32 x = std::max( encoded[ 0 ] / k_snorm16_max, -1.0f );
+        const f32 y = std::max( encoded[ 1 ] / k_snorm16_max, -1.0f );
+
+        f32 n[ 3 ] = { x, y, 1.0f - fabsf( x ) - fabsf( y ) };
+        const f32 t = std::max( -n[ 2 ], 0.0f );
+        n[ 0 ] += n[ 0 ] >= 0.0f ? -t : t;
+        n[ 1 ] += n[ 1 ] >= 0.0f ? -t : t;
+
+        const f32 length = sqrtf( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+        vector[ 0 ] = n[ 0 ] / length;
+        vector[ 1 ] = n[ 1 ] / length;
+        vector[ 2 ] = n[ 2 ] / length;
+    }
+
+    f32 QuantizePositions( const f32* positions, const f32* tangents, u32 vertexCount, u16* output, f32* offset, f32* scale ) {
+        f32 boxMin[ 3 ] = { 0.0f, 0.0f, 0.0f }, boxMax[ 3 ] = { 0.0f, 0.0f, 0.0f };
+        for ( u32 v = 0; v < vertexCount; ++v ) {
+            for ( u32 k = 0; k < 3; ++k ) {
+                const f32 value = positions[ v * 3 + k ];
+                boxMin[ k ] = v == 0 ? value : std::min( boxMin[ k ], value );
+                boxMax[ k ] = v == 0 ? value : std::max( boxMax[ k ], value );
+            }
+        }
+
+        f32 inverseScale[ 3 ];
+        for ( u32 k = 0; k < 3; ++k ) {
+            offset[ k ] = boxMin[ k ];
+            scale[ k ] = boxMax[ k ] - boxMin[ k ];
+            inverseScale[ k ] = scale[ k ] > 0.0f ? k_unorm16_max / scale[ k ] : 0.0f;
+        }
+
+        f32 maxError = 0.0f;
+        for ( u32 v = 0; v < vertexCount; ++v ) {
+            f32 error = 0.0f;
+            for ( u32 k = 0; k < 3; ++k ) {
+                const f32 value = positions[ v * 3 + k ];
+                const u16 quantized = ( u16 )std::min( lroundf( ( value - offset[ k ] ) * inverseScale[ k ] ), 65535l );
+                output[ v * 4 + k ] = quantized;
+
+                const f32 difference = quantized / k_unorm16_max * scale[ k ] + offset[ k ] - value;
+                error += difference * difference;
+            }
+            output[ v * 4 + 3 ] = tangents == nullptr || tangents[ v * 4 + 3 ] >= 0.0f ? 65535 : 0;
+            maxError = std::max( maxError, sqrtf( error ) );
+        }
+        return maxError;
+    }
+
+    f32 QuantizeUnitVectors( const f32* vectors, u32 stride, u32 vertexCount, i16* output ) {
+        f32 minDot = 1.0f;
+        for ( u32 v = 0; v < vertexCount; ++v ) {
+            const f32* vector = ( const f32* )( ( const u8* )vectors + ( sizet )v * stride );
+            EncodeOctahedral( vector, output + v * 2 );
+
+            const f32 length = sqrtf( vector[ 0 ] * vector[ 0 ] + vector[ 1 ] * vector[ 1 ] + vector[ 2 ] * vector[ 2 ] );
+            if ( length == 0.0f ) {
+                continue;
+            }
+            f32 decoded[ 3 ];
+            DecodeOctahedral( output + v * 2, decoded );
+            minDot = std::min( minDot, ( decoded[ 0 ] * vector[ 0 ] + decoded[ 1 ] * vector[ 1 ] + decoded[ 2 ] * vector[ 2 ] ) / length );
+        }
+        return acosf( std::clamp( minDot, -1.0f, 1.0f ) ) * 57.2957795f;
+    }
+
+    f32 QuantizeTexcoords( const f32* texcoords, u32 vertexCount, u16* output ) {
+        f32 maxError = 0.0f;
+        for ( u32 i = 0; i < vertexCount * 2; ++i ) {
+            output[ i ] = QuantizeHalf( texcoords[ i ] );
+            maxError = std::max( maxError, fabsf( DequantizeHalf( output[ i ] ) - texcoords[ i ] ) );
+        }
+        return maxError;
+    }
+}
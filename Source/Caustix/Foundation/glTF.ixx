@@ -1,8 +1,14 @@
 module;
 
-#include "nlohmann/json.hpp"
+#include <string.h>
 
+#include <algorithm>
+#include <new>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <filesystem>
 
 export module Foundation.glTF;
@@ -15,7 +21,9 @@ import Foundation.Services.ServiceManager;
 import Foundation.Assert;
 import Foundation.Log;
 import Foundation.Platform;
+import Foundation.Base64;
 import Foundation.File;
+import Foundation.Json;
 
 export namespace Caustix {
 
@@ -51,12 +59,6 @@ export namespace Caustix {
             f32                         znear;
         };
 
-        struct AccessorSparse {
-            i32                         count;
-            i32                         indices;
-            i32                         values;
-        };
-
         struct Camera {
             i32                         orthographic;
             i32                         perspective;
@@ -115,6 +117,9 @@ export namespace Caustix {
             // image/png
             StringBuffer                 mime_type;
             StringBuffer                 uri;
+            // Decoded content of a data uri, null otherwise.
+            const u8*                   data;
+            u32                         data_size;
         };
 
         struct Node {
@@ -183,6 +188,17 @@ export namespace Caustix {
             i32                         component_type;
         };
 
+        struct AccessorSparseValues {
+            i32                         bufferView;
+            i32                         byteOffset;
+        };
+
+        struct AccessorSparse {
+            i32                         count;
+            AccessorSparseIndices       indices;
+            AccessorSparseValues        values;
+        };
+
         struct Accessor {
             enum ComponentType {
                 BYTE = 5120, UNSIGNED_BYTE = 5121, SHORT = 5122, UNSIGNED_SHORT = 5123, UNSIGNED_INT = 5125, FLOAT = 5126
@@ -202,7 +218,7 @@ export namespace Caustix {
             u32                         min_count;
             f32*                        min;
             bool                        normalized;
-            i32                         sparse;
+            AccessorSparse*             sparse;     // Null when the accessor is not sparse.
             Type                        type;
         };
 
@@ -252,6 +268,8 @@ export namespace Caustix {
             i32                         byte_length;
             StringBuffer                 uri;
             StringBuffer                 name;
+            // Content already in memory, like the binary chunk of a GLB file or a decoded data uri. Null when it has to be read from uri.
+            const u8*                   data;
         };
 
         struct CameraPerspective {
@@ -268,11 +286,6 @@ export namespace Caustix {
             AnimationSampler*           samplers;
         };
 
-        struct AccessorSparseValues {
-            i32                         bufferView;
-            i32                         byteOffset;
-        };
-
         struct Scene {
             u32                         nodes_count;
             i32*                        nodes;
@@ -294,41 +307,44 @@ export namespace Caustix {
         };
 
         struct glTF {
-            u32                         accessors_count;
-            Accessor*                   accessors;
-            u32                         animations_count;
-            Animation*                  animations;
-            Asset*                      asset;
-            u32                         buffer_views_count;
-            BufferView*                 buffer_views;
-            u32                         buffers_count;
-            Buffer*                     buffers;
-            u32                         cameras_count;
-            Camera*                     cameras;
-            u32                         extensions_required_count;
-            StringBuffer*                extensions_required;
-            u32                         extensions_used_count;
-            StringBuffer*                extensions_used;
-            u32                         images_count;
-            Image*                      images;
-            u32                         materials_count;
-            Material*                   materials;
-            u32                         meshes_count;
-            Mesh*                       meshes;
-            u32                         nodes_count;
-            Node*                       nodes;
-            u32                         samplers_count;
-            Sampler*                    samplers;
-            i32                         scene;
-            u32                         scenes_count;
-            Scene*                      scenes;
-            u32                         skins_count;
-            Skin*                       skins;
-            u32                         textures_count;
-            Texture*                    textures;
+            u32                         accessors_count = 0;
+            Accessor*                   accessors = nullptr;
+            u32                         animations_count = 0;
+            Animation*                  animations = nullptr;
+            Asset*                      asset = nullptr;
+            u32                         buffer_views_count = 0;
+            BufferView*                 buffer_views = nullptr;
+            u32                         buffers_count = 0;
+            Buffer*                     buffers = nullptr;
+            u32                         cameras_count = 0;
+            Camera*                     cameras = nullptr;
+            u32                         extensions_required_count = 0;
+            StringBuffer*                extensions_required = nullptr;
+            u32                         extensions_used_count = 0;
+            StringBuffer*                extensions_used = nullptr;
+            u32                         images_count = 0;
+            Image*                      images = nullptr;
+            u32                         materials_count = 0;
+            Material*                   materials = nullptr;
+            u32                         meshes_count = 0;
+            Mesh*                       meshes = nullptr;
+            u32                         nodes_count = 0;
+            Node*                       nodes = nullptr;
+            u32                         samplers_count = 0;
+            Sampler*                    samplers = nullptr;
+            i32                         scene = INVALID_INT_VALUE;
+            u32                         scenes_count = 0;
+            Scene*                      scenes = nullptr;
+            u32                         skins_count = 0;
+            Skin*                       skins = nullptr;
+            u32                         textures_count = 0;
+            Texture*                    textures = nullptr;
 
             Allocator*                  allocator;
 
+            // A GLB file stays mapped while the scene is alive, buffers[ 0 ].data points inside it.
+            MappedFile                  binary_file;
+
             glTF(Allocator* allocator_) : allocator(allocator_) {}
         };
 
@@ -341,7 +357,6 @@ export namespace Caustix {
 }
 
 namespace Caustix {
-    using json = nlohmann::json;
 
     static void* AllocateAndZero(Allocator* allocator, sizet size) {
         void* result = allocator->allocate( size, 64 );
@@ -350,55 +365,18 @@ namespace Caustix {
         return result;
     }
 
-    static void TryLoadString(json& jsonData, cstring key, StringBuffer& stringBuffer, Allocator* allocator) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() )
-            return;
-
-        std::string value = jsonData.value( key, "" );
-
-        StringBuffer tempBuffer(*allocator);
-
-        memcpy(&stringBuffer, &tempBuffer, sizeof (StringBuffer));
-
-        stringBuffer.append( value );
+    // The structs are zeroed memory, strings need to be constructed before they are assigned.
+    static void InitString( StringBuffer& stringBuffer, Allocator* allocator ) {
+        new ( &stringBuffer ) StringBuffer( *allocator );
     }
 
-    static void TryLoadInt(json& json_data, cstring key, i32& value) {
-        auto it = json_data.find(key);
-        if (it == json_data.end())
-        {
-            value = glTF::INVALID_INT_VALUE;
-            return;
-        }
-
-        value = json_data.value(key, 0);
-    }
-
-    static void TryLoadFloat( json& jsonData, cstring key, f32& value ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() )
-        {
-            value = glTF::INVALID_FLOAT_VALUE;
-            return;
-        }
-
-        value = jsonData.value( key, 0.0f );
+    static void LoadString( JsonReader& reader, StringBuffer& stringBuffer ) {
+        // Unescaped straight into the destination.
+        reader.ReadString( stringBuffer );
     }
 
-    static void TryLoadBool( json& jsonData, cstring key, bool& value ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() )
-        {
-            value = false;
-            return;
-        }
-
-        value = jsonData.value( key, false );
-    }
-
-    static void TryLoadType( json& jsonData, cstring key, glTF::Accessor::Type& type ) {
-        std::string value = jsonData.value( key, "" );
+    static void LoadType( JsonReader& reader, glTF::Accessor::Type& type ) {
+        const std::string_view value = reader.ReadString();
         if ( value == "SCALAR" ) {
             type = glTF::Accessor::Type::Scalar;
         }
@@ -425,394 +403,584 @@ namespace Caustix {
         }
     }
 
-    static void TryLoadIntArray( json& jsonData, cstring key, u32& count, i32** array, Allocator* allocator ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() ) {
-            count = 0;
-            *array = nullptr;
-            return;
+    // Elements are loaded while the array is read, so the document is scanned once. The storage doubles when full,
+    // elements already loaded are moved: every string is constructed by its loader, so they are all valid objects.
+    template <typename T>
+    static T* GrowArray( T* values, u32 count, u32& capacity, Allocator* allocator ) {
+        const u32 newCapacity = capacity ? capacity * 2 : 4;
+        T* newValues = ( T* )AllocateAndZero( allocator, sizeof( T ) * newCapacity );
+        if constexpr ( std::is_trivially_copyable_v<T> ) {
+            if ( count ) {
+                memcpy( newValues, values, sizeof( T ) * count );
+            }
+        } else {
+            for ( u32 i = 0; i < count; ++i ) {
+                new ( &newValues[ i ] ) T( std::move( values[ i ] ) );
+                values[ i ].~T();
+            }
         }
 
-        json jsonArray = jsonData.at( key );
-
-        count = jsonArray.size();
-
-        i32* values = ( i32* )AllocateAndZero( allocator, sizeof( i32 ) * count );
-
-        for ( sizet i = 0; i < count; ++i ) {
-            values[ i ] = jsonArray.at( i );
+        if ( values ) {
+            allocator->deallocate( values );
         }
-
-        *array = values;
+        capacity = newCapacity;
+        return newValues;
     }
 
-    static void TryLoadFloatArray( json& jsonData, cstring key, u32& count, float** array, Allocator* allocator ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() ) {
-            count = 0;
-            *array = nullptr;
+    template <typename T, typename LoadElement>
+    static void LoadArray( JsonReader& reader, u32& count, T** array, Allocator* allocator, LoadElement&& loadElement ) {
+        count = 0;
+        *array = nullptr;
+
+        if ( !reader.BeginArray() ) {
             return;
         }
 
-        json json_array = jsonData.at( key );
-
-        count = json_array.size();
-
-        float* values = ( float* )AllocateAndZero( allocator, sizeof( float ) * count );
-
-        for ( sizet i = 0; i < count; ++i ) {
-            values[ i ] = json_array.at( i );
+        T* values = nullptr;
+        u32 capacity = 0;
+        while ( reader.NextElement() ) {
+            if ( count == capacity ) {
+                values = GrowArray( values, count, capacity, allocator );
+            }
+            loadElement( values[ count ] );
+            ++count;
         }
 
         *array = values;
     }
 
-    static void LoadScene(json& jsonData, glTF::Scene& scene, Allocator* allocator) {
-        TryLoadIntArray(jsonData, "nodes", scene.nodes_count, &scene.nodes, allocator);
+    static void LoadIntArray( JsonReader& reader, u32& count, i32** array, Allocator* allocator ) {
+        LoadArray( reader, count, array, allocator, [ &reader ]( i32& value ) {
+            value = reader.ReadInt();
+        } );
     }
 
-    static void LoadScenes(json& jsonData, glTF::glTF& gltfData, Allocator* allocator) {
-        json scenes = jsonData[ "scenes" ];
-
-        sizet scene_count = scenes.size();
-        gltfData.scenes = ( glTF::Scene* )AllocateAndZero( allocator, sizeof( glTF::Scene ) * scene_count );
-        gltfData.scenes_count = scene_count;
-
-        for ( sizet i = 0; i < scene_count; ++i ) {
-            LoadScene( scenes[ i ], gltfData.scenes[ i ], allocator );
-        }
+    static void LoadFloatArray( JsonReader& reader, u32& count, f32** array, Allocator* allocator ) {
+        LoadArray( reader, count, array, allocator, [ &reader ]( f32& value ) {
+            value = reader.ReadFloat();
+        } );
     }
 
-    static void LoadBuffer( json& jsonData, glTF::Buffer& buffer, Allocator* allocator ) {
-        TryLoadString( jsonData, "uri", buffer.uri, allocator );
-        TryLoadInt( jsonData, "byteLength", buffer.byte_length );
-        TryLoadString( jsonData, "name", buffer.name, allocator );
+    static void LoadStringArray( JsonReader& reader, u32& count, StringBuffer** array, Allocator* allocator ) {
+        LoadArray( reader, count, array, allocator, [ &reader, allocator ]( StringBuffer& value ) {
+            InitString( value, allocator );
+            LoadString( reader, value );
+        } );
     }
 
-    static void LoadBuffers( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json buffers = jsonData[ "buffers" ];
-
-        sizet buffer_count = buffers.size();
-        gltfData.buffers = ( glTF::Buffer* )AllocateAndZero( allocator, sizeof( glTF::Buffer ) * buffer_count );
-        gltfData.buffers_count = buffer_count;
+    static void LoadScene( JsonReader& reader, glTF::Scene& scene, Allocator* allocator ) {
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < buffer_count; ++i ) {
-            LoadBuffer( buffers[ i ], gltfData.buffers[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "nodes" ) {
+                LoadIntArray( reader, scene.nodes_count, &scene.nodes, allocator );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadBufferView( json& jsonData, glTF::BufferView& bufferView, Allocator* allocator ) {
-        TryLoadInt( jsonData, "buffer", bufferView.buffer );
-        TryLoadInt( jsonData, "byteLength", bufferView.byte_length );
-        TryLoadInt( jsonData, "byteOffset", bufferView.byte_offset );
-        TryLoadInt( jsonData, "byteStride", bufferView.byte_stride );
-        TryLoadInt( jsonData, "target", bufferView.target );
-        TryLoadString( jsonData, "name", bufferView.name, allocator );
-    }
-
-    static void LoadBufferViews( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json buffers = jsonData[ "bufferViews" ];
+    static void LoadBuffer( JsonReader& reader, glTF::Buffer& buffer, Allocator* allocator ) {
+        buffer.byte_length = glTF::INVALID_INT_VALUE;
+        buffer.data = nullptr;
+        InitString( buffer.uri, allocator );
+        InitString( buffer.name, allocator );
 
-        sizet buffer_count = buffers.size();
-        gltfData.buffer_views = ( glTF::BufferView* )AllocateAndZero( allocator, sizeof( glTF::BufferView ) * buffer_count );
-        gltfData.buffer_views_count = buffer_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < buffer_count; ++i ) {
-            LoadBufferView( buffers[ i ], gltfData.buffer_views[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "uri" ) {
+                LoadString( reader, buffer.uri );
+            } else if ( key == "byteLength" ) {
+                buffer.byte_length = reader.ReadInt();
+            } else if ( key == "name" ) {
+                LoadString( reader, buffer.name );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadNode( json& jsonData, glTF::Node& node, Allocator* allocator ) {
-        TryLoadInt( jsonData, "camera", node.camera );
-        TryLoadInt( jsonData, "mesh", node.mesh );
-        TryLoadInt( jsonData, "skin", node.skin );
-        TryLoadIntArray( jsonData, "children", node.children_count, &node.children, allocator );
-        TryLoadFloatArray( jsonData, "matrix", node.matrix_count, &node.matrix, allocator );
-        TryLoadFloatArray( jsonData, "rotation", node.rotation_count, &node.rotation, allocator );
-        TryLoadFloatArray( jsonData, "scale", node.scale_count, &node.scale, allocator );
-        TryLoadFloatArray( jsonData, "translation", node.translation_count, &node.translation, allocator );
-        TryLoadFloatArray( jsonData, "weights", node.weights_count, &node.weights, allocator );
-        TryLoadString( jsonData, "name", node.name, allocator );
-    }
-
-    static void LoadNodes( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "nodes" ];
+    static void LoadBufferView( JsonReader& reader, glTF::BufferView& bufferView, Allocator* allocator ) {
+        bufferView.buffer = glTF::INVALID_INT_VALUE;
+        bufferView.byte_length = glTF::INVALID_INT_VALUE;
+        bufferView.byte_offset = glTF::INVALID_INT_VALUE;
+        bufferView.byte_stride = glTF::INVALID_INT_VALUE;
+        bufferView.target = glTF::INVALID_INT_VALUE;
+        InitString( bufferView.name, allocator );
 
-        sizet array_count = array.size();
-        gltfData.nodes = ( glTF::Node* )AllocateAndZero( allocator, sizeof( glTF::Node ) * array_count );
-        gltfData.nodes_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadNode( array[ i ], gltfData.nodes[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "buffer" ) {
+                bufferView.buffer = reader.ReadInt();
+            } else if ( key == "byteLength" ) {
+                bufferView.byte_length = reader.ReadInt();
+            } else if ( key == "byteOffset" ) {
+                bufferView.byte_offset = reader.ReadInt();
+            } else if ( key == "byteStride" ) {
+                bufferView.byte_stride = reader.ReadInt();
+            } else if ( key == "target" ) {
+                bufferView.target = reader.ReadInt();
+            } else if ( key == "name" ) {
+                LoadString( reader, bufferView.name );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadMeshPrimitive( json& jsonData, glTF::MeshPrimitive& meshPrimitive, Allocator* allocator ) {
-        TryLoadInt( jsonData, "indices", meshPrimitive.indices );
-        TryLoadInt( jsonData, "material", meshPrimitive.material );
-        TryLoadInt( jsonData, "mode", meshPrimitive.mode );
-
-        json attributes = jsonData[ "attributes" ];
-
-        meshPrimitive.attributes = ( glTF::MeshPrimitive::Attribute* )AllocateAndZero( allocator, sizeof( glTF::MeshPrimitive::Attribute ) * attributes.size() );
-        meshPrimitive.attribute_count = attributes.size();
+    static void LoadNode( JsonReader& reader, glTF::Node& node, Allocator* allocator ) {
+        node.camera = glTF::INVALID_INT_VALUE;
+        node.mesh = glTF::INVALID_INT_VALUE;
+        node.skin = glTF::INVALID_INT_VALUE;
+        InitString( node.name, allocator );
 
-        u32 index = 0;
-        for ( auto json_attribute : attributes.items() ) {
-            std::string key = json_attribute.key();
-            glTF::MeshPrimitive::Attribute& attribute = meshPrimitive.attributes[ index ];
-
-            StringBuffer tempBuffer(*allocator);
-
-            memcpy(&attribute.key, &tempBuffer, sizeof (StringBuffer));
-
-            attribute.key.append( key.c_str() );
-
-            attribute.accessor_index = json_attribute.value();
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-            ++index;
+        while ( reader.NextKey( key ) ) {
+            if ( key == "camera" ) {
+                node.camera = reader.ReadInt();
+            } else if ( key == "mesh" ) {
+                node.mesh = reader.ReadInt();
+            } else if ( key == "skin" ) {
+                node.skin = reader.ReadInt();
+            } else if ( key == "children" ) {
+                LoadIntArray( reader, node.children_count, &node.children, allocator );
+            } else if ( key == "matrix" ) {
+                LoadFloatArray( reader, node.matrix_count, &node.matrix, allocator );
+            } else if ( key == "rotation" ) {
+                LoadFloatArray( reader, node.rotation_count, &node.rotation, allocator );
+            } else if ( key == "scale" ) {
+                LoadFloatArray( reader, node.scale_count, &node.scale, allocator );
+            } else if ( key == "translation" ) {
+                LoadFloatArray( reader, node.translation_count, &node.translation, allocator );
+            } else if ( key == "weights" ) {
+                LoadFloatArray( reader, node.weights_count, &node.weights, allocator );
+            } else if ( key == "name" ) {
+                LoadString( reader, node.name );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadMeshPrimitives( json& jsonData, glTF::Mesh& mesh, Allocator* allocator ) {
-        json array = jsonData[ "primitives" ];
+    static void LoadMeshPrimitiveAttributes( JsonReader& reader, glTF::MeshPrimitive& meshPrimitive, Allocator* allocator ) {
+        if ( !reader.BeginObject() ) {
+            return;
+        }
 
-        sizet array_count = array.size();
-        mesh.primitives = ( glTF::MeshPrimitive* )AllocateAndZero( allocator, sizeof( glTF::MeshPrimitive ) * array_count );
-        mesh.primitives_count = array_count;
+        u32 capacity = 0;
+        std::string_view key;
+        while ( reader.NextKey( key ) ) {
+            if ( meshPrimitive.attribute_count == capacity ) {
+                meshPrimitive.attributes = GrowArray( meshPrimitive.attributes, meshPrimitive.attribute_count, capacity, allocator );
+            }
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadMeshPrimitive( array[ i ], mesh.primitives[ i ], allocator );
+            glTF::MeshPrimitive::Attribute& attribute = meshPrimitive.attributes[ meshPrimitive.attribute_count++ ];
+            new ( &attribute ) glTF::MeshPrimitive::Attribute( *allocator );
+            attribute.key.assign( key.data(), key.size() );
+            attribute.accessor_index = reader.ReadInt( glTF::INVALID_INT_VALUE );
         }
     }
 
-    static void LoadMesh( json& jsonData, glTF::Mesh& mesh, Allocator* allocator ) {
-        LoadMeshPrimitives( jsonData, mesh, allocator );
-        TryLoadFloatArray( jsonData, "weights", mesh.weights_count, &mesh.weights, allocator );
-        TryLoadString( jsonData, "name", mesh.name, allocator );
-    }
-
-    static void LoadMeshes( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "meshes" ];
+    static void LoadMeshPrimitive( JsonReader& reader, glTF::MeshPrimitive& meshPrimitive, Allocator* allocator ) {
+        meshPrimitive.indices = glTF::INVALID_INT_VALUE;
+        meshPrimitive.material = glTF::INVALID_INT_VALUE;
+        meshPrimitive.mode = glTF::INVALID_INT_VALUE;
 
-        sizet array_count = array.size();
-        gltfData.meshes = ( glTF::Mesh* )AllocateAndZero( allocator, sizeof( glTF::Mesh ) * array_count );
-        gltfData.meshes_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadMesh( array[ i ], gltfData.meshes[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "indices" ) {
+                meshPrimitive.indices = reader.ReadInt();
+            } else if ( key == "material" ) {
+                meshPrimitive.material = reader.ReadInt();
+            } else if ( key == "mode" ) {
+                meshPrimitive.mode = reader.ReadInt();
+            } else if ( key == "attributes" ) {
+                LoadMeshPrimitiveAttributes( reader, meshPrimitive, allocator );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadAccessor( json& jsonData, glTF::Accessor& accessor, Allocator* allocator ) {
-        TryLoadInt( jsonData, "bufferView", accessor.buffer_view );
-        TryLoadInt( jsonData, "byteOffset", accessor.byte_offset );
-        TryLoadInt( jsonData, "componentType", accessor.component_type );
-        TryLoadInt( jsonData, "count", accessor.count );
-        TryLoadInt( jsonData, "sparse", accessor.sparse );
-        TryLoadFloatArray( jsonData, "max", accessor.max_count, &accessor.max, allocator );
-        TryLoadFloatArray( jsonData, "min", accessor.min_count, &accessor.min, allocator );
-        TryLoadBool( jsonData, "normalized", accessor.normalized );
-        TryLoadType( jsonData, "type", accessor.type );
-    }
-
-    static void LoadAccessors( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "accessors" ];
+    static void LoadMesh( JsonReader& reader, glTF::Mesh& mesh, Allocator* allocator ) {
+        InitString( mesh.name, allocator );
 
-        sizet array_count = array.size();
-        gltfData.accessors = ( glTF::Accessor* )AllocateAndZero( allocator, sizeof( glTF::Accessor ) * array_count );
-        gltfData.accessors_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadAccessor( array[ i ], gltfData.accessors[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "primitives" ) {
+                LoadArray( reader, mesh.primitives_count, &mesh.primitives, allocator, [ &reader, allocator ]( glTF::MeshPrimitive& primitive ) {
+                    LoadMeshPrimitive( reader, primitive, allocator );
+                } );
+            } else if ( key == "weights" ) {
+                LoadFloatArray( reader, mesh.weights_count, &mesh.weights, allocator );
+            } else if ( key == "name" ) {
+                LoadString( reader, mesh.name );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void TryLoadTextureInfo( json& jsonData, cstring key, glTF::TextureInfo** texture_info, Allocator* allocator ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() ) {
-            *texture_info = nullptr;
+    static void LoadAccessorSparseIndices( JsonReader& reader, glTF::AccessorSparseIndices& indices ) {
+        indices.buffer_view = glTF::INVALID_INT_VALUE;
+        indices.byte_offset = glTF::INVALID_INT_VALUE;
+        indices.component_type = glTF::INVALID_INT_VALUE;
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
             return;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "bufferView" ) {
+                indices.buffer_view = reader.ReadInt();
+            } else if ( key == "byteOffset" ) {
+                indices.byte_offset = reader.ReadInt();
+            } else if ( key == "componentType" ) {
+                indices.component_type = reader.ReadInt();
+            } else {
+                reader.Skip();
+            }
         }
+    }
 
-        glTF::TextureInfo* ti = ( glTF::TextureInfo* ) allocator->allocate( sizeof( glTF::TextureInfo ), 64 );
+    static void LoadAccessorSparseValues( JsonReader& reader, glTF::AccessorSparseValues& values ) {
+        values.bufferView = glTF::INVALID_INT_VALUE;
+        values.byteOffset = glTF::INVALID_INT_VALUE;
 
-        TryLoadInt( *it, "index", ti->index );
-        TryLoadInt( *it, "texCoord", ti->texCoord );
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        *texture_info = ti;
+        while ( reader.NextKey( key ) ) {
+            if ( key == "bufferView" ) {
+                values.bufferView = reader.ReadInt();
+            } else if ( key == "byteOffset" ) {
+                values.byteOffset = reader.ReadInt();
+            } else {
+                reader.Skip();
+            }
+        }
     }
 
-    static void TryLoadMaterialNormalTextureInfo( json& jsonData, cstring key, glTF::MaterialNormalTextureInfo** texture_info, Allocator* allocator ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() ) {
-            *texture_info = nullptr;
-            return;
+    static glTF::AccessorSparse* LoadAccessorSparse( JsonReader& reader, Allocator* allocator ) {
+        glTF::AccessorSparse* sparse = ( glTF::AccessorSparse* ) allocator->allocate( sizeof( glTF::AccessorSparse ), 64 );
+        sparse->count = glTF::INVALID_INT_VALUE;
+        sparse->indices = { glTF::INVALID_INT_VALUE, glTF::INVALID_INT_VALUE, glTF::INVALID_INT_VALUE };
+        sparse->values = { glTF::INVALID_INT_VALUE, glTF::INVALID_INT_VALUE };
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return sparse;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "count" ) {
+                sparse->count = reader.ReadInt();
+            } else if ( key == "indices" ) {
+                LoadAccessorSparseIndices( reader, sparse->indices );
+            } else if ( key == "values" ) {
+                LoadAccessorSparseValues( reader, sparse->values );
+            } else {
+                reader.Skip();
+            }
         }
-
-        glTF::MaterialNormalTextureInfo* ti = ( glTF::MaterialNormalTextureInfo* ) allocator->allocate( sizeof( glTF::MaterialNormalTextureInfo ), 64 );
-
-        TryLoadInt( *it, "index", ti->index );
-        TryLoadInt( *it, "texCoord", ti->tex_coord );
-        TryLoadFloat( *it, "scale", ti->scale );
-
-        *texture_info = ti;
+        return sparse;
     }
 
-    static void TryLoadMaterialOcclusionTextureInfo( json& jsonData, cstring key, glTF::MaterialOcclusionTextureInfo** texture_info, Allocator* allocator ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() ) {
-            *texture_info = nullptr;
+    static void LoadAccessor( JsonReader& reader, glTF::Accessor& accessor, Allocator* allocator ) {
+        accessor.buffer_view = glTF::INVALID_INT_VALUE;
+        accessor.byte_offset = glTF::INVALID_INT_VALUE;
+        accessor.component_type = glTF::INVALID_INT_VALUE;
+        accessor.count = glTF::INVALID_INT_VALUE;
+        accessor.sparse = nullptr;
+        accessor.normalized = false;
+        accessor.type = glTF::Accessor::Type::Scalar;
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
             return;
-        }
-
-        glTF::MaterialOcclusionTextureInfo* ti = ( glTF::MaterialOcclusionTextureInfo* ) allocator->allocate( sizeof( glTF::MaterialOcclusionTextureInfo ), 64 );
 
-        TryLoadInt( *it, "index", ti->index );
-        TryLoadInt( *it, "texCoord", ti->texCoord );
-        TryLoadFloat( *it, "strength", ti->strength );
-
-        *texture_info = ti;
+        while ( reader.NextKey( key ) ) {
+            if ( key == "bufferView" ) {
+                accessor.buffer_view = reader.ReadInt();
+            } else if ( key == "byteOffset" ) {
+                accessor.byte_offset = reader.ReadInt();
+            } else if ( key == "componentType" ) {
+                accessor.component_type = reader.ReadInt();
+            } else if ( key == "count" ) {
+                accessor.count = reader.ReadInt();
+            } else if ( key == "sparse" ) {
+                accessor.sparse = LoadAccessorSparse( reader, allocator );
+            } else if ( key == "max" ) {
+                LoadFloatArray( reader, accessor.max_count, &accessor.max, allocator );
+            } else if ( key == "min" ) {
+                LoadFloatArray( reader, accessor.min_count, &accessor.min, allocator );
+            } else if ( key == "normalized" ) {
+                accessor.normalized = reader.ReadBool();
+            } else if ( key == "type" ) {
+                LoadType( reader, accessor.type );
+            } else {
+                reader.Skip();
+            }
+        }
     }
 
-    static void TryLoadMaterialPBRMetallicRoughness( json& jsonData, cstring key, glTF::MaterialPBRMetallicRoughness** texture_info, Allocator* allocator ) {
-        auto it = jsonData.find( key );
-        if ( it == jsonData.end() )
-        {
-            *texture_info = nullptr;
-            return;
+    static glTF::TextureInfo* LoadTextureInfo( JsonReader& reader, Allocator* allocator ) {
+        glTF::TextureInfo* ti = ( glTF::TextureInfo* ) allocator->allocate( sizeof( glTF::TextureInfo ), 64 );
+        ti->index = glTF::INVALID_INT_VALUE;
+        ti->texCoord = glTF::INVALID_INT_VALUE;
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return ti;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "index" ) {
+                ti->index = reader.ReadInt();
+            } else if ( key == "texCoord" ) {
+                ti->texCoord = reader.ReadInt();
+            } else {
+                reader.Skip();
+            }
         }
-
-        glTF::MaterialPBRMetallicRoughness* ti = ( glTF::MaterialPBRMetallicRoughness* ) allocator->allocate( sizeof( glTF::MaterialPBRMetallicRoughness ), 64 );
-
-        TryLoadFloatArray( *it, "baseColorFactor", ti->base_color_factor_count, &ti->base_color_factor, allocator );
-        TryLoadTextureInfo( *it, "baseColorTexture", &ti->base_color_texture, allocator );
-        TryLoadFloat( *it, "metallicFactor", ti->metallic_factor );
-        TryLoadTextureInfo( *it, "metallicRoughnessTexture", &ti->metallic_roughness_texture, allocator );
-        TryLoadFloat( *it, "roughnessFactor", ti->roughness_factor );
-
-        *texture_info = ti;
+        return ti;
     }
 
-    static void load_material( json& json_data, glTF::Material& material, Allocator* allocator ) {
-        TryLoadFloatArray( json_data, "emissiveFactor", material.emissive_factor_count, &material.emissive_factor, allocator );
-        TryLoadFloat( json_data, "alphaCutoff", material.alpha_cutoff );
-        TryLoadString( json_data, "alphaMode", material.alpha_mode, allocator );
-        TryLoadBool( json_data, "doubleSided", material.double_sided );
-
-        TryLoadTextureInfo( json_data, "emissiveTexture", &material.emissive_texture, allocator );
-        TryLoadMaterialNormalTextureInfo( json_data, "normalTexture", &material.normal_texture, allocator );
-        TryLoadMaterialOcclusionTextureInfo( json_data, "occlusionTexture", &material.occlusion_texture, allocator );
-        TryLoadMaterialPBRMetallicRoughness( json_data, "pbrMetallicRoughness", &material.pbr_metallic_roughness, allocator );
-
-        TryLoadString( json_data, "name", material.name, allocator );
+    static glTF::MaterialNormalTextureInfo* LoadMaterialNormalTextureInfo( JsonReader& reader, Allocator* allocator ) {
+        glTF::MaterialNormalTextureInfo* ti = ( glTF::MaterialNormalTextureInfo* ) allocator->allocate( sizeof( glTF::MaterialNormalTextureInfo ), 64 );
+        ti->index = glTF::INVALID_INT_VALUE;
+        ti->tex_coord = glTF::INVALID_INT_VALUE;
+        ti->scale = glTF::INVALID_FLOAT_VALUE;
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return ti;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "index" ) {
+                ti->index = reader.ReadInt();
+            } else if ( key == "texCoord" ) {
+                ti->tex_coord = reader.ReadInt();
+            } else if ( key == "scale" ) {
+                ti->scale = reader.ReadFloat();
+            } else {
+                reader.Skip();
+            }
+        }
+        return ti;
     }
 
-    static void LoadMaterials( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "materials" ];
-
-        sizet array_count = array.size();
-        gltfData.materials = ( glTF::Material* )AllocateAndZero( allocator, sizeof( glTF::Material ) * array_count );
-        gltfData.materials_count = array_count;
-
-        for ( sizet i = 0; i < array_count; ++i ) {
-            load_material( array[ i ], gltfData.materials[ i ], allocator );
+    static glTF::MaterialOcclusionTextureInfo* LoadMaterialOcclusionTextureInfo( JsonReader& reader, Allocator* allocator ) {
+        glTF::MaterialOcclusionTextureInfo* ti = ( glTF::MaterialOcclusionTextureInfo* ) allocator->allocate( sizeof( glTF::MaterialOcclusionTextureInfo ), 64 );
+        ti->index = glTF::INVALID_INT_VALUE;
+        ti->texCoord = glTF::INVALID_INT_VALUE;
+        ti->strength = glTF::INVALID_FLOAT_VALUE;
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return ti;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "index" ) {
+                ti->index = reader.ReadInt();
+            } else if ( key == "texCoord" ) {
+                ti->texCoord = reader.ReadInt();
+            } else if ( key == "strength" ) {
+                ti->strength = reader.ReadFloat();
+            } else {
+                reader.Skip();
+            }
         }
+        return ti;
     }
 
-    static void LoadTexture( json& jsonData, glTF::Texture& texture, Allocator* allocator ) {
-        TryLoadInt( jsonData, "sampler", texture.sampler );
-        TryLoadInt( jsonData, "source", texture.source );
-        TryLoadString( jsonData, "name", texture.name, allocator );
+    static glTF::MaterialPBRMetallicRoughness* LoadMaterialPBRMetallicRoughness( JsonReader& reader, Allocator* allocator ) {
+        glTF::MaterialPBRMetallicRoughness* ti = ( glTF::MaterialPBRMetallicRoughness* ) AllocateAndZero( allocator, sizeof( glTF::MaterialPBRMetallicRoughness ) );
+        ti->metallic_factor = glTF::INVALID_FLOAT_VALUE;
+        ti->roughness_factor = glTF::INVALID_FLOAT_VALUE;
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return ti;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "baseColorFactor" ) {
+                LoadFloatArray( reader, ti->base_color_factor_count, &ti->base_color_factor, allocator );
+            } else if ( key == "baseColorTexture" ) {
+                ti->base_color_texture = LoadTextureInfo( reader, allocator );
+            } else if ( key == "metallicFactor" ) {
+                ti->metallic_factor = reader.ReadFloat();
+            } else if ( key == "metallicRoughnessTexture" ) {
+                ti->metallic_roughness_texture = LoadTextureInfo( reader, allocator );
+            } else if ( key == "roughnessFactor" ) {
+                ti->roughness_factor = reader.ReadFloat();
+            } else {
+                reader.Skip();
+            }
+        }
+        return ti;
     }
 
-    static void LoadTextures( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "textures" ];
+    static void LoadMaterial( JsonReader& reader, glTF::Material& material, Allocator* allocator ) {
+        material.alpha_cutoff = glTF::INVALID_FLOAT_VALUE;
+        material.double_sided = false;
+        InitString( material.alpha_mode, allocator );
+        InitString( material.name, allocator );
 
-        sizet array_count = array.size();
-        gltfData.textures = ( glTF::Texture* )AllocateAndZero( allocator, sizeof( glTF::Texture ) * array_count );
-        gltfData.textures_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadTexture( array[ i ], gltfData.textures[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "emissiveFactor" ) {
+                LoadFloatArray( reader, material.emissive_factor_count, &material.emissive_factor, allocator );
+            } else if ( key == "alphaCutoff" ) {
+                material.alpha_cutoff = reader.ReadFloat();
+            } else if ( key == "alphaMode" ) {
+                LoadString( reader, material.alpha_mode );
+            } else if ( key == "doubleSided" ) {
+                material.double_sided = reader.ReadBool();
+            } else if ( key == "emissiveTexture" ) {
+                material.emissive_texture = LoadTextureInfo( reader, allocator );
+            } else if ( key == "normalTexture" ) {
+                material.normal_texture = LoadMaterialNormalTextureInfo( reader, allocator );
+            } else if ( key == "occlusionTexture" ) {
+                material.occlusion_texture = LoadMaterialOcclusionTextureInfo( reader, allocator );
+            } else if ( key == "pbrMetallicRoughness" ) {
+                material.pbr_metallic_roughness = LoadMaterialPBRMetallicRoughness( reader, allocator );
+            } else if ( key == "name" ) {
+                LoadString( reader, material.name );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadImage( json& jsonData, glTF::Image& image, Allocator* allocator ) {
-        TryLoadInt( jsonData, "bufferView", image.buffer_view );
-        TryLoadString( jsonData, "mimeType", image.mime_type, allocator );
-        TryLoadString( jsonData, "uri", image.uri, allocator );
-    }
-
-    static void LoadImages( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "images" ];
+    static void LoadTexture( JsonReader& reader, glTF::Texture& texture, Allocator* allocator ) {
+        texture.sampler = glTF::INVALID_INT_VALUE;
+        texture.source = glTF::INVALID_INT_VALUE;
+        InitString( texture.name, allocator );
 
-        sizet array_count = array.size();
-        gltfData.images = ( glTF::Image* )AllocateAndZero( allocator, sizeof( glTF::Image ) * array_count );
-        gltfData.images_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadImage( array[ i ], gltfData.images[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "sampler" ) {
+                texture.sampler = reader.ReadInt();
+            } else if ( key == "source" ) {
+                texture.source = reader.ReadInt();
+            } else if ( key == "name" ) {
+                LoadString( reader, texture.name );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadSampler( json& jsonData, glTF::Sampler& sampler, Allocator* allocator ) {
-        TryLoadInt( jsonData, "magFilter", sampler.mag_filter );
-        TryLoadInt( jsonData, "minFilter", sampler.min_filter );
-        TryLoadInt( jsonData, "wrapS", sampler.wrap_s );
-        TryLoadInt( jsonData, "wrapT", sampler.wrap_t );
-    }
-
-    static void LoadSamplers( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "samplers" ];
+    static void LoadImage( JsonReader& reader, glTF::Image& image, Allocator* allocator ) {
+        image.buffer_view = glTF::INVALID_INT_VALUE;
+        image.data = nullptr;
+        image.data_size = 0;
+        InitString( image.mime_type, allocator );
+        InitString( image.uri, allocator );
 
-        sizet array_count = array.size();
-        gltfData.samplers = ( glTF::Sampler* )AllocateAndZero( allocator, sizeof( glTF::Sampler ) * array_count );
-        gltfData.samplers_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadSampler( array[ i ], gltfData.samplers[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "bufferView" ) {
+                image.buffer_view = reader.ReadInt();
+            } else if ( key == "mimeType" ) {
+                LoadString( reader, image.mime_type );
+            } else if ( key == "uri" ) {
+                LoadString( reader, image.uri );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadSkin( json& jsonData, glTF::Skin& skin, Allocator* allocator ) {
-        TryLoadInt( jsonData, "skeleton", skin.skeleton_root_node_index );
-        TryLoadInt( jsonData, "inverseBindMatrices", skin.inverse_bind_matrices_buffer_index );
-        TryLoadIntArray( jsonData, "joints", skin.joints_count, &skin.joints, allocator );
-    }
+    static void LoadSampler( JsonReader& reader, glTF::Sampler& sampler ) {
+        sampler.mag_filter = glTF::INVALID_INT_VALUE;
+        sampler.min_filter = glTF::INVALID_INT_VALUE;
+        sampler.wrap_s = glTF::INVALID_INT_VALUE;
+        sampler.wrap_t = glTF::INVALID_INT_VALUE;
 
-    static void LoadSkins( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "skins" ];
-
-        sizet array_count = array.size();
-        gltfData.skins = ( glTF::Skin* )AllocateAndZero( allocator, sizeof( glTF::Skin ) * array_count );
-        gltfData.skins_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadSkin( array[ i ], gltfData.skins[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "magFilter" ) {
+                sampler.mag_filter = reader.ReadInt();
+            } else if ( key == "minFilter" ) {
+                sampler.min_filter = reader.ReadInt();
+            } else if ( key == "wrapS" ) {
+                sampler.wrap_s = reader.ReadInt();
+            } else if ( key == "wrapT" ) {
+                sampler.wrap_t = reader.ReadInt();
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadAnimation( json& jsonData, glTF::Animation& animation, Allocator* allocator ) {
+    static void LoadSkin( JsonReader& reader, glTF::Skin& skin, Allocator* allocator ) {
+        skin.skeleton_root_node_index = glTF::INVALID_INT_VALUE;
+        skin.inverse_bind_matrices_buffer_index = glTF::INVALID_INT_VALUE;
 
-        json json_array = jsonData.at( "samplers" );
-        if ( json_array.is_array() ) {
-            sizet count = json_array.size();
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-            glTF::AnimationSampler* values = ( glTF::AnimationSampler* )AllocateAndZero( allocator, sizeof( glTF::AnimationSampler ) * count );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "skeleton" ) {
+                skin.skeleton_root_node_index = reader.ReadInt();
+            } else if ( key == "inverseBindMatrices" ) {
+                skin.inverse_bind_matrices_buffer_index = reader.ReadInt();
+            } else if ( key == "joints" ) {
+                LoadIntArray( reader, skin.joints_count, &skin.joints, allocator );
+            } else {
+                reader.Skip();
+            }
+        }
+    }
 
-            for ( sizet i = 0; i < count; ++i ) {
-                json element = json_array.at( i );
-                glTF::AnimationSampler& sampler = values[ i ];
+    static void LoadAnimationSampler( JsonReader& reader, glTF::AnimationSampler& sampler ) {
+        sampler.input_keyframe_buffer_index = glTF::INVALID_INT_VALUE;
+        sampler.output_keyframe_buffer_index = glTF::INVALID_INT_VALUE;
+        sampler.interpolation = glTF::AnimationSampler::Linear;
 
-                TryLoadInt( element, "input", sampler.input_keyframe_buffer_index );
-                TryLoadInt( element, "output", sampler.output_keyframe_buffer_index );
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-                std::string value = element.value( "interpolation", "");
-                if ( value == "LINEAR" ) {
-                    sampler.interpolation = glTF::AnimationSampler::Linear;
-                }
-                else if ( value == "STEP" ) {
+        while ( reader.NextKey( key ) ) {
+            if ( key == "input" ) {
+                sampler.input_keyframe_buffer_index = reader.ReadInt();
+            } else if ( key == "output" ) {
+                sampler.output_keyframe_buffer_index = reader.ReadInt();
+            } else if ( key == "interpolation" ) {
+                const std::string_view value = reader.ReadString();
+                if ( value == "STEP" ) {
                     sampler.interpolation = glTF::AnimationSampler::Step;
                 }
                 else if ( value == "CUBICSPLINE" ) {
@@ -821,123 +989,347 @@ namespace Caustix {
                 else {
                     sampler.interpolation = glTF::AnimationSampler::Linear;
                 }
+            } else {
+                reader.Skip();
             }
-
-            animation.samplers = values;
-            animation.samplers_count = count;
         }
+    }
 
-        json_array = jsonData.at( "channels" );
-        if ( json_array.is_array() ) {
-            sizet count = json_array.size();
-
-            glTF::AnimationChannel* values = ( glTF::AnimationChannel* )AllocateAndZero( allocator, sizeof( glTF::AnimationChannel ) * count );
-
-            for ( sizet i = 0; i < count; ++i ) {
-                json element = json_array.at( i );
-                glTF::AnimationChannel& channel = values[ i ];
-
-                TryLoadInt( element, "sampler", channel.sampler );
-                json target = element.at( "target" );
-                TryLoadInt( target, "node", channel.target_node );
+    static void LoadAnimationChannelTarget( JsonReader& reader, glTF::AnimationChannel& channel ) {
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-                std::string target_path = target.value( "path", "");
-                if ( target_path == "scale" ) {
+        while ( reader.NextKey( key ) ) {
+            if ( key == "node" ) {
+                channel.target_node = reader.ReadInt();
+            } else if ( key == "path" ) {
+                const std::string_view targetPath = reader.ReadString();
+                if ( targetPath == "scale" ) {
                     channel.target_type = glTF::AnimationChannel::Scale;
                 }
-                else if ( target_path == "rotation" ) {
+                else if ( targetPath == "rotation" ) {
                     channel.target_type = glTF::AnimationChannel::Rotation;
                 }
-                else if ( target_path == "translation" ) {
+                else if ( targetPath == "translation" ) {
                     channel.target_type = glTF::AnimationChannel::Translation;
                 }
-                else if ( target_path == "weights" ) {
+                else if ( targetPath == "weights" ) {
                     channel.target_type = glTF::AnimationChannel::Weights;
                 }
                 else {
-                    error( "Error parsing target path %s\n", target_path.c_str() );
+                    error( "Error parsing target path {}", targetPath );
                     CASSERT( false );
                     channel.target_type = glTF::AnimationChannel::Count;
                 }
+            } else {
+                reader.Skip();
             }
-
-            animation.channels = values;
-            animation.channels_count = count;
         }
     }
 
-    static void LoadAnimations( json& jsonData, glTF::glTF& gltfData, Allocator* allocator ) {
-        json array = jsonData[ "animations" ];
+    static void LoadAnimationChannel( JsonReader& reader, glTF::AnimationChannel& channel ) {
+        channel.sampler = glTF::INVALID_INT_VALUE;
+        channel.target_node = glTF::INVALID_INT_VALUE;
+        channel.target_type = glTF::AnimationChannel::Count;
 
-        sizet array_count = array.size();
-        gltfData.animations = ( glTF::Animation* )AllocateAndZero( allocator, sizeof( glTF::Animation ) * array_count );
-        gltfData.animations_count = array_count;
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
 
-        for ( sizet i = 0; i < array_count; ++i ) {
-            LoadAnimation( array[ i ], gltfData.animations[ i ], allocator );
+        while ( reader.NextKey( key ) ) {
+            if ( key == "sampler" ) {
+                channel.sampler = reader.ReadInt();
+            } else if ( key == "target" ) {
+                LoadAnimationChannelTarget( reader, channel );
+            } else {
+                reader.Skip();
+            }
         }
     }
 
-    static void LoadAsset( json& jsonData, glTF::glTF& gltfData, Allocator* allocator) {
-        json jsonAsset = jsonData[ "asset" ];
+    static void LoadAnimation( JsonReader& reader, glTF::Animation& animation, Allocator* allocator ) {
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "samplers" ) {
+                LoadArray( reader, animation.samplers_count, &animation.samplers, allocator, [ &reader ]( glTF::AnimationSampler& sampler ) {
+                    LoadAnimationSampler( reader, sampler );
+                } );
+            } else if ( key == "channels" ) {
+                LoadArray( reader, animation.channels_count, &animation.channels, allocator, [ &reader ]( glTF::AnimationChannel& channel ) {
+                    LoadAnimationChannel( reader, channel );
+                } );
+            } else {
+                reader.Skip();
+            }
+        }
+    }
 
+    static void LoadAsset( JsonReader& reader, glTF::glTF& gltfData, Allocator* allocator ) {
         gltfData.asset = ( glTF::Asset* )AllocateAndZero( allocator, sizeof( glTF::Asset ) );
 
-        TryLoadString(jsonAsset, "copyright", gltfData.asset->copyright, allocator);
-        TryLoadString(jsonAsset, "generator", gltfData.asset->generator, allocator);
-        TryLoadString(jsonAsset, "minVersion", gltfData.asset->minVersion, allocator);
-        TryLoadString(jsonAsset, "version", gltfData.asset->version, allocator);
+        glTF::Asset& asset = *gltfData.asset;
+        InitString( asset.copyright, allocator );
+        InitString( asset.generator, allocator );
+        InitString( asset.minVersion, allocator );
+        InitString( asset.version, allocator );
+
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "copyright" ) {
+                LoadString( reader, asset.copyright );
+            } else if ( key == "generator" ) {
+                LoadString( reader, asset.generator );
+            } else if ( key == "minVersion" ) {
+                LoadString( reader, asset.minVersion );
+            } else if ( key == "version" ) {
+                LoadString( reader, asset.version );
+            } else {
+                reader.Skip();
+            }
+        }
+    }
+
+    // Top level properties are dispatched as they come, in a single pass over the document.
+    static void LoadDocument( JsonReader& reader, glTF::glTF& result, Allocator* allocator ) {
+        std::string_view key;
+        if ( !reader.BeginObject() )
+            return;
+
+        while ( reader.NextKey( key ) ) {
+            if ( key == "asset" ) {
+                LoadAsset( reader, result, allocator );
+            } else if ( key == "scene" ) {
+                result.scene = reader.ReadInt();
+            } else if ( key == "scenes" ) {
+                LoadArray( reader, result.scenes_count, &result.scenes, allocator, [ &reader, allocator ]( glTF::Scene& scene ) {
+                    LoadScene( reader, scene, allocator );
+                } );
+            } else if ( key == "buffers" ) {
+                LoadArray( reader, result.buffers_count, &result.buffers, allocator, [ &reader, allocator ]( glTF::Buffer& buffer ) {
+                    LoadBuffer( reader, buffer, allocator );
+                } );
+            } else if ( key == "bufferViews" ) {
+                LoadArray( reader, result.buffer_views_count, &result.buffer_views, allocator, [ &reader, allocator ]( glTF::BufferView& bufferView ) {
+                    LoadBufferView( reader, bufferView, allocator );
+                } );
+            } else if ( key == "nodes" ) {
+                LoadArray( reader, result.nodes_count, &result.nodes, allocator, [ &reader, allocator ]( glTF::Node& node ) {
+                    LoadNode( reader, node, allocator );
+                } );
+            } else if ( key == "meshes" ) {
+                LoadArray( reader, result.meshes_count, &result.meshes, allocator, [ &reader, allocator ]( glTF::Mesh& mesh ) {
+                    LoadMesh( reader, mesh, allocator );
+                } );
+            } else if ( key == "accessors" ) {
+                LoadArray( reader, result.accessors_count, &result.accessors, allocator, [ &reader, allocator ]( glTF::Accessor& accessor ) {
+                    LoadAccessor( reader, accessor, allocator );
+                } );
+            } else if ( key == "materials" ) {
+                LoadArray( reader, result.materials_count, &result.materials, allocator, [ &reader, allocator ]( glTF::Material& material ) {
+                    LoadMaterial( reader, material, allocator );
+                } );
+            } else if ( key == "textures" ) {
+                LoadArray( reader, result.textures_count, &result.textures, allocator, [ &reader, allocator ]( glTF::Texture& texture ) {
+                    LoadTexture( reader, texture, allocator );
+                } );
+            } else if ( key == "images" ) {
+                LoadArray( reader, result.images_count, &result.images, allocator, [ &reader, allocator ]( glTF::Image& image ) {
+                    LoadImage( reader, image, allocator );
+                } );
+            } else if ( key == "samplers" ) {
+                LoadArray( reader, result.samplers_count, &result.samplers, allocator, [ &reader ]( glTF::Sampler& sampler ) {
+                    LoadSampler( reader, sampler );
+                } );
+            } else if ( key == "skins" ) {
+                LoadArray( reader, result.skins_count, &result.skins, allocator, [ &reader, allocator ]( glTF::Skin& skin ) {
+                    LoadSkin( reader, skin, allocator );
+                } );
+            } else if ( key == "animations" ) {
+                LoadArray( reader, result.animations_count, &result.animations, allocator, [ &reader, allocator ]( glTF::Animation& animation ) {
+                    LoadAnimation( reader, animation, allocator );
+                } );
+            } else if ( key == "extensionsUsed" ) {
+                LoadStringArray( reader, result.extensions_used_count, &result.extensions_used, allocator );
+            } else if ( key == "extensionsRequired" ) {
+                LoadStringArray( reader, result.extensions_required_count, &result.extensions_required, allocator );
+            } else {
+                reader.Skip();
+            }
+        }
+    }
+
+    // GLB container: a 12 bytes header followed by 8 bytes aligned chunks, JSON first and then an optional binary chunk.
+    static constexpr u32 k_glb_magic            = 0x46546C67; // "glTF"
+    static constexpr u32 k_glb_version          = 2;
+    static constexpr u32 k_glb_header_size      = 12;
+    static constexpr u32 k_glb_chunk_header_size = 8;
+    static constexpr u32 k_glb_chunk_json       = 0x4E4F534A; // "JSON"
+    static constexpr u32 k_glb_chunk_bin        = 0x004E4942; // "BIN\0"
+
+    static u32 ReadGlbU32( const u8* data ) {
+        u32 value;
+        memcpy( &value, data, sizeof( u32 ) );
+        return value;
+    }
+
+    static bool IsGlb( const MappedFile& file ) {
+        return file.m_size >= k_glb_header_size && ReadGlbU32( file.m_data ) == k_glb_magic;
+    }
+
+    // Finds the JSON and binary chunks inside the mapping, the binary chunk is optional.
+    static bool ParseGlbChunks( cstring filePath, const MappedFile& file, std::span<const u8>& json, std::span<const u8>& binary ) {
+        const u32 version = ReadGlbU32( file.m_data + 4 );
+        const sizet length = std::min<sizet>( ReadGlbU32( file.m_data + 8 ), file.m_size );
+        if ( version != k_glb_version ) {
+            error( "Error: {} is a GLB version {} file, only version {} is supported.", filePath, version, k_glb_version );
+            return false;
+        }
+
+        sizet offset = k_glb_header_size;
+        if ( offset + k_glb_chunk_header_size > length ) {
+            error( "Error: {} has no JSON chunk.", filePath );
+            return false;
+        }
+
+        const u32 jsonLength = ReadGlbU32( file.m_data + offset );
+        const u32 jsonType = ReadGlbU32( file.m_data + offset + 4 );
+        offset += k_glb_chunk_header_size;
+        if ( jsonType != k_glb_chunk_json || offset + jsonLength > length ) {
+            error( "Error: {} has an invalid JSON chunk.", filePath );
+            return false;
+        }
+        json = file.GetSpan( offset, jsonLength );
+        offset = MemoryAlign( offset + jsonLength, 4 );
+
+        binary = {};
+        if ( offset + k_glb_chunk_header_size <= length ) {
+            const u32 binaryLength = ReadGlbU32( file.m_data + offset );
+            const u32 binaryType = ReadGlbU32( file.m_data + offset + 4 );
+            offset += k_glb_chunk_header_size;
+            if ( binaryType == k_glb_chunk_bin && offset + binaryLength <= length ) {
+                binary = file.GetSpan( offset, binaryLength );
+            }
+        }
+
+        return true;
+    }
+
+    // data:[<media type>][;base64],<data>
+    static bool IsDataUri( const StringBuffer& uri ) {
+        return uri.starts_with( "data:" );
+    }
+
+    static void ReleaseUri( StringBuffer& uri ) {
+        uri.clear();
+        uri.shrink_to_fit();
+    }
+
+    // Decodes a base64 data uri straight into an allocation of the decoded size and releases the text.
+    // The text is released on failure too, so it is never taken for a file path: the result then has neither data nor uri.
+    static const u8* LoadDataUri( cstring filePath, StringBuffer& uri, Allocator* allocator, sizet& size ) {
+        size = 0;
+
+        const sizet comma = uri.find( ',' );
+        if ( comma == StringBuffer::npos || !std::string_view( uri.data(), comma ).ends_with( ";base64" ) ) {
+            error( "Error: {} has a data uri that is not base64 encoded.", filePath );
+            ReleaseUri( uri );
+            return nullptr;
+        }
+
+        const char* text = uri.data() + comma + 1;
+        const sizet length = uri.size() - comma - 1;
+        const sizet decodedSize = Base64DecodedSize( text, length );
+
+        u8* data = ( u8* )allocator->allocate( decodedSize ? decodedSize : 1, 64 );
+        if ( !Base64Decode( text, length, data ) ) {
+            error( "Error: {} has an invalid base64 data uri.", filePath );
+            allocator->deallocate( data );
+            ReleaseUri( uri );
+            return nullptr;
+        }
+
+        ReleaseUri( uri );
+
+        size = decodedSize;
+        return data;
+    }
+
+    static void LoadDataUris( cstring filePath, glTF::glTF& result ) {
+        for ( u32 bufferIndex = 0; bufferIndex < result.buffers_count; ++bufferIndex ) {
+            glTF::Buffer& buffer = result.buffers[ bufferIndex ];
+            if ( !IsDataUri( buffer.uri ) ) {
+                continue;
+            }
+
+            sizet size;
+            buffer.data = LoadDataUri( filePath, buffer.uri, result.allocator, size );
+            // Accessors would read past a short buffer, it fails like an undecodable one.
+            if ( buffer.data && buffer.byte_length != glTF::INVALID_INT_VALUE && size < ( sizet )buffer.byte_length ) {
+                error( "Error: {} buffer {} data uri holds {} bytes instead of {}.", filePath, bufferIndex, size, buffer.byte_length );
+                result.allocator->deallocate( ( void* )buffer.data );
+                buffer.data = nullptr;
+            }
+        }
+
+        for ( u32 imageIndex = 0; imageIndex < result.images_count; ++imageIndex ) {
+            glTF::Image& image = result.images[ imageIndex ];
+            if ( !IsDataUri( image.uri ) ) {
+                continue;
+            }
+
+            sizet size;
+            image.data = LoadDataUri( filePath, image.uri, result.allocator, size );
+            image.data_size = ( u32 )size;
+        }
     }
 
     glTF::glTF gltfLoadFile(cstring filePath, Allocator* allocator_) {
         glTF::glTF result(allocator_);
 
-//        if (std::filesystem::exists(filePath) || true) {
-//            info("Error: file {} does not exists.\n", filePath);
-//            return result;
-//        }
-
-        Allocator* heapAllocator = &ServiceManager::GetInstance()->Get<MemoryService>()->m_systemAllocator;
-
-        FileReadResult readResult = FileReadText(filePath, heapAllocator);
-
-        json gltfData = json::parse(readResult.data);
-
-        Allocator* allocator = result.allocator;
-
-        for (auto properties : gltfData.items()) {
-            if (properties.key() == "asset") {
-                LoadAsset(gltfData, result, allocator);
-            } else if (properties.key() == "scene") {
-                TryLoadInt(gltfData, "scene", result.scene);
-            } else if ( properties.key() == "scenes" ) {
-                LoadScenes( gltfData, result, allocator );
-            } else if ( properties.key() == "buffers" ) {
-                LoadBuffers( gltfData, result, allocator );
-            } else if ( properties.key() == "bufferViews" ) {
-                LoadBufferViews( gltfData, result, allocator );
-            } else if ( properties.key() == "nodes" ) {
-                LoadNodes( gltfData, result, allocator );
-            } else if ( properties.key() == "meshes" ) {
-                LoadMeshes( gltfData, result, allocator );
-            } else if ( properties.key() == "accessors" ) {
-                LoadAccessors( gltfData, result, allocator );
-            } else if ( properties.key() == "materials" ) {
-                LoadMaterials( gltfData, result, allocator );
-            } else if ( properties.key() == "textures" ) {
-                LoadTextures( gltfData, result, allocator );
-            } else if ( properties.key() == "images" ) {
-                LoadImages( gltfData, result, allocator );
-            } else if ( properties.key() == "samplers" ) {
-                LoadSamplers( gltfData, result, allocator );
-            } else if ( properties.key() == "skins" ) {
-                LoadSkins( gltfData, result, allocator );
-            } else if ( properties.key() == "animations" ) {
-                LoadAnimations( gltfData, result, allocator );
-            }
-        }
-
-        heapAllocator->deallocate(readResult.data);
+        MappedFile file;
+        if ( !file.Open( filePath, FileAccessHint::Sequential ) ) {
+            error( "Error: file {} does not exist.", filePath );
+            return result;
+        }
+
+        std::span<const u8> json = file.GetSpan();
+        std::span<const u8> binary;
+
+        const bool isGlb = IsGlb( file );
+        if ( isGlb && !ParseGlbChunks( filePath, file, json, binary ) ) {
+            return result;
+        }
+
+        // The reader never writes to the document, so the JSON is parsed straight from the read only mapping.
+        JsonReader reader( ( const char* )json.data(), json.size() );
+        LoadDocument( reader, result, result.allocator );
+
+        if ( reader.HasError() ) {
+            error( "Error parsing {} at byte {}", filePath, reader.GetErrorOffset() );
+        }
+
+        if ( isGlb ) {
+            // The first buffer of a GLB has no uri and references the binary chunk. Bound before data uris are decoded,
+            // which clears their text, so a decoded buffer 0 is never mistaken for the chunk.
+            if ( result.buffers_count > 0 && result.buffers[ 0 ].data == nullptr && result.buffers[ 0 ].uri.empty() ) {
+                glTF::Buffer& buffer = result.buffers[ 0 ];
+                if ( binary.empty() || ( buffer.byte_length != glTF::INVALID_INT_VALUE && ( sizet )buffer.byte_length > binary.size() ) ) {
+                    error( "Error: {} binary chunk is smaller than its buffer.", filePath );
+                } else {
+                    buffer.data = binary.data();
+                    result.binary_file = std::move( file );
+                }
+            }
+        }
+
+        LoadDataUris( filePath, result );
 
         return result;
     }
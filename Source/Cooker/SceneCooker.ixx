@@ -0,0 +1,502 @@
+module;
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cglm/types-struct.h>
+#include <cglm/struct/mat4.h>
+#include <cglm/struct/quat.h>
+#include <cglm/struct/affine.h>
+#include <cglm/struct/vec3.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+export module SceneCooker;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.CookedScene;
+import Foundation.Blob;
+import Foundation.File;
+import Foundation.glTF;
+import Foundation.GeometryImport;
+import Foundation.TangentSpace;
+import Foundation.MeshOptimizer;
+import Foundation.Platform;
+import Foundation.Assert;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Converts a glTF scene into a CookedScene blob written at outputPath.
+    bool CookScene( cstring gltfPath, cstring outputPath, Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    struct CookerContext {
+        glTF::glTF&             m_scene;
+        Array(const u8*)&       m_buffers;
+        Array(u8)&              m_vertexData;
+        Array(u8)&              m_indexData;
+        Allocator*              m_allocator;
+        GeometryImportStatistics m_statistics;
+    };
+
+    // Decodes an attribute of any component type into the vertex stream as tightly packed floats, returns its offset in the stream.
+    static u32 CookAttribute( CookerContext& context, i32 accessorIndex, u32 componentCount ) {
+        if ( accessorIndex == -1 ) {
+            return k_cooked_invalid_index;
+        }
+
+        const glTF::Accessor& accessor = context.m_scene.accessors[ accessorIndex ];
+        const u32 elementSize = componentCount * sizeof( f32 );
+
+        const u32 offset = ( u32 )MemoryAlign( context.m_vertexData.size(), k_cooked_stream_alignment );
+        context.m_vertexData.resize( offset + ( sizet )elementSize * accessor.count );
+        f32* destination = ( f32* )( context.m_vertexData.data() + offset );
+
+        if ( !DecodeAccessor( context.m_scene, context.m_buffers.data(), accessorIndex, destination, componentCount, elementSize, nullptr, &context.m_statistics ) ) {
+            error( "Cooker: accessor {} cannot be decoded, skipped", accessorIndex );
+            context.m_vertexData.resize( offset );
+            return k_cooked_invalid_index;
+        }
+
+        return offset;
+    }
+
+    // Generated the same way as the demo does at load time.
+    // Runs on the source vertices, before welding, so vertices split for flat shading keep their face normals.
+    static u32 CookNormals( CookerContext& context, const CookedPrimitive& primitive, const u32* indices ) {
+        const u32 offset = ( u32 )MemoryAlign( context.m_vertexData.size(), k_cooked_stream_alignment );
+        context.m_vertexData.resize( offset + sizeof( vec3s ) * primitive.m_vertexCount );
+
+        f32* normals = ( f32* )( context.m_vertexData.data() + offset );
+        const f32* positions = ( const f32* )( context.m_vertexData.data() + primitive.m_positionOffset );
+
+        if ( !GenerateNormals( positions, primitive.m_vertexCount, indices, primitive.m_indexCount, normals, context.m_allocator ) ) {
+            context.m_vertexData.resize( offset );
+            return k_cooked_invalid_index;
+        }
+        return offset;
+    }
+
+    static u32 CookTangents( CookerContext& context, const CookedPrimitive& primitive ) {
+        const u32 offset = ( u32 )MemoryAlign( context.m_vertexData.size(), k_cooked_stream_alignment );
+        context.m_vertexData.resize( offset + sizeof( vec4s ) * primitive.m_vertexCount );
+
+        f32* tangents = ( f32* )( context.m_vertexData.data() + offset );
+        const f32* positions = ( const f32* )( context.m_vertexData.data() + primitive.m_positionOffset );
+        const f32* normals = ( const f32* )( context.m_vertexData.data() + primitive.m_normalOffset );
+        const f32* texcoords = ( const f32* )( context.m_vertexData.data() + primitive.m_texcoordOffset );
+        const u8* indexData = context.m_indexData.data() + primitive.m_indexOffset;
+
+        const bool generated = primitive.m_indexType == CookedIndexType_Uint32
+            ? GenerateTangents( positions, normals, texcoords, primitive.m_vertexCount, ( const u32* )indexData, primitive.m_indexCount, tangents, context.m_allocator )
+            : GenerateTangents( positions, normals, texcoords, primitive.m_vertexCount, ( const u16* )indexData, primitive.m_indexCount, tangents, context.m_allocator );
+        if ( !generated ) {
+            context.m_vertexData.resize( offset );
+            return k_cooked_invalid_index;
+        }
+        return offset;
+    }
+
+    // Welds, reorders for the vertex cache, overdraw and vertex fetch, then packs the streams of the primitive again
+    // from vertexDataStart, since welding removes vertices.
+    static void CookOptimizedMesh( CookerContext& context, CookedPrimitive& primitive, Array(u32)& indices, sizet vertexDataStart ) {
+        static constexpr u32 k_max_streams = 4;
+        u32* offsets[ k_max_streams ] = { &primitive.m_positionOffset, &primitive.m_tangentOffset, &primitive.m_normalOffset, &primitive.m_texcoordOffset };
+        const u32 sizes[ k_max_streams ] = { sizeof( vec3s ), sizeof( vec4s ), sizeof( vec3s ), sizeof( vec2s ) };
+
+        VertexStream streams[ k_max_streams ];
+        u32 streamSizes[ k_max_streams ];
+        u32* streamOffsets[ k_max_streams ];
+        u32 streamCount = 0;
+        for ( u32 i = 0; i < k_max_streams; ++i ) {
+            if ( *offsets[ i ] != k_cooked_invalid_index ) {
+                streams[ streamCount ] = { context.m_vertexData.data() + *offsets[ i ], sizes[ i ] };
+                streamSizes[ streamCount ] = sizes[ i ];
+                streamOffsets[ streamCount++ ] = offsets[ i ];
+            }
+        }
+
+        // In the order they were appended, generated normals come last.
+        for ( u32 i = 1; i < streamCount; ++i ) {
+            for ( u32 j = i; j > 0 && *streamOffsets[ j ] < *streamOffsets[ j - 1 ]; --j ) {
+                std::swap( streams[ j ], streams[ j - 1 ] );
+                std::swap( streamSizes[ j ], streamSizes[ j - 1 ] );
+                std::swap( streamOffsets[ j ], streamOffsets[ j - 1 ] );
+            }
+        }
+
+        MeshOptimizerReport report;
+        primitive.m_vertexCount = OptimizeMesh( indices.data(), primitive.m_indexCount, streams, streamCount, primitive.m_vertexCount, 0,
+                                                context.m_allocator, {}, &report );
+        info( "Cooker: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", report.m_verticesBefore, report.m_verticesAfter,
+              report.m_before.m_acmr, report.m_after.m_acmr, report.m_before.m_atvr, report.m_after.m_atvr );
+
+        // Streams were appended in order, so every one only moves down.
+        sizet end = vertexDataStart;
+        for ( u32 i = 0; i < streamCount; ++i ) {
+            const u32 offset = ( u32 )MemoryAlign( end, k_cooked_stream_alignment );
+            memmove( context.m_vertexData.data() + offset, context.m_vertexData.data() + *streamOffsets[ i ], ( sizet )streamSizes[ i ] * primitive.m_vertexCount );
+            *streamOffsets[ i ] = offset;
+            end = offset + ( sizet )streamSizes[ i ] * primitive.m_vertexCount;
+        }
+        context.m_vertexData.resize( end );
+    }
+
+    static bool CookPrimitive( CookerContext& context, glTF::MeshPrimitive& meshPrimitive, CookedPrimitive& primitive ) {
+        if ( meshPrimitive.mode != glTF::INVALID_INT_VALUE && meshPrimitive.mode != 4 ) {
+            error( "Cooker: only triangle lists are supported, primitive skipped" );
+            return false;
+        }
+
+        const i32 positionAccessorIndex = gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "POSITION" );
+        if ( positionAccessorIndex == -1 || meshPrimitive.indices == glTF::INVALID_INT_VALUE ) {
+            error( "Cooker: primitive without positions or indices skipped" );
+            return false;
+        }
+
+        primitive.m_material = meshPrimitive.material == glTF::INVALID_INT_VALUE ? 0 : ( u32 )meshPrimitive.material;
+
+        primitive.m_vertexCount = ( u32 )context.m_scene.accessors[ positionAccessorIndex ].count;
+        primitive.m_indexCount = ( u32 )context.m_scene.accessors[ meshPrimitive.indices ].count;
+        CASSERT( ( primitive.m_indexCount % 3 ) == 0 );
+
+        Array(u32) indices( *context.m_allocator );
+        indices.resize( primitive.m_indexCount );
+        if ( !DecodeIndices( context.m_scene, context.m_buffers.data(), meshPrimitive.indices, indices.data(), nullptr, &context.m_statistics ) ) {
+            return false;
+        }
+
+        // Vertex streams
+        const sizet vertexDataStart = context.m_vertexData.size();
+        primitive.m_positionOffset = CookAttribute( context, positionAccessorIndex, 3 );
+        if ( primitive.m_positionOffset == k_cooked_invalid_index ) {
+            return false;
+        }
+
+        primitive.m_tangentOffset = CookAttribute( context, gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "TANGENT" ), 4 );
+        primitive.m_normalOffset = CookAttribute( context, gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "NORMAL" ), 3 );
+        primitive.m_texcoordOffset = CookAttribute( context, gltfGetAttributeAccessorIndex( meshPrimitive.attributes, meshPrimitive.attribute_count, "TEXCOORD_0" ), 2 );
+
+        // Missing normals are generated before welding, which then keeps flat shaded vertices apart as glTF asks.
+        if ( primitive.m_normalOffset == k_cooked_invalid_index ) {
+            primitive.m_normalOffset = CookNormals( context, primitive, indices.data() );
+            if ( primitive.m_normalOffset == k_cooked_invalid_index ) {
+                return false;
+            }
+        }
+
+        CookOptimizedMesh( context, primitive, indices, vertexDataStart );
+
+        // Indices, 16 bit whenever the optimized vertex count allows it whatever the source type
+        const bool wideIndices = primitive.m_vertexCount > 65536;
+        primitive.m_indexType = wideIndices ? CookedIndexType_Uint32 : CookedIndexType_Uint16;
+        primitive.m_indexOffset = ( u32 )MemoryAlign( context.m_indexData.size(), sizeof( u32 ) );
+
+        context.m_indexData.resize( primitive.m_indexOffset + ( sizet )( wideIndices ? sizeof( u32 ) : sizeof( u16 ) ) * primitive.m_indexCount );
+        u8* indexDestination = context.m_indexData.data() + primitive.m_indexOffset;
+        if ( wideIndices ) {
+            memcpy( indexDestination, indices.data(), sizeof( u32 ) * primitive.m_indexCount );
+        } else {
+            for ( u32 i = 0; i < primitive.m_indexCount; ++i ) {
+                ( ( u16* )indexDestination )[ i ] = ( u16 )indices[ i ];
+            }
+        }
+
+        if ( primitive.m_tangentOffset == k_cooked_invalid_index && primitive.m_texcoordOffset != k_cooked_invalid_index ) {
+            primitive.m_tangentOffset = CookTangents( context, primitive );
+        }
+
+        return true;
+    }
+
+    static void CookTextureSlot( glTF::glTF& scene, CookedMaterial& material, CookedTextureSlot slot, i32 textureIndex ) {
+        if ( textureIndex == glTF::INVALID_INT_VALUE ) {
+            return;
+        }
+
+        glTF::Texture& texture = scene.textures[ textureIndex ];
+        material.m_textures[ slot ] = texture.source == glTF::INVALID_INT_VALUE ? k_cooked_invalid_index : ( u32 )texture.source;
+        material.m_samplers[ slot ] = texture.sampler == glTF::INVALID_INT_VALUE ? k_cooked_invalid_index : ( u32 )texture.sampler;
+    }
+
+    static void CookDefaultMaterial( CookedMaterial& material ) {
+        for ( u32 slot = 0; slot < CookedTextureSlot_Count; ++slot ) {
+            material.m_textures[ slot ] = k_cooked_invalid_index;
+            material.m_samplers[ slot ] = k_cooked_invalid_index;
+        }
+
+        material.m_baseColorFactor[ 0 ] = material.m_baseColorFactor[ 1 ] = material.m_baseColorFactor[ 2 ] = material.m_baseColorFactor[ 3 ] = 1.0f;
+        material.m_emissiveFactor[ 0 ] = material.m_emissiveFactor[ 1 ] = material.m_emissiveFactor[ 2 ] = 0.0f;
+        material.m_metallicFactor = 1.0f;
+        material.m_roughnessFactor = 1.0f;
+        material.m_occlusionFactor = 1.0f;
+    }
+
+    static void CookMaterial( glTF::glTF& scene, glTF::Material& source, CookedMaterial& material ) {
+        CookDefaultMaterial( material );
+
+        if ( source.pbr_metallic_roughness != nullptr ) {
+            glTF::MaterialPBRMetallicRoughness& pbr = *source.pbr_metallic_roughness;
+            if ( pbr.base_color_factor_count == 4 ) {
+                memcpy( material.m_baseColorFactor, pbr.base_color_factor, sizeof( f32 ) * 4 );
+            }
+            if ( pbr.metallic_factor != glTF::INVALID_FLOAT_VALUE ) {
+                material.m_metallicFactor = pbr.metallic_factor;
+            }
+            if ( pbr.roughness_factor != glTF::INVALID_FLOAT_VALUE ) {
+                material.m_roughnessFactor = pbr.roughness_factor;
+            }
+            if ( pbr.base_color_texture != nullptr ) {
+                CookTextureSlot( scene, material, CookedTextureSlot_Color, pbr.base_color_texture->index );
+            }
+            if ( pbr.metallic_roughness_texture != nullptr ) {
+                CookTextureSlot( scene, material, CookedTextureSlot_MetallicRoughness, pbr.metallic_roughness_texture->index );
+            }
+        }
+
+        if ( source.occlusion_texture != nullptr ) {
+            CookTextureSlot( scene, material, CookedTextureSlot_Occlusion, source.occlusion_texture->index );
+            if ( source.occlusion_texture->strength != glTF::INVALID_FLOAT_VALUE ) {
+                material.m_occlusionFactor = source.occlusion_texture->strength;
+            }
+        }
+
+        if ( source.emissive_factor_count == 3 ) {
+            memcpy( material.m_emissiveFactor, source.emissive_factor, sizeof( f32 ) * 3 );
+        }
+        if ( source.emissive_texture != nullptr ) {
+            CookTextureSlot( scene, material, CookedTextureSlot_Emissive, source.emissive_texture->index );
+        }
+        if ( source.normal_texture != nullptr ) {
+            CookTextureSlot( scene, material, CookedTextureSlot_Normal, source.normal_texture->index );
+        }
+    }
+
+    static mat4s NodeLocalMatrix( glTF::Node& node ) {
+        mat4s localMatrix = glms_mat4_identity();
+        if ( node.matrix_count ) {
+            // CGLM and glTF have the same matrix layout
+            memcpy( &localMatrix, node.matrix, sizeof( mat4s ) );
+            return localMatrix;
+        }
+
+        const vec3s scale = node.scale_count ? vec3s{ node.scale[ 0 ], node.scale[ 1 ], node.scale[ 2 ] } : vec3s{ 1.0f, 1.0f, 1.0f };
+        const vec3s translation = node.translation_count ? vec3s{ node.translation[ 0 ], node.translation[ 1 ], node.translation[ 2 ] } : vec3s{ 0.0f, 0.0f, 0.0f };
+        const versors rotation = node.rotation_count ? glms_quat_init( node.rotation[ 0 ], node.rotation[ 1 ], node.rotation[ 2 ], node.rotation[ 3 ] ) : glms_quat_identity();
+
+        return glms_mat4_mul( glms_mat4_mul( glms_translate_make( translation ), glms_quat_mat4( rotation ) ), glms_scale_make( scale ) );
+    }
+
+    struct CookedImage {
+        u8*                     m_pixels;
+        i32                     m_width;
+        i32                     m_height;
+        cstring                 m_name;
+    };
+
+    bool CookScene( cstring gltfPath, cstring outputPath, Allocator* allocator ) {
+        // Relative uris are resolved from the glTF folder, like the demo does.
+        const std::filesystem::path absoluteOutput = std::filesystem::absolute( outputPath );
+        const std::filesystem::path absoluteInput = std::filesystem::absolute( gltfPath );
+        const auto cwd = std::filesystem::current_path();
+        std::filesystem::current_path( absoluteInput.parent_path() );
+
+        const std::string gltfFile = absoluteInput.filename().string();
+        glTF::glTF scene = gltfLoadFile( gltfFile.c_str(), allocator );
+
+        // Buffers already in memory, like the GLB binary chunk, are used as they are, the others are mapped.
+        Array(MappedFile) bufferFiles( *allocator );
+        bufferFiles.reserve( scene.buffers_count );
+        Array(const u8*) buffers( *allocator );
+        buffers.reserve( scene.buffers_count );
+        for ( u32 bufferIndex = 0; bufferIndex < scene.buffers_count; ++bufferIndex ) {
+            glTF::Buffer& buffer = scene.buffers[ bufferIndex ];
+            if ( buffer.data ) {
+                buffers.push_back( buffer.data );
+                continue;
+            }
+
+            MappedFile& bufferFile = bufferFiles.emplace_back();
+            if ( !bufferFile.Open( buffer.uri.data(), FileAccessHint::Sequential ) ) {
+                error( "Cooker: cannot open buffer {}", buffer.uri.data() );
+                std::filesystem::current_path( cwd );
+                return false;
+            }
+            // Accessors are range checked against the declared length, the file has to hold all of it.
+            if ( buffer.byte_length == glTF::INVALID_INT_VALUE || bufferFile.m_size < ( sizet )buffer.byte_length ) {
+                error( "Cooker: buffer {} is smaller than its declared length", buffer.uri.data() );
+                std::filesystem::current_path( cwd );
+                return false;
+            }
+            buffers.push_back( bufferFile.m_data );
+        }
+
+        Array(u8) vertexData( *allocator );
+        Array(u8) indexData( *allocator );
+        CookerContext context{ scene, buffers, vertexData, indexData, allocator };
+
+        // Geometry is cooked once per mesh primitive, nodes sharing a mesh share the streams.
+        Array(CookedPrimitive) meshPrimitives( *allocator );
+        Array(u32) meshFirstPrimitive( *allocator );
+        Array(u32) meshPrimitiveCount( *allocator );
+        meshFirstPrimitive.resize( scene.meshes_count );
+        meshPrimitiveCount.resize( scene.meshes_count );
+        for ( u32 meshIndex = 0; meshIndex < scene.meshes_count; ++meshIndex ) {
+            glTF::Mesh& mesh = scene.meshes[ meshIndex ];
+            meshFirstPrimitive[ meshIndex ] = ( u32 )meshPrimitives.size();
+
+            for ( u32 primitiveIndex = 0; primitiveIndex < mesh.primitives_count; ++primitiveIndex ) {
+                CookedPrimitive primitive{};
+                if ( CookPrimitive( context, mesh.primitives[ primitiveIndex ], primitive ) ) {
+                    meshPrimitives.push_back( primitive );
+                }
+            }
+            meshPrimitiveCount[ meshIndex ] = ( u32 )meshPrimitives.size() - meshFirstPrimitive[ meshIndex ];
+        }
+
+        // Nodes in parent before child order, world matrices composed once here.
+        Array(CookedNode) nodes( *allocator );
+        Array(CookedPrimitive) primitives( *allocator );
+        Array(u32) nodeStack( *allocator );
+        Array(u32) nodeParent( *allocator );
+        nodes.reserve( scene.nodes_count );
+
+        glTF::Scene& rootScene = scene.scenes[ scene.scene == glTF::INVALID_INT_VALUE ? 0 : scene.scene ];
+        for ( u32 i = 0; i < rootScene.nodes_count; ++i ) {
+            nodeStack.push_back( ( u32 )rootScene.nodes[ i ] );
+            nodeParent.push_back( k_cooked_invalid_index );
+        }
+
+        while ( nodeStack.size() ) {
+            const u32 nodeIndex = nodeStack.back();
+            const u32 parent = nodeParent.back();
+            nodeStack.pop_back();
+            nodeParent.pop_back();
+
+            glTF::Node& node = scene.nodes[ nodeIndex ];
+            const u32 cookedIndex = ( u32 )nodes.size();
+
+            CookedNode& cookedNode = nodes.emplace_back();
+            cookedNode.m_parent = parent;
+
+            const mat4s localMatrix = NodeLocalMatrix( node );
+            mat4s worldMatrix = localMatrix;
+            if ( parent != k_cooked_invalid_index ) {
+                // Cooked matrices are not 16 bytes aligned, copy before using SIMD math on them.
+                mat4s parentMatrix;
+                memcpy( &parentMatrix, nodes[ parent ].m_worldMatrix, sizeof( mat4s ) );
+                worldMatrix = glms_mat4_mul( parentMatrix, localMatrix );
+            }
+            memcpy( cookedNode.m_localMatrix, &localMatrix, sizeof( mat4s ) );
+            memcpy( cookedNode.m_worldMatrix, &worldMatrix, sizeof( mat4s ) );
+
+            for ( u32 childIndex = 0; childIndex < node.children_count; ++childIndex ) {
+                nodeStack.push_back( ( u32 )node.children[ childIndex ] );
+                nodeParent.push_back( cookedIndex );
+            }
+
+            if ( node.mesh == glTF::INVALID_INT_VALUE ) {
+                continue;
+            }
+
+            for ( u32 i = 0; i < meshPrimitiveCount[ node.mesh ]; ++i ) {
+                CookedPrimitive primitive = meshPrimitives[ meshFirstPrimitive[ node.mesh ] + i ];
+                primitive.m_node = cookedIndex;
+                primitives.push_back( primitive );
+            }
+        }
+
+        Array(CookedMaterial) materials( *allocator );
+        materials.resize( scene.materials_count ? scene.materials_count : 1 );
+        if ( scene.materials_count == 0 ) {
+            CookDefaultMaterial( materials[ 0 ] );
+        }
+        for ( u32 materialIndex = 0; materialIndex < scene.materials_count; ++materialIndex ) {
+            CookMaterial( scene, scene.materials[ materialIndex ], materials[ materialIndex ] );
+        }
+
+        Array(CookedSampler) samplers( *allocator );
+        samplers.resize( scene.samplers_count );
+        for ( u32 samplerIndex = 0; samplerIndex < scene.samplers_count; ++samplerIndex ) {
+            glTF::Sampler& sampler = scene.samplers[ samplerIndex ];
+            samplers[ samplerIndex ] = { sampler.min_filter, sampler.mag_filter, sampler.wrap_s, sampler.wrap_t };
+        }
+
+        // Textures are decoded here so that loading is a plain copy to the GPU.
+        Array(CookedImage) images( *allocator );
+        images.resize( scene.images_count );
+        for ( u32 imageIndex = 0; imageIndex < scene.images_count; ++imageIndex ) {
+            glTF::Image& image = scene.images[ imageIndex ];
+            CookedImage& cookedImage = images[ imageIndex ];
+            cookedImage.m_name = image.uri.data();
+
+            i32 components = 0;
+            if ( image.data ) {
+                cookedImage.m_pixels = stbi_load_from_memory( image.data, ( i32 )image.data_size, &cookedImage.m_width, &cookedImage.m_height, &components, 4 );
+            } else if ( image.buffer_view != glTF::INVALID_INT_VALUE && image.uri.empty() ) {
+                glTF::BufferView& bufferView = scene.buffer_views[ image.buffer_view ];
+                const u8* data = buffers[ bufferView.buffer ] + glTF::GetDataOffset( 0, bufferView.byte_offset );
+                cookedImage.m_pixels = stbi_load_from_memory( data, bufferView.byte_length, &cookedImage.m_width, &cookedImage.m_height, &components, 4 );
+            } else {
+                cookedImage.m_pixels = stbi_load( image.uri.data(), &cookedImage.m_width, &cookedImage.m_height, &components, 4 );
+            }
+
+            if ( cookedImage.m_pixels == nullptr ) {
+                // Keep the indices stable, a 1x1 white texture stands in for it.
+                error( "Cooker: cannot decode image {}", imageIndex );
+                cookedImage.m_pixels = ( u8* )malloc( 4 );
+                memset( cookedImage.m_pixels, 0xff, 4 );
+                cookedImage.m_width = cookedImage.m_height = 1;
+            }
+        }
+
+        std::filesystem::current_path( cwd );
+
+        // Exact size of the blob, every allocation can waste up to its alignment.
+        sizet blobSize = k_blob_root_offset + sizeof( CookedScene );
+        blobSize += nodes.size() * sizeof( CookedNode ) + primitives.size() * sizeof( CookedPrimitive ) + materials.size() * sizeof( CookedMaterial );
+        blobSize += images.size() * sizeof( CookedTexture ) + samplers.size() * sizeof( CookedSampler );
+        blobSize += vertexData.size() + indexData.size() + 7 * k_cache_line_size;
+        for ( const CookedImage& image : images ) {
+            blobSize += ( sizet )image.m_width * image.m_height * 4 + strlen( image.m_name ) + 1 + 2 * k_cache_line_size;
+        }
+
+        BlobSerializer serializer;
+        CookedScene* cooked = serializer.WriteAndPrepare<CookedScene>( allocator, k_cooked_scene_version, blobSize );
+        serializer.AllocateAndSet( cooked->m_nodes, ( u32 )nodes.size(), nodes.data() );
+        serializer.AllocateAndSet( cooked->m_primitives, ( u32 )primitives.size(), primitives.data() );
+        serializer.AllocateAndSet( cooked->m_materials, ( u32 )materials.size(), materials.data() );
+        serializer.AllocateAndSet( cooked->m_samplers, ( u32 )samplers.size(), samplers.data() );
+        serializer.AllocateAndSet( cooked->m_vertexData, ( u32 )vertexData.size(), vertexData.data() );
+        serializer.AllocateAndSet( cooked->m_indexData, ( u32 )indexData.size(), indexData.data() );
+
+        serializer.AllocateAndSet( cooked->m_textures, ( u32 )images.size() );
+        for ( u32 imageIndex = 0; imageIndex < images.size(); ++imageIndex ) {
+            CookedImage& image = images[ imageIndex ];
+            CookedTexture& texture = cooked->m_textures[ imageIndex ];
+            texture.m_width = ( u32 )image.m_width;
+            texture.m_height = ( u32 )image.m_height;
+            serializer.AllocateAndSet( texture.m_pixels, texture.m_width * texture.m_height * 4, image.m_pixels );
+            serializer.AllocateAndSet( texture.m_name, image.m_name );
+
+            stbi_image_free( image.m_pixels );
+        }
+
+        const bool saved = serializer.Save( absoluteOutput.string().c_str() );
+        info( "Cooker: {} nodes, {} draws, {} materials, {} textures, {} bytes written to {}", nodes.size(), primitives.size(), materials.size(),
+              images.size(), serializer.GetBlobSize(), absoluteOutput.string() );
+        context.m_statistics.Log();
+
+        serializer.Shutdown();
+        return saved;
+    }
+}
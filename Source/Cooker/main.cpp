@@ -0,0 +1,34 @@
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+import SceneCooker;
+
+import Foundation.Services.MemoryService;
+import Foundation.Services.ServiceManager;
+import Foundation.Memory.MemoryDefines;
+import Foundation.CookedScene;
+import Foundation.Log;
+
+int main(int argc, char **argv) {
+    using namespace Caustix;
+
+    if (argc < 2) {
+        info("Usage: Cooker [path to glTF model] [output path, defaults to the model path with the {} extension]", k_cooked_scene_extension);
+        return -1;
+    }
+
+    MemoryServiceConfiguration memoryConfiguration;
+    ServiceManager::GetInstance()->AddService(MemoryService::Create(memoryConfiguration), MemoryService::m_name);
+    MemoryService* memoryService = ServiceManager::GetInstance()->Get<MemoryService>();
+
+    const std::string outputPath = argc > 2 ? std::string(argv[2]) : std::filesystem::path(argv[1]).replace_extension(k_cooked_scene_extension).string();
+
+    const auto cookStart = std::chrono::high_resolution_clock::now();
+    const bool cooked = CookScene(argv[1], outputPath.c_str(), &memoryService->m_systemAllocator);
+    const double cookTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cookStart).count();
+
+    info("Cooked {} in {:.2f} ms", argv[1], cookTime);
+
+    return cooked ? 0 : -1;
+}
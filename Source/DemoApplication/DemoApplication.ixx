@@ -1,10 +1,15 @@
 module;
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <new>
+#include <string>
 
 #include <vulkan/vulkan.h>
 
 #include <cglm/types-struct.h>
+#include <cglm/struct/vec3.h>
 #include <cglm/struct/mat4.h>
 #include <cglm/struct/quat.h>
 #include <cglm/struct/affine.h>
@@ -24,7 +29,18 @@ import Foundation.Log;
 import Foundation.Memory.Allocators.StackAllocator;
 import Foundation.Memory.MemoryDefines;
 import Foundation.glTF;
+import Foundation.GeometryImport;
+import Foundation.TangentSpace;
+import Foundation.MeshOptimizer;
+import Foundation.Meshlets;
+import Foundation.MeshSimplifier;
+import Foundation.VertexQuantization;
+import Foundation.SceneGraph;
+import Foundation.FrustumCulling;
+import Foundation.Blob;
+import Foundation.CookedScene;
 import Foundation.File;
+import Foundation.Services.IoService;
 import Foundation.Memory.Allocators.Allocator;
 
 
@@ -66,6 +82,11 @@ export namespace Caustix {
 
         BufferHandle materialBuffer;
         MaterialData materialData;
+        // Scene graph node whose world matrix is materialData.model.
+        u32 node;
+        // Model space box of the positions, frustum culled once transformed by the node.
+        vec3s boxMin;
+        vec3s boxMax;
 
         u32 indexOffset;
         u32 positionOffset;
@@ -75,6 +96,21 @@ export namespace Caustix {
 
         u32 count;
 
+        // Clusters in DemoApplication::m_meshlets, none for cooked scenes.
+        u32 meshletOffset;
+        u32 meshletCount;
+
+        // Levels of detail in the index buffer and the model space sphere their distance is measured from.
+        // None for cooked scenes, count indices are drawn then.
+        MeshLod lods[ k_max_mesh_lods ];
+        u32 lodCount;
+        u32 lodIndex;
+        vec4s boundingSphere;
+
+        // Quantized vertices are drawn with the matching pipeline, positions are scaled back to model space by dequantization.
+        bool quantized;
+        mat4s dequantization;
+
         VkIndexType indexType;
 
         DescriptorSetHandle descriptorSet;
@@ -118,11 +154,21 @@ export namespace Caustix {
 
         void    OnResize( u32 new_width, u32 new_height );
 
+        void    CreatePipeline();
+        void    LoadGltfScene( cstring path );
+        // Loads a scene produced by the Cooker, see CookedScene.
+        void    LoadCookedScene( cstring path );
+        // Scene space bounds of every draw and the draws of every node.
+        void    UpdateDrawBounds();
+        // Matrices and bounds of the draws of the nodes the last scene graph update moved.
+        void    UpdateMovedDraws();
+
         GameCamera      m_gameCamera;
 
         BufferHandle                    cube_vb;
         BufferHandle                    cube_ib;
         PipelineHandle                  cube_pipeline;
+        PipelineHandle                  cube_quantized_pipeline;
         BufferHandle                    cube_cb;
         DescriptorSetHandle             cube_rl;
         DescriptorSetLayoutHandle       cube_dsl;
@@ -131,6 +177,35 @@ export namespace Caustix {
 
         Array(BufferHandle)             customMeshBuffers;
 
+        // Model space clusters of every primitive, culled on the CPU each frame as a reference for GPU cluster culling.
+        MeshletMesh                     m_meshlets;
+        Array(u32)                      m_visibleMeshlets;
+        u32                             m_visibleMeshletCount = 0;
+
+        // Node transforms of the loaded scene, animating nodes only recomputes their subtrees.
+        SceneGraph                      m_sceneGraph;
+        Array(u32)                      m_sceneRoots;
+        bool                            m_animateRoots = false;
+        u32                             m_sceneGraphUpdatedNodes = 0;
+        f64                             m_sceneGraphUpdateTime = 0.0;
+        // Indices in meshDraws of the draws of node n in [ m_nodeDrawOffsets[ n ], m_nodeDrawOffsets[ n + 1 ] ).
+        Array(u32)                      m_nodeDrawOffsets;
+        Array(u32)                      m_nodeDraws;
+
+        // Draws outside the camera frustum are skipped, m_drawVisibility is indexed like meshDraws.
+        CullingBounds                   m_drawBounds;
+        Array(u8)                       m_drawVisibility;
+        bool                            m_frustumCulling = true;
+        u32                             m_visibleDraws = 0;
+        f64                             m_drawCullingTime = 0.0;
+
+        // Screen space error in pixels a level of detail may have to be drawn.
+        f32                             m_lodErrorPixels = 1.0f;
+        // glTF vertices are quantized at import, see VertexQuantization.
+        bool                            m_quantizeVertices = true;
+
+        StringBuffer                    m_resourceNames;
+
         BufferHandle                    dummyAttributeBuffer;
         TextureHandle                   dummyTexture;
         SamplerHandle                   dummySampler;
@@ -144,7 +219,7 @@ export namespace Caustix {
 }
 
 namespace Caustix {
-    static u8* get_buffer_data( Caustix::glTF::BufferView* bufferViews, u32 bufferIndex, Array(void*)& buffersData, u32* bufferSize = nullptr, char** bufferName = nullptr ) {
+    static const u8* get_buffer_data( Caustix::glTF::BufferView* bufferViews, u32 bufferIndex, Array(const u8*)& buffersData, u32* bufferSize = nullptr, char** bufferName = nullptr ) {
         glTF::BufferView& buffer = bufferViews[ bufferIndex ];
 
         i32 offset = buffer.byte_offset;
@@ -162,9 +237,9 @@ namespace Caustix {
             *bufferSize = buffer.byte_length;
         }
 
-        u8* data = ( u8* )buffersData[ buffer.buffer ] + offset;
+        const u8* data = buffersData[ buffer.buffer ];
 
-        return data;
+        return data ? data + offset : nullptr;
     }
 
     DemoApplication::DemoApplication(const ApplicationConfiguration& configuration, char **argv)
@@ -173,33 +248,53 @@ namespace Caustix {
     , m_gpuProfiler(&m_memoryService->m_systemAllocator, 100)
     , meshDraws(m_memoryService->m_systemAllocator)
     , customMeshBuffers(m_memoryService->m_systemAllocator)
+    , m_meshlets(m_memoryService->m_systemAllocator)
+    , m_visibleMeshlets(m_memoryService->m_systemAllocator)
+    , m_sceneGraph(m_memoryService->m_systemAllocator)
+    , m_sceneRoots(m_memoryService->m_systemAllocator)
+    , m_nodeDrawOffsets(m_memoryService->m_systemAllocator)
+    , m_nodeDraws(m_memoryService->m_systemAllocator)
+    , m_drawBounds(m_memoryService->m_systemAllocator)
+    , m_drawVisibility(m_memoryService->m_systemAllocator)
+    , m_resourceNames(m_memoryService->m_systemAllocator)
     {
-        char gltfBasePath[512]{};
-        memcpy(gltfBasePath, argv[1], strlen(argv[1]));
-        FileDirectoryFromPath(gltfBasePath);
-
-        const auto cwd = std::filesystem::current_path();
-
-        std::filesystem::current_path(gltfBasePath);
-
-        char gltfFile[512]{};
-        memcpy(gltfFile, argv[1], strlen(argv[1]));
-        FileNameFromPath(gltfFile);
-
-        glTF::glTF scene = gltfLoadFile(gltfFile, &m_memoryService->m_scratchAllocator);
+        CreatePipeline();
 
-        Array(TextureResource) images(m_memoryService->m_systemAllocator);
-        images.reserve(scene.images_count);
+        const auto loadStart = std::chrono::high_resolution_clock::now();
+        if (std::filesystem::path(argv[1]).extension() == k_cooked_scene_extension) {
+            LoadCookedScene(argv[1]);
+        } else {
+            LoadGltfScene(argv[1]);
+        }
+        const f64 loadTime = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        info("Scene {} loaded in {:.2f} ms, {} draws", argv[1], loadTime, meshDraws.size());
+        UpdateDrawBounds();
 
-        for (u32 image_index = 0; image_index < scene.images_count; ++image_index) {
-            glTF::Image &image = scene.images[image_index];
-            TextureResource *tr =
-                m_renderer->CreateTexture(image.uri.data(), image.uri.data());
-            CASSERT(tr != nullptr);
+        m_gameCamera.m_camera.IntializePerspective(0.01, 100.0, 45, m_window->m_width / m_window->m_height);
+        m_gameCamera.Reset();
+    }
 
-            images.push_back(*tr);
+    // Position, tangent, normal and texcoord, one stream each.
+    static constexpr u32 k_vertex_stream_count = 4;
+    static constexpr VertexComponentFormat::Enum k_float_vertex_formats[ k_vertex_stream_count ] = {
+        VertexComponentFormat::Float3, VertexComponentFormat::Float4, VertexComponentFormat::Float3, VertexComponentFormat::Float2 };
+    // Box relative positions with the bitangent sign in w, octahedral tangents and normals, half float texcoords.
+    static constexpr VertexComponentFormat::Enum k_quantized_vertex_formats[ k_vertex_stream_count ] = {
+        VertexComponentFormat::UShort4N, VertexComponentFormat::Short2N, VertexComponentFormat::Short2N, VertexComponentFormat::Half2 };
+
+    static_assert( VertexComponentFormat::GetSize( k_quantized_vertex_formats[ 0 ] ) == k_quantized_position_size );
+    static_assert( VertexComponentFormat::GetSize( k_quantized_vertex_formats[ 2 ] ) == k_quantized_unit_vector_size );
+    static_assert( VertexComponentFormat::GetSize( k_quantized_vertex_formats[ 3 ] ) == k_quantized_texcoord_size );
+
+    static void SetVertexInput( VertexInputCreation& vertexInput, const VertexComponentFormat::Enum* formats ) {
+        vertexInput.Reset();
+        for ( u16 stream = 0; stream < k_vertex_stream_count; ++stream ) {
+            vertexInput.AddVertexAttribute( { stream, stream, 0, formats[ stream ] } );
+            vertexInput.AddVertexStream( { stream, ( u16 )VertexComponentFormat::GetSize( formats[ stream ] ), VertexInputRate::PerVertex } );
         }
+    }
 
+    void DemoApplication::CreatePipeline() {
         TextureCreation textureCreation{};
         u32 zeroValue = 0;
         textureCreation.SetName("dummyTexture").SetSize(1,1,1).SetFormatType(VK_FORMAT_R8G8B8A8_UNORM, TextureType::Texture2D).SetFlags(1,0).SetData(&zeroValue);
@@ -212,73 +307,6 @@ namespace Caustix {
         samplerCreation.m_addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
         dummySampler = m_gpu->create_sampler(samplerCreation);
 
-        StringBuffer resourceNameBuffer(m_memoryService->m_systemAllocator);
-        resourceNameBuffer.reserve(ckilo(64));
-
-        Array(SamplerResource) samplers(m_memoryService->m_systemAllocator);
-        samplers.reserve(scene.samplers_count);
-
-        for ( u32 samplerIndex = 0; samplerIndex < scene.samplers_count; ++samplerIndex ) {
-            glTF::Sampler& sampler = scene.samplers[ samplerIndex ];
-
-            char* sampler_name = resourceNameBuffer.data() + resourceNameBuffer.size();
-            resourceNameBuffer.append(std::format("sampler_{}", samplerIndex));
-            resourceNameBuffer.push_back('\0');
-
-            SamplerCreation creation;
-            creation.m_minFilter = sampler.min_filter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
-            creation.m_magFilter = sampler.mag_filter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
-            creation.m_name = sampler_name;
-
-            SamplerResource* sr = m_renderer->CreateSampler( creation );
-            CASSERT( sr != nullptr );
-
-            samplers.push_back( *sr );
-        }
-
-        Array(void*) buffersData(m_memoryService->m_systemAllocator);
-        buffersData.reserve(scene.buffers_count);
-
-        for ( u32 bufferIndex = 0; bufferIndex < scene.buffers_count; ++bufferIndex ) {
-            glTF::Buffer& buffer = scene.buffers[ bufferIndex ];
-
-            FileReadResult bufferData = FileReadBinary(buffer.uri.data(), &m_memoryService->m_systemAllocator);
-            buffersData.push_back( bufferData.data );
-        }
-
-        Array(BufferResource) buffers(m_memoryService->m_systemAllocator);
-        buffers.reserve(scene.buffer_views_count);
-
-        for ( u32 bufferIndex = 0; bufferIndex < scene.buffer_views_count; ++bufferIndex ) {
-            char* bufferName = nullptr;
-            u32 buffer_size = 0;
-            u8* data = get_buffer_data( scene.buffer_views, bufferIndex, buffersData, &buffer_size, &bufferName );
-
-            // NOTE(marco): the target attribute of a BufferView is not mandatory, so we prepare for both uses
-            VkBufferUsageFlags flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-            if ( bufferName == nullptr ) {
-                bufferName = resourceNameBuffer.data() + resourceNameBuffer.size();
-                resourceNameBuffer.append(std::format("buffer_{}", bufferIndex));
-                resourceNameBuffer.push_back('\0');
-            } else {
-                // NOTE(marco); some buffers might have the same name, which causes issues in the renderer cache
-                bufferName = resourceNameBuffer.data() + resourceNameBuffer.size();
-                resourceNameBuffer.append(std::format("{}_{}", bufferName, bufferIndex));
-                resourceNameBuffer.push_back('\0');
-            }
-
-            BufferResource* br = m_renderer->CreateBuffer( flags, ResourceUsageType::Immutable, buffer_size, data, bufferName );
-            CASSERT( br != nullptr);
-
-            buffers.push_back( *br );
-        }
-
-        meshDraws.reserve(scene.meshes_count);
-
-        //Array(BufferHandle) customMeshBuffers(m_memoryService->m_systemAllocator);
-        customMeshBuffers.reserve(8);
-
         vec4s dummyData[3]{};
 
         BufferCreation bufferCreation;
@@ -291,18 +319,8 @@ namespace Caustix {
             PipelineCreation pipelineCreation;
 
             // Vertex input
-            // TODO(marco): component format should be based on buffer view type
-            pipelineCreation.m_vertexInput.AddVertexAttribute({0,0,0, VertexComponentFormat::Float3}); // position
-            pipelineCreation.m_vertexInput.AddVertexStream( { 0, 12, VertexInputRate::PerVertex } );
-
-            pipelineCreation.m_vertexInput.AddVertexAttribute( { 1, 1, 0, VertexComponentFormat::Float4 } ); // tangent
-            pipelineCreation.m_vertexInput.AddVertexStream( { 1, 16, VertexInputRate::PerVertex} );
-
-            pipelineCreation.m_vertexInput.AddVertexAttribute( { 2, 2, 0, VertexComponentFormat::Float3 } ); // normal
-            pipelineCreation.m_vertexInput.AddVertexStream( { 2, 12, VertexInputRate::PerVertex } );
-
-            pipelineCreation.m_vertexInput.AddVertexAttribute( { 3, 3, 0, VertexComponentFormat::Float2 } ); // texcoord
-            pipelineCreation.m_vertexInput.AddVertexStream( { 3, 8, VertexInputRate::PerVertex} );
+            // glTF primitives are decoded to this float layout whatever their component types, see LoadGltfScene.
+            SetVertexInput( pipelineCreation.m_vertexInput, k_float_vertex_formats );
 
             // Render pass
             pipelineCreation.m_renderPass = m_gpu->get_swapchain_output();
@@ -600,28 +618,226 @@ namespace Caustix {
 
             cube_pipeline = m_gpu->create_pipeline( pipelineCreation );
 
-            glTF::Scene& root_gltf_scene = scene.scenes[ scene.scene ];
+            // Same material with the quantized vertex formats, decoded in the vertex shader.
+            const char* vs_quantized_code = R"FOO(#version 450
+    uint MaterialFeatures_TangentVertexAttribute = 1 << 5;
+    uint MaterialFeatures_TexcoordVertexAttribute = 1 << 6;
 
-            Array(i32) node_parents(m_memoryService->m_systemAllocator);
-            node_parents.reserve( scene.nodes_count );
-            node_parents.resize( scene.nodes_count );
+    layout(std140, binding = 0) uniform LocalConstants {
+        mat4 m;
+        mat4 vp;
+        vec4 eye;
+        vec4 light;
+    };
 
-            Array(u32) node_stack(m_memoryService->m_systemAllocator);
-            node_stack.reserve( 8 );
+    layout(std140, binding = 1) uniform MaterialConstant {
+        vec4 base_color_factor;
+        mat4 model;
+        mat4 model_inv;
 
-            Array(mat4s) node_matrix(m_memoryService->m_systemAllocator);
-            node_matrix.reserve( scene.nodes_count );
-            node_matrix.resize( scene.nodes_count );
+        vec3  emissive_factor;
+        float metallic_factor;
 
-            for ( u32 node_index = 0; node_index < root_gltf_scene.nodes_count; ++node_index ) {
-                u32 root_node = root_gltf_scene.nodes[ node_index ];
-                node_parents[ root_node ] = -1;
-                node_stack.push_back( root_node );
+        float roughness_factor;
+        float occlusion_factor;
+        uint  flags;
+    };
+
+    layout(location=0) in vec4 position;
+    layout(location=1) in vec2 tangent;
+    layout(location=2) in vec2 normal;
+    layout(location=3) in vec2 texCoord0;
+
+    layout (location = 0) out vec2 vTexcoord0;
+    layout (location = 1) out vec3 vNormal;
+    layout (location = 2) out vec4 vTangent;
+    layout (location = 3) out vec4 vPosition;
+
+    vec3 decode_octahedral( vec2 e ) {
+        vec3 n = vec3( e.xy, 1.0 - abs( e.x ) - abs( e.y ) );
+        float t = max( -n.z, 0.0 );
+        n.x += n.x >= 0.0 ? -t : t;
+        n.y += n.y >= 0.0 ? -t : t;
+        return normalize( n );
+    }
+
+    void main() {
+        // The model matrix includes the dequantization of the box relative positions.
+        gl_Position = vp * m * model * vec4(position.xyz, 1);
+        vPosition = m * model * vec4(position.xyz, 1.0);
+
+        if ( ( flags & MaterialFeatures_TexcoordVertexAttribute ) != 0 ) {
+            vTexcoord0 = texCoord0;
+        }
+        vNormal = mat3( model_inv ) * decode_octahedral( normal );
+
+        if ( ( flags & MaterialFeatures_TangentVertexAttribute ) != 0 ) {
+            vTangent = vec4( decode_octahedral( tangent ), position.w * 2.0 - 1.0 );
+        }
+    }
+    )FOO";
+
+            SetVertexInput( pipelineCreation.m_vertexInput, k_quantized_vertex_formats );
+            pipelineCreation.m_shaders.Reset().SetName( "CubeQuantized" ).AddStage( vs_quantized_code, ( uint32_t )strlen( vs_quantized_code ), VK_SHADER_STAGE_VERTEX_BIT ).AddStage( fs_code, ( uint32_t )strlen( fs_code ), VK_SHADER_STAGE_FRAGMENT_BIT );
+            cube_quantized_pipeline = m_gpu->create_pipeline( pipelineCreation );
+        }
+    }
+
+    void DemoApplication::LoadGltfScene(cstring path) {
+        char gltfBasePath[512]{};
+        memcpy(gltfBasePath, path, strlen(path));
+        FileDirectoryFromPath(gltfBasePath);
+
+        const auto cwd = std::filesystem::current_path();
+
+        std::filesystem::current_path(gltfBasePath);
+
+        char gltfFile[512]{};
+        memcpy(gltfFile, path, strlen(path));
+        FileNameFromPath(gltfFile);
+
+        glTF::glTF scene = gltfLoadFile(gltfFile, &m_memoryService->m_scratchAllocator);
+
+        // Buffers are mapped and read in place, primitives are decoded from the mapping straight into their vertex buffers.
+        // The binary chunk of a GLB is already mapped by the loader.
+        Array(MappedFile) buffersFiles(m_memoryService->m_systemAllocator);
+        buffersFiles.reserve(scene.buffers_count);
+        Array(const u8*) buffersData(m_memoryService->m_systemAllocator);
+        buffersData.reserve(scene.buffers_count);
+
+        for ( u32 bufferIndex = 0; bufferIndex < scene.buffers_count; ++bufferIndex ) {
+            glTF::Buffer& buffer = scene.buffers[ bufferIndex ];
+            if ( buffer.data ) {
+                buffersData.push_back( buffer.data );
+                continue;
             }
 
-            while ( node_stack.size() ) {
-                u32 node_index = node_stack.back();
-                node_stack.pop_back();
+            // A buffer that fails to open stays null, the primitives and images using it are skipped.
+            MappedFile& bufferFile = buffersFiles.emplace_back();
+            if (!bufferFile.Open(buffer.uri.data(), FileAccessHint::WillNeed)) {
+                error("Error opening buffer {}", buffer.uri.data());
+                buffersData.push_back( nullptr );
+                continue;
+            }
+            // Accessors are range checked against the declared length, the file has to hold all of it.
+            if (buffer.byte_length == glTF::INVALID_INT_VALUE || bufferFile.m_size < (sizet)buffer.byte_length) {
+                error("Buffer {} is smaller than its declared length", buffer.uri.data());
+                buffersData.push_back( nullptr );
+                continue;
+            }
+            buffersData.push_back( ( const u8* )bufferFile.m_data );
+        }
+
+        // Image files are read in a single batch, decoding starts once every read is done.
+        // Images stored in a buffer view or in a data uri are decoded straight from memory.
+        IoRequest* imageRequests = callocaa<IoRequest>(scene.images_count, &m_memoryService->m_systemAllocator, alignof(IoRequest));
+        u32 imageRequestCount = 0;
+        for (u32 image_index = 0; image_index < scene.images_count; ++image_index) {
+            glTF::Image &image = scene.images[image_index];
+            if (image.uri.empty()) {
+                continue;
+            }
+
+            IoRequest* request = new (&imageRequests[imageRequestCount++]) IoRequest();
+
+            std::error_code errorCode;
+            const sizet fileSize = std::filesystem::file_size(image.uri.data(), errorCode);
+            request->m_path = image.uri.data();
+            request->m_size = errorCode ? 0 : fileSize;
+            request->m_destination = request->m_size ? calloca(request->m_size, &m_memoryService->m_systemAllocator) : nullptr;
+        }
+        m_ioService->Submit(imageRequests, imageRequestCount);
+        m_ioService->Wait(imageRequests, imageRequestCount);
+
+        StringBuffer resourceNameBuffer(m_memoryService->m_systemAllocator);
+        resourceNameBuffer.reserve(ckilo(64));
+
+        Array(TextureResource) images(m_memoryService->m_systemAllocator);
+        images.reserve(scene.images_count);
+
+        u32 imageRequestIndex = 0;
+        for (u32 image_index = 0; image_index < scene.images_count; ++image_index) {
+            glTF::Image &image = scene.images[image_index];
+
+            TextureResource* tr = nullptr;
+            if (image.uri.empty()) {
+                u32 imageSize = image.data_size;
+                const u8* imageData = image.data;
+                if (!imageData && image.buffer_view != glTF::INVALID_INT_VALUE) {
+                    imageData = get_buffer_data( scene.buffer_views, image.buffer_view, buffersData, &imageSize );
+                }
+
+                char* imageName = resourceNameBuffer.data() + resourceNameBuffer.size();
+                resourceNameBuffer.append(std::format("image_{}", image_index));
+                resourceNameBuffer.push_back('\0');
+
+                tr = m_renderer->CreateTexture(imageName, imageData, imageData ? imageSize : 0);
+            } else {
+                IoRequest& request = imageRequests[imageRequestIndex++];
+                if (request.m_status.load() != IoStatus::Completed) {
+                    error("Error reading image {}", image.uri.data());
+                }
+
+                tr = m_renderer->CreateTexture(image.uri.data(), (const u8*)request.m_destination, request.m_bytesRead);
+
+                if (request.m_destination) {
+                    cfree(request.m_destination, &m_memoryService->m_systemAllocator);
+                }
+            }
+            CASSERT(tr != nullptr);
+
+            images.push_back(*tr);
+        }
+        cfree(imageRequests, &m_memoryService->m_systemAllocator);
+
+        Array(SamplerResource) samplers(m_memoryService->m_systemAllocator);
+        samplers.reserve(scene.samplers_count);
+
+        for ( u32 samplerIndex = 0; samplerIndex < scene.samplers_count; ++samplerIndex ) {
+            glTF::Sampler& sampler = scene.samplers[ samplerIndex ];
+
+            char* sampler_name = resourceNameBuffer.data() + resourceNameBuffer.size();
+            resourceNameBuffer.append(std::format("sampler_{}", samplerIndex));
+            resourceNameBuffer.push_back('\0');
+
+            SamplerCreation creation;
+            creation.m_minFilter = sampler.min_filter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+            creation.m_magFilter = sampler.mag_filter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+            creation.m_name = sampler_name;
+
+            SamplerResource* sr = m_renderer->CreateSampler( creation );
+            CASSERT( sr != nullptr );
+
+            samplers.push_back( *sr );
+        }
+
+        meshDraws.reserve(scene.meshes_count);
+
+        //Array(BufferHandle) customMeshBuffers(m_memoryService->m_systemAllocator);
+        customMeshBuffers.reserve(8);
+
+        {
+            BufferCreation buffer_creation;
+            GeometryImportStatistics import_statistics;
+            f64 generation_time = 0.0;
+            u64 generated_triangles = 0;
+            u64 optimizer_transforms_before = 0;
+            u64 optimizer_transforms_after = 0;
+            f64 meshlet_time = 0.0;
+            f64 lod_time = 0.0;
+            u64 lod_source_triangles = 0;
+            VertexQuantizationReport quantization_report;
+
+            glTF::Scene& root_gltf_scene = scene.scenes[ scene.scene == glTF::INVALID_INT_VALUE ? 0 : scene.scene ];
+
+            // Local matrices and parents of every node, the scene graph composes the world matrices.
+            Array(u32) node_parents(m_memoryService->m_systemAllocator);
+            node_parents.assign( scene.nodes_count, k_scene_graph_root );
+
+            Array(mat4s) node_matrix(m_memoryService->m_systemAllocator);
+            node_matrix.resize( scene.nodes_count );
+
+            for ( u32 node_index = 0; node_index < scene.nodes_count; ++node_index ) {
                 glTF::Node& node = scene.nodes[ node_index ];
 
                 mat4s local_matrix{ };
@@ -661,9 +877,28 @@ namespace Caustix {
                 node_matrix[ node_index ] = local_matrix;
 
                 for ( u32 child_index = 0; child_index < node.children_count; ++child_index ) {
-                    u32 child_node_index = node.children[ child_index ];
-                    node_parents[ child_node_index ] = node_index;
-                    node_stack.push_back( child_node_index );
+                    node_parents[ node.children[ child_index ] ] = node_index;
+                }
+            }
+
+            m_sceneGraph.Build( node_parents.data(), ( const f32* )node_matrix.data(), scene.nodes_count );
+
+            Array(u32) node_stack(m_memoryService->m_systemAllocator);
+            node_stack.reserve( 8 );
+
+            for ( u32 node_index = 0; node_index < root_gltf_scene.nodes_count; ++node_index ) {
+                u32 root_node = root_gltf_scene.nodes[ node_index ];
+                node_stack.push_back( root_node );
+                m_sceneRoots.push_back( root_node );
+            }
+
+            while ( node_stack.size() ) {
+                u32 node_index = node_stack.back();
+                node_stack.pop_back();
+                glTF::Node& node = scene.nodes[ node_index ];
+
+                for ( u32 child_index = 0; child_index < node.children_count; ++child_index ) {
+                    node_stack.push_back( node.children[ child_index ] );
                 }
 
                 if ( node.mesh == glTF::INVALID_INT_VALUE ) {
@@ -672,125 +907,277 @@ namespace Caustix {
 
                 glTF::Mesh& mesh = scene.meshes[ node.mesh ];
 
-                mat4s final_matrix = local_matrix;
-                i32 node_parent = node_parents[ node_index ];
-                while( node_parent != -1 ) {
-                    final_matrix = glms_mat4_mul( node_matrix[ node_parent ], final_matrix );
-                    node_parent = node_parents[ node_parent ];
-                }
+                mat4s final_matrix;
+                memcpy( &final_matrix, m_sceneGraph.GetWorldMatrix( node_index ), sizeof( mat4s ) );
 
                 // Final SRT composition
                 for ( u32 primitive_index = 0; primitive_index < mesh.primitives_count; ++primitive_index ) {
                     MeshDraw mesh_draw{ };
 
                     mesh_draw.materialData.model = final_matrix;
+                    mesh_draw.node = node_index;
 
                     glTF::MeshPrimitive& mesh_primitive = mesh.primitives[ primitive_index ];
 
-                    glTF::Accessor& indices_accessor = scene.accessors[ mesh_primitive.indices ];
-                    CASSERT( indices_accessor.component_type == glTF::Accessor::UNSIGNED_INT || indices_accessor.component_type == glTF::Accessor::UNSIGNED_SHORT );
-                    mesh_draw.indexType = indices_accessor.component_type == glTF::Accessor::UNSIGNED_INT ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
-
-                    glTF::BufferView& indices_buffer_view = scene.buffer_views[ indices_accessor.buffer_view ];
-                    BufferResource& indices_buffer_gpu = buffers[ indices_accessor.buffer_view ];
-                    mesh_draw.indexBuffer = indices_buffer_gpu.m_handle;
-                    mesh_draw.indexOffset = indices_accessor.byte_offset == glTF::INVALID_INT_VALUE ? 0 : indices_accessor.byte_offset;
-                    mesh_draw.count = indices_accessor.count;
-                    CASSERT( ( mesh_draw.count % 3 ) == 0 );
-
                     i32 position_accessor_index = gltfGetAttributeAccessorIndex( mesh_primitive.attributes, mesh_primitive.attribute_count, "POSITION" );
                     i32 tangent_accessor_index = gltfGetAttributeAccessorIndex( mesh_primitive.attributes, mesh_primitive.attribute_count, "TANGENT" );
                     i32 normal_accessor_index = gltfGetAttributeAccessorIndex( mesh_primitive.attributes, mesh_primitive.attribute_count, "NORMAL" );
                     i32 texcoord_accessor_index = gltfGetAttributeAccessorIndex( mesh_primitive.attributes, mesh_primitive.attribute_count, "TEXCOORD_0" );
 
-                    vec3s* position_data = nullptr;
-                    u32* index_data_32 = ( u32* )get_buffer_data( scene.buffer_views, indices_accessor.buffer_view, buffersData );
-                    u16* index_data_16 = ( u16* )index_data_32;
-                    u32 vertex_count = 0;
-
-                    if ( position_accessor_index != -1 ) {
-                        glTF::Accessor& position_accessor = scene.accessors[ position_accessor_index ];
-                        glTF::BufferView& position_buffer_view = scene.buffer_views[ position_accessor.buffer_view ];
-                        BufferResource& position_buffer_gpu = buffers[ position_accessor.buffer_view ];
-
-                        vertex_count = position_accessor.count;
-
-                        mesh_draw.positionBuffer = position_buffer_gpu.m_handle;
-                        mesh_draw.positionOffset = position_accessor.byte_offset == glTF::INVALID_INT_VALUE ? 0 : position_accessor.byte_offset;
-
-                        position_data = ( vec3s* )get_buffer_data( scene.buffer_views, position_accessor.buffer_view, buffersData );
-                    } else {
+                    if ( position_accessor_index == -1 || mesh_primitive.indices == glTF::INVALID_INT_VALUE ) {
                         CASSERT( false );
                         continue;
                     }
 
+                    // Attributes of any component type are decoded to the float layout of the pipeline, one vertex buffer per primitive.
+                    u32 vertex_count = scene.accessors[ position_accessor_index ].count;
+                    const u32 index_count = scene.accessors[ mesh_primitive.indices ].count;
+                    CASSERT( ( index_count % 3 ) == 0 );
+
+                    // Missing tangents are generated when there are uvs to derive them from.
+                    const bool has_tangents = tangent_accessor_index != -1 || texcoord_accessor_index != -1;
+
+                    // Streams follow each other, the layout is computed again once the optimizer removed vertices.
+                    const u32 position_offset = 0;
+                    u32 tangent_offset = 0, normal_offset = 0, texcoord_offset = 0, vertex_size = 0;
+                    auto compute_layout = [ & ]( u32 count ) {
+                        tangent_offset = position_offset + count * sizeof( vec3s );
+                        normal_offset = tangent_offset + ( has_tangents ? count * sizeof( vec4s ) : 0 );
+                        texcoord_offset = normal_offset + count * sizeof( vec3s );
+                        vertex_size = texcoord_offset + ( texcoord_accessor_index != -1 ? count * sizeof( vec2s ) : 0 );
+                    };
+                    compute_layout( vertex_count );
+
+                    u8* vertex_data = callocaa<u8>( vertex_size, &m_memoryService->m_systemAllocator );
+                    u32* index_data = callocaa<u32>( index_count, &m_memoryService->m_systemAllocator );
+
+                    bool decoded = DecodeAccessor( scene, buffersData.data(), position_accessor_index, ( f32* )( vertex_data + position_offset ), 3, sizeof( vec3s ), m_jobSystem, &import_statistics );
+                    if ( tangent_accessor_index != -1 ) {
+                        decoded &= DecodeAccessor( scene, buffersData.data(), tangent_accessor_index, ( f32* )( vertex_data + tangent_offset ), 4, sizeof( vec4s ), m_jobSystem, &import_statistics );
+                    }
                     if ( normal_accessor_index != -1 ) {
-                        glTF::Accessor& normal_accessor = scene.accessors[ normal_accessor_index ];
-                        glTF::BufferView& normal_buffer_view = scene.buffer_views[ normal_accessor.buffer_view ];
-                        BufferResource& normal_buffer_gpu = buffers[ normal_accessor.buffer_view ];
+                        decoded &= DecodeAccessor( scene, buffersData.data(), normal_accessor_index, ( f32* )( vertex_data + normal_offset ), 3, sizeof( vec3s ), m_jobSystem, &import_statistics );
+                    }
+                    if ( texcoord_accessor_index != -1 ) {
+                        decoded &= DecodeAccessor( scene, buffersData.data(), texcoord_accessor_index, ( f32* )( vertex_data + texcoord_offset ), 2, sizeof( vec2s ), m_jobSystem, &import_statistics );
+                    }
+                    decoded &= DecodeIndices( scene, buffersData.data(), mesh_primitive.indices, index_data, m_jobSystem, &import_statistics );
 
-                        mesh_draw.normalBuffer = normal_buffer_gpu.m_handle;
-                        mesh_draw.normalOffset = normal_accessor.byte_offset == glTF::INVALID_INT_VALUE ? 0 : normal_accessor.byte_offset;
+                    if ( !decoded ) {
+                        error( "Error decoding primitive {} of mesh {}", primitive_index, node.mesh );
+                        cfree( vertex_data, &m_memoryService->m_systemAllocator );
+                        cfree( index_data, &m_memoryService->m_systemAllocator );
+                        continue;
+                    }
+
+                    // The file has to give float bounds, quantized accessors store them unnormalized.
+                    const glTF::Accessor& position_accessor = scene.accessors[ position_accessor_index ];
+                    if ( position_accessor.component_type == glTF::Accessor::FLOAT && position_accessor.min_count == 3 && position_accessor.max_count == 3 ) {
+                        mesh_draw.boxMin = vec3s{ position_accessor.min[ 0 ], position_accessor.min[ 1 ], position_accessor.min[ 2 ] };
+                        mesh_draw.boxMax = vec3s{ position_accessor.max[ 0 ], position_accessor.max[ 1 ], position_accessor.max[ 2 ] };
                     } else {
-                        // NOTE(marco): we could compute this at runtime
-                        Array(vec3s) normals_array(m_memoryService->m_systemAllocator);
-                        normals_array.reserve( vertex_count );
-                        normals_array.resize( vertex_count );
-                        memset( normals_array.data(), 0, normals_array.size() * sizeof( vec3s ) );
-
-                        u32 index_count = mesh_draw.count;
-                        for ( u32 index = 0; index < index_count; index += 3 ) {
-                            u32 i0 = indices_accessor.component_type == glTF::Accessor::UNSIGNED_INT ? index_data_32[ index ] : index_data_16[ index ];
-                            u32 i1 = indices_accessor.component_type == glTF::Accessor::UNSIGNED_INT ? index_data_32[ index + 1 ] : index_data_16[ index + 1 ];
-                            u32 i2 = indices_accessor.component_type == glTF::Accessor::UNSIGNED_INT ? index_data_32[ index + 2 ] : index_data_16[ index + 2 ];
-
-                            vec3s p0 = position_data[ i0 ];
-                            vec3s p1 = position_data[ i1 ];
-                            vec3s p2 = position_data[ i2 ];
-
-                            vec3s a = glms_vec3_sub( p1, p0 );
-                            vec3s b = glms_vec3_sub( p2, p0 );
-
-                            vec3s normal = glms_cross( a, b );
-
-                            normals_array[ i0 ] = glms_vec3_add( normals_array[ i0 ], normal );
-                            normals_array[ i1 ] = glms_vec3_add( normals_array[ i1 ], normal );
-                            normals_array[ i2 ] = glms_vec3_add( normals_array[ i2 ], normal );
+                        const f32* positions = ( const f32* )( vertex_data + position_offset );
+                        mesh_draw.boxMin = mesh_draw.boxMax = vec3s{ positions[ 0 ], positions[ 1 ], positions[ 2 ] };
+                        for ( u32 vertex = 1; vertex < vertex_count; ++vertex ) {
+                            const vec3s position = { positions[ vertex * 3 + 0 ], positions[ vertex * 3 + 1 ], positions[ vertex * 3 + 2 ] };
+                            mesh_draw.boxMin = glms_vec3_minv( mesh_draw.boxMin, position );
+                            mesh_draw.boxMax = glms_vec3_maxv( mesh_draw.boxMax, position );
+                        }
+                    }
+
+                    // Missing normals are generated before welding: vertices split for flat shading keep their face normals
+                    // and so stay apart, as glTF asks for primitives without normals.
+                    if ( normal_accessor_index == -1 ) {
+                        const auto generation_start = std::chrono::high_resolution_clock::now();
+                        decoded = GenerateNormals( ( f32* )( vertex_data + position_offset ), vertex_count, index_data, index_count, ( f32* )( vertex_data + normal_offset ),
+                                                   &m_memoryService->m_systemAllocator, m_jobSystem );
+                        generation_time += std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - generation_start ).count();
+
+                        if ( !decoded ) {
+                            error( "Error generating the normals of primitive {} of mesh {}", primitive_index, node.mesh );
+                            cfree( vertex_data, &m_memoryService->m_systemAllocator );
+                            cfree( index_data, &m_memoryService->m_systemAllocator );
+                            continue;
+                        }
+                    }
+
+                    // Welds identical vertices, reorders triangles for the vertex cache and overdraw and vertices for fetch locality.
+                    // Generated tangents are computed on the result and take no part.
+                    {
+                        VertexStream streams[ 4 ];
+                        u32 stream_count = 0;
+                        streams[ stream_count++ ] = { vertex_data + position_offset, sizeof( vec3s ) };
+                        if ( tangent_accessor_index != -1 ) {
+                            streams[ stream_count++ ] = { vertex_data + tangent_offset, sizeof( vec4s ) };
+                        }
+                        streams[ stream_count++ ] = { vertex_data + normal_offset, sizeof( vec3s ) };
+                        if ( texcoord_accessor_index != -1 ) {
+                            streams[ stream_count++ ] = { vertex_data + texcoord_offset, sizeof( vec2s ) };
                         }
 
-                        for ( u32 vertex = 0; vertex < vertex_count; ++vertex ) {
-                            normals_array[ vertex ] = glms_normalize( normals_array[ vertex ] );
+                        MeshOptimizerReport report;
+                        vertex_count = OptimizeMesh( index_data, index_count, streams, stream_count, vertex_count, 0, &m_memoryService->m_systemAllocator, {}, &report );
+                        info( "Mesh {} primitive {}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", node.mesh, primitive_index,
+                              report.m_verticesBefore, report.m_verticesAfter, report.m_before.m_acmr, report.m_after.m_acmr, report.m_before.m_atvr, report.m_after.m_atvr );
+                        optimizer_transforms_before += report.m_before.m_vertexTransforms;
+                        optimizer_transforms_after += report.m_after.m_vertexTransforms;
+
+                        // Offsets only move down, streams are compacted in order.
+                        const u32 previous_tangent_offset = tangent_offset;
+                        const u32 previous_normal_offset = normal_offset;
+                        const u32 previous_texcoord_offset = texcoord_offset;
+                        compute_layout( vertex_count );
+                        if ( tangent_accessor_index != -1 ) {
+                            memmove( vertex_data + tangent_offset, vertex_data + previous_tangent_offset, vertex_count * sizeof( vec4s ) );
+                        }
+                        memmove( vertex_data + normal_offset, vertex_data + previous_normal_offset, vertex_count * sizeof( vec3s ) );
+                        if ( texcoord_accessor_index != -1 ) {
+                            memmove( vertex_data + texcoord_offset, vertex_data + previous_texcoord_offset, vertex_count * sizeof( vec2s ) );
                         }
+                    }
 
-                        BufferCreation normals_creation{ };
-                        normals_creation.Set( VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, ResourceUsageType::Immutable, normals_array.size() * sizeof( vec3s ) ).SetName( "normals" ).SetData( normals_array.data() );
+                    f32* position_data = ( f32* )( vertex_data + position_offset );
+                    f32* normal_data = ( f32* )( vertex_data + normal_offset );
 
-                        mesh_draw.normalBuffer = m_gpu->create_buffer( normals_creation );
-                        mesh_draw.normalOffset = 0;
+                    if ( tangent_accessor_index == -1 && has_tangents ) {
+                        const auto generation_start = std::chrono::high_resolution_clock::now();
+                        decoded = GenerateTangents( position_data, normal_data, ( f32* )( vertex_data + texcoord_offset ), vertex_count, index_data, index_count,
+                                                    ( f32* )( vertex_data + tangent_offset ), &m_memoryService->m_systemAllocator, m_jobSystem );
+                        generation_time += std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - generation_start ).count();
+                    }
 
-                        customMeshBuffers.push_back( mesh_draw.normalBuffer );
+                    if ( normal_accessor_index == -1 || ( tangent_accessor_index == -1 && has_tangents ) ) {
+                        generated_triangles += index_count / 3;
+                    }
 
-                        normals_array.clear();
+                    if ( !decoded ) {
+                        error( "Error generating the tangent space of primitive {} of mesh {}", primitive_index, node.mesh );
+                        cfree( vertex_data, &m_memoryService->m_systemAllocator );
+                        cfree( index_data, &m_memoryService->m_systemAllocator );
+                        continue;
                     }
 
-                    if ( tangent_accessor_index != -1 ) {
-                        glTF::Accessor& tangent_accessor = scene.accessors[ tangent_accessor_index ];
-                        glTF::BufferView& tangent_buffer_view = scene.buffer_views[ tangent_accessor.buffer_view ];
-                        BufferResource& tangent_buffer_gpu = buffers[ tangent_accessor.buffer_view ];
+                    // Clusters follow the optimized triangle order, so they stay compact.
+                    {
+                        const auto meshlet_start = std::chrono::high_resolution_clock::now();
+                        mesh_draw.meshletOffset = BuildMeshlets( index_data, index_count, position_data, vertex_count, m_meshlets, m_jobSystem );
+                        mesh_draw.meshletCount = ( u32 )m_meshlets.m_meshlets.size() - mesh_draw.meshletOffset;
+                        meshlet_time += std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - meshlet_start ).count();
+                    }
 
-                        mesh_draw.tangentBuffer = tangent_buffer_gpu.m_handle;
-                        mesh_draw.tangentOffset = tangent_accessor.byte_offset == glTF::INVALID_INT_VALUE ? 0 : tangent_accessor.byte_offset;
+                    // Every level indexes the same vertices, they follow each other in the index buffer.
+                    Array(u32) lod_indices( m_memoryService->m_systemAllocator );
+                    {
+                        SimplifierAttribute attributes[ 2 ];
+                        u32 attribute_count = 0;
+                        attributes[ attribute_count++ ] = { normal_data, sizeof( vec3s ), 3, 0.5f };
+                        if ( texcoord_accessor_index != -1 ) {
+                            attributes[ attribute_count++ ] = { ( f32* )( vertex_data + texcoord_offset ), sizeof( vec2s ), 2, 0.5f };
+                        }
+
+                        const auto lod_start = std::chrono::high_resolution_clock::now();
+                        mesh_draw.lodCount = GenerateMeshLods( index_data, index_count, position_data, vertex_count, attributes, attribute_count,
+                                                               lod_indices, mesh_draw.lods, &m_memoryService->m_systemAllocator );
+                        lod_time += std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - lod_start ).count();
+                        lod_source_triangles += index_count / 3;
+
+                        std::string lod_triangles;
+                        for ( u32 lod_index = 0; lod_index < mesh_draw.lodCount; ++lod_index ) {
+                            lod_triangles += std::format( " {} ({:.4f})", mesh_draw.lods[ lod_index ].m_indexCount / 3, mesh_draw.lods[ lod_index ].m_error );
+                        }
+                        info( "Mesh {} primitive {}: LOD triangles (error){}", node.mesh, primitive_index, lod_triangles );
+
+                        vec3s box_min = { position_data[ 0 ], position_data[ 1 ], position_data[ 2 ] };
+                        vec3s box_max = box_min;
+                        for ( u32 vertex = 1; vertex < vertex_count; ++vertex ) {
+                            const vec3s position = { position_data[ vertex * 3 + 0 ], position_data[ vertex * 3 + 1 ], position_data[ vertex * 3 + 2 ] };
+                            box_min = glms_vec3_minv( box_min, position );
+                            box_max = glms_vec3_maxv( box_max, position );
+                        }
+                        const vec3s center = glms_vec3_scale( glms_vec3_add( box_min, box_max ), 0.5f );
+                        mesh_draw.boundingSphere = vec4s{ center.x, center.y, center.z, glms_vec3_distance( center, box_max ) };
+                    }
+
+                    // 16 bit indices whenever the vertex count allows it, whatever the file stores. Narrowed in place.
+                    const bool index_32 = vertex_count > 65536;
+                    const u32 index_size = ( u32 )lod_indices.size() * ( index_32 ? sizeof( u32 ) : sizeof( u16 ) );
+                    if ( !index_32 ) {
+                        u16* index_data_16 = ( u16* )lod_indices.data();
+                        for ( u32 index = 0; index < lod_indices.size(); ++index ) {
+                            index_data_16[ index ] = ( u16 )lod_indices[ index ];
+                        }
+                    }
+
+                    // Quantized streams follow each other in the same order as the float ones and replace them.
+                    if ( m_quantizeVertices ) {
+                        const u32 quantized_tangent_offset = position_offset + vertex_count * k_quantized_position_size;
+                        const u32 quantized_normal_offset = quantized_tangent_offset + ( has_tangents ? vertex_count * k_quantized_unit_vector_size : 0 );
+                        const u32 quantized_texcoord_offset = quantized_normal_offset + vertex_count * k_quantized_unit_vector_size;
+                        const u32 quantized_size = quantized_texcoord_offset + ( texcoord_accessor_index != -1 ? vertex_count * k_quantized_texcoord_size : 0 );
+                        u8* quantized_data = callocaa<u8>( quantized_size, &m_memoryService->m_systemAllocator );
+
+                        VertexQuantizationReport report;
+                        f32 offset[ 3 ], scale[ 3 ];
+                        const f32* tangent_data = has_tangents ? ( f32* )( vertex_data + tangent_offset ) : nullptr;
+                        report.m_positionError = QuantizePositions( position_data, tangent_data, vertex_count, ( u16* )( quantized_data + position_offset ), offset, scale );
+                        if ( has_tangents ) {
+                            report.m_tangentError = QuantizeUnitVectors( tangent_data, sizeof( vec4s ), vertex_count, ( i16* )( quantized_data + quantized_tangent_offset ) );
+                        }
+                        report.m_normalError = QuantizeUnitVectors( normal_data, sizeof( vec3s ), vertex_count, ( i16* )( quantized_data + quantized_normal_offset ) );
+                        if ( texcoord_accessor_index != -1 ) {
+                            report.m_texcoordError = QuantizeTexcoords( ( f32* )( vertex_data + texcoord_offset ), vertex_count, ( u16* )( quantized_data + quantized_texcoord_offset ) );
+                        }
+                        report.m_bytesBefore = vertex_size;
+                        report.m_bytesAfter = quantized_size;
+                        info( "Mesh {} primitive {}: vertices quantized from {} to {} bytes, largest errors position {:.6f}, normal {:.4f} deg, tangent {:.4f} deg, texcoord {:.6f}",
+                              node.mesh, primitive_index, report.m_bytesBefore, report.m_bytesAfter, report.m_positionError, report.m_normalError, report.m_tangentError, report.m_texcoordError );
+                        quantization_report.Add( report );
+
+                        mesh_draw.quantized = true;
+                        mesh_draw.dequantization = glms_mat4_mul( glms_translate_make( vec3s{ offset[ 0 ], offset[ 1 ], offset[ 2 ] } ), glms_scale_make( vec3s{ scale[ 0 ], scale[ 1 ], scale[ 2 ] } ) );
+
+                        cfree( vertex_data, &m_memoryService->m_systemAllocator );
+                        vertex_data = quantized_data;
+                        tangent_offset = quantized_tangent_offset;
+                        normal_offset = quantized_normal_offset;
+                        texcoord_offset = quantized_texcoord_offset;
+                        vertex_size = quantized_size;
+                    }
+
+                    BufferCreation vertex_creation{ };
+                    vertex_creation.Set( VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, ResourceUsageType::Immutable, vertex_size ).SetName( "vertices" ).SetData( vertex_data );
+                    BufferHandle vertex_buffer = m_gpu->create_buffer( vertex_creation );
+
+                    BufferCreation index_creation{ };
+                    index_creation.Set( VK_BUFFER_USAGE_INDEX_BUFFER_BIT, ResourceUsageType::Immutable, index_size ).SetName( "indices" ).SetData( lod_indices.data() );
+                    BufferHandle index_buffer = m_gpu->create_buffer( index_creation );
+
+                    customMeshBuffers.push_back( vertex_buffer );
+                    customMeshBuffers.push_back( index_buffer );
+
+                    cfree( vertex_data, &m_memoryService->m_systemAllocator );
+                    cfree( index_data, &m_memoryService->m_systemAllocator );
+
+                    mesh_draw.indexBuffer = index_buffer;
+                    mesh_draw.indexOffset = 0;
+                    mesh_draw.indexType = index_32 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+                    mesh_draw.count = index_count;
+
+                    mesh_draw.positionBuffer = vertex_buffer;
+                    mesh_draw.positionOffset = position_offset;
+                    mesh_draw.normalBuffer = vertex_buffer;
+                    mesh_draw.normalOffset = normal_offset;
+
+                    if ( has_tangents ) {
+                        mesh_draw.tangentBuffer = vertex_buffer;
+                        mesh_draw.tangentOffset = tangent_offset;
 
                         mesh_draw.materialData.flags |= MaterialFeatures_TangentVertexAttribute;
                     }
 
                     if ( texcoord_accessor_index != -1 ) {
-                        glTF::Accessor& texcoord_accessor = scene.accessors[ texcoord_accessor_index ];
-                        glTF::BufferView& texcoord_buffer_view = scene.buffer_views[ texcoord_accessor.buffer_view ];
-                        BufferResource& texcoord_buffer_gpu = buffers[ texcoord_accessor.buffer_view ];
-
-                        mesh_draw.texcoordBuffer = texcoord_buffer_gpu.m_handle;
-                        mesh_draw.texcoordOffset = texcoord_accessor.byte_offset == glTF::INVALID_INT_VALUE ? 0 : texcoord_accessor.byte_offset;
+                        mesh_draw.texcoordBuffer = vertex_buffer;
+                        mesh_draw.texcoordOffset = texcoord_offset;
 
                         mesh_draw.materialData.flags |= MaterialFeatures_TexcoordVertexAttribute;
                     }
@@ -938,22 +1325,217 @@ namespace Caustix {
             node_parents.clear();
             node_stack.clear();
             node_matrix.clear();
+
+            import_statistics.Log();
+            if ( generated_triangles ) {
+                info( "Tangent space generated for {} triangles in {:.2f} ms", generated_triangles, generation_time );
+            }
+            info( "Mesh optimization: {} -> {} vertex shader invocations", optimizer_transforms_before, optimizer_transforms_after );
+            info( "Built {} meshlets in {:.2f} ms", m_meshlets.m_meshlets.size(), meshlet_time );
+            if ( lod_time > 0.0 ) {
+                info( "LODs generated for {} triangles in {:.2f} ms, {:.2f} M triangles/s", lod_source_triangles, lod_time, lod_source_triangles / ( lod_time * 1000.0 ) );
+            }
+            if ( quantization_report.m_bytesBefore ) {
+                info( "Vertex quantization: {} -> {} bytes, {:.1f}% saved, largest errors position {:.6f}, normal {:.4f} deg, tangent {:.4f} deg, texcoord {:.6f}",
+                      quantization_report.m_bytesBefore, quantization_report.m_bytesAfter, 100.0 - 100.0 * quantization_report.m_bytesAfter / quantization_report.m_bytesBefore,
+                      quantization_report.m_positionError, quantization_report.m_normalError, quantization_report.m_tangentError, quantization_report.m_texcoordError );
+            }
+            m_visibleMeshlets.resize( m_meshlets.m_meshlets.size() );
         }
 
-        auto rx = 0.0f;
-        auto ry = 0.0f;
+        buffersData.clear();
+        buffersFiles.clear();
+
+        std::filesystem::current_path(cwd);
+    }
 
-        for ( u32 buffer_index = 0; buffer_index < scene.buffers_count; ++buffer_index ) {
-            void* buffer = buffersData[ buffer_index ];
-            m_memoryService->m_systemAllocator.deallocate( buffer );
+    void DemoApplication::LoadCookedScene(cstring path) {
+        // Mapped and used in place, only the GPU upload touches the data.
+        MappedFile cookedFile;
+        if (!cookedFile.Open(path, FileAccessHint::WillNeed)) {
+            error("Error opening cooked scene {}", path);
+            return;
         }
 
-        buffersData.clear();
+        BlobSerializer serializer;
+        // Older versions are migrated into memory, with room for the fields added since.
+        const CookedScene* scene = serializer.Map<CookedScene>(cookedFile, k_cooked_scene_version, &m_memoryService->m_systemAllocator, cookedFile.m_size * 2);
+        if (scene == nullptr) {
+            error("Error reading cooked scene {}", path);
+            return;
+        }
 
-        m_gameCamera.m_camera.IntializePerspective(0.01, 100.0, 45, m_window->m_width / m_window->m_height);
-        m_gameCamera.Reset();
+        // Names must outlive the scene mapping, reserved once so that the pointers stay valid.
+        sizet namesSize = 0;
+        for (const CookedTexture& texture : scene->m_textures) {
+            namesSize += texture.m_name.m_size + 1;
+        }
+        m_resourceNames.reserve(namesSize + ckilo(1));
 
-        std::filesystem::current_path(cwd);
+        Array(TextureHandle) textures(m_memoryService->m_systemAllocator);
+        textures.reserve(scene->m_textures.m_size);
+        for (const CookedTexture& texture : scene->m_textures) {
+            char* textureName = m_resourceNames.data() + m_resourceNames.size();
+            m_resourceNames.append(texture.m_name.CStr());
+            m_resourceNames.push_back('\0');
+
+            TextureCreation creation;
+            creation.SetData((void*)texture.m_pixels.Get()).SetFormatType(VK_FORMAT_R8G8B8A8_UNORM, TextureType::Texture2D).SetFlags(1, 0).SetSize((u16)texture.m_width, (u16)texture.m_height, 1).SetName(textureName);
+
+            TextureResource* tr = m_renderer->CreateTexture(creation);
+            CASSERT(tr != nullptr);
+            textures.push_back(tr->m_handle);
+        }
+
+        Array(SamplerHandle) samplers(m_memoryService->m_systemAllocator);
+        samplers.reserve(scene->m_samplers.m_size);
+        for (const CookedSampler& sampler : scene->m_samplers) {
+            SamplerCreation creation;
+            creation.m_minFilter = sampler.m_minFilter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+            creation.m_magFilter = sampler.m_magFilter == glTF::Sampler::Filter::LINEAR ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+            SamplerResource* sr = m_renderer->CreateSampler(creation);
+            CASSERT(sr != nullptr);
+            samplers.push_back(sr->m_handle);
+        }
+
+        // All the primitives share one vertex and one index buffer.
+        BufferResource* vertexBuffer = m_renderer->CreateBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, ResourceUsageType::Immutable, scene->m_vertexData.m_size, (void*)scene->m_vertexData.Get(), "cooked_vertices");
+        BufferResource* indexBuffer = m_renderer->CreateBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, ResourceUsageType::Immutable, scene->m_indexData.m_size, (void*)scene->m_indexData.Get(), "cooked_indices");
+        CASSERT(vertexBuffer != nullptr && indexBuffer != nullptr);
+
+        // Cooked nodes are already in parent before child order, the scene graph sorts them anyway.
+        {
+            Array(u32) parents(m_memoryService->m_systemAllocator);
+            Array(f32) localMatrices(m_memoryService->m_systemAllocator);
+            parents.reserve(scene->m_nodes.m_size);
+            localMatrices.reserve(scene->m_nodes.m_size * 16);
+            for (u32 nodeIndex = 0; nodeIndex < scene->m_nodes.m_size; ++nodeIndex) {
+                const CookedNode& node = scene->m_nodes[nodeIndex];
+                parents.push_back(node.m_parent == k_cooked_invalid_index ? k_scene_graph_root : node.m_parent);
+                localMatrices.insert(localMatrices.end(), node.m_localMatrix, node.m_localMatrix + 16);
+                if (node.m_parent == k_cooked_invalid_index) {
+                    m_sceneRoots.push_back(nodeIndex);
+                }
+            }
+            m_sceneGraph.Build(parents.data(), localMatrices.data(), scene->m_nodes.m_size);
+        }
+
+        meshDraws.reserve(scene->m_primitives.m_size);
+
+        BufferCreation bufferCreation;
+        for (const CookedPrimitive& primitive : scene->m_primitives) {
+            MeshDraw meshDraw{};
+
+            memcpy(&meshDraw.materialData.model, m_sceneGraph.GetWorldMatrix(primitive.m_node), sizeof(mat4s));
+            meshDraw.node = primitive.m_node;
+
+            const f32* positions = (const f32*)(scene->m_vertexData.Get() + primitive.m_positionOffset);
+            meshDraw.boxMin = meshDraw.boxMax = vec3s{ positions[0], positions[1], positions[2] };
+            for (u32 vertex = 1; vertex < primitive.m_vertexCount; ++vertex) {
+                const vec3s position = { positions[vertex * 3 + 0], positions[vertex * 3 + 1], positions[vertex * 3 + 2] };
+                meshDraw.boxMin = glms_vec3_minv(meshDraw.boxMin, position);
+                meshDraw.boxMax = glms_vec3_maxv(meshDraw.boxMax, position);
+            }
+
+            meshDraw.indexBuffer = indexBuffer->m_handle;
+            meshDraw.indexOffset = primitive.m_indexOffset;
+            meshDraw.indexType = primitive.m_indexType == CookedIndexType_Uint32 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+            meshDraw.count = primitive.m_indexCount;
+
+            meshDraw.positionBuffer = vertexBuffer->m_handle;
+            meshDraw.positionOffset = primitive.m_positionOffset;
+            // Missing normals are generated by the cooker.
+            meshDraw.normalBuffer = vertexBuffer->m_handle;
+            meshDraw.normalOffset = primitive.m_normalOffset;
+
+            if (primitive.m_tangentOffset != k_cooked_invalid_index) {
+                meshDraw.tangentBuffer = vertexBuffer->m_handle;
+                meshDraw.tangentOffset = primitive.m_tangentOffset;
+                meshDraw.materialData.flags |= MaterialFeatures_TangentVertexAttribute;
+            }
+
+            if (primitive.m_texcoordOffset != k_cooked_invalid_index) {
+                meshDraw.texcoordBuffer = vertexBuffer->m_handle;
+                meshDraw.texcoordOffset = primitive.m_texcoordOffset;
+                meshDraw.materialData.flags |= MaterialFeatures_TexcoordVertexAttribute;
+            }
+
+            const CookedMaterial& material = scene->m_materials[primitive.m_material];
+            meshDraw.materialData.baseColorFactor = { material.m_baseColorFactor[0], material.m_baseColorFactor[1], material.m_baseColorFactor[2], material.m_baseColorFactor[3] };
+            meshDraw.materialData.emissiveFactor = { material.m_emissiveFactor[0], material.m_emissiveFactor[1], material.m_emissiveFactor[2] };
+            meshDraw.materialData.metallicFactor = material.m_metallicFactor;
+            meshDraw.materialData.roughnessFactor = material.m_roughnessFactor;
+            meshDraw.materialData.occlusionFactor = material.m_occlusionFactor;
+
+            DescriptorSetCreation dsCreation{};
+            dsCreation.SetLayout(cube_dsl).Buffer(cube_cb, 0);
+
+            bufferCreation.Reset().Set(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, ResourceUsageType::Dynamic, sizeof(MaterialData)).SetName("material");
+            meshDraw.materialBuffer = m_gpu->create_buffer(bufferCreation);
+            dsCreation.Buffer(meshDraw.materialBuffer, 1);
+
+            // Slots follow the descriptor bindings, starting from binding 2.
+            static const u32 k_slot_features[CookedTextureSlot_Count] = { MaterialFeatures_ColorTexture, MaterialFeatures_RoughnessTexture, MaterialFeatures_OcclusionTexture, MaterialFeatures_EmissiveTexture, MaterialFeatures_NormalTexture };
+            for (u32 slot = 0; slot < CookedTextureSlot_Count; ++slot) {
+                const u32 textureIndex = material.m_textures[slot];
+                if (textureIndex == k_cooked_invalid_index) {
+                    dsCreation.TextureSampler(dummyTexture, dummySampler, (u16)(2 + slot));
+                    continue;
+                }
+
+                const u32 samplerIndex = material.m_samplers[slot];
+                dsCreation.TextureSampler(textures[textureIndex], samplerIndex != k_cooked_invalid_index ? samplers[samplerIndex] : dummySampler, (u16)(2 + slot));
+                meshDraw.materialData.flags |= k_slot_features[slot];
+            }
+
+            meshDraw.descriptorSet = m_gpu->create_descriptor_set(dsCreation);
+
+            meshDraws.push_back(meshDraw);
+        }
+
+        serializer.Shutdown();
+    }
+
+    void DemoApplication::UpdateDrawBounds() {
+        m_drawBounds.Resize( ( u32 )meshDraws.size() );
+        m_drawVisibility.resize( meshDraws.size() );
+        for ( u32 mesh_index = 0; mesh_index < meshDraws.size(); ++mesh_index ) {
+            const MeshDraw& mesh_draw = meshDraws[ mesh_index ];
+            m_drawBounds.SetBox( mesh_index, &mesh_draw.boxMin.x, &mesh_draw.boxMax.x, &mesh_draw.materialData.model.m00 );
+        }
+
+        // Counted per node, then placed in draw order.
+        m_nodeDrawOffsets.assign( m_sceneGraph.m_nodeCount + 1, 0 );
+        for ( const MeshDraw& mesh_draw : meshDraws ) {
+            ++m_nodeDrawOffsets[ mesh_draw.node + 1 ];
+        }
+        for ( u32 node = 0; node < m_sceneGraph.m_nodeCount; ++node ) {
+            m_nodeDrawOffsets[ node + 1 ] += m_nodeDrawOffsets[ node ];
+        }
+        m_nodeDraws.resize( meshDraws.size() );
+        for ( u32 mesh_index = 0; mesh_index < meshDraws.size(); ++mesh_index ) {
+            m_nodeDraws[ m_nodeDrawOffsets[ meshDraws[ mesh_index ].node ]++ ] = mesh_index;
+        }
+        for ( u32 node = m_sceneGraph.m_nodeCount; node > 0; --node ) {
+            m_nodeDrawOffsets[ node ] = m_nodeDrawOffsets[ node - 1 ];
+        }
+        m_nodeDrawOffsets[ 0 ] = 0;
+    }
+
+    void DemoApplication::UpdateMovedDraws() {
+        const Array(u32)& ranges = m_sceneGraph.m_updatedRanges;
+        for ( u32 range = 0; range < ranges.size(); range += 2 ) {
+            for ( u32 order = ranges[ range ]; order < ranges[ range + 1 ]; ++order ) {
+                const u32 node = m_sceneGraph.m_nodes[ order ];
+                for ( u32 draw = m_nodeDrawOffsets[ node ]; draw < m_nodeDrawOffsets[ node + 1 ]; ++draw ) {
+                    const u32 mesh_index = m_nodeDraws[ draw ];
+                    MeshDraw& mesh_draw = meshDraws[ mesh_index ];
+                    memcpy( &mesh_draw.materialData.model, m_sceneGraph.GetWorldMatrix( node ), sizeof( mat4s ) );
+                    m_drawBounds.SetBox( mesh_index, &mesh_draw.boxMin.x, &mesh_draw.boxMax.x, &mesh_draw.materialData.model.m00 );
+                }
+            }
+        }
     }
 
     void DemoApplication::Shutdown() {
@@ -976,10 +1558,19 @@ namespace Caustix {
         m_gpu->destroy_sampler( dummySampler );
 
         meshDraws.clear();
+        m_meshlets.Clear();
+        m_visibleMeshlets.clear();
+        m_sceneGraph.Clear();
+        m_sceneRoots.clear();
+        m_drawBounds.Clear();
+        m_drawVisibility.clear();
+        m_nodeDrawOffsets.clear();
+        m_nodeDraws.clear();
 
         m_gpu->destroy_buffer( cube_cb );
         m_gpu->destroy_descriptor_set_layout( cube_dsl );
         m_gpu->destroy_pipeline( cube_pipeline );
+        m_gpu->destroy_pipeline( cube_quantized_pipeline );
 
         GameApplication::Shutdown();
     }
@@ -999,6 +1590,20 @@ namespace Caustix {
 
         if ( ImGui::Begin( "Caustix ImGui" ) ) {
             ImGui::InputFloat("Model scale", &model_scale, 0.001f);
+            ImGui::Text( "Clusters visible %u / %u", m_visibleMeshletCount, ( u32 )m_meshlets.m_meshlets.size() );
+            ImGui::SliderFloat( "LOD error (pixels)", &m_lodErrorPixels, 0.0f, 16.0f );
+
+            u32 drawn_triangles = 0;
+            for ( const MeshDraw& mesh_draw : meshDraws ) {
+                drawn_triangles += ( mesh_draw.lodCount ? mesh_draw.lods[ mesh_draw.lodIndex ].m_indexCount : mesh_draw.count ) / 3;
+            }
+            ImGui::Text( "Triangles drawn %u", drawn_triangles );
+
+            ImGui::Checkbox( "Animate scene roots", &m_animateRoots );
+            ImGui::Text( "Scene graph: %u / %u nodes updated in %.3f ms", m_sceneGraphUpdatedNodes, m_sceneGraph.m_nodeCount, m_sceneGraphUpdateTime );
+
+            ImGui::Checkbox( "Frustum culling", &m_frustumCulling );
+            ImGui::Text( "Draws visible %u, culled %u in %.3f ms", m_visibleDraws, ( u32 )meshDraws.size() - m_visibleDraws, m_drawCullingTime );
         }
         ImGui::End();
 
@@ -1032,6 +1637,77 @@ namespace Caustix {
             m_gpu->unmap_buffer( cb_map );
         }
 
+        // Only the subtrees of changed nodes are recomputed, and only their draws pick up the new matrices.
+        {
+            const auto update_start = std::chrono::high_resolution_clock::now();
+            if ( m_animateRoots ) {
+                const mat4s rotation = glms_rotate_make( delta, vec3s{ 0.0f, 1.0f, 0.0f } );
+                for ( u32 root : m_sceneRoots ) {
+                    mat4s local_matrix;
+                    memcpy( &local_matrix, m_sceneGraph.GetLocalMatrix( root ), sizeof( mat4s ) );
+                    local_matrix = glms_mat4_mul( rotation, local_matrix );
+                    m_sceneGraph.SetLocalMatrix( root, ( const f32* )&local_matrix );
+                }
+            }
+
+            m_sceneGraphUpdatedNodes = m_sceneGraph.Update();
+            if ( m_sceneGraphUpdatedNodes ) {
+                UpdateMovedDraws();
+            }
+            m_sceneGraphUpdateTime = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - update_start ).count();
+        }
+
+        // Bounds are in scene space, global_model goes into the planes so the bounds only change with the scene graph.
+        {
+            const auto culling_start = std::chrono::high_resolution_clock::now();
+            if ( m_frustumCulling ) {
+                const mat4s scene_view_projection = glms_mat4_mul( m_gameCamera.m_camera.m_viewProjection, global_model );
+                FrustumPlanes planes;
+                ExtractFrustumPlanes( &scene_view_projection.m00, planes );
+                m_visibleDraws = CullBounds( m_drawBounds, planes, m_drawVisibility.data(), m_jobSystem );
+            } else {
+                std::fill( m_drawVisibility.begin(), m_drawVisibility.end(), ( u8 )1 );
+                m_visibleDraws = ( u32 )meshDraws.size();
+            }
+            m_drawCullingTime = std::chrono::duration<f64, std::milli>( std::chrono::high_resolution_clock::now() - culling_start ).count();
+        }
+
+        // Level of detail from the projected error at the nearest point of the bounding sphere.
+        for ( u32 mesh_index = 0; mesh_index < meshDraws.size(); ++mesh_index ) {
+            MeshDraw& mesh_draw = meshDraws[ mesh_index ];
+            if ( mesh_draw.lodCount == 0 || !m_drawVisibility[ mesh_index ] ) {
+                continue;
+            }
+
+            const mat4s world = glms_mat4_mul( global_model, mesh_draw.materialData.model );
+            const f32 world_scale = glm_max( glms_vec3_norm( glms_vec3( world.col[ 0 ] ) ), glm_max( glms_vec3_norm( glms_vec3( world.col[ 1 ] ) ), glms_vec3_norm( glms_vec3( world.col[ 2 ] ) ) ) );
+            const vec4s center = glms_mat4_mulv( world, vec4s{ mesh_draw.boundingSphere.x, mesh_draw.boundingSphere.y, mesh_draw.boundingSphere.z, 1.0f } );
+            const f32 distance = glms_vec3_distance( glms_vec3( center ), m_gameCamera.m_camera.m_position ) - mesh_draw.boundingSphere.w * world_scale;
+
+            const f32 pixels_per_unit = m_gameCamera.m_camera.ProjectLength( world_scale, distance, ( f32 )m_window->m_height );
+            mesh_draw.lodIndex = SelectMeshLod( mesh_draw.lods, mesh_draw.lodCount, pixels_per_unit, m_lodErrorPixels );
+        }
+
+        // Clusters are tested in model space: frustum planes of the model view projection and camera moved by the inverse world.
+        m_visibleMeshletCount = 0;
+        for ( u32 mesh_index = 0; mesh_index < meshDraws.size(); ++mesh_index ) {
+            const MeshDraw& mesh_draw = meshDraws[ mesh_index ];
+            if ( mesh_draw.meshletCount == 0 || !m_drawVisibility[ mesh_index ] ) {
+                continue;
+            }
+
+            const mat4s world = glms_mat4_mul( global_model, mesh_draw.materialData.model );
+            const mat4s model_view_projection = glms_mat4_mul( m_gameCamera.m_camera.m_viewProjection, world );
+            FrustumPlanes planes;
+            ExtractFrustumPlanes( &model_view_projection.m00, planes );
+
+            const vec4s eye = glms_mat4_mulv( glms_mat4_inv( world ), vec4s{ m_gameCamera.m_camera.m_position.x, m_gameCamera.m_camera.m_position.y, m_gameCamera.m_camera.m_position.z, 1.0f } );
+            const f32 camera_position[ 3 ] = { eye.x, eye.y, eye.z };
+
+            m_visibleMeshletCount += CullMeshlets( m_meshlets, mesh_draw.meshletOffset, mesh_draw.meshletCount, planes, camera_position,
+                                                   m_visibleMeshlets.data() + m_visibleMeshletCount );
+        }
+
         m_gameCamera.Update(m_input, m_window->m_width, m_window->m_height, delta);
     }
 
@@ -1045,10 +1721,24 @@ namespace Caustix {
         gpuCommands->SetScissor( nullptr );
         gpuCommands->SetViewport( nullptr );
 
+        bool quantized_pipeline = false;
         for ( u32 mesh_index = 0; mesh_index < meshDraws.size(); ++mesh_index ) {
+            if ( !m_drawVisibility[ mesh_index ] ) {
+                continue;
+            }
+
             MeshDraw mesh_draw = meshDraws[ mesh_index ];
             mesh_draw.materialData.modelInv = glms_mat4_inv( glms_mat4_transpose( glms_mat4_mul( global_model, mesh_draw.materialData.model ) ) );
 
+            if ( mesh_draw.quantized != quantized_pipeline ) {
+                quantized_pipeline = mesh_draw.quantized;
+                gpuCommands->BindPipeline( quantized_pipeline ? cube_quantized_pipeline : cube_pipeline );
+            }
+            // Normals use the inverse above, only positions need the dequantization.
+            if ( mesh_draw.quantized ) {
+                mesh_draw.materialData.model = glms_mat4_mul( mesh_draw.materialData.model, mesh_draw.dequantization );
+            }
+
             MapBufferParameters material_map = { mesh_draw.materialBuffer, 0, 0 };
             MaterialData* material_buffer_data = ( MaterialData* )m_gpu->map_buffer( material_map );
 
@@ -1074,7 +1764,12 @@ namespace Caustix {
             gpuCommands->BindIndexBuffer( mesh_draw.indexBuffer, mesh_draw.indexOffset, mesh_draw.indexType );
             gpuCommands->BindDescriptorSet( &mesh_draw.descriptorSet, 1, nullptr, 0 );
 
-            gpuCommands->DrawIndexed( TopologyType::Triangle, mesh_draw.count, 1, 0, 0, 0 );
+            if ( mesh_draw.lodCount ) {
+                const MeshLod& lod = mesh_draw.lods[ mesh_draw.lodIndex ];
+                gpuCommands->DrawIndexed( TopologyType::Triangle, lod.m_indexCount, 1, lod.m_indexOffset, 0, 0 );
+            } else {
+                gpuCommands->DrawIndexed( TopologyType::Triangle, mesh_draw.count, 1, 0, 0, 0 );
+            }
         }
 
         m_gpuProfiler.Update(*m_gpu);
@@ -0,0 +1,166 @@
+module;
+
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+export module Tests.Base64;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Base64;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Decodes random and malformed texts with every instruction set the CPU supports and compares them
+    // with the scalar path and a reference decoder.
+    bool RunBase64Tests( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr char k_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    // Written after the decoded bytes to catch stores past the end.
+    static constexpr u8 k_guard_value = 0xCD;
+    static constexpr u32 k_guard_size = 64;
+
+    static void Encode( const Array(u8)& data, bool padding, Array(char)& text ) {
+        text.clear();
+        sizet i = 0;
+        for ( ; i + 3 <= data.size(); i += 3 ) {
+            const u32 triple = ( data[ i ] << 16 ) | ( data[ i + 1 ] << 8 ) | data[ i + 2 ];
+            text.push_back( k_alphabet[ triple >> 18 ] );
+            text.push_back( k_alphabet[ ( triple >> 12 ) & 63 ] );
+            text.push_back( k_alphabet[ ( triple >> 6 ) & 63 ] );
+            text.push_back( k_alphabet[ triple & 63 ] );
+        }
+
+        const sizet remainder = data.size() - i;
+        if ( remainder == 0 ) {
+            return;
+        }
+        const u32 triple = ( data[ i ] << 16 ) | ( remainder == 2 ? data[ i + 1 ] << 8 : 0 );
+        text.push_back( k_alphabet[ triple >> 18 ] );
+        text.push_back( k_alphabet[ ( triple >> 12 ) & 63 ] );
+        if ( remainder == 2 ) {
+            text.push_back( k_alphabet[ ( triple >> 6 ) & 63 ] );
+        }
+        if ( padding ) {
+            text.resize( text.size() + 3 - remainder, '=' );
+        }
+    }
+
+    // One character at a time, sharing no code with the decoder under test.
+    static bool ReferenceDecode( const Array(char)& text, Array(u8)& output ) {
+        output.clear();
+
+        sizet length = text.size();
+        for ( u32 padding = 0; padding < 2 && length > 0 && text[ length - 1 ] == '='; ++padding ) {
+            --length;
+        }
+        if ( length % 4 == 1 ) {
+            return false;
+        }
+
+        u32 bits = 0;
+        u32 bitCount = 0;
+        for ( sizet i = 0; i < length; ++i ) {
+            const char* position = text[ i ] ? strchr( k_alphabet, text[ i ] ) : nullptr;
+            if ( position == nullptr ) {
+                return false;
+            }
+
+            bits = ( bits << 6 ) | ( u32 )( position - k_alphabet );
+            bitCount += 6;
+            if ( bitCount >= 8 ) {
+                bitCount -= 8;
+                output.push_back( ( u8 )( bits >> bitCount ) );
+            }
+        }
+        return true;
+    }
+
+    static bool CheckDecode( const Array(char)& text, Array(u8)& expected, Array(u8)& output ) {
+        const bool expectedValid = ReferenceDecode( text, expected );
+        const sizet size = Base64DecodedSize( text.data(), text.size() );
+        if ( expectedValid && size != expected.size() ) {
+            error( "Base64DecodedSize returned {} for {} bytes", size, expected.size() );
+            return false;
+        }
+
+        const Base64Isa supported = Base64SupportedIsa();
+        for ( u32 isa = ( u32 )Base64Isa::Scalar; isa <= ( u32 )supported; ++isa ) {
+            output.assign( size + k_guard_size, k_guard_value );
+            const bool valid = Base64Decode( text.data(), text.size(), output.data(), ( Base64Isa )isa );
+            if ( valid != expectedValid ) {
+                error( "Base64 isa {} returned {} instead of {} for {} characters", isa, valid, expectedValid, text.size() );
+                return false;
+            }
+            if ( valid && size && memcmp( output.data(), expected.data(), size ) != 0 ) {
+                error( "Base64 isa {} decoded {} characters differently from the reference", isa, text.size() );
+                return false;
+            }
+            for ( u32 i = 0; i < k_guard_size; ++i ) {
+                if ( output[ size + i ] != k_guard_value ) {
+                    error( "Base64 isa {} wrote past the end of {} decoded bytes", isa, size );
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool RunBase64Tests( Allocator* allocator ) {
+        std::mt19937 random( 1234 );
+
+        Array(u8) data( *allocator );
+        Array(char) text( *allocator );
+        Array(u8) expected( *allocator );
+        Array(u8) output( *allocator );
+
+        u32 failures = 0;
+        constexpr u32 k_iterations = 20000;
+        for ( u32 iteration = 0; iteration < k_iterations && failures < 10; ++iteration ) {
+            // Sizes around the 16 and 32 character blocks and the tails the vector paths leave to the scalar one.
+            const sizet size = iteration < 512 ? iteration : random() % 4096;
+            data.resize( size );
+            for ( u8& byte : data ) {
+                byte = ( u8 )random();
+            }
+            Encode( data, random() & 1, text );
+
+            failures += !CheckDecode( text, expected, output );
+
+            // Same text with a few characters replaced by any byte, truncated or with padding in the middle.
+            if ( text.empty() ) {
+                continue;
+            }
+            switch ( random() % 3 ) {
+                case 0: {
+                    const u32 changes = 1 + random() % 3;
+                    for ( u32 i = 0; i < changes; ++i ) {
+                        text[ random() % text.size() ] = ( char )random();
+                    }
+                    break;
+                }
+                case 1:
+                    text.resize( random() % text.size() );
+                    break;
+                case 2:
+                    text[ random() % text.size() ] = '=';
+                    break;
+            }
+            failures += !CheckDecode( text, expected, output );
+        }
+
+        const char* isaNames[] = { "scalar", "SSSE3", "AVX2" };
+        if ( failures ) {
+            error( "Base64 tests failed, {} mismatches", failures );
+        } else {
+            info( "Base64 tests passed, {} texts decoded up to {}", k_iterations * 2, isaNames[ ( u32 )Base64SupportedIsa() ] );
+        }
+        return failures == 0;
+    }
+}
@@ -0,0 +1,159 @@
+module;
+
+#include <string.h>
+
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+export module Tests.Glb;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.LinearAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.File;
+import Foundation.glTF;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Writes GLB files and loads them back: JSON and binary chunks in place, a file without binary chunk,
+    // and files with a bad magic, a bad version or chunk lengths running past the end, which must load nothing.
+    bool RunGlbTests( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_glb_test_magic       = 0x46546C67; // "glTF"
+    static constexpr u32 k_glb_test_json        = 0x4E4F534A; // "JSON"
+    static constexpr u32 k_glb_test_bin         = 0x004E4942; // "BIN\0"
+    static constexpr u32 k_glb_test_bin_size    = 200;        // Not a multiple of 4, the chunk gets padded.
+
+    struct GlbTestFile {
+        u32             m_magic         = k_glb_test_magic;
+        u32             m_version       = 2;
+        bool            m_binary        = true;
+        u32             m_jsonLengthPad = 0;    // Added to the JSON chunk length, past the end of the file when big.
+        u32             m_binLengthPad  = 0;
+    };
+
+    static void AppendU32( Array(u8)& bytes, u32 value ) {
+        const sizet offset = bytes.size();
+        bytes.resize( offset + sizeof( u32 ) );
+        memcpy( bytes.data() + offset, &value, sizeof( u32 ) );
+    }
+
+    // The JSON chunk is padded with spaces and the binary one with zeros, to 4 bytes like the specification asks.
+    static void BuildGlb( const GlbTestFile& description, Array(u8)& bytes ) {
+        std::string json = R"({"asset":{"version":"2.0"},"bufferViews":[{"buffer":0,"byteOffset":0,"byteLength":)" +
+                           std::to_string( k_glb_test_bin_size ) + "}]";
+        if ( description.m_binary ) {
+            json += R"(,"buffers":[{"byteLength":)" + std::to_string( k_glb_test_bin_size ) + "}]";
+        }
+        json += "}";
+        json.resize( MemoryAlign( json.size(), 4 ), ' ' );
+
+        bytes.clear();
+        AppendU32( bytes, description.m_magic );
+        AppendU32( bytes, description.m_version );
+        AppendU32( bytes, 0 );
+
+        AppendU32( bytes, ( u32 )json.size() + description.m_jsonLengthPad );
+        AppendU32( bytes, k_glb_test_json );
+        bytes.insert( bytes.end(), json.begin(), json.end() );
+
+        if ( description.m_binary ) {
+            AppendU32( bytes, k_glb_test_bin_size + description.m_binLengthPad );
+            AppendU32( bytes, k_glb_test_bin );
+            for ( u32 i = 0; i < k_glb_test_bin_size; ++i ) {
+                bytes.push_back( ( u8 )( i * 7 + 3 ) );
+            }
+            bytes.resize( MemoryAlign( bytes.size(), 4 ), 0 );
+        }
+
+        const u32 length = ( u32 )bytes.size();
+        memcpy( bytes.data() + 8, &length, sizeof( u32 ) );
+    }
+
+    // Loads the file and checks what came out of it. Every scene lives in the scratch allocator.
+    static bool TestGlb( cstring name, const GlbTestFile& description, bool expectLoaded, cstring path, LinearAllocator& scratch, Allocator* allocator ) {
+        Array(u8) bytes( *allocator );
+        BuildGlb( description, bytes );
+        if ( !FileWriteBinary( path, bytes.data(), bytes.size() ) ) {
+            error( "GLB {}: cannot write {}", name, path );
+            return false;
+        }
+
+        bool passed = true;
+        {
+            glTF::glTF scene = gltfLoadFile( path, &scratch );
+            const bool loaded = scene.asset != nullptr && scene.buffer_views_count == 1;
+            if ( loaded != expectLoaded ) {
+                error( "GLB {}: the document was {}", name, loaded ? "loaded" : "not loaded" );
+                passed = false;
+            }
+
+            const u8* data = scene.buffers_count ? scene.buffers[ 0 ].data : nullptr;
+            const bool expectData = expectLoaded && description.m_binary && description.m_binLengthPad == 0;
+            if ( ( data != nullptr ) != expectData ) {
+                error( "GLB {}: the binary chunk was {}", name, data ? "bound" : "not bound" );
+                passed = false;
+            }
+
+            // In place: the buffer points inside the mapping the scene keeps, at the bytes written.
+            if ( data ) {
+                const u8* mapping = scene.binary_file.m_data;
+                if ( mapping == nullptr || data < mapping || data + k_glb_test_bin_size > mapping + scene.binary_file.m_size ) {
+                    error( "GLB {}: the binary chunk was copied out of the mapping", name );
+                    passed = false;
+                } else {
+                    for ( u32 i = 0; i < k_glb_test_bin_size; ++i ) {
+                        if ( data[ i ] != ( u8 )( i * 7 + 3 ) ) {
+                            error( "GLB {}: the binary chunk does not hold the bytes written", name );
+                            passed = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        scratch.Clear();
+        return passed;
+    }
+
+    bool RunGlbTests( Allocator* allocator ) {
+        const std::string path = ( std::filesystem::temp_directory_path() / "caustix_glb_test.glb" ).string();
+        LinearAllocator scratch( cmega( 1 ) );
+
+        struct GlbTestCase {
+            cstring         m_name;
+            GlbTestFile     m_file;
+            bool            m_loaded;
+        };
+        const GlbTestCase cases[] = {
+            { "round trip", {}, true },
+            { "json only", { .m_binary = false }, true },
+            { "bad magic", { .m_magic = 0x58546C67 }, false },
+            { "bad version", { .m_version = 1 }, false },
+            { "truncated json chunk", { .m_jsonLengthPad = 4096 }, false },
+            // The JSON is fine, only the buffer is left unbound.
+            { "truncated binary chunk", { .m_binLengthPad = 4096 }, true },
+        };
+
+        u32 failures = 0;
+        for ( const GlbTestCase& testCase : cases ) {
+            failures += !TestGlb( testCase.m_name, testCase.m_file, testCase.m_loaded, path.c_str(), scratch, allocator );
+        }
+        std::filesystem::remove( path );
+
+        if ( failures ) {
+            error( "GLB tests failed, {} cases out of {}", failures, std::size( cases ) );
+        } else {
+            info( "GLB tests passed, {} files", std::size( cases ) );
+        }
+        return failures == 0;
+    }
+}
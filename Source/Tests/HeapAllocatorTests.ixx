@@ -0,0 +1,133 @@
+module;
+
+#include <string.h>
+
+#include <iterator>
+#include <vector>
+
+export module Tests.HeapAllocator;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.Memory.Allocators.HeapAllocator;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Allocates blocks of every power of two alignment from 1 to 4096 from fixed, growing and threaded heaps,
+    // checks their alignment and that they don't overlap, then frees and allocates them again.
+    bool RunHeapAllocatorTests( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr sizet k_heap_test_max_alignment = 4096;
+    static constexpr u32 k_heap_test_blocks = 8;
+    static constexpr sizet k_heap_test_sizes[] = { 1, 3, 16, 100, 4096, 10000 };
+
+    struct HeapTestBlock {
+        u8*             m_memory;
+        sizet           m_size;
+        u8              m_pattern;
+    };
+
+    static bool AllocateBlock( HeapAllocator& heap, cstring name, sizet size, sizet alignment, u8 pattern, HeapTestBlock& block ) {
+        block = { ( u8* )heap.allocate( size, alignment ), size, pattern };
+        if ( block.m_memory == nullptr ) {
+            error( "Heap {}: allocating {} bytes aligned to {} failed", name, size, alignment );
+            return false;
+        }
+        if ( ( ( sizet )block.m_memory & ( alignment - 1 ) ) != 0 ) {
+            error( "Heap {}: {} bytes at {} are not aligned to {}", name, size, ( void* )block.m_memory, alignment );
+            return false;
+        }
+        // Writes the whole block, overlapping blocks show up as a broken pattern.
+        memset( block.m_memory, pattern, size );
+        return true;
+    }
+
+    static bool CheckBlocks( cstring name, const Array(HeapTestBlock)& blocks, sizet alignment ) {
+        for ( const HeapTestBlock& block : blocks ) {
+            for ( sizet i = 0; i < block.m_size; ++i ) {
+                if ( block.m_memory[ i ] != block.m_pattern ) {
+                    error( "Heap {}: block of {} bytes aligned to {} was overwritten", name, block.m_size, alignment );
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static sizet GetAllocatedBytes( const HeapAllocator& heap ) {
+        sizet allocated = 0;
+        for ( u32 i = 0; i < heap.m_arenaCount; ++i ) {
+            allocated += heap.m_arenas[ i ].m_allocatedBytes;
+        }
+        return allocated;
+    }
+
+    static bool TestAlignments( HeapAllocator& heap, cstring name, Allocator* allocator ) {
+        Array(HeapTestBlock) blocks( *allocator );
+
+        for ( sizet alignment = 1; alignment <= k_heap_test_max_alignment; alignment *= 2 ) {
+            blocks.resize( k_heap_test_blocks * std::size( k_heap_test_sizes ) );
+
+            u8 pattern = 1;
+            bool valid = true;
+            for ( u32 i = 0; i < blocks.size() && valid; ++i, ++pattern ) {
+                valid = AllocateBlock( heap, name, k_heap_test_sizes[ i % std::size( k_heap_test_sizes ) ], alignment, pattern, blocks[ i ] );
+            }
+            valid = valid && CheckBlocks( name, blocks, alignment );
+
+            // Every other block freed and allocated again, so the new blocks reuse the holes between the live ones.
+            for ( u32 i = 0; i < blocks.size() && valid; i += 2, ++pattern ) {
+                heap.deallocate( blocks[ i ].m_memory );
+                valid = AllocateBlock( heap, name, blocks[ i ].m_size, alignment, pattern, blocks[ i ] );
+            }
+            valid = valid && CheckBlocks( name, blocks, alignment );
+
+            for ( const HeapTestBlock& block : blocks ) {
+                heap.deallocate( block.m_memory );
+            }
+            blocks.clear();
+
+            if ( !valid ) {
+                return false;
+            }
+        }
+
+        const sizet allocated = GetAllocatedBytes( heap );
+        if ( allocated != 0 ) {
+            error( "Heap {}: {} bytes still allocated after freeing every block", name, allocated );
+            return false;
+        }
+        return true;
+    }
+
+    bool RunHeapAllocatorTests( Allocator* allocator ) {
+        struct HeapTestConfiguration {
+            cstring                     m_name;
+            HeapAllocatorConfiguration  m_configuration;
+        };
+        // The growing heaps start too small for the largest alignments, so those come from pools added on demand.
+        const HeapTestConfiguration configurations[] = {
+            { "fixed", { cmega( 4 ) } },
+            { "growing", { ckilo( 64 ), 0, ckilo( 64 ) } },
+            { "threaded", { ckilo( 256 ), 2, ckilo( 64 ) } },
+        };
+
+        u32 failures = 0;
+        for ( const HeapTestConfiguration& configuration : configurations ) {
+            HeapAllocator heap( configuration.m_configuration );
+            failures += !TestAlignments( heap, configuration.m_name, allocator );
+        }
+
+        if ( failures ) {
+            error( "Heap allocator tests failed, {} heaps out of {}", failures, std::size( configurations ) );
+        } else {
+            info( "Heap allocator tests passed, alignments 1 to {}", k_heap_test_max_alignment );
+        }
+        return failures == 0;
+    }
+}
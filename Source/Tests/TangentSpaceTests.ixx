@@ -0,0 +1,149 @@
+module;
+
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+export module Tests.TangentSpace;
+
+import Foundation.Memory.Allocators.Allocator;
+import Foundation.TangentSpace;
+import Foundation.Jobs;
+import Foundation.Platform;
+import Foundation.Log;
+
+export namespace Caustix {
+    // Generates normals and tangents of a mesh big enough to be split in many jobs, with 32 and 16 bit indices,
+    // and checks that one thread, one worker and several workers give the same bits.
+    bool RunTangentSpaceTests( Allocator* allocator );
+}
+
+namespace Caustix {
+    #define Array(Element) std::vector<Element, STLAdaptor<Element>>
+
+    static constexpr u32 k_tangent_test_side    = 181;  // Vertices per side, below 65536 vertices for the 16 bit indices.
+    static constexpr u32 k_tangent_test_workers = 4;    // Also on machines with fewer cores, the splits are what matters.
+
+    struct TangentTestMesh {
+        TangentTestMesh( Allocator& allocator ) : m_positions( allocator ), m_texcoords( allocator ), m_indices( allocator ), m_shortIndices( allocator ) {}
+
+        Array(f32)      m_positions;
+        Array(f32)      m_texcoords;
+        Array(u32)      m_indices;
+        Array(u16)      m_shortIndices;
+        u32             m_vertexCount = 0;
+    };
+
+    // Jittered grid with mixed diagonals, mirrored uvs on half of it and a few degenerate triangles, so vertices
+    // sum faces of different sizes and orientations and every code path of the groups is taken.
+    static void BuildTangentTestMesh( TangentTestMesh& mesh ) {
+        const u32 side = k_tangent_test_side;
+        mesh.m_vertexCount = side * side;
+        mesh.m_positions.resize( mesh.m_vertexCount * 3 );
+        mesh.m_texcoords.resize( mesh.m_vertexCount * 2 );
+
+        u32 state = 0x6C078965u;
+        for ( u32 row = 0; row < side; ++row ) {
+            for ( u32 column = 0; column < side; ++column ) {
+                const u32 vertex = row * side + column;
+                state = state * 1664525u + 1013904223u;
+                const f32 jitter = ( ( state >> 8 ) & 0xFFFF ) / 65535.0f - 0.5f;
+
+                const f32 u = ( column + jitter * 0.3f ) / ( side - 1 );
+                const f32 v = ( f32 )row / ( side - 1 );
+                mesh.m_positions[ vertex * 3 + 0 ] = u * 2.0f - 1.0f;
+                mesh.m_positions[ vertex * 3 + 1 ] = 0.2f * sinf( u * 11.0f ) * cosf( v * 7.0f ) + jitter * 0.01f;
+                mesh.m_positions[ vertex * 3 + 2 ] = v * 2.0f - 1.0f;
+                mesh.m_texcoords[ vertex * 2 + 0 ] = column < side / 2 ? u : 1.0f - u;
+                mesh.m_texcoords[ vertex * 2 + 1 ] = v;
+            }
+        }
+
+        mesh.m_indices.clear();
+        for ( u32 row = 0; row + 1 < side; ++row ) {
+            for ( u32 column = 0; column + 1 < side; ++column ) {
+                const u32 corner = row * side + column;
+                if ( ( row * 7 + column ) % 97 == 0 ) {
+                    const u32 degenerate[ 3 ] = { corner, corner, corner + 1 };
+                    mesh.m_indices.insert( mesh.m_indices.end(), degenerate, degenerate + 3 );
+                }
+                if ( ( row + column ) & 1 ) {
+                    const u32 quad[ 6 ] = { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 };
+                    mesh.m_indices.insert( mesh.m_indices.end(), quad, quad + 6 );
+                } else {
+                    const u32 quad[ 6 ] = { corner, corner + side, corner + side + 1, corner, corner + side + 1, corner + 1 };
+                    mesh.m_indices.insert( mesh.m_indices.end(), quad, quad + 6 );
+                }
+            }
+        }
+        mesh.m_shortIndices.assign( mesh.m_indices.begin(), mesh.m_indices.end() );
+    }
+
+    template <typename T>
+    static bool Generate( const TangentTestMesh& mesh, const Array(T)& indices, Array(f32)& normals, Array(f32)& tangents, Allocator* allocator, JobSystem* jobSystem ) {
+        normals.assign( mesh.m_vertexCount * 3, 0.0f );
+        tangents.assign( mesh.m_vertexCount * 4, 0.0f );
+        return GenerateNormals( mesh.m_positions.data(), mesh.m_vertexCount, indices.data(), ( u32 )indices.size(), normals.data(), allocator, jobSystem ) &&
+               GenerateTangents( mesh.m_positions.data(), normals.data(), mesh.m_texcoords.data(), mesh.m_vertexCount, indices.data(), ( u32 )indices.size(),
+                                 tangents.data(), allocator, jobSystem );
+    }
+
+    template <typename T>
+    static bool TestWorkers( cstring name, const TangentTestMesh& mesh, const Array(T)& indices, const Array(f32)& referenceNormals,
+                             const Array(f32)& referenceTangents, JobSystem& jobSystem, Allocator* allocator ) {
+        Array(f32) normals( *allocator );
+        Array(f32) tangents( *allocator );
+        const u32 workers = jobSystem.GetWorkerCount();
+        if ( !Generate( mesh, indices, normals, tangents, allocator, &jobSystem ) ) {
+            error( "Tangent space {}: generation failed on {} workers", name, workers );
+            return false;
+        }
+        if ( memcmp( normals.data(), referenceNormals.data(), normals.size() * sizeof( f32 ) ) != 0 ) {
+            error( "Tangent space {}: normals on {} workers differ from one thread", name, workers );
+            return false;
+        }
+        if ( memcmp( tangents.data(), referenceTangents.data(), tangents.size() * sizeof( f32 ) ) != 0 ) {
+            error( "Tangent space {}: tangents on {} workers differ from one thread", name, workers );
+            return false;
+        }
+        return true;
+    }
+
+    bool RunTangentSpaceTests( Allocator* allocator ) {
+        TangentTestMesh mesh( *allocator );
+        BuildTangentTestMesh( mesh );
+
+        // References on the calling thread, without job system.
+        Array(f32) normals( *allocator );
+        Array(f32) tangents( *allocator );
+        Array(f32) shortNormals( *allocator );
+        Array(f32) shortTangents( *allocator );
+        if ( !Generate( mesh, mesh.m_indices, normals, tangents, allocator, nullptr ) ||
+             !Generate( mesh, mesh.m_shortIndices, shortNormals, shortTangents, allocator, nullptr ) ) {
+            error( "Tangent space tests failed, generation failed on one thread" );
+            return false;
+        }
+
+        // One system at a time, the thread creating it becomes its worker 0.
+        u32 failures = 0;
+        const u32 workerCounts[] = { 1, k_tangent_test_workers };
+        for ( u32 workers : workerCounts ) {
+            JobSystemConfiguration configuration;
+            configuration.m_allocator = allocator;
+            configuration.m_workerCount = workers;
+            configuration.m_pinThreads = false;
+            JobSystem jobSystem( configuration );
+
+            failures += !TestWorkers( "32 bit indices", mesh, mesh.m_indices, normals, tangents, jobSystem, allocator );
+            failures += !TestWorkers( "16 bit indices", mesh, mesh.m_shortIndices, shortNormals, shortTangents, jobSystem, allocator );
+        }
+
+        if ( failures ) {
+            error( "Tangent space tests failed, {} runs differ", failures );
+        } else {
+            info( "Tangent space tests passed, {} triangles identical on one thread, 1 and {} workers", mesh.m_indices.size() / 3, k_tangent_test_workers );
+        }
+        return failures == 0;
+    }
+}
@@ -0,0 +1,29 @@
+import Tests.Base64;
+import Tests.Glb;
+import Tests.HeapAllocator;
+import Tests.TangentSpace;
+
+import Foundation.Services.MemoryService;
+import Foundation.Services.ServiceManager;
+import Foundation.Memory.MemoryDefines;
+import Foundation.Log;
+
+int main(int argc, char **argv) {
+    using namespace Caustix;
+
+    MemoryServiceConfiguration memoryConfiguration;
+    ServiceManager::GetInstance()->AddService(MemoryService::Create(memoryConfiguration), MemoryService::m_name);
+    MemoryService* memoryService = ServiceManager::GetInstance()->Get<MemoryService>();
+
+    bool passed = true;
+    passed &= RunBase64Tests(&memoryService->m_systemAllocator);
+    passed &= RunGlbTests(&memoryService->m_systemAllocator);
+    passed &= RunHeapAllocatorTests(&memoryService->m_systemAllocator);
+    passed &= RunTangentSpaceTests(&memoryService->m_systemAllocator);
+
+    if (passed) {
+        info("All tests passed");
+    }
+
+    return passed ? 0 : -1;
+}